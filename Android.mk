@@ -43,9 +43,29 @@ LOCAL_WHOLE_STATIC_LIBRARIES := \
 ifeq ($(WEBRTC_BUILD_NEON_LIBS),true)
 LOCAL_WHOLE_STATIC_LIBRARIES_arm += \
     libwebrtc_aecm_neon \
+    libwebrtc_apm_neon \
+    libwebrtc_apm_utility_neon \
     libwebrtc_ns_neon
 endif
 
+# Add the SSE4.1, POPCNT and AVX2 kernels, selected at runtime.
+LOCAL_WHOLE_STATIC_LIBRARIES_x86 += \
+    libwebrtc_aec_avx2 \
+    libwebrtc_aecm_avx2 \
+    libwebrtc_aecm_sse41 \
+    libwebrtc_apm_avx2 \
+    libwebrtc_apm_utility_avx2 \
+    libwebrtc_apm_utility_popcnt \
+    libwebrtc_ns_sse41
+LOCAL_WHOLE_STATIC_LIBRARIES_x86_64 += \
+    libwebrtc_aec_avx2 \
+    libwebrtc_aecm_avx2 \
+    libwebrtc_aecm_sse41 \
+    libwebrtc_apm_avx2 \
+    libwebrtc_apm_utility_avx2 \
+    libwebrtc_apm_utility_popcnt \
+    libwebrtc_ns_sse41
+
 LOCAL_SHARED_LIBRARIES := \
     libcutils \
     libdl \
@@ -118,6 +118,10 @@ class FakeAudioProcessing : public webrtc::AudioProcessing {
   WEBRTC_STUB(StartDebugRecording, (FILE* handle));
   WEBRTC_STUB(StopDebugRecording, ());
   WEBRTC_VOID_STUB(UpdateHistogramsOnCallEnd, ());
+  WEBRTC_STUB_CONST(GetSubmoduleTimings,
+                    (std::vector<SubmoduleTiming>* timings));
+  size_t num_skipped_silent_frames() const override { return 0; }
+  size_t num_dropped_debug_dump_messages() const override { return 0; }
   webrtc::EchoCancellation* echo_cancellation() const override { return NULL; }
   webrtc::EchoControlMobile* echo_control_mobile() const override {
     return NULL;
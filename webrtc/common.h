@@ -31,7 +31,10 @@ enum class ConfigOptionID {
   kExperimentalAgc,
   kExperimentalNs,
   kBeamforming,
-  kIntelligibility
+  kIntelligibility,
+  kSubmoduleProfiling,
+  kSilentFrameSkipping,
+  kDebugDumpCompression
 };
 
 // Class Config is designed to ease passing a set of options across webrtc code.
@@ -25,6 +25,7 @@ LOCAL_SRC_FILES := \
     fft4g.c \
     fir_filter.cc \
     lapped_transform.cc \
+    rdft.c \
     real_fourier_ooura.cc \
     real_fourier.cc \
     ring_buffer.c \
@@ -33,7 +34,8 @@ LOCAL_SRC_FILES := \
     window_generator.cc \
 
 ifeq ($(TARGET_ARCH), $(filter $(TARGET_ARCH),x86 x86_64))
-LOCAL_SRC_FILES += fir_filter_sse.cc
+LOCAL_SRC_FILES += fir_filter_sse.cc \
+    rdft_sse2.c
 endif
 
 # Flags passed to both C and C++ files.
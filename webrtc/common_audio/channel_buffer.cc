@@ -15,57 +15,71 @@ namespace webrtc {
 IFChannelBuffer::IFChannelBuffer(size_t num_frames,
                                  size_t num_channels,
                                  size_t num_bands)
-    : ivalid_(true),
-      ibuf_(num_frames, num_channels, num_bands),
-      fvalid_(true),
-      fbuf_(num_frames, num_channels, num_bands) {}
+    : num_frames_(num_frames),
+      num_channels_(num_channels),
+      num_bands_(num_bands),
+      num_conversions_(0),
+      ivalid_(true),
+      fvalid_(true) {}
+
+IFChannelBuffer::~IFChannelBuffer() {}
 
 ChannelBuffer<int16_t>* IFChannelBuffer::ibuf() {
   RefreshI();
   fvalid_ = false;
-  return &ibuf_;
+  return ibuf_.get();
 }
 
 ChannelBuffer<float>* IFChannelBuffer::fbuf() {
   RefreshF();
   ivalid_ = false;
-  return &fbuf_;
+  return fbuf_.get();
 }
 
 const ChannelBuffer<int16_t>* IFChannelBuffer::ibuf_const() const {
   RefreshI();
-  return &ibuf_;
+  return ibuf_.get();
 }
 
 const ChannelBuffer<float>* IFChannelBuffer::fbuf_const() const {
   RefreshF();
-  return &fbuf_;
+  return fbuf_.get();
 }
 
+// A representation that was never requested is allocated zeroed, which is
+// what both held until then unless the other one has been written since.
 void IFChannelBuffer::RefreshF() const {
+  if (!fbuf_) {
+    fbuf_.reset(
+        new ChannelBuffer<float>(num_frames_, num_channels_, num_bands_));
+  }
   if (!fvalid_) {
     assert(ivalid_);
-    const int16_t* const* int_channels = ibuf_.channels();
-    float* const* float_channels = fbuf_.channels();
-    for (size_t i = 0; i < ibuf_.num_channels(); ++i) {
-      for (size_t j = 0; j < ibuf_.num_frames(); ++j) {
+    const int16_t* const* int_channels = ibuf_->channels();
+    float* const* float_channels = fbuf_->channels();
+    for (size_t i = 0; i < num_channels_; ++i) {
+      for (size_t j = 0; j < num_frames_; ++j) {
         float_channels[i][j] = int_channels[i][j];
       }
     }
+    num_conversions_ += num_channels_ * num_frames_;
     fvalid_ = true;
   }
 }
 
 void IFChannelBuffer::RefreshI() const {
+  if (!ibuf_) {
+    ibuf_.reset(
+        new ChannelBuffer<int16_t>(num_frames_, num_channels_, num_bands_));
+  }
   if (!ivalid_) {
     assert(fvalid_);
-    int16_t* const* int_channels = ibuf_.channels();
-    const float* const* float_channels = fbuf_.channels();
-    for (size_t i = 0; i < ibuf_.num_channels(); ++i) {
-      FloatS16ToS16(float_channels[i],
-                    ibuf_.num_frames(),
-                    int_channels[i]);
+    int16_t* const* int_channels = ibuf_->channels();
+    const float* const* float_channels = fbuf_->channels();
+    for (size_t i = 0; i < num_channels_; ++i) {
+      FloatS16ToS16(float_channels[i], num_frames_, int_channels[i]);
     }
+    num_conversions_ += num_channels_ * num_frames_;
     ivalid_ = true;
   }
 }
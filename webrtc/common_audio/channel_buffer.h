@@ -140,28 +140,39 @@ class ChannelBuffer {
 // therefore safe to use the return value of ibuf_const() and fbuf_const()
 // until the next call to ibuf() or fbuf(), and the return value of ibuf() and
 // fbuf() until the next call to any of the other functions.
+// Each ChannelBuffer is only allocated the first time it is requested, so a
+// user of only one of the representations never pays for the other.
 class IFChannelBuffer {
  public:
   IFChannelBuffer(size_t num_frames, size_t num_channels, size_t num_bands = 1);
+  ~IFChannelBuffer();
 
   ChannelBuffer<int16_t>* ibuf();
   ChannelBuffer<float>* fbuf();
   const ChannelBuffer<int16_t>* ibuf_const() const;
   const ChannelBuffer<float>* fbuf_const() const;
 
-  size_t num_frames() const { return ibuf_.num_frames(); }
-  size_t num_frames_per_band() const { return ibuf_.num_frames_per_band(); }
-  size_t num_channels() const { return ibuf_.num_channels(); }
-  size_t num_bands() const { return ibuf_.num_bands(); }
+  size_t num_frames() const { return num_frames_; }
+  size_t num_frames_per_band() const { return num_frames_ / num_bands_; }
+  size_t num_channels() const { return num_channels_; }
+  size_t num_bands() const { return num_bands_; }
+
+  // Samples converted between the int16 and float representations so far,
+  // i.e. the cost of mixing ibuf() and fbuf() accesses.
+  size_t num_conversions() const { return num_conversions_; }
 
  private:
   void RefreshF() const;
   void RefreshI() const;
 
+  const size_t num_frames_;
+  const size_t num_channels_;
+  const size_t num_bands_;
+  mutable size_t num_conversions_;
   mutable bool ivalid_;
-  mutable ChannelBuffer<int16_t> ibuf_;
+  mutable rtc::scoped_ptr<ChannelBuffer<int16_t>> ibuf_;
   mutable bool fvalid_;
-  mutable ChannelBuffer<float> fbuf_;
+  mutable rtc::scoped_ptr<ChannelBuffer<float>> fbuf_;
 };
 
 }  // namespace webrtc
@@ -47,6 +47,9 @@
         'include/audio_util.h',
         'lapped_transform.cc',
         'lapped_transform.h',
+        'rdft.c',
+        'rdft.h',
+        'rdft_internal.h',
         'real_fourier.cc',
         'real_fourier.h',
         'real_fourier_ooura.cc',
@@ -199,6 +202,7 @@
           'type': 'static_library',
           'sources': [
             'fir_filter_sse.cc',
+            'rdft_sse2.c',
             'resampler/sinc_resampler_sse.cc',
           ],
           'conditions': [
@@ -220,6 +224,7 @@
           'includes': ['../build/arm_neon.gypi',],
           'sources': [
             'fir_filter_neon.cc',
+            'rdft_neon.c',
             'resampler/sinc_resampler_neon.cc',
             'signal_processing/cross_correlation_neon.c',
             'signal_processing/downsample_fast_neon.c',
@@ -247,6 +252,7 @@
             'blocker_unittest.cc',
             'fir_filter_unittest.cc',
             'lapped_transform_unittest.cc',
+            'rdft_unittest.cc',
             'real_fourier_unittest.cc',
             'resampler/resampler_unittest.cc',
             'resampler/push_resampler_unittest.cc',
@@ -0,0 +1,159 @@
+/*
+ *  Copyright (c) 2016 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/common_audio/rdft.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "webrtc/common_audio/fft4g.h"
+#include "webrtc/common_audio/rdft_internal.h"
+#include "webrtc/system_wrappers/include/cpu_features_wrapper.h"
+
+static const double kPi = 3.14159265358979323846;
+
+static void ForwardOoura(const struct WebRtcRdft* self, float* data) {
+  WebRtc_rdft(self->length, 1, data, self->ip, self->w);
+}
+
+static void InverseOoura(const struct WebRtcRdft* self, float* data) {
+  WebRtc_rdft(self->length, -1, data, self->ip, self->w);
+}
+
+static int InitOoura(struct WebRtcRdft* self) {
+  float* data;
+
+  self->ip = calloc(2 + (size_t)ceil(sqrt((double)self->length)),
+                    sizeof(*self->ip));
+  self->w = calloc(self->length / 2, sizeof(*self->w));
+  data = calloc(self->length, sizeof(*data));
+  if (!self->ip || !self->w || !data) {
+    free(data);
+    return -1;
+  }
+
+  // Ooura fills its tables on the first transform; do that here rather than
+  // in the middle of a stream.
+  WebRtc_rdft(self->length, 1, data, self->ip, self->w);
+  free(data);
+
+  self->forward = ForwardOoura;
+  self->inverse = InverseOoura;
+  return 0;
+}
+
+static int InitRadix4(struct WebRtcRdft* self) {
+  const size_t half_length = self->length / 2;
+  size_t twiddle_length = 0;
+  size_t span, offset, p, j;
+  float* tables;
+
+  for (span = half_length; span >= 4; span /= 4) {
+    twiddle_length += span / 4;
+  }
+
+  tables = malloc((6 * twiddle_length + 6 * half_length) * sizeof(*tables));
+  if (!tables) {
+    return -1;
+  }
+  self->tables = tables;
+  for (j = 0; j < 3; ++j) {
+    self->twiddle_re[j] = tables + 2 * j * twiddle_length;
+    self->twiddle_im[j] = tables + (2 * j + 1) * twiddle_length;
+  }
+  self->split_re = tables + 6 * twiddle_length;
+  self->split_im = self->split_re + half_length;
+  self->work = self->split_im + half_length;
+
+  offset = 0;
+  for (span = half_length; span >= 4; span /= 4) {
+    for (p = 0; p < span / 4; ++p) {
+      for (j = 0; j < 3; ++j) {
+        const double phase = -2 * kPi * (j + 1) * p / span;
+        self->twiddle_re[j][offset + p] = (float)cos(phase);
+        self->twiddle_im[j][offset + p] = (float)sin(phase);
+      }
+    }
+    offset += span / 4;
+  }
+
+  for (p = 0; p < half_length; ++p) {
+    const double phase = -2 * kPi * p / self->length;
+    self->split_re[p] = (float)cos(phase);
+    self->split_im[p] = (float)sin(phase);
+  }
+
+  return 0;
+}
+
+struct WebRtcRdft* WebRtcRdft_Create(size_t length) {
+  struct WebRtcRdft* self;
+  int radix4 = 0;
+
+  if (length < 2 || (length & (length - 1)) != 0) {
+    return NULL;
+  }
+
+  self = calloc(1, sizeof(*self));
+  if (!self) {
+    return NULL;
+  }
+  self->length = length;
+
+  if (length >= kRdftMinRadix4Length) {
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+    if (WebRtc_GetCPUInfo(kSSE2)) {
+      self->forward = WebRtcRdft_ForwardSSE2;
+      self->inverse = WebRtcRdft_InverseSSE2;
+      radix4 = 1;
+    }
+#elif defined(WEBRTC_HAS_NEON)
+    self->forward = WebRtcRdft_ForwardNEON;
+    self->inverse = WebRtcRdft_InverseNEON;
+    radix4 = 1;
+#elif defined(WEBRTC_DETECT_NEON)
+    if ((WebRtc_GetCPUFeaturesARM() & kCPUFeatureNEON) != 0) {
+      self->forward = WebRtcRdft_ForwardNEON;
+      self->inverse = WebRtcRdft_InverseNEON;
+      radix4 = 1;
+    }
+#endif
+  }
+
+  if ((radix4 ? InitRadix4(self) : InitOoura(self)) != 0) {
+    WebRtcRdft_Free(self);
+    return NULL;
+  }
+
+  return self;
+}
+
+void WebRtcRdft_Free(struct WebRtcRdft* self) {
+  if (!self) {
+    return;
+  }
+
+  free(self->ip);
+  free(self->w);
+  free(self->tables);
+  free(self);
+}
+
+size_t WebRtcRdft_length(const struct WebRtcRdft* self) {
+  return self->length;
+}
+
+void WebRtcRdft_Forward(const struct WebRtcRdft* self, float* data) {
+  self->forward(self, data);
+}
+
+void WebRtcRdft_Inverse(const struct WebRtcRdft* self, float* data) {
+  self->inverse(self, data);
+}
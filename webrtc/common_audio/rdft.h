@@ -0,0 +1,60 @@
+/*
+ *  Copyright (c) 2016 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef WEBRTC_COMMON_AUDIO_RDFT_H_
+#define WEBRTC_COMMON_AUDIO_RDFT_H_
+
+#include <stddef.h>
+
+// Real DFT with the data layout and scaling of WebRtc_rdft() (fft4g.h), for a
+// length fixed at creation. Knowing the length up front lets the tables be
+// laid out for a radix-4 transform that runs on SSE2 or NEON; lengths too
+// short for it, and CPUs without either, fall back to Ooura.
+//
+// A WebRtcRdft keeps scratch space, so one instance must not run two
+// transforms at the same time.
+
+struct WebRtcRdft;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// |length| must be a power of 2 of at least 2. Returns NULL on failure.
+struct WebRtcRdft* WebRtcRdft_Create(size_t length);
+void WebRtcRdft_Free(struct WebRtcRdft* self);
+
+size_t WebRtcRdft_length(const struct WebRtcRdft* self);
+
+// In-place forward transform of |length| real samples. On return
+//     data[0] = R[0], data[1] = R[length / 2],
+//     data[2 * k] = R[k], data[2 * k + 1] = I[k], 0 < k < length / 2,
+// where R[k] and I[k] are defined as for WebRtc_rdft(), i.e. I[k] is the
+// negated imaginary part of the usual DFT.
+void WebRtcRdft_Forward(const struct WebRtcRdft* self, float* data);
+
+// In-place inverse of WebRtcRdft_Forward(), taking the same layout. Like
+// WebRtc_rdft(length, -1, ...) the output is scaled by |length| / 2.
+void WebRtcRdft_Inverse(const struct WebRtcRdft* self, float* data);
+
+#ifdef __cplusplus
+}  // extern "C"
+
+namespace webrtc {
+
+// Deleter for use with scoped_ptr.
+struct RdftDeleter {
+  void operator()(WebRtcRdft* rdft) const { WebRtcRdft_Free(rdft); }
+};
+
+}  // namespace webrtc
+#endif
+
+#endif  // WEBRTC_COMMON_AUDIO_RDFT_H_
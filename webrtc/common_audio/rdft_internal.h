@@ -0,0 +1,74 @@
+/*
+ *  Copyright (c) 2016 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef WEBRTC_COMMON_AUDIO_RDFT_INTERNAL_H_
+#define WEBRTC_COMMON_AUDIO_RDFT_INTERNAL_H_
+
+#include <stddef.h>
+
+#include "webrtc/common_audio/rdft.h"
+#include "webrtc/typedefs.h"
+
+// The SIMD kernels work on four complex values at a time, which takes a
+// complex FFT of at least 16 points.
+enum { kRdftMinRadix4Length = 32 };
+
+typedef void (*WebRtcRdftTransform)(const struct WebRtcRdft* self,
+                                    float* data);
+
+// A real transform of length n runs as a complex FFT of n / 2 points on the
+// even samples in the real part and the odd ones in the imaginary part, whose
+// spectrum is then split into the real spectrum.
+//
+// The complex FFT is a Stockham radix-4 FFT on separate real and imaginary
+// arrays, ending with one radix-2 stage when log2(n / 2) is odd. Stage s
+// runs n / 2 / 4^(s + 1) butterflies of span L = n / 2 / 4^s, butterfly p
+// scaling its outputs 1, 2 and 3 by e^(-2 pi i * j * p / L), j = 1, 2, 3.
+struct WebRtcRdft {
+  size_t length;
+  WebRtcRdftTransform forward;
+  WebRtcRdftTransform inverse;
+
+  // Work arrays for Ooura, see fft4g.c.
+  size_t* ip;
+  float* w;
+
+  // Radix-4 twiddles, twiddle_re[j - 1][p] is the real part of the factor for
+  // output j of butterfly p, with the stages following each other.
+  float* twiddle_re[3];
+  float* twiddle_im[3];
+  // e^(-2 pi i * k / n) for 0 <= k < n / 2, to split the spectrum.
+  float* split_re;
+  float* split_im;
+  // Two pairs of n / 2 point real and imaginary arrays, the complex FFT
+  // ping-pongs between them.
+  float* work;
+  float* tables;
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+void WebRtcRdft_ForwardSSE2(const struct WebRtcRdft* self, float* data);
+void WebRtcRdft_InverseSSE2(const struct WebRtcRdft* self, float* data);
+#endif
+
+#if defined(WEBRTC_DETECT_NEON) || defined(WEBRTC_HAS_NEON)
+void WebRtcRdft_ForwardNEON(const struct WebRtcRdft* self, float* data);
+void WebRtcRdft_InverseNEON(const struct WebRtcRdft* self, float* data);
+#endif
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // WEBRTC_COMMON_AUDIO_RDFT_INTERNAL_H_
@@ -0,0 +1,273 @@
+/*
+ *  Copyright (c) 2016 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/common_audio/rdft_internal.h"
+
+#include <arm_neon.h>
+#include <string.h>
+
+// Same transforms as rdft_sse2.c, see there for the math.
+
+// Real part of (a_re + i a_im) * (b_re + i b_im).
+static __inline float32x4_t MulRe(float32x4_t a_re, float32x4_t a_im,
+                                  float32x4_t b_re, float32x4_t b_im) {
+  return vmlsq_f32(vmulq_f32(a_re, b_re), a_im, b_im);
+}
+
+// Imaginary part of (a_re + i a_im) * (b_re + i b_im).
+static __inline float32x4_t MulIm(float32x4_t a_re, float32x4_t a_im,
+                                  float32x4_t b_re, float32x4_t b_im) {
+  return vmlaq_f32(vmulq_f32(a_re, b_im), a_im, b_re);
+}
+
+static __inline float32x4_t Reverse(float32x4_t a) {
+  const float32x4_t rev = vrev64q_f32(a);
+  return vcombine_f32(vget_high_f32(rev), vget_low_f32(rev));
+}
+
+// Lane 0 from |first|, lanes 1 to 3 from lanes 0 to 2 of |rest|.
+static __inline float32x4_t Shift(float first, float32x4_t rest) {
+  return vextq_f32(vdupq_n_f32(first), rest, 3);
+}
+
+static void ComplexFFT(const struct WebRtcRdft* self,
+                       float* re,
+                       float* im,
+                       float* tmp_re,
+                       float* tmp_im) {
+  const size_t length = self->length / 2;
+  const float* w1_re = self->twiddle_re[0];
+  const float* w1_im = self->twiddle_im[0];
+  const float* w2_re = self->twiddle_re[1];
+  const float* w2_im = self->twiddle_im[1];
+  const float* w3_re = self->twiddle_re[2];
+  const float* w3_im = self->twiddle_im[2];
+  float* x_re = re;
+  float* x_im = im;
+  float* y_re = tmp_re;
+  float* y_im = tmp_im;
+  float* swap;
+  size_t span, stride, p, q;
+
+  // The interleaving stores put the outputs of the first stage in place.
+  {
+    const size_t n1 = length / 4;
+    for (p = 0; p < n1; p += 4) {
+      const float32x4_t a_re = vld1q_f32(&x_re[p]);
+      const float32x4_t a_im = vld1q_f32(&x_im[p]);
+      const float32x4_t b_re = vld1q_f32(&x_re[p + n1]);
+      const float32x4_t b_im = vld1q_f32(&x_im[p + n1]);
+      const float32x4_t c_re = vld1q_f32(&x_re[p + 2 * n1]);
+      const float32x4_t c_im = vld1q_f32(&x_im[p + 2 * n1]);
+      const float32x4_t d_re = vld1q_f32(&x_re[p + 3 * n1]);
+      const float32x4_t d_im = vld1q_f32(&x_im[p + 3 * n1]);
+      const float32x4_t apc_re = vaddq_f32(a_re, c_re);
+      const float32x4_t apc_im = vaddq_f32(a_im, c_im);
+      const float32x4_t amc_re = vsubq_f32(a_re, c_re);
+      const float32x4_t amc_im = vsubq_f32(a_im, c_im);
+      const float32x4_t bpd_re = vaddq_f32(b_re, d_re);
+      const float32x4_t bpd_im = vaddq_f32(b_im, d_im);
+      // i * (b - d)
+      const float32x4_t jbmd_re = vsubq_f32(d_im, b_im);
+      const float32x4_t jbmd_im = vsubq_f32(b_re, d_re);
+      const float32x4_t t1_re = vsubq_f32(amc_re, jbmd_re);
+      const float32x4_t t1_im = vsubq_f32(amc_im, jbmd_im);
+      const float32x4_t t2_re = vsubq_f32(apc_re, bpd_re);
+      const float32x4_t t2_im = vsubq_f32(apc_im, bpd_im);
+      const float32x4_t t3_re = vaddq_f32(amc_re, jbmd_re);
+      const float32x4_t t3_im = vaddq_f32(amc_im, jbmd_im);
+      const float32x4_t v1_re = vld1q_f32(&w1_re[p]);
+      const float32x4_t v1_im = vld1q_f32(&w1_im[p]);
+      const float32x4_t v2_re = vld1q_f32(&w2_re[p]);
+      const float32x4_t v2_im = vld1q_f32(&w2_im[p]);
+      const float32x4_t v3_re = vld1q_f32(&w3_re[p]);
+      const float32x4_t v3_im = vld1q_f32(&w3_im[p]);
+      float32x4x4_t y;
+      y.val[0] = vaddq_f32(apc_re, bpd_re);
+      y.val[1] = MulRe(t1_re, t1_im, v1_re, v1_im);
+      y.val[2] = MulRe(t2_re, t2_im, v2_re, v2_im);
+      y.val[3] = MulRe(t3_re, t3_im, v3_re, v3_im);
+      vst4q_f32(&y_re[4 * p], y);
+      y.val[0] = vaddq_f32(apc_im, bpd_im);
+      y.val[1] = MulIm(t1_re, t1_im, v1_re, v1_im);
+      y.val[2] = MulIm(t2_re, t2_im, v2_re, v2_im);
+      y.val[3] = MulIm(t3_re, t3_im, v3_re, v3_im);
+      vst4q_f32(&y_im[4 * p], y);
+    }
+    swap = x_re; x_re = y_re; y_re = swap;
+    swap = x_im; x_im = y_im; y_im = swap;
+    w1_re += n1; w1_im += n1;
+    w2_re += n1; w2_im += n1;
+    w3_re += n1; w3_im += n1;
+  }
+
+  for (span = length / 4, stride = 4; span >= 4; span /= 4, stride *= 4) {
+    const size_t n1 = span / 4;
+    for (p = 0; p < n1; ++p) {
+      const float32x4_t v1_re = vdupq_n_f32(w1_re[p]);
+      const float32x4_t v1_im = vdupq_n_f32(w1_im[p]);
+      const float32x4_t v2_re = vdupq_n_f32(w2_re[p]);
+      const float32x4_t v2_im = vdupq_n_f32(w2_im[p]);
+      const float32x4_t v3_re = vdupq_n_f32(w3_re[p]);
+      const float32x4_t v3_im = vdupq_n_f32(w3_im[p]);
+      const float* a_re_ptr = &x_re[stride * p];
+      const float* a_im_ptr = &x_im[stride * p];
+      float* y0_re_ptr = &y_re[stride * 4 * p];
+      float* y0_im_ptr = &y_im[stride * 4 * p];
+      for (q = 0; q < stride; q += 4) {
+        const float32x4_t a_re = vld1q_f32(&a_re_ptr[q]);
+        const float32x4_t a_im = vld1q_f32(&a_im_ptr[q]);
+        const float32x4_t b_re = vld1q_f32(&a_re_ptr[q + stride * n1]);
+        const float32x4_t b_im = vld1q_f32(&a_im_ptr[q + stride * n1]);
+        const float32x4_t c_re = vld1q_f32(&a_re_ptr[q + stride * 2 * n1]);
+        const float32x4_t c_im = vld1q_f32(&a_im_ptr[q + stride * 2 * n1]);
+        const float32x4_t d_re = vld1q_f32(&a_re_ptr[q + stride * 3 * n1]);
+        const float32x4_t d_im = vld1q_f32(&a_im_ptr[q + stride * 3 * n1]);
+        const float32x4_t apc_re = vaddq_f32(a_re, c_re);
+        const float32x4_t apc_im = vaddq_f32(a_im, c_im);
+        const float32x4_t amc_re = vsubq_f32(a_re, c_re);
+        const float32x4_t amc_im = vsubq_f32(a_im, c_im);
+        const float32x4_t bpd_re = vaddq_f32(b_re, d_re);
+        const float32x4_t bpd_im = vaddq_f32(b_im, d_im);
+        const float32x4_t jbmd_re = vsubq_f32(d_im, b_im);
+        const float32x4_t jbmd_im = vsubq_f32(b_re, d_re);
+        const float32x4_t t1_re = vsubq_f32(amc_re, jbmd_re);
+        const float32x4_t t1_im = vsubq_f32(amc_im, jbmd_im);
+        const float32x4_t t2_re = vsubq_f32(apc_re, bpd_re);
+        const float32x4_t t2_im = vsubq_f32(apc_im, bpd_im);
+        const float32x4_t t3_re = vaddq_f32(amc_re, jbmd_re);
+        const float32x4_t t3_im = vaddq_f32(amc_im, jbmd_im);
+        vst1q_f32(&y0_re_ptr[q], vaddq_f32(apc_re, bpd_re));
+        vst1q_f32(&y0_im_ptr[q], vaddq_f32(apc_im, bpd_im));
+        vst1q_f32(&y0_re_ptr[q + stride], MulRe(t1_re, t1_im, v1_re, v1_im));
+        vst1q_f32(&y0_im_ptr[q + stride], MulIm(t1_re, t1_im, v1_re, v1_im));
+        vst1q_f32(&y0_re_ptr[q + 2 * stride],
+                  MulRe(t2_re, t2_im, v2_re, v2_im));
+        vst1q_f32(&y0_im_ptr[q + 2 * stride],
+                  MulIm(t2_re, t2_im, v2_re, v2_im));
+        vst1q_f32(&y0_re_ptr[q + 3 * stride],
+                  MulRe(t3_re, t3_im, v3_re, v3_im));
+        vst1q_f32(&y0_im_ptr[q + 3 * stride],
+                  MulIm(t3_re, t3_im, v3_re, v3_im));
+      }
+    }
+    swap = x_re; x_re = y_re; y_re = swap;
+    swap = x_im; x_im = y_im; y_im = swap;
+    w1_re += n1; w1_im += n1;
+    w2_re += n1; w2_im += n1;
+    w3_re += n1; w3_im += n1;
+  }
+
+  if (span == 2) {
+    for (q = 0; q < stride; q += 4) {
+      const float32x4_t a_re = vld1q_f32(&x_re[q]);
+      const float32x4_t a_im = vld1q_f32(&x_im[q]);
+      const float32x4_t b_re = vld1q_f32(&x_re[q + stride]);
+      const float32x4_t b_im = vld1q_f32(&x_im[q + stride]);
+      vst1q_f32(&y_re[q], vaddq_f32(a_re, b_re));
+      vst1q_f32(&y_im[q], vaddq_f32(a_im, b_im));
+      vst1q_f32(&y_re[q + stride], vsubq_f32(a_re, b_re));
+      vst1q_f32(&y_im[q + stride], vsubq_f32(a_im, b_im));
+    }
+    swap = x_re; x_re = y_re; y_re = swap;
+    swap = x_im; x_im = y_im; y_im = swap;
+  }
+
+  if (x_re != re) {
+    memcpy(re, x_re, length * sizeof(*re));
+    memcpy(im, x_im, length * sizeof(*im));
+  }
+}
+
+void WebRtcRdft_ForwardNEON(const struct WebRtcRdft* self, float* data) {
+  const size_t length = self->length / 2;
+  const float32x4_t half = vdupq_n_f32(0.5f);
+  float* z_re = self->work;
+  float* z_im = z_re + length;
+  size_t k;
+
+  for (k = 0; k < length; k += 4) {
+    const float32x4x2_t z = vld2q_f32(&data[2 * k]);
+    vst1q_f32(&z_re[k], z.val[0]);
+    vst1q_f32(&z_im[k], z.val[1]);
+  }
+
+  ComplexFFT(self, z_re, z_im, z_im + length, z_im + 2 * length);
+
+  for (k = 0; k < length; k += 4) {
+    const float32x4_t zk_re = vld1q_f32(&z_re[k]);
+    const float32x4_t zk_im = vld1q_f32(&z_im[k]);
+    // Z[n / 2] is Z[0].
+    const float32x4_t zm_re =
+        k == 0 ? Shift(z_re[0], Reverse(vld1q_f32(&z_re[length - 4])))
+               : Reverse(vld1q_f32(&z_re[length - k - 3]));
+    const float32x4_t zm_im =
+        k == 0 ? Shift(z_im[0], Reverse(vld1q_f32(&z_im[length - 4])))
+               : Reverse(vld1q_f32(&z_im[length - k - 3]));
+    const float32x4_t e_re = vmulq_f32(half, vaddq_f32(zk_re, zm_re));
+    const float32x4_t e_im = vmulq_f32(half, vsubq_f32(zk_im, zm_im));
+    const float32x4_t o_re = vmulq_f32(half, vaddq_f32(zk_im, zm_im));
+    const float32x4_t o_im = vmulq_f32(half, vsubq_f32(zm_re, zk_re));
+    const float32x4_t w_re = vld1q_f32(&self->split_re[k]);
+    const float32x4_t w_im = vld1q_f32(&self->split_im[k]);
+    float32x4x2_t x;
+    x.val[0] = vaddq_f32(e_re, MulRe(o_re, o_im, w_re, w_im));
+    x.val[1] = vnegq_f32(vaddq_f32(e_im, MulIm(o_re, o_im, w_re, w_im)));
+    vst2q_f32(&data[2 * k], x);
+  }
+  data[0] = z_re[0] + z_im[0];
+  data[1] = z_re[0] - z_im[0];
+}
+
+void WebRtcRdft_InverseNEON(const struct WebRtcRdft* self, float* data) {
+  const size_t length = self->length / 2;
+  const float32x4_t half = vdupq_n_f32(0.5f);
+  float* z_re = self->work;
+  float* z_im = z_re + length;
+  size_t k;
+
+  for (k = 0; k < length; k += 4) {
+    float32x4x2_t xk = vld2q_f32(&data[2 * k]);
+    float32x4_t xm_re, xm_im;
+    if (k == 0) {
+      // X[0] and X[n / 2] are real, and packed into data[0] and data[1].
+      const float32x4x2_t xm = vld2q_f32(&data[2 * length - 8]);
+      xk.val[1] = vsetq_lane_f32(0.f, xk.val[1], 0);
+      xm_re = Shift(data[1], Reverse(xm.val[0]));
+      xm_im = Shift(0.f, Reverse(xm.val[1]));
+    } else {
+      const float32x4x2_t xm = vld2q_f32(&data[2 * (length - k) - 6]);
+      xm_re = Reverse(xm.val[0]);
+      xm_im = Reverse(xm.val[1]);
+    }
+    {
+      const float32x4_t e_re = vmulq_f32(half, vaddq_f32(xk.val[0], xm_re));
+      const float32x4_t e_im = vmulq_f32(half, vsubq_f32(xm_im, xk.val[1]));
+      const float32x4_t d_re = vmulq_f32(half, vsubq_f32(xk.val[0], xm_re));
+      const float32x4_t d_im =
+          vnegq_f32(vmulq_f32(half, vaddq_f32(xk.val[1], xm_im)));
+      const float32x4_t w_re = vld1q_f32(&self->split_re[k]);
+      const float32x4_t w_im = vnegq_f32(vld1q_f32(&self->split_im[k]));
+      const float32x4_t o_re = MulRe(d_re, d_im, w_re, w_im);
+      const float32x4_t o_im = MulIm(d_re, d_im, w_re, w_im);
+      vst1q_f32(&z_re[k], vsubq_f32(e_re, o_im));
+      vst1q_f32(&z_im[k], vaddq_f32(e_im, o_re));
+    }
+  }
+
+  ComplexFFT(self, z_im, z_re, z_im + length, z_im + 2 * length);
+
+  for (k = 0; k < length; k += 4) {
+    float32x4x2_t x;
+    x.val[0] = vld1q_f32(&z_re[k]);
+    x.val[1] = vld1q_f32(&z_im[k]);
+    vst2q_f32(&data[2 * k], x);
+  }
+}
@@ -0,0 +1,308 @@
+/*
+ *  Copyright (c) 2016 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/common_audio/rdft_internal.h"
+
+#include <emmintrin.h>
+#include <string.h>
+
+// Real part of (a_re + i a_im) * (b_re + i b_im).
+static __inline __m128 MulRe(__m128 a_re, __m128 a_im,
+                             __m128 b_re, __m128 b_im) {
+  return _mm_sub_ps(_mm_mul_ps(a_re, b_re), _mm_mul_ps(a_im, b_im));
+}
+
+// Imaginary part of (a_re + i a_im) * (b_re + i b_im).
+static __inline __m128 MulIm(__m128 a_re, __m128 a_im,
+                             __m128 b_re, __m128 b_im) {
+  return _mm_add_ps(_mm_mul_ps(a_re, b_im), _mm_mul_ps(a_im, b_re));
+}
+
+static __inline __m128 Reverse(__m128 a) {
+  return _mm_shuffle_ps(a, a, _MM_SHUFFLE(0, 1, 2, 3));
+}
+
+// Forward complex FFT of self->length / 2 points, see rdft_internal.h. Stages
+// alternate between (re, im) and (tmp_re, tmp_im); the result ends up in
+// (re, im).
+static void ComplexFFT(const struct WebRtcRdft* self,
+                       float* re,
+                       float* im,
+                       float* tmp_re,
+                       float* tmp_im) {
+  const size_t length = self->length / 2;
+  const float* w1_re = self->twiddle_re[0];
+  const float* w1_im = self->twiddle_im[0];
+  const float* w2_re = self->twiddle_re[1];
+  const float* w2_im = self->twiddle_im[1];
+  const float* w3_re = self->twiddle_re[2];
+  const float* w3_im = self->twiddle_im[2];
+  float* x_re = re;
+  float* x_im = im;
+  float* y_re = tmp_re;
+  float* y_im = tmp_im;
+  float* swap;
+  size_t span, stride, p, q;
+
+  // The first stage has a stride of 1, it runs four butterflies at a time and
+  // transposes their outputs into place.
+  {
+    const size_t n1 = length / 4;
+    for (p = 0; p < n1; p += 4) {
+      const __m128 a_re = _mm_loadu_ps(&x_re[p]);
+      const __m128 a_im = _mm_loadu_ps(&x_im[p]);
+      const __m128 b_re = _mm_loadu_ps(&x_re[p + n1]);
+      const __m128 b_im = _mm_loadu_ps(&x_im[p + n1]);
+      const __m128 c_re = _mm_loadu_ps(&x_re[p + 2 * n1]);
+      const __m128 c_im = _mm_loadu_ps(&x_im[p + 2 * n1]);
+      const __m128 d_re = _mm_loadu_ps(&x_re[p + 3 * n1]);
+      const __m128 d_im = _mm_loadu_ps(&x_im[p + 3 * n1]);
+      const __m128 apc_re = _mm_add_ps(a_re, c_re);
+      const __m128 apc_im = _mm_add_ps(a_im, c_im);
+      const __m128 amc_re = _mm_sub_ps(a_re, c_re);
+      const __m128 amc_im = _mm_sub_ps(a_im, c_im);
+      const __m128 bpd_re = _mm_add_ps(b_re, d_re);
+      const __m128 bpd_im = _mm_add_ps(b_im, d_im);
+      // i * (b - d)
+      const __m128 jbmd_re = _mm_sub_ps(d_im, b_im);
+      const __m128 jbmd_im = _mm_sub_ps(b_re, d_re);
+      const __m128 t1_re = _mm_sub_ps(amc_re, jbmd_re);
+      const __m128 t1_im = _mm_sub_ps(amc_im, jbmd_im);
+      const __m128 t2_re = _mm_sub_ps(apc_re, bpd_re);
+      const __m128 t2_im = _mm_sub_ps(apc_im, bpd_im);
+      const __m128 t3_re = _mm_add_ps(amc_re, jbmd_re);
+      const __m128 t3_im = _mm_add_ps(amc_im, jbmd_im);
+      const __m128 v1_re = _mm_loadu_ps(&w1_re[p]);
+      const __m128 v1_im = _mm_loadu_ps(&w1_im[p]);
+      const __m128 v2_re = _mm_loadu_ps(&w2_re[p]);
+      const __m128 v2_im = _mm_loadu_ps(&w2_im[p]);
+      const __m128 v3_re = _mm_loadu_ps(&w3_re[p]);
+      const __m128 v3_im = _mm_loadu_ps(&w3_im[p]);
+      __m128 y0_re = _mm_add_ps(apc_re, bpd_re);
+      __m128 y0_im = _mm_add_ps(apc_im, bpd_im);
+      __m128 y1_re = MulRe(t1_re, t1_im, v1_re, v1_im);
+      __m128 y1_im = MulIm(t1_re, t1_im, v1_re, v1_im);
+      __m128 y2_re = MulRe(t2_re, t2_im, v2_re, v2_im);
+      __m128 y2_im = MulIm(t2_re, t2_im, v2_re, v2_im);
+      __m128 y3_re = MulRe(t3_re, t3_im, v3_re, v3_im);
+      __m128 y3_im = MulIm(t3_re, t3_im, v3_re, v3_im);
+      _MM_TRANSPOSE4_PS(y0_re, y1_re, y2_re, y3_re);
+      _MM_TRANSPOSE4_PS(y0_im, y1_im, y2_im, y3_im);
+      _mm_storeu_ps(&y_re[4 * p], y0_re);
+      _mm_storeu_ps(&y_re[4 * p + 4], y1_re);
+      _mm_storeu_ps(&y_re[4 * p + 8], y2_re);
+      _mm_storeu_ps(&y_re[4 * p + 12], y3_re);
+      _mm_storeu_ps(&y_im[4 * p], y0_im);
+      _mm_storeu_ps(&y_im[4 * p + 4], y1_im);
+      _mm_storeu_ps(&y_im[4 * p + 8], y2_im);
+      _mm_storeu_ps(&y_im[4 * p + 12], y3_im);
+    }
+    swap = x_re; x_re = y_re; y_re = swap;
+    swap = x_im; x_im = y_im; y_im = swap;
+    w1_re += n1; w1_im += n1;
+    w2_re += n1; w2_im += n1;
+    w3_re += n1; w3_im += n1;
+  }
+
+  // The later stages have a stride of at least 4 and run four transforms at
+  // a time, with the twiddles of a butterfly shared between them.
+  for (span = length / 4, stride = 4; span >= 4; span /= 4, stride *= 4) {
+    const size_t n1 = span / 4;
+    for (p = 0; p < n1; ++p) {
+      const __m128 v1_re = _mm_set1_ps(w1_re[p]);
+      const __m128 v1_im = _mm_set1_ps(w1_im[p]);
+      const __m128 v2_re = _mm_set1_ps(w2_re[p]);
+      const __m128 v2_im = _mm_set1_ps(w2_im[p]);
+      const __m128 v3_re = _mm_set1_ps(w3_re[p]);
+      const __m128 v3_im = _mm_set1_ps(w3_im[p]);
+      const float* a_re_ptr = &x_re[stride * p];
+      const float* a_im_ptr = &x_im[stride * p];
+      float* y0_re_ptr = &y_re[stride * 4 * p];
+      float* y0_im_ptr = &y_im[stride * 4 * p];
+      for (q = 0; q < stride; q += 4) {
+        const __m128 a_re = _mm_loadu_ps(&a_re_ptr[q]);
+        const __m128 a_im = _mm_loadu_ps(&a_im_ptr[q]);
+        const __m128 b_re = _mm_loadu_ps(&a_re_ptr[q + stride * n1]);
+        const __m128 b_im = _mm_loadu_ps(&a_im_ptr[q + stride * n1]);
+        const __m128 c_re = _mm_loadu_ps(&a_re_ptr[q + stride * 2 * n1]);
+        const __m128 c_im = _mm_loadu_ps(&a_im_ptr[q + stride * 2 * n1]);
+        const __m128 d_re = _mm_loadu_ps(&a_re_ptr[q + stride * 3 * n1]);
+        const __m128 d_im = _mm_loadu_ps(&a_im_ptr[q + stride * 3 * n1]);
+        const __m128 apc_re = _mm_add_ps(a_re, c_re);
+        const __m128 apc_im = _mm_add_ps(a_im, c_im);
+        const __m128 amc_re = _mm_sub_ps(a_re, c_re);
+        const __m128 amc_im = _mm_sub_ps(a_im, c_im);
+        const __m128 bpd_re = _mm_add_ps(b_re, d_re);
+        const __m128 bpd_im = _mm_add_ps(b_im, d_im);
+        const __m128 jbmd_re = _mm_sub_ps(d_im, b_im);
+        const __m128 jbmd_im = _mm_sub_ps(b_re, d_re);
+        const __m128 t1_re = _mm_sub_ps(amc_re, jbmd_re);
+        const __m128 t1_im = _mm_sub_ps(amc_im, jbmd_im);
+        const __m128 t2_re = _mm_sub_ps(apc_re, bpd_re);
+        const __m128 t2_im = _mm_sub_ps(apc_im, bpd_im);
+        const __m128 t3_re = _mm_add_ps(amc_re, jbmd_re);
+        const __m128 t3_im = _mm_add_ps(amc_im, jbmd_im);
+        _mm_storeu_ps(&y0_re_ptr[q], _mm_add_ps(apc_re, bpd_re));
+        _mm_storeu_ps(&y0_im_ptr[q], _mm_add_ps(apc_im, bpd_im));
+        _mm_storeu_ps(&y0_re_ptr[q + stride],
+                      MulRe(t1_re, t1_im, v1_re, v1_im));
+        _mm_storeu_ps(&y0_im_ptr[q + stride],
+                      MulIm(t1_re, t1_im, v1_re, v1_im));
+        _mm_storeu_ps(&y0_re_ptr[q + 2 * stride],
+                      MulRe(t2_re, t2_im, v2_re, v2_im));
+        _mm_storeu_ps(&y0_im_ptr[q + 2 * stride],
+                      MulIm(t2_re, t2_im, v2_re, v2_im));
+        _mm_storeu_ps(&y0_re_ptr[q + 3 * stride],
+                      MulRe(t3_re, t3_im, v3_re, v3_im));
+        _mm_storeu_ps(&y0_im_ptr[q + 3 * stride],
+                      MulIm(t3_re, t3_im, v3_re, v3_im));
+      }
+    }
+    swap = x_re; x_re = y_re; y_re = swap;
+    swap = x_im; x_im = y_im; y_im = swap;
+    w1_re += n1; w1_im += n1;
+    w2_re += n1; w2_im += n1;
+    w3_re += n1; w3_im += n1;
+  }
+
+  // A radix-2 stage is left over when log2(length) is odd.
+  if (span == 2) {
+    for (q = 0; q < stride; q += 4) {
+      const __m128 a_re = _mm_loadu_ps(&x_re[q]);
+      const __m128 a_im = _mm_loadu_ps(&x_im[q]);
+      const __m128 b_re = _mm_loadu_ps(&x_re[q + stride]);
+      const __m128 b_im = _mm_loadu_ps(&x_im[q + stride]);
+      _mm_storeu_ps(&y_re[q], _mm_add_ps(a_re, b_re));
+      _mm_storeu_ps(&y_im[q], _mm_add_ps(a_im, b_im));
+      _mm_storeu_ps(&y_re[q + stride], _mm_sub_ps(a_re, b_re));
+      _mm_storeu_ps(&y_im[q + stride], _mm_sub_ps(a_im, b_im));
+    }
+    swap = x_re; x_re = y_re; y_re = swap;
+    swap = x_im; x_im = y_im; y_im = swap;
+  }
+
+  if (x_re != re) {
+    memcpy(re, x_re, length * sizeof(*re));
+    memcpy(im, x_im, length * sizeof(*im));
+  }
+}
+
+void WebRtcRdft_ForwardSSE2(const struct WebRtcRdft* self, float* data) {
+  const size_t length = self->length / 2;
+  const __m128 half = _mm_set1_ps(0.5f);
+  float* z_re = self->work;
+  float* z_im = z_re + length;
+  size_t k;
+
+  // Even samples to the real part, odd ones to the imaginary part.
+  for (k = 0; k < length; k += 4) {
+    const __m128 lo = _mm_loadu_ps(&data[2 * k]);
+    const __m128 hi = _mm_loadu_ps(&data[2 * k + 4]);
+    _mm_storeu_ps(&z_re[k], _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0)));
+    _mm_storeu_ps(&z_im[k], _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1)));
+  }
+
+  ComplexFFT(self, z_re, z_im, z_im + length, z_im + 2 * length);
+
+  // With E and O the spectra of the even and odd samples,
+  //     E[k] = (Z[k] + conj(Z[n / 2 - k])) / 2,
+  //     O[k] = (Z[k] - conj(Z[n / 2 - k])) / 2i,
+  //     X[k] = E[k] + e^(-2 pi i * k / n) * O[k],
+  // stored conjugated like Ooura does.
+  for (k = 0; k < length; k += 4) {
+    const __m128 zk_re = _mm_loadu_ps(&z_re[k]);
+    const __m128 zk_im = _mm_loadu_ps(&z_im[k]);
+    // Z[n / 2] is Z[0].
+    const __m128 zm_re =
+        k == 0 ? _mm_setr_ps(z_re[0], z_re[length - 1], z_re[length - 2],
+                             z_re[length - 3])
+               : Reverse(_mm_loadu_ps(&z_re[length - k - 3]));
+    const __m128 zm_im =
+        k == 0 ? _mm_setr_ps(z_im[0], z_im[length - 1], z_im[length - 2],
+                             z_im[length - 3])
+               : Reverse(_mm_loadu_ps(&z_im[length - k - 3]));
+    const __m128 e_re = _mm_mul_ps(half, _mm_add_ps(zk_re, zm_re));
+    const __m128 e_im = _mm_mul_ps(half, _mm_sub_ps(zk_im, zm_im));
+    const __m128 o_re = _mm_mul_ps(half, _mm_add_ps(zk_im, zm_im));
+    const __m128 o_im = _mm_mul_ps(half, _mm_sub_ps(zm_re, zk_re));
+    const __m128 w_re = _mm_loadu_ps(&self->split_re[k]);
+    const __m128 w_im = _mm_loadu_ps(&self->split_im[k]);
+    const __m128 x_re = _mm_add_ps(e_re, MulRe(o_re, o_im, w_re, w_im));
+    const __m128 x_im = _mm_sub_ps(_mm_setzero_ps(),
+                                   _mm_add_ps(e_im, MulIm(o_re, o_im, w_re,
+                                                          w_im)));
+    _mm_storeu_ps(&data[2 * k], _mm_unpacklo_ps(x_re, x_im));
+    _mm_storeu_ps(&data[2 * k + 4], _mm_unpackhi_ps(x_re, x_im));
+  }
+  data[0] = z_re[0] + z_im[0];
+  data[1] = z_re[0] - z_im[0];
+}
+
+void WebRtcRdft_InverseSSE2(const struct WebRtcRdft* self, float* data) {
+  const size_t length = self->length / 2;
+  const __m128 half = _mm_set1_ps(0.5f);
+  const __m128 zero = _mm_setzero_ps();
+  float* z_re = self->work;
+  float* z_im = z_re + length;
+  size_t k;
+
+  // Undoes the split of the forward transform,
+  //     E[k] = (X[k] + conj(X[n / 2 - k])) / 2,
+  //     O[k] = (X[k] - conj(X[n / 2 - k])) / 2 * e^(2 pi i * k / n),
+  //     Z[k] = E[k] + i * O[k],
+  // with X[0] and X[n / 2] both real.
+  for (k = 0; k < length; k += 4) {
+    __m128 xk_re, xk_im, xm_re, xm_im;
+    if (k == 0) {
+      xk_re = _mm_setr_ps(data[0], data[2], data[4], data[6]);
+      xk_im = _mm_setr_ps(0.f, data[3], data[5], data[7]);
+      xm_re = _mm_setr_ps(data[1], data[2 * length - 2], data[2 * length - 4],
+                          data[2 * length - 6]);
+      xm_im = _mm_setr_ps(0.f, data[2 * length - 1], data[2 * length - 3],
+                          data[2 * length - 5]);
+    } else {
+      const __m128 lo = _mm_loadu_ps(&data[2 * k]);
+      const __m128 hi = _mm_loadu_ps(&data[2 * k + 4]);
+      const __m128 mirror_lo = _mm_loadu_ps(&data[2 * (length - k) - 6]);
+      const __m128 mirror_hi = _mm_loadu_ps(&data[2 * (length - k) - 2]);
+      xk_re = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0));
+      xk_im = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1));
+      xm_re = _mm_shuffle_ps(mirror_hi, mirror_lo, _MM_SHUFFLE(0, 2, 0, 2));
+      xm_im = _mm_shuffle_ps(mirror_hi, mirror_lo, _MM_SHUFFLE(1, 3, 1, 3));
+    }
+    {
+      // The data holds conj(X), which flips the sign of xk_im only.
+      const __m128 e_re = _mm_mul_ps(half, _mm_add_ps(xk_re, xm_re));
+      const __m128 e_im = _mm_mul_ps(half, _mm_sub_ps(xm_im, xk_im));
+      const __m128 d_re = _mm_mul_ps(half, _mm_sub_ps(xk_re, xm_re));
+      const __m128 d_im = _mm_mul_ps(half, _mm_sub_ps(zero,
+                                                      _mm_add_ps(xk_im,
+                                                                 xm_im)));
+      const __m128 w_re = _mm_loadu_ps(&self->split_re[k]);
+      const __m128 w_im = _mm_sub_ps(zero, _mm_loadu_ps(&self->split_im[k]));
+      const __m128 o_re = MulRe(d_re, d_im, w_re, w_im);
+      const __m128 o_im = MulIm(d_re, d_im, w_re, w_im);
+      _mm_storeu_ps(&z_re[k], _mm_sub_ps(e_re, o_im));
+      _mm_storeu_ps(&z_im[k], _mm_add_ps(e_im, o_re));
+    }
+  }
+
+  // The unscaled inverse FFT is the forward one with real and imaginary
+  // parts swapped on the way in and out. Its length / 2 scale is the one
+  // Ooura's inverse has.
+  ComplexFFT(self, z_im, z_re, z_im + length, z_im + 2 * length);
+
+  for (k = 0; k < length; k += 4) {
+    const __m128 x_re = _mm_loadu_ps(&z_re[k]);
+    const __m128 x_im = _mm_loadu_ps(&z_im[k]);
+    _mm_storeu_ps(&data[2 * k], _mm_unpacklo_ps(x_re, x_im));
+    _mm_storeu_ps(&data[2 * k + 4], _mm_unpackhi_ps(x_re, x_im));
+  }
+}
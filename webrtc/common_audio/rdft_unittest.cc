@@ -0,0 +1,145 @@
+/*
+ *  Copyright (c) 2016 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/common_audio/rdft.h"
+
+#include <math.h>
+
+#include <random>
+#include <vector>
+
+#include "testing/gtest/include/gtest/gtest.h"
+#include "webrtc/base/scoped_ptr.h"
+#include "webrtc/common_audio/fft4g.h"
+#include "webrtc/system_wrappers/include/cpu_features_wrapper.h"
+
+namespace webrtc {
+namespace {
+
+typedef rtc::scoped_ptr<WebRtcRdft, RdftDeleter> ScopedRdft;
+
+// Relative to the largest value of the output.
+const float kTolerance = 1e-5f;
+const size_t kMaxOrder = 11;
+
+int CPUInfoWithoutSIMD(CPUFeature feature) {
+  return WebRtc_GetCPUInfoNoASM(feature);
+}
+
+// Creates the transform as the given CPU would have it.
+ScopedRdft CreateRdft(size_t length, WebRtc_CPUInfo cpu_info) {
+  WebRtc_CPUInfo saved = WebRtc_GetCPUInfo;
+  WebRtc_GetCPUInfo = cpu_info;
+  ScopedRdft rdft(WebRtcRdft_Create(length));
+  WebRtc_GetCPUInfo = saved;
+  return rdft;
+}
+
+void ExpectNear(const std::vector<float>& expected,
+                const std::vector<float>& actual) {
+  ASSERT_EQ(expected.size(), actual.size());
+  float max_abs = 0.f;
+  for (float value : expected) {
+    max_abs = fmaxf(max_abs, fabsf(value));
+  }
+  for (size_t i = 0; i < expected.size(); ++i) {
+    ASSERT_NEAR(expected[i], actual[i], kTolerance * (1.f + max_abs))
+        << "at " << i;
+  }
+}
+
+class RdftTest : public ::testing::TestWithParam<bool> {
+ protected:
+  WebRtc_CPUInfo cpu_info() const {
+    return GetParam() ? WebRtc_GetCPUInfo : CPUInfoWithoutSIMD;
+  }
+
+  std::vector<float> RandomSignal(size_t length) {
+    std::uniform_real_distribution<float> dist(-32768.f, 32767.f);
+    std::vector<float> signal(length);
+    for (float& sample : signal) {
+      sample = dist(random_);
+    }
+    return signal;
+  }
+
+  std::mt19937 random_;
+};
+
+TEST(RdftCreateTest, RejectsLengthsOtherThanPowersOfTwo) {
+  EXPECT_TRUE(WebRtcRdft_Create(0) == NULL);
+  EXPECT_TRUE(WebRtcRdft_Create(1) == NULL);
+  EXPECT_TRUE(WebRtcRdft_Create(96) == NULL);
+  ScopedRdft rdft(WebRtcRdft_Create(256));
+  ASSERT_TRUE(rdft.get() != NULL);
+  EXPECT_EQ(256u, WebRtcRdft_length(rdft.get()));
+}
+
+TEST_P(RdftTest, ForwardMatchesOoura) {
+  for (size_t order = 1; order <= kMaxOrder; ++order) {
+    const size_t length = 1u << order;
+    SCOPED_TRACE(length);
+    ScopedRdft rdft = CreateRdft(length, cpu_info());
+    ASSERT_TRUE(rdft.get() != NULL);
+    std::vector<size_t> ip(2 + length);
+    std::vector<float> w(length / 2);
+
+    for (int round = 0; round < 3; ++round) {
+      std::vector<float> expected = RandomSignal(length);
+      std::vector<float> actual = expected;
+      WebRtc_rdft(length, 1, &expected[0], &ip[0], &w[0]);
+      WebRtcRdft_Forward(rdft.get(), &actual[0]);
+      ExpectNear(expected, actual);
+    }
+  }
+}
+
+TEST_P(RdftTest, InverseMatchesOoura) {
+  for (size_t order = 1; order <= kMaxOrder; ++order) {
+    const size_t length = 1u << order;
+    SCOPED_TRACE(length);
+    ScopedRdft rdft = CreateRdft(length, cpu_info());
+    ASSERT_TRUE(rdft.get() != NULL);
+    std::vector<size_t> ip(2 + length);
+    std::vector<float> w(length / 2);
+
+    for (int round = 0; round < 3; ++round) {
+      std::vector<float> expected = RandomSignal(length);
+      std::vector<float> actual = expected;
+      WebRtc_rdft(length, -1, &expected[0], &ip[0], &w[0]);
+      WebRtcRdft_Inverse(rdft.get(), &actual[0]);
+      ExpectNear(expected, actual);
+    }
+  }
+}
+
+TEST_P(RdftTest, InverseUndoesForward) {
+  for (size_t order = 1; order <= kMaxOrder; ++order) {
+    const size_t length = 1u << order;
+    SCOPED_TRACE(length);
+    ScopedRdft rdft = CreateRdft(length, cpu_info());
+    ASSERT_TRUE(rdft.get() != NULL);
+
+    const std::vector<float> signal = RandomSignal(length);
+    std::vector<float> actual = signal;
+    WebRtcRdft_Forward(rdft.get(), &actual[0]);
+    WebRtcRdft_Inverse(rdft.get(), &actual[0]);
+    for (float& sample : actual) {
+      sample *= 2.f / length;
+    }
+    ExpectNear(signal, actual);
+  }
+}
+
+// false runs the generic fallback, true the SIMD backend of this CPU, if any.
+INSTANTIATE_TEST_CASE_P(Backends, RdftTest, ::testing::Bool());
+
+}  // namespace
+}  // namespace webrtc
@@ -14,6 +14,7 @@
 #include <complex>
 
 #include "webrtc/base/scoped_ptr.h"
+#include "webrtc/common_audio/rdft.h"
 #include "webrtc/common_audio/real_fourier.h"
 
 namespace webrtc {
@@ -33,10 +34,9 @@ class RealFourierOoura : public RealFourier {
   const int order_;
   const size_t length_;
   const size_t complex_length_;
-  // These are work arrays for Ooura. The names are based on the comments in
-  // fft4g.c.
-  const rtc::scoped_ptr<size_t[]> work_ip_;
-  const rtc::scoped_ptr<float[]> work_w_;
+  // Runs in Ooura's layout, on the radix-4 SIMD backend where the CPU and
+  // the length allow.
+  const rtc::scoped_ptr<WebRtcRdft, RdftDeleter> rdft_;
 };
 
 }  // namespace webrtc
@@ -15,6 +15,7 @@
 #include <utility>
 #include <vector>
 
+#include "webrtc/base/atomicops.h"
 #include "webrtc/base/checks.h"
 #include "webrtc/base/criticalsection.h"
 
@@ -205,6 +206,130 @@ class SwapQueue {
   RTC_DISALLOW_COPY_AND_ASSIGN(SwapQueue);
 };
 
+// Same as SwapQueue, but for exactly one producer and one consumer, and
+// without a lock: Insert() and Remove() are wait-free, so neither side can be
+// held up by the other being preempted in the middle of a call. The producer
+// side (Insert()) and the consumer side (Remove()) may each move between
+// threads, as long as the calls of one side never overlap, e.g. when they are
+// serialized by a lock of that side. Clear() must not overlap with either.
+//
+// Each side only touches its own index and the slot it points at; the shared
+// element count hands a slot over from one side to the other.
+template <typename T, typename QueueItemVerifier = SwapQueueItemVerifier<T>>
+class SpscSwapQueue {
+ public:
+  // Creates a queue of size size and fills it with default constructed Ts.
+  explicit SpscSwapQueue(size_t size) : queue_(size) {
+    RTC_DCHECK(VerifyQueueSlots());
+  }
+
+  // Same as above and accepts an item verification functor.
+  SpscSwapQueue(size_t size, const QueueItemVerifier& queue_item_verifier)
+      : queue_item_verifier_(queue_item_verifier), queue_(size) {
+    RTC_DCHECK(VerifyQueueSlots());
+  }
+
+  // Creates a queue of size size and fills it with copies of prototype.
+  SpscSwapQueue(size_t size, const T& prototype) : queue_(size, prototype) {
+    RTC_DCHECK(VerifyQueueSlots());
+  }
+
+  // Same as above and accepts an item verification functor.
+  SpscSwapQueue(size_t size,
+                const T& prototype,
+                const QueueItemVerifier& queue_item_verifier)
+      : queue_item_verifier_(queue_item_verifier), queue_(size, prototype) {
+    RTC_DCHECK(VerifyQueueSlots());
+  }
+
+  // Resets the queue to have zero content wile maintaining the queue size.
+  void Clear() {
+    next_write_index_ = 0;
+    next_read_index_ = 0;
+    rtc::AtomicOps::ReleaseStore(&num_elements_, 0);
+  }
+
+  // Same as SwapQueue::Insert(); producer side only.
+  bool Insert(T* input) WARN_UNUSED_RESULT {
+    RTC_DCHECK(input);
+    RTC_DCHECK(queue_item_verifier_(*input));
+
+    // The consumer only ever lowers the count, so a slot seen free stays free.
+    if (static_cast<size_t>(rtc::AtomicOps::AcquireLoad(&num_elements_)) ==
+        queue_.size()) {
+      return false;
+    }
+
+    using std::swap;
+    swap(*input, queue_[next_write_index_]);
+
+    ++next_write_index_;
+    if (next_write_index_ == queue_.size()) {
+      next_write_index_ = 0;
+    }
+
+    // Publishes the slot, the increment is a full barrier.
+    const int num_elements = rtc::AtomicOps::Increment(&num_elements_);
+
+    RTC_DCHECK_LT(next_write_index_, queue_.size());
+    RTC_DCHECK_LE(static_cast<size_t>(num_elements), queue_.size());
+
+    return true;
+  }
+
+  // Same as SwapQueue::Remove(); consumer side only.
+  bool Remove(T* output) WARN_UNUSED_RESULT {
+    RTC_DCHECK(output);
+    RTC_DCHECK(queue_item_verifier_(*output));
+
+    // The producer only ever raises the count, so a slot seen full stays full.
+    if (rtc::AtomicOps::AcquireLoad(&num_elements_) == 0) {
+      return false;
+    }
+
+    using std::swap;
+    swap(*output, queue_[next_read_index_]);
+
+    ++next_read_index_;
+    if (next_read_index_ == queue_.size()) {
+      next_read_index_ = 0;
+    }
+
+    // Hands the emptied slot back, the decrement is a full barrier.
+    const int num_elements = rtc::AtomicOps::Decrement(&num_elements_);
+
+    RTC_DCHECK_LT(next_read_index_, queue_.size());
+    RTC_DCHECK_GE(num_elements, 0);
+
+    return true;
+  }
+
+ private:
+  // Verify that the queue slots complies with the ItemVerifier test.
+  bool VerifyQueueSlots() {
+    for (const auto& v : queue_) {
+      RTC_DCHECK(queue_item_verifier_(v));
+    }
+    return true;
+  }
+
+  // TODO(peah): Change this to use std::function() once we can use C++11 std
+  // lib.
+  QueueItemVerifier queue_item_verifier_;
+
+  // Only touched by the producer.
+  size_t next_write_index_ = 0;
+  // Only touched by the consumer.
+  size_t next_read_index_ = 0;
+  // Number of full slots, the only state both sides touch.
+  volatile int num_elements_ = 0;
+
+  // queue_.size() is constant, each slot belongs to one side at a time.
+  std::vector<T> queue_;
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(SpscSwapQueue);
+};
+
 }  // namespace webrtc
 
 #endif  // WEBRTC_COMMON_AUDIO_SWAP_QUEUE_H_
@@ -13,6 +13,8 @@
 #include <vector>
 
 #include "testing/gtest/include/gtest/gtest.h"
+#include "webrtc/base/platform_thread.h"
+#include "webrtc/system_wrappers/include/sleep.h"
 
 namespace webrtc {
 
@@ -222,4 +224,133 @@ TEST(SwapQueueTest, OneSlotQueue) {
   EXPECT_FALSE(queue.Remove(&i));
 }
 
+TEST(SpscSwapQueueTest, FullAndEmptyQueue) {
+  SpscSwapQueue<int> queue(2);
+  int i = 0;
+  EXPECT_FALSE(queue.Remove(&i));
+  EXPECT_TRUE(queue.Insert(&i));
+  i = 1;
+  EXPECT_TRUE(queue.Insert(&i));
+
+  // Neither a full Insert() nor an empty Remove() swaps anything.
+  i = 2;
+  EXPECT_FALSE(queue.Insert(&i));
+  EXPECT_EQ(i, 2);
+  EXPECT_TRUE(queue.Remove(&i));
+  EXPECT_EQ(i, 0);
+  EXPECT_TRUE(queue.Remove(&i));
+  EXPECT_EQ(i, 1);
+  EXPECT_FALSE(queue.Remove(&i));
+  EXPECT_EQ(i, 1);
+}
+
+TEST(SpscSwapQueueTest, Clear) {
+  SpscSwapQueue<int> queue(2);
+  int i = 0;
+  EXPECT_TRUE(queue.Insert(&i));
+  EXPECT_TRUE(queue.Insert(&i));
+  EXPECT_FALSE(queue.Insert(&i));
+
+  queue.Clear();
+  EXPECT_FALSE(queue.Remove(&i));
+  EXPECT_TRUE(queue.Insert(&i));
+}
+
+TEST(SpscSwapQueueTest, ZeroSlotQueue) {
+  SpscSwapQueue<int> queue(0);
+  int i = 42;
+  EXPECT_FALSE(queue.Insert(&i));
+  EXPECT_FALSE(queue.Remove(&i));
+  EXPECT_EQ(i, 42);
+}
+
+TEST(SpscSwapQueueTest, SuccessfulItemVerifyFunctor) {
+  std::vector<int> template_element(kChunkSize);
+  LengthVerifierFunctor verifier(kChunkSize);
+  SpscSwapQueue<std::vector<int>, LengthVerifierFunctor> queue(
+      2, template_element, verifier);
+  std::vector<int> valid_chunk(kChunkSize, 0);
+
+  EXPECT_TRUE(queue.Insert(&valid_chunk));
+  EXPECT_EQ(valid_chunk.size(), kChunkSize);
+  EXPECT_TRUE(queue.Remove(&valid_chunk));
+  EXPECT_EQ(valid_chunk.size(), kChunkSize);
+}
+
+#if RTC_DCHECK_IS_ON && GTEST_HAS_DEATH_TEST && !defined(WEBRTC_ANDROID)
+TEST(SpscSwapQueueTest, UnSuccessfulItemVerifyInsert) {
+  std::vector<int> template_element(kChunkSize);
+  SpscSwapQueue<std::vector<int>,
+                SwapQueueItemVerifier<std::vector<int>, &LengthVerifierFunction>>
+      queue(2, template_element);
+  std::vector<int> invalid_chunk(kChunkSize - 1, 0);
+  bool result;
+  EXPECT_DEATH(result = queue.Insert(&invalid_chunk), "");
+}
+#endif
+
+// Frames of a running counter go through the queue from this thread to a
+// consumer thread, wrapping around the slots many times; every frame must
+// arrive once, in order and intact.
+namespace {
+const size_t kThreadTestQueueSize = 4;
+const size_t kFrameLength = 160;
+const int kNumFrames = 2000;
+}  // namespace
+
+class SpscSwapQueueThreadTest : public ::testing::Test {
+ protected:
+  SpscSwapQueueThreadTest()
+      : queue_(kThreadTestQueueSize, std::vector<int>(kFrameLength)),
+        consumer_buffer_(kFrameLength),
+        consumer_thread_(&ConsumerThreadFunc, this, "consumer") {}
+
+  static bool ConsumerThreadFunc(void* context) {
+    return static_cast<SpscSwapQueueThreadTest*>(context)->Consume();
+  }
+
+  // Spins on the queue until all frames are in, in one call of the thread.
+  bool Consume() {
+    while (num_frames_received_ < kNumFrames) {
+      if (!queue_.Remove(&consumer_buffer_)) {
+        // Let the producer run on single core machines.
+        SleepMs(0);
+        continue;
+      }
+      for (size_t k = 0; k < kFrameLength; ++k) {
+        if (consumer_buffer_[k] !=
+            static_cast<int>(num_frames_received_ * kFrameLength + k)) {
+          ++num_errors_;
+          break;
+        }
+      }
+      ++num_frames_received_;
+    }
+    return false;
+  }
+
+  SpscSwapQueue<std::vector<int>> queue_;
+  std::vector<int> consumer_buffer_;
+  int num_frames_received_ = 0;
+  int num_errors_ = 0;
+  rtc::PlatformThread consumer_thread_;
+};
+
+TEST_F(SpscSwapQueueThreadTest, ConcurrentInsertAndRemove) {
+  std::vector<int> producer_buffer(kFrameLength);
+  consumer_thread_.Start();
+  for (int n = 0; n < kNumFrames; ++n) {
+    for (size_t k = 0; k < kFrameLength; ++k) {
+      producer_buffer[k] = static_cast<int>(n * kFrameLength + k);
+    }
+    while (!queue_.Insert(&producer_buffer)) {
+      SleepMs(0);
+    }
+  }
+  consumer_thread_.Stop();
+
+  EXPECT_EQ(kNumFrames, num_frames_received_);
+  EXPECT_EQ(0, num_errors_);
+}
+
 }  // namespace webrtc
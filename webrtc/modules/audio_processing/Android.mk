@@ -25,13 +25,20 @@ LOCAL_SRC_FILES := \
     gain_control_impl.cc \
     high_pass_filter_impl.cc \
     level_estimator_impl.cc \
+    logging/aec_trace.cc \
     noise_suppression_impl.cc \
     rms_level.cc \
     splitting_filter.cc \
+    submodule_profiler.cc \
     three_band_filter_bank.cc \
     processing_component.cc \
     voice_detection_impl.cc
 
+ifeq ($(TARGET_ARCH),$(filter $(TARGET_ARCH),x86 x86_64))
+LOCAL_SRC_FILES += \
+    three_band_filter_bank_sse2.cc
+endif
+
 # Flags passed to both C and C++ files.
 LOCAL_CFLAGS := \
     $(MY_WEBRTC_COMMON_DEFS) \
@@ -72,6 +79,86 @@ endif
 
 include $(BUILD_STATIC_LIBRARY)
 
+#########################
+# Build the AVX2 filter bank and beamformer kernels, picked at runtime over the
+# SSE2 ones.
+ifneq (,$(filter x86 x86_64,$(TARGET_ARCH)))
+
+include $(CLEAR_VARS)
+
+include $(LOCAL_PATH)/../../../android-webrtc.mk
+
+LOCAL_MODULE_CLASS := STATIC_LIBRARIES
+LOCAL_MODULE := libwebrtc_apm_avx2
+LOCAL_MODULE_TAGS := optional
+LOCAL_CPP_EXTENSION := .cc
+LOCAL_SRC_FILES := \
+    beamformer/bin_quadratic_forms_avx2.cc \
+    three_band_filter_bank_avx2.cc
+
+# Flags passed to both C and C++ files.
+LOCAL_CFLAGS := \
+    $(MY_WEBRTC_COMMON_DEFS) \
+    -mavx2 \
+    -mfma \
+    -std=c++11
+
+LOCAL_CFLAGS_x86 := $(MY_WEBRTC_COMMON_DEFS_x86)
+LOCAL_CFLAGS_x86_64 := $(MY_WEBRTC_COMMON_DEFS_x86_64)
+
+LOCAL_C_INCLUDES := \
+    $(LOCAL_PATH)/../../..
+
+ifdef WEBRTC_STL
+LOCAL_NDK_STL_VARIANT := $(WEBRTC_STL)
+LOCAL_SDK_VERSION := 14
+LOCAL_MODULE := $(LOCAL_MODULE)_$(WEBRTC_STL)
+endif
+
+include $(BUILD_STATIC_LIBRARY)
+
+endif # x86 or x86_64
+
+#########################
+# Build the neon filter bank and beamformer kernels.
+ifeq ($(WEBRTC_BUILD_NEON_LIBS),true)
+
+include $(CLEAR_VARS)
+
+include $(LOCAL_PATH)/../../../android-webrtc.mk
+
+LOCAL_ARM_MODE := arm
+LOCAL_MODULE_CLASS := STATIC_LIBRARIES
+LOCAL_MODULE := libwebrtc_apm_neon
+LOCAL_MODULE_TAGS := optional
+LOCAL_CPP_EXTENSION := .cc
+LOCAL_SRC_FILES := \
+    beamformer/bin_quadratic_forms_neon.cc \
+    three_band_filter_bank_neon.cc \
+    transient/wpd_node_neon.cc
+
+# Flags passed to both C and C++ files.
+LOCAL_CFLAGS := \
+    $(MY_WEBRTC_COMMON_DEFS) \
+    -flax-vector-conversions \
+    -std=c++11
+
+LOCAL_MODULE_TARGET_ARCH := arm
+LOCAL_CFLAGS_arm := $(MY_WEBRTC_COMMON_DEFS_arm)
+
+LOCAL_C_INCLUDES := \
+    $(LOCAL_PATH)/../../..
+
+ifdef WEBRTC_STL
+LOCAL_NDK_STL_VARIANT := $(WEBRTC_STL)
+LOCAL_SDK_VERSION := 14
+LOCAL_MODULE := $(LOCAL_MODULE)_$(WEBRTC_STL)
+endif
+
+include $(BUILD_STATIC_LIBRARY)
+
+endif # ifeq ($(WEBRTC_BUILD_NEON_LIBS),true)
+
 # apm process test app
 
 include $(CLEAR_VARS)
@@ -54,3 +54,41 @@ LOCAL_MODULE := $(LOCAL_MODULE)_$(WEBRTC_STL)
 endif
 
 include $(BUILD_STATIC_LIBRARY)
+
+#########################
+# Build the AVX2/FMA kernels, picked at runtime over the SSE2 ones.
+ifneq (,$(filter x86 x86_64,$(TARGET_ARCH)))
+
+include $(CLEAR_VARS)
+
+include $(LOCAL_PATH)/../../../../android-webrtc.mk
+
+LOCAL_MODULE_CLASS := STATIC_LIBRARIES
+LOCAL_MODULE := libwebrtc_aec_avx2
+LOCAL_MODULE_TAGS := optional
+LOCAL_SRC_FILES := aec_core_avx2.c
+
+# Flags passed to both C and C++ files.
+LOCAL_CFLAGS := \
+    $(MY_WEBRTC_COMMON_DEFS) \
+    -mavx2 \
+    -mfma
+
+LOCAL_CFLAGS_x86 := $(MY_WEBRTC_COMMON_DEFS_x86)
+LOCAL_CFLAGS_x86_64 := $(MY_WEBRTC_COMMON_DEFS_x86_64)
+
+LOCAL_C_INCLUDES := \
+    $(LOCAL_PATH)/include \
+    $(LOCAL_PATH)/../utility \
+    $(LOCAL_PATH)/../../../.. \
+    $(LOCAL_PATH)/../../../common_audio/signal_processing/include
+
+ifdef WEBRTC_STL
+LOCAL_NDK_STL_VARIANT := $(WEBRTC_STL)
+LOCAL_SDK_VERSION := 14
+LOCAL_MODULE := $(LOCAL_MODULE)_$(WEBRTC_STL)
+endif
+
+include $(BUILD_STATIC_LIBRARY)
+
+endif # x86 or x86_64
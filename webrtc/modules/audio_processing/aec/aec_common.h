@@ -21,6 +21,14 @@
 #define ALIGN16_END __attribute__((aligned(16)))
 #endif
 
+#ifdef _MSC_VER /* visual c++ */
+#define ALIGN32_BEG __declspec(align(32))
+#define ALIGN32_END
+#else /* gcc or icc */
+#define ALIGN32_BEG
+#define ALIGN32_END __attribute__((aligned(32)))
+#endif
+
 extern ALIGN16_BEG const float ALIGN16_END WebRtcAec_sqrtHanning[65];
 extern ALIGN16_BEG const float ALIGN16_END WebRtcAec_weightCurve[65];
 extern ALIGN16_BEG const float ALIGN16_END WebRtcAec_overDriveCurve[65];
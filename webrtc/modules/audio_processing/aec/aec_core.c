@@ -156,18 +156,14 @@ static int CmpFloat(const void* a, const void* b) {
 static void FilterFar(
     int num_partitions,
     int x_fft_buf_block_pos,
-    float x_fft_buf[2][kExtendedNumPartitions * PART_LEN1],
-    float h_fft_buf[2][kExtendedNumPartitions * PART_LEN1],
+    float x_fft_buf[2][2 * kExtendedNumPartitions * PART_LEN1_PADDED],
+    float h_fft_buf[2][kExtendedNumPartitions * PART_LEN1_PADDED],
     float y_fft[2][PART_LEN1]) {
   int i;
   for (i = 0; i < num_partitions; i++) {
     int j;
-    int xPos = (i + x_fft_buf_block_pos) * PART_LEN1;
-    int pos = i * PART_LEN1;
-    // Check for wrap
-    if (i + x_fft_buf_block_pos >= num_partitions) {
-      xPos -= num_partitions * (PART_LEN1);
-    }
+    int xPos = (i + x_fft_buf_block_pos) * PART_LEN1_PADDED;
+    int pos = i * PART_LEN1_PADDED;
 
     for (j = 0; j < PART_LEN1; j++) {
       y_fft[0][j] += MulRe(x_fft_buf[0][xPos + j],
@@ -214,20 +210,16 @@ static void ScaleErrorSignal(int extended_filter_enabled,
 static void FilterAdaptation(
     int num_partitions,
     int x_fft_buf_block_pos,
-    float x_fft_buf[2][kExtendedNumPartitions * PART_LEN1],
+    float x_fft_buf[2][2 * kExtendedNumPartitions * PART_LEN1_PADDED],
     float e_fft[2][PART_LEN1],
-    float h_fft_buf[2][kExtendedNumPartitions * PART_LEN1]) {
+    float h_fft_buf[2][kExtendedNumPartitions * PART_LEN1_PADDED]) {
   int i, j;
   float fft[PART_LEN2];
   for (i = 0; i < num_partitions; i++) {
-    int xPos = (i + x_fft_buf_block_pos) * (PART_LEN1);
+    int xPos = (i + x_fft_buf_block_pos) * PART_LEN1_PADDED;
     int pos;
-    // Check for wrap
-    if (i + x_fft_buf_block_pos >= num_partitions) {
-      xPos -= num_partitions * PART_LEN1;
-    }
 
-    pos = i * PART_LEN1;
+    pos = i * PART_LEN1_PADDED;
 
     for (j = 0; j < PART_LEN; j++) {
 
@@ -301,7 +293,7 @@ static int PartitionDelay(const AecCore* aec) {
 
   for (i = 0; i < aec->num_partitions; i++) {
     int j;
-    int pos = i * PART_LEN1;
+    int pos = i * PART_LEN1_PADDED;
     float wfEn = 0;
     for (j = 0; j < PART_LEN1; j++) {
       wfEn += aec->wfBuf[0][pos + j] * aec->wfBuf[0][pos + j] +
@@ -927,10 +919,10 @@ static void EchoSubtraction(
     int extended_filter_enabled,
     float normal_mu,
     float normal_error_threshold,
-    float x_fft_buf[2][kExtendedNumPartitions * PART_LEN1],
+    float x_fft_buf[2][2 * kExtendedNumPartitions * PART_LEN1_PADDED],
     float* const y,
     float x_pow[PART_LEN1],
-    float h_fft_buf[2][kExtendedNumPartitions * PART_LEN1],
+    float h_fft_buf[2][kExtendedNumPartitions * PART_LEN1_PADDED],
     PowerLevel* linout_level,
     float echo_subtractor_output[PART_LEN]) {
   float s_fft[2][PART_LEN1];
@@ -1135,6 +1127,7 @@ static void EchoSuppression(AecCore* aec,
       hNlFbLow = hNlPref[(int)floor(prefBandQuantLow * (prefBandSize - 1))];
     }
   }
+  aec->nlp_gain = hNlFb;
 
   // Track the local filter minimum to determine suppression overdrive.
   if (hNlFbLow < 0.6f && hNlFbLow < aec->hNlFbLocalMin) {
@@ -1241,6 +1234,53 @@ static void EchoSuppression(AecCore* aec,
           sizeof(aec->xfwBuf) - sizeof(complex_t) * PART_LEN1);
 }
 
+// Adds the state of the core after the block to its trace.
+static void TraceBlock(AecCore* aec,
+                       const float* nearend,
+                       const float* echo_subtractor_output) {
+  AecTraceRecord record;
+  float near_energy = 0;
+  float error_energy = 0;
+  int i;
+
+  // The filter energy takes a pass over the whole filter, so it is only
+  // refreshed when the partition delay is.
+  if (aec->delayEstCtr == 0 || aec->trace_filter_energy < 0) {
+    aec->trace_filter_energy = 0;
+    for (i = 0; i < aec->num_partitions; i++) {
+      const int pos = i * PART_LEN1_PADDED;
+      int j;
+      for (j = 0; j < PART_LEN1; j++) {
+        aec->trace_filter_energy +=
+            aec->wfBuf[0][pos + j] * aec->wfBuf[0][pos + j] +
+            aec->wfBuf[1][pos + j] * aec->wfBuf[1][pos + j];
+      }
+    }
+  }
+  for (i = 0; i < PART_LEN; i++) {
+    near_energy += nearend[i] * nearend[i];
+    error_energy += echo_subtractor_output[i] * echo_subtractor_output[i];
+  }
+
+  record.instance = aec->trace_instance;
+  record.block = aec->trace_block;
+  record.sample_rate_hz = aec->sampFreq;
+  record.system_delay = aec->system_delay;
+  record.known_delay = aec->knownDelay;
+  record.filter_delay = aec->delayIdx;
+  record.filter_energy = aec->trace_filter_energy;
+  // Offset by one, as the signals are on the 16 bit scale.
+  record.erle_db =
+      10.0f * log10f((near_energy + 1.0f) / (error_energy + 1.0f));
+  record.nlp_gain = aec->nlp_gain;
+  record.nlp_gain_min = aec->hNlFbMin;
+  record.overdrive = aec->overDriveSm;
+  record.echo_state = aec->echoState;
+  record.near_state = aec->stNearState;
+  record.diverge_state = aec->divergeState;
+  WebRtcAecTrace_Add(aec->trace, &record);
+}
+
 static void ProcessBlock(AecCore* aec) {
   size_t i;
 
@@ -1370,19 +1410,21 @@ static void ProcessBlock(AecCore* aec) {
     }
   }
 
-  // Update the xfBuf block position.
+  // Update the xfBuf block position. The buffer always cycles through the
+  // extended number of partitions, so switching the filter length keeps the
+  // partitions in order.
   aec->xfBufBlockPos--;
   if (aec->xfBufBlockPos == -1) {
-    aec->xfBufBlockPos = aec->num_partitions - 1;
+    aec->xfBufBlockPos = kExtendedNumPartitions - 1;
   }
 
-  // Buffer xf
-  memcpy(aec->xfBuf[0] + aec->xfBufBlockPos * PART_LEN1,
-         xf_ptr,
-         sizeof(float) * PART_LEN1);
-  memcpy(aec->xfBuf[1] + aec->xfBufBlockPos * PART_LEN1,
-         &xf_ptr[PART_LEN1],
-         sizeof(float) * PART_LEN1);
+  // Buffer xf, in both copies of the partition.
+  for (i = 0; i < 2; i++) {
+    const size_t pos =
+        (aec->xfBufBlockPos + i * kExtendedNumPartitions) * PART_LEN1_PADDED;
+    memcpy(aec->xfBuf[0] + pos, xf_ptr, sizeof(float) * PART_LEN1);
+    memcpy(aec->xfBuf[1] + pos, &xf_ptr[PART_LEN1], sizeof(float) * PART_LEN1);
+  }
 
   // Perform echo subtraction.
   EchoSubtraction(aec,
@@ -1419,14 +1461,24 @@ static void ProcessBlock(AecCore* aec) {
   }
 
   RTC_AEC_DEBUG_WAV_WRITE(aec->outFile, output, PART_LEN);
+
+  if (aec->trace) {
+    TraceBlock(aec, nearend_ptr, echo_subtractor_output);
+  }
+  aec->trace_block++;
 }
 
 AecCore* WebRtcAec_CreateAec() {
   int i;
-  AecCore* aec = malloc(sizeof(AecCore));
-  if (!aec) {
+  // malloc() does not guarantee the 32-byte alignment of the fft buffers.
+  void* mem_block = malloc(sizeof(AecCore) + 31);
+  AecCore* aec;
+  if (!mem_block) {
     return NULL;
   }
+  aec = (AecCore*)(((uintptr_t)mem_block + 31) & ~(uintptr_t)31);
+  aec->mem_block = mem_block;
+  aec->trace = NULL;
 
   aec->nearFrBuf = WebRtc_CreateBuffer(FRAME_LEN + PART_LEN, sizeof(float));
   if (!aec->nearFrBuf) {
@@ -1489,12 +1541,8 @@ AecCore* WebRtcAec_CreateAec() {
   }
 #ifdef WEBRTC_ANDROID
   aec->delay_agnostic_enabled = 1;  // DA-AEC enabled by default.
-  // DA-AEC assumes the system is causal from the beginning and will self adjust
-  // the lookahead when shifting is required.
-  WebRtc_set_lookahead(aec->delay_estimator, 0);
 #else
   aec->delay_agnostic_enabled = 0;
-  WebRtc_set_lookahead(aec->delay_estimator, kLookaheadBlocks);
 #endif
   aec->extended_filter_enabled = 0;
 
@@ -1513,6 +1561,9 @@ AecCore* WebRtcAec_CreateAec() {
 #if defined(WEBRTC_ARCH_X86_FAMILY)
   if (WebRtc_GetCPUInfo(kSSE2)) {
     WebRtcAec_InitAec_SSE2();
+    if (WebRtc_GetCPUInfo(kAVX2) && WebRtc_GetCPUInfo(kFMA3)) {
+      WebRtcAec_InitAec_AVX2();
+    }
   }
 #endif
 
@@ -1558,7 +1609,7 @@ void WebRtcAec_FreeAec(AecCore* aec) {
   WebRtc_FreeDelayEstimator(aec->delay_estimator);
   WebRtc_FreeDelayEstimatorFarend(aec->delay_estimator_farend);
 
-  free(aec);
+  free(aec->mem_block);
 }
 
 int WebRtcAec_InitAec(AecCore* aec, int sampFreq) {
@@ -1617,6 +1668,16 @@ int WebRtcAec_InitAec(AecCore* aec, int sampFreq) {
   if (WebRtc_InitDelayEstimator(aec->delay_estimator) != 0) {
     return -1;
   }
+  // The signal based delay correction moves the lookahead, so set it here
+  // rather than at create to have a re-initialized instance start like a new
+  // one.
+#ifdef WEBRTC_ANDROID
+  // DA-AEC assumes the system is causal from the beginning and will self adjust
+  // the lookahead when shifting is required.
+  WebRtc_set_lookahead(aec->delay_estimator, 0);
+#else
+  WebRtc_set_lookahead(aec->delay_estimator, kLookaheadBlocks);
+#endif
   aec->delay_logging_enabled = 0;
   aec->delay_metrics_delivered = 0;
   memset(aec->delay_histogram, 0, sizeof(aec->delay_histogram));
@@ -1685,10 +1746,11 @@ int WebRtcAec_InitAec(AecCore* aec, int sampFreq) {
 
   // Holds the last block written to
   aec->xfBufBlockPos = 0;
+  // The kernels also run over the padding bins, they must stay zero.
+  memset(aec->xfBuf, 0, sizeof(aec->xfBuf));
+  memset(aec->wfBuf, 0, sizeof(aec->wfBuf));
   // TODO: Investigate need for these initializations. Deleting them doesn't
   //       change the output at all and yields 0.4% overall speedup.
-  memset(aec->xfBuf, 0, sizeof(complex_t) * kExtendedNumPartitions * PART_LEN1);
-  memset(aec->wfBuf, 0, sizeof(complex_t) * kExtendedNumPartitions * PART_LEN1);
   memset(aec->sde, 0, sizeof(complex_t) * PART_LEN1);
   memset(aec->sxd, 0, sizeof(complex_t) * PART_LEN1);
   memset(
@@ -1723,6 +1785,10 @@ int WebRtcAec_InitAec(AecCore* aec, int sampFreq) {
 
   aec->extreme_filter_divergence = 0;
 
+  aec->trace_block = 0;
+  aec->trace_filter_energy = -1;
+  aec->nlp_gain = 1;
+
   // Metrics disabled by default
   aec->metricsMode = 0;
   InitMetrics(aec);
@@ -1948,3 +2014,9 @@ void WebRtcAec_SetSystemDelay(AecCore* self, int delay) {
   assert(delay >= 0);
   self->system_delay = delay;
 }
+
+void WebRtcAec_SetTrace(AecCore* self, struct AecTrace* trace, int instance) {
+  self->trace = trace;
+  self->trace_instance = instance;
+  self->trace_filter_energy = -1;
+}
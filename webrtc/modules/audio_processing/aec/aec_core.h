@@ -52,11 +52,13 @@ typedef struct Stats {
 } Stats;
 
 typedef struct AecCore AecCore;
+struct AecTrace;
 
 AecCore* WebRtcAec_CreateAec();  // Returns NULL on error.
 void WebRtcAec_FreeAec(AecCore* aec);
 int WebRtcAec_InitAec(AecCore* aec, int sampFreq);
 void WebRtcAec_InitAec_SSE2(void);
+void WebRtcAec_InitAec_AVX2(void);
 #if defined(MIPS_FPU_LE)
 void WebRtcAec_InitAec_mips(void);
 #endif
@@ -126,4 +128,9 @@ int WebRtcAec_system_delay(AecCore* self);
 // care.
 void WebRtcAec_SetSystemDelay(AecCore* self, int delay);
 
+// Attaches |trace|, see logging/aec_trace.h, to which the core then adds a
+// record per block tagged with |instance|. NULL detaches it. Must not overlap
+// with WebRtcAec_ProcessFrames().
+void WebRtcAec_SetTrace(AecCore* self, struct AecTrace* trace, int instance);
+
 #endif  // WEBRTC_MODULES_AUDIO_PROCESSING_AEC_AEC_CORE_H_
@@ -0,0 +1,357 @@
+/*
+ *  Copyright (c) 2016 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+/*
+ * The core AEC algorithm, AVX2/FMA version of the speed-critical functions
+ * that sweep the filter partitions. Same algorithms as the SSE2 version,
+ * eight bins at once; the fused multiply-adds round once instead of twice,
+ * so results differ from SSE2 in the last bits.
+ */
+
+#include <immintrin.h>
+#include <math.h>
+#include <string.h>  // memset
+
+#include "webrtc/modules/audio_processing/aec/aec_common.h"
+#include "webrtc/modules/audio_processing/aec/aec_core_internal.h"
+#include "webrtc/modules/audio_processing/aec/aec_rdft.h"
+
+__inline static float MulRe(float aRe, float aIm, float bRe, float bIm) {
+  return aRe * bRe - aIm * bIm;
+}
+
+static void FilterFarAVX2(
+    int num_partitions,
+    int x_fft_buf_block_pos,
+    float x_fft_buf[2][2 * kExtendedNumPartitions * PART_LEN1_PADDED],
+    float h_fft_buf[2][kExtendedNumPartitions * PART_LEN1_PADDED],
+    float y_fft[2][PART_LEN1]) {
+  int j;
+  // As in FilterFarSSE2(), the bins are accumulated in registers and only the
+  // first bin of the last vector is backed by y_fft.
+  for (j = 0; j < PART_LEN1; j += 8) {
+    const int last = j + 8 > PART_LEN1;
+    __m256 y_fft_re =
+        last ? _mm256_setr_ps(y_fft[0][j], 0.f, 0.f, 0.f, 0.f, 0.f, 0.f, 0.f)
+             : _mm256_loadu_ps(&y_fft[0][j]);
+    __m256 y_fft_im =
+        last ? _mm256_setr_ps(y_fft[1][j], 0.f, 0.f, 0.f, 0.f, 0.f, 0.f, 0.f)
+             : _mm256_loadu_ps(&y_fft[1][j]);
+    int i;
+    for (i = 0; i < num_partitions; i++) {
+      const int xPos = (i + x_fft_buf_block_pos) * PART_LEN1_PADDED + j;
+      const int pos = i * PART_LEN1_PADDED + j;
+      const __m256 x_fft_buf_re = _mm256_loadu_ps(&x_fft_buf[0][xPos]);
+      const __m256 x_fft_buf_im = _mm256_loadu_ps(&x_fft_buf[1][xPos]);
+      const __m256 h_fft_buf_re = _mm256_loadu_ps(&h_fft_buf[0][pos]);
+      const __m256 h_fft_buf_im = _mm256_loadu_ps(&h_fft_buf[1][pos]);
+      y_fft_re = _mm256_fmadd_ps(x_fft_buf_re, h_fft_buf_re, y_fft_re);
+      y_fft_re = _mm256_fnmadd_ps(x_fft_buf_im, h_fft_buf_im, y_fft_re);
+      y_fft_im = _mm256_fmadd_ps(x_fft_buf_re, h_fft_buf_im, y_fft_im);
+      y_fft_im = _mm256_fmadd_ps(x_fft_buf_im, h_fft_buf_re, y_fft_im);
+    }
+    if (last) {
+      _mm_store_ss(&y_fft[0][j], _mm256_castps256_ps128(y_fft_re));
+      _mm_store_ss(&y_fft[1][j], _mm256_castps256_ps128(y_fft_im));
+    } else {
+      _mm256_storeu_ps(&y_fft[0][j], y_fft_re);
+      _mm256_storeu_ps(&y_fft[1][j], y_fft_im);
+    }
+  }
+}
+
+static void ScaleErrorSignalAVX2(int extended_filter_enabled,
+                                 float normal_mu,
+                                 float normal_error_threshold,
+                                 float x_pow[PART_LEN1],
+                                 float ef[2][PART_LEN1]) {
+  const __m256 k1e_10f = _mm256_set1_ps(1e-10f);
+  const __m256 kMu = extended_filter_enabled ? _mm256_set1_ps(kExtendedMu)
+      : _mm256_set1_ps(normal_mu);
+  const __m256 kThresh = extended_filter_enabled
+                             ? _mm256_set1_ps(kExtendedErrorThreshold)
+                             : _mm256_set1_ps(normal_error_threshold);
+
+  int i;
+  // vectorized code (eight at once)
+  for (i = 0; i + 7 < PART_LEN1; i += 8) {
+    const __m256 x_pow_local = _mm256_loadu_ps(&x_pow[i]);
+    const __m256 ef_re_base = _mm256_loadu_ps(&ef[0][i]);
+    const __m256 ef_im_base = _mm256_loadu_ps(&ef[1][i]);
+
+    const __m256 xPowPlus = _mm256_add_ps(x_pow_local, k1e_10f);
+    __m256 ef_re = _mm256_div_ps(ef_re_base, xPowPlus);
+    __m256 ef_im = _mm256_div_ps(ef_im_base, xPowPlus);
+    const __m256 ef_sum2 =
+        _mm256_fmadd_ps(ef_im, ef_im, _mm256_mul_ps(ef_re, ef_re));
+    const __m256 absEf = _mm256_sqrt_ps(ef_sum2);
+    const __m256 bigger = _mm256_cmp_ps(absEf, kThresh, _CMP_GT_OQ);
+    const __m256 absEfPlus = _mm256_add_ps(absEf, k1e_10f);
+    const __m256 absEfInv = _mm256_div_ps(kThresh, absEfPlus);
+    ef_re = _mm256_blendv_ps(ef_re, _mm256_mul_ps(ef_re, absEfInv), bigger);
+    ef_im = _mm256_blendv_ps(ef_im, _mm256_mul_ps(ef_im, absEfInv), bigger);
+    ef_re = _mm256_mul_ps(ef_re, kMu);
+    ef_im = _mm256_mul_ps(ef_im, kMu);
+
+    _mm256_storeu_ps(&ef[0][i], ef_re);
+    _mm256_storeu_ps(&ef[1][i], ef_im);
+  }
+  // scalar code for the remaining items.
+  {
+    const float mu =
+        extended_filter_enabled ? kExtendedMu : normal_mu;
+    const float error_threshold = extended_filter_enabled
+                                      ? kExtendedErrorThreshold
+                                      : normal_error_threshold;
+    for (; i < (PART_LEN1); i++) {
+      float abs_ef;
+      ef[0][i] /= (x_pow[i] + 1e-10f);
+      ef[1][i] /= (x_pow[i] + 1e-10f);
+      abs_ef = sqrtf(ef[0][i] * ef[0][i] + ef[1][i] * ef[1][i]);
+
+      if (abs_ef > error_threshold) {
+        abs_ef = error_threshold / (abs_ef + 1e-10f);
+        ef[0][i] *= abs_ef;
+        ef[1][i] *= abs_ef;
+      }
+
+      // Stepsize factor
+      ef[0][i] *= mu;
+      ef[1][i] *= mu;
+    }
+  }
+}
+
+static void FilterAdaptationAVX2(
+    int num_partitions,
+    int x_fft_buf_block_pos,
+    float x_fft_buf[2][2 * kExtendedNumPartitions * PART_LEN1_PADDED],
+    float e_fft[2][PART_LEN1],
+    float h_fft_buf[2][kExtendedNumPartitions * PART_LEN1_PADDED]) {
+  float fft[PART_LEN2];
+  int i, j;
+  for (i = 0; i < num_partitions; i++) {
+    int xPos = (i + x_fft_buf_block_pos) * PART_LEN1_PADDED;
+    int pos = i * PART_LEN1_PADDED;
+
+    // Process the whole array...
+    for (j = 0; j < PART_LEN; j += 8) {
+      // Load x_fft_buf and e_fft.
+      const __m256 x_fft_buf_re = _mm256_loadu_ps(&x_fft_buf[0][xPos + j]);
+      const __m256 x_fft_buf_im = _mm256_loadu_ps(&x_fft_buf[1][xPos + j]);
+      const __m256 e_fft_re = _mm256_loadu_ps(&e_fft[0][j]);
+      const __m256 e_fft_im = _mm256_loadu_ps(&e_fft[1][j]);
+      // Calculate the product of conjugate(x_fft_buf) by e_fft.
+      //   re(conjugate(a) * b) = aRe * bRe + aIm * bIm
+      //   im(conjugate(a) * b)=  aRe * bIm - aIm * bRe
+      const __m256 e = _mm256_fmadd_ps(x_fft_buf_re, e_fft_re,
+                                       _mm256_mul_ps(x_fft_buf_im, e_fft_im));
+      const __m256 f = _mm256_fmsub_ps(x_fft_buf_re, e_fft_im,
+                                       _mm256_mul_ps(x_fft_buf_im, e_fft_re));
+      // Interleave real and imaginary parts. unpack works per 128 bit lane,
+      // so the lanes are put back in order afterwards.
+      const __m256 g = _mm256_unpacklo_ps(e, f);  // 0 1 | 4 5
+      const __m256 h = _mm256_unpackhi_ps(e, f);  // 2 3 | 6 7
+      // Store
+      _mm256_storeu_ps(&fft[2 * j + 0], _mm256_permute2f128_ps(g, h, 0x20));
+      _mm256_storeu_ps(&fft[2 * j + 8], _mm256_permute2f128_ps(g, h, 0x31));
+    }
+    // ... and fixup the first imaginary entry.
+    fft[1] = MulRe(x_fft_buf[0][xPos + PART_LEN],
+                   -x_fft_buf[1][xPos + PART_LEN],
+                   e_fft[0][PART_LEN],
+                   e_fft[1][PART_LEN]);
+
+    aec_rdft_inverse_128(fft);
+    memset(fft + PART_LEN, 0, sizeof(float) * PART_LEN);
+
+    // fft scaling
+    {
+      const __m256 scale_ps = _mm256_set1_ps(2.0f / PART_LEN2);
+      for (j = 0; j < PART_LEN; j += 8) {
+        const __m256 fft_ps = _mm256_loadu_ps(&fft[j]);
+        _mm256_storeu_ps(&fft[j], _mm256_mul_ps(fft_ps, scale_ps));
+      }
+    }
+    aec_rdft_forward_128(fft);
+
+    {
+      float wt1 = h_fft_buf[1][pos];
+      h_fft_buf[0][pos + PART_LEN] += fft[1];
+      for (j = 0; j < PART_LEN; j += 8) {
+        __m256 wtBuf_re = _mm256_loadu_ps(&h_fft_buf[0][pos + j]);
+        __m256 wtBuf_im = _mm256_loadu_ps(&h_fft_buf[1][pos + j]);
+        const __m256 fft0 = _mm256_loadu_ps(&fft[2 * j + 0]);
+        const __m256 fft8 = _mm256_loadu_ps(&fft[2 * j + 8]);
+        // 0 1 4 5 | 2 3 6 7, the middle 64 bit pairs are swapped back.
+        const __m256 fft_re_l =
+            _mm256_shuffle_ps(fft0, fft8, _MM_SHUFFLE(2, 0, 2, 0));
+        const __m256 fft_im_l =
+            _mm256_shuffle_ps(fft0, fft8, _MM_SHUFFLE(3, 1, 3, 1));
+        const __m256 fft_re = _mm256_castpd_ps(_mm256_permute4x64_pd(
+            _mm256_castps_pd(fft_re_l), _MM_SHUFFLE(3, 1, 2, 0)));
+        const __m256 fft_im = _mm256_castpd_ps(_mm256_permute4x64_pd(
+            _mm256_castps_pd(fft_im_l), _MM_SHUFFLE(3, 1, 2, 0)));
+        wtBuf_re = _mm256_add_ps(wtBuf_re, fft_re);
+        wtBuf_im = _mm256_add_ps(wtBuf_im, fft_im);
+        _mm256_storeu_ps(&h_fft_buf[0][pos + j], wtBuf_re);
+        _mm256_storeu_ps(&h_fft_buf[1][pos + j], wtBuf_im);
+      }
+      h_fft_buf[1][pos] = wt1;
+    }
+  }
+}
+
+// a^b = exp2(b * log2(a)), with the same polynomial approximations as
+// mm_pow_ps in aec_core_sse2.c.
+static __m256 mm256_pow_ps(__m256 a, __m256 b) {
+  __m256 log2_a, b_log2_a, a_exp_b;
+
+  // Calculate log2(x), x = a, as log2(y) + n with x = y * 2^n, y in [1, 2).
+  {
+    const __m256 float_exponent_mask =
+        _mm256_castsi256_ps(_mm256_set1_epi32(0x7F800000));
+    const __m256 eight_biased_exponent =
+        _mm256_castsi256_ps(_mm256_set1_epi32(0x43800000));
+    const __m256 implicit_leading_one =
+        _mm256_castsi256_ps(_mm256_set1_epi32(0x43BF8000));
+    const __m256 mantissa_mask =
+        _mm256_castsi256_ps(_mm256_set1_epi32(0x007FFFFF));
+    const __m256 zero_biased_exponent_is_one =
+        _mm256_castsi256_ps(_mm256_set1_epi32(0x3F800000));
+    static const int shift_exponent_into_top_mantissa = 8;
+
+    // Compute n.
+    const __m256 two_n = _mm256_and_ps(a, float_exponent_mask);
+    const __m256 n_1 = _mm256_castsi256_ps(_mm256_srli_epi32(
+        _mm256_castps_si256(two_n), shift_exponent_into_top_mantissa));
+    const __m256 n_0 = _mm256_or_ps(n_1, eight_biased_exponent);
+    const __m256 n = _mm256_sub_ps(n_0, implicit_leading_one);
+
+    // Compute y.
+    const __m256 mantissa = _mm256_and_ps(a, mantissa_mask);
+    const __m256 y = _mm256_or_ps(mantissa, zero_biased_exponent_is_one);
+
+    // Approximate log2(y) ~= (y - 1) * pol5(y).
+    __m256 pol5_y = _mm256_set1_ps(-3.4436006e-2f);
+    pol5_y = _mm256_fmadd_ps(pol5_y, y, _mm256_set1_ps(3.1821337e-1f));
+    pol5_y = _mm256_fmadd_ps(pol5_y, y, _mm256_set1_ps(-1.2315303f));
+    pol5_y = _mm256_fmadd_ps(pol5_y, y, _mm256_set1_ps(2.5988452f));
+    pol5_y = _mm256_fmadd_ps(pol5_y, y, _mm256_set1_ps(-3.3241990f));
+    pol5_y = _mm256_fmadd_ps(pol5_y, y, _mm256_set1_ps(3.1157899f));
+
+    // Combine parts.
+    log2_a = _mm256_fmadd_ps(_mm256_sub_ps(y, zero_biased_exponent_is_one),
+                             pol5_y, n);
+  }
+
+  // b * log2(a)
+  b_log2_a = _mm256_mul_ps(b, log2_a);
+
+  // Calculate exp2(x), x = b * log2(a), as 2^n * 2^y with n the integer part
+  // of x - 0.5 and y in [0.5, 1.5).
+  {
+    static const int float_exponent_shift = 23;
+    // To avoid over/underflow, we reduce the range of input to ]-127, 129].
+    const __m256 x_min = _mm256_min_ps(b_log2_a, _mm256_set1_ps(129.f));
+    const __m256 x_max = _mm256_max_ps(x_min, _mm256_set1_ps(-126.99999f));
+    // Compute n.
+    const __m256 x_minus_half = _mm256_sub_ps(x_max, _mm256_set1_ps(0.5f));
+    const __m256i x_minus_half_floor = _mm256_cvtps_epi32(x_minus_half);
+    // Compute 2^n.
+    const __m256i two_n_exponent =
+        _mm256_add_epi32(x_minus_half_floor, _mm256_set1_epi32(127));
+    const __m256 two_n = _mm256_castsi256_ps(
+        _mm256_slli_epi32(two_n_exponent, float_exponent_shift));
+    // Compute y.
+    const __m256 y =
+        _mm256_sub_ps(x_max, _mm256_cvtepi32_ps(x_minus_half_floor));
+    // Approximate 2^y ~= C2 * y^2 + C1 * y + C0.
+    __m256 exp2_y = _mm256_set1_ps(3.3718944e-1f);
+    exp2_y = _mm256_fmadd_ps(exp2_y, y, _mm256_set1_ps(6.5763628e-1f));
+    exp2_y = _mm256_fmadd_ps(exp2_y, y, _mm256_set1_ps(1.0017247f));
+
+    // Combine parts.
+    a_exp_b = _mm256_mul_ps(exp2_y, two_n);
+  }
+  return a_exp_b;
+}
+
+static void OverdriveAndSuppressAVX2(AecCore* aec,
+                                     float hNl[PART_LEN1],
+                                     const float hNlFb,
+                                     float efw[2][PART_LEN1]) {
+  int i;
+  const __m256 vec_hNlFb = _mm256_set1_ps(hNlFb);
+  const __m256 vec_one = _mm256_set1_ps(1.0f);
+  const __m256 vec_minus_one = _mm256_set1_ps(-1.0f);
+  const __m256 vec_overDriveSm = _mm256_set1_ps(aec->overDriveSm);
+  // vectorized code (eight at once)
+  for (i = 0; i + 7 < PART_LEN1; i += 8) {
+    // Weight subbands
+    __m256 vec_hNl = _mm256_loadu_ps(&hNl[i]);
+    const __m256 vec_weightCurve = _mm256_loadu_ps(&WebRtcAec_weightCurve[i]);
+    const __m256 bigger = _mm256_cmp_ps(vec_hNl, vec_hNlFb, _CMP_GT_OQ);
+    const __m256 vec_one_weightCurve = _mm256_sub_ps(vec_one, vec_weightCurve);
+    const __m256 vec_weighted =
+        _mm256_fmadd_ps(vec_weightCurve, vec_hNlFb,
+                        _mm256_mul_ps(vec_one_weightCurve, vec_hNl));
+    vec_hNl = _mm256_blendv_ps(vec_hNl, vec_weighted, bigger);
+
+    {
+      const __m256 vec_overDriveCurve =
+          _mm256_loadu_ps(&WebRtcAec_overDriveCurve[i]);
+      const __m256 vec_overDriveSm_overDriveCurve =
+          _mm256_mul_ps(vec_overDriveSm, vec_overDriveCurve);
+      vec_hNl = mm256_pow_ps(vec_hNl, vec_overDriveSm_overDriveCurve);
+      _mm256_storeu_ps(&hNl[i], vec_hNl);
+    }
+
+    // Suppress error signal
+    {
+      __m256 vec_efw_re = _mm256_loadu_ps(&efw[0][i]);
+      __m256 vec_efw_im = _mm256_loadu_ps(&efw[1][i]);
+      vec_efw_re = _mm256_mul_ps(vec_efw_re, vec_hNl);
+      vec_efw_im = _mm256_mul_ps(vec_efw_im, vec_hNl);
+
+      // Ooura fft returns incorrect sign on imaginary component. It matters
+      // here because we are making an additive change with comfort noise.
+      vec_efw_im = _mm256_mul_ps(vec_efw_im, vec_minus_one);
+      _mm256_storeu_ps(&efw[0][i], vec_efw_re);
+      _mm256_storeu_ps(&efw[1][i], vec_efw_im);
+    }
+  }
+  // scalar code for the remaining items.
+  for (; i < PART_LEN1; i++) {
+    // Weight subbands
+    if (hNl[i] > hNlFb) {
+      hNl[i] = WebRtcAec_weightCurve[i] * hNlFb +
+               (1 - WebRtcAec_weightCurve[i]) * hNl[i];
+    }
+    hNl[i] = powf(hNl[i], aec->overDriveSm * WebRtcAec_overDriveCurve[i]);
+
+    // Suppress error signal
+    efw[0][i] *= hNl[i];
+    efw[1][i] *= hNl[i];
+
+    // Ooura fft returns incorrect sign on imaginary component. It matters
+    // here because we are making an additive change with comfort noise.
+    efw[1][i] *= -1;
+  }
+}
+
+// Called after WebRtcAec_InitAec_SSE2, the kernels not listed here keep
+// their SSE2 versions.
+void WebRtcAec_InitAec_AVX2(void) {
+  WebRtcAec_FilterFar = FilterFarAVX2;
+  WebRtcAec_ScaleErrorSignal = ScaleErrorSignalAVX2;
+  WebRtcAec_FilterAdaptation = FilterAdaptationAVX2;
+  WebRtcAec_OverdriveAndSuppress = OverdriveAndSuppressAVX2;
+}
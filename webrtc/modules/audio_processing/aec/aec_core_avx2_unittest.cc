@@ -0,0 +1,215 @@
+/*
+ *  Copyright (c) 2016 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include <random>
+
+extern "C" {
+#include "webrtc/modules/audio_processing/aec/aec_core.h"
+#include "webrtc/modules/audio_processing/aec/aec_core_internal.h"
+}
+#include "testing/gtest/include/gtest/gtest.h"
+#include "webrtc/system_wrappers/include/cpu_features_wrapper.h"
+
+namespace webrtc {
+namespace {
+
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+
+// The AVX2 kernels fuse multiplies and adds, so they only match the SSE2
+// ones to within rounding, relative to the largest value of the output.
+const float kTolerance = 1e-5f;
+// Both pow() approximations are only good to about 0.2%, and the large
+// overdrive exponents stretch their rounding differences further.
+const float kPowTolerance = 1e-4f;
+
+WebRtc_CPUInfo g_cpu_info = NULL;
+
+int CPUInfoWithoutAVX2(CPUFeature feature) {
+  return (feature == kAVX2 || feature == kFMA3) ? 0 : g_cpu_info(feature);
+}
+
+struct Kernels {
+  WebRtcAecFilterFar filter_far;
+  WebRtcAecScaleErrorSignal scale_error_signal;
+  WebRtcAecFilterAdaptation filter_adaptation;
+  WebRtcAecOverdriveAndSuppress overdrive_and_suppress;
+};
+
+// The kernels are picked by WebRtcAec_CreateAec() from the CPU features.
+void LoadKernels(WebRtc_CPUInfo cpu_info, Kernels* kernels) {
+  WebRtc_CPUInfo saved = WebRtc_GetCPUInfo;
+  WebRtc_GetCPUInfo = cpu_info;
+  AecCore* aec = WebRtcAec_CreateAec();
+  WebRtc_GetCPUInfo = saved;
+  ASSERT_TRUE(aec);
+  kernels->filter_far = WebRtcAec_FilterFar;
+  kernels->scale_error_signal = WebRtcAec_ScaleErrorSignal;
+  kernels->filter_adaptation = WebRtcAec_FilterAdaptation;
+  kernels->overdrive_and_suppress = WebRtcAec_OverdriveAndSuppress;
+  WebRtcAec_FreeAec(aec);
+}
+
+void ExpectNear(const float* expected,
+                const float* actual,
+                size_t size,
+                float tolerance = kTolerance) {
+  float max_abs = 0.f;
+  for (size_t i = 0; i < size; ++i) {
+    max_abs = fmaxf(max_abs, fabsf(expected[i]));
+  }
+  for (size_t i = 0; i < size; ++i) {
+    ASSERT_NEAR(expected[i], actual[i], tolerance * (1.f + max_abs))
+        << "at " << i;
+  }
+}
+
+class AecCoreAVX2Test : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    g_cpu_info = WebRtc_GetCPUInfo;
+    has_avx2_ = g_cpu_info(kAVX2) && g_cpu_info(kFMA3);
+    if (!has_avx2_) {
+      return;
+    }
+    LoadKernels(CPUInfoWithoutAVX2, &sse2_);
+    LoadKernels(g_cpu_info, &avx2_);
+    ASSERT_NE(sse2_.filter_far, avx2_.filter_far);
+  }
+
+  void Fill(float* data, size_t size, float min, float max) {
+    std::uniform_real_distribution<float> dist(min, max);
+    for (size_t i = 0; i < size; ++i) {
+      data[i] = dist(random_);
+    }
+  }
+
+  bool has_avx2_;
+  Kernels sse2_;
+  Kernels avx2_;
+  std::mt19937 random_;
+};
+
+TEST_F(AecCoreAVX2Test, FilterFar) {
+  if (!has_avx2_) {
+    return;
+  }
+  static float x_fft_buf[2][2 * kExtendedNumPartitions * PART_LEN1_PADDED];
+  static float h_fft_buf[2][kExtendedNumPartitions * PART_LEN1_PADDED];
+  float y_sse2[2][PART_LEN1];
+  float y_avx2[2][PART_LEN1];
+
+  const int kPartitions[] = {kNormalNumPartitions, kExtendedNumPartitions};
+  for (int num_partitions : kPartitions) {
+    for (int block_pos = 0; block_pos < kExtendedNumPartitions;
+         block_pos += 5) {
+      Fill(&x_fft_buf[0][0], 4 * kExtendedNumPartitions * PART_LEN1_PADDED,
+           -1e3f, 1e3f);
+      Fill(&h_fft_buf[0][0], 2 * kExtendedNumPartitions * PART_LEN1_PADDED,
+           -1.f, 1.f);
+      Fill(&y_sse2[0][0], 2 * PART_LEN1, -1e3f, 1e3f);
+      memcpy(y_avx2, y_sse2, sizeof(y_sse2));
+
+      sse2_.filter_far(num_partitions, block_pos, x_fft_buf, h_fft_buf,
+                       y_sse2);
+      avx2_.filter_far(num_partitions, block_pos, x_fft_buf, h_fft_buf,
+                       y_avx2);
+      ExpectNear(&y_sse2[0][0], &y_avx2[0][0], 2 * PART_LEN1);
+    }
+  }
+}
+
+TEST_F(AecCoreAVX2Test, ScaleErrorSignal) {
+  if (!has_avx2_) {
+    return;
+  }
+  float x_pow[PART_LEN1];
+  float ef_sse2[2][PART_LEN1];
+  float ef_avx2[2][PART_LEN1];
+
+  for (int extended = 0; extended < 2; ++extended) {
+    for (int round = 0; round < 10; ++round) {
+      // Small powers push some bins over the error threshold.
+      Fill(x_pow, PART_LEN1, 1e2f, 1e7f);
+      Fill(&ef_sse2[0][0], 2 * PART_LEN1, -1e2f, 1e2f);
+      memcpy(ef_avx2, ef_sse2, sizeof(ef_sse2));
+
+      sse2_.scale_error_signal(extended, 0.5f, 2e-6f, x_pow, ef_sse2);
+      avx2_.scale_error_signal(extended, 0.5f, 2e-6f, x_pow, ef_avx2);
+      ExpectNear(&ef_sse2[0][0], &ef_avx2[0][0], 2 * PART_LEN1);
+    }
+  }
+}
+
+TEST_F(AecCoreAVX2Test, FilterAdaptation) {
+  if (!has_avx2_) {
+    return;
+  }
+  static float x_fft_buf[2][2 * kExtendedNumPartitions * PART_LEN1_PADDED];
+  static float h_sse2[2][kExtendedNumPartitions * PART_LEN1_PADDED];
+  static float h_avx2[2][kExtendedNumPartitions * PART_LEN1_PADDED];
+  float e_fft[2][PART_LEN1];
+
+  const int kPartitions[] = {kNormalNumPartitions, kExtendedNumPartitions};
+  for (int num_partitions : kPartitions) {
+    for (int block_pos = 0; block_pos < kExtendedNumPartitions;
+         block_pos += 5) {
+      Fill(&x_fft_buf[0][0], 4 * kExtendedNumPartitions * PART_LEN1_PADDED,
+           -1e3f, 1e3f);
+      Fill(&e_fft[0][0], 2 * PART_LEN1, -1e-3f, 1e-3f);
+      Fill(&h_sse2[0][0], 2 * kExtendedNumPartitions * PART_LEN1_PADDED, -1.f,
+           1.f);
+      memcpy(h_avx2, h_sse2, sizeof(h_sse2));
+
+      sse2_.filter_adaptation(num_partitions, block_pos, x_fft_buf, e_fft,
+                              h_sse2);
+      avx2_.filter_adaptation(num_partitions, block_pos, x_fft_buf, e_fft,
+                              h_avx2);
+      ExpectNear(&h_sse2[0][0], &h_avx2[0][0],
+                 2 * kExtendedNumPartitions * PART_LEN1_PADDED);
+    }
+  }
+}
+
+TEST_F(AecCoreAVX2Test, OverdriveAndSuppress) {
+  if (!has_avx2_) {
+    return;
+  }
+  AecCore* aec = WebRtcAec_CreateAec();
+  ASSERT_TRUE(aec);
+  float h_nl_sse2[PART_LEN1];
+  float h_nl_avx2[PART_LEN1];
+  float efw_sse2[2][PART_LEN1];
+  float efw_avx2[2][PART_LEN1];
+
+  for (int round = 0; round < 20; ++round) {
+    float h_nl_fb;
+    Fill(&h_nl_fb, 1, 0.f, 1.f);
+    Fill(&aec->overDriveSm, 1, 1.f, 30.f);
+    Fill(h_nl_sse2, PART_LEN1, 1e-3f, 1.f);
+    Fill(&efw_sse2[0][0], 2 * PART_LEN1, -1e4f, 1e4f);
+    memcpy(h_nl_avx2, h_nl_sse2, sizeof(h_nl_sse2));
+    memcpy(efw_avx2, efw_sse2, sizeof(efw_sse2));
+
+    sse2_.overdrive_and_suppress(aec, h_nl_sse2, h_nl_fb, efw_sse2);
+    avx2_.overdrive_and_suppress(aec, h_nl_avx2, h_nl_fb, efw_avx2);
+    ExpectNear(h_nl_sse2, h_nl_avx2, PART_LEN1, kPowTolerance);
+    ExpectNear(&efw_sse2[0][0], &efw_avx2[0][0], 2 * PART_LEN1, kPowTolerance);
+  }
+
+  WebRtcAec_FreeAec(aec);
+}
+
+#endif  // WEBRTC_ARCH_X86_FAMILY
+
+}  // namespace
+}  // namespace webrtc
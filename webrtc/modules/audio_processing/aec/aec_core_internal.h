@@ -15,6 +15,7 @@
 #include "webrtc/common_audio/wav_file.h"
 #include "webrtc/modules/audio_processing/aec/aec_common.h"
 #include "webrtc/modules/audio_processing/aec/aec_core.h"
+#include "webrtc/modules/audio_processing/logging/aec_trace.h"
 #include "webrtc/typedefs.h"
 
 // Number of partitions for the extended filter mode. The first one is an enum
@@ -24,6 +25,12 @@ enum {
 };
 static const int kNormalNumPartitions = 12;
 
+// The farend and filter fft buffers store a partition every PART_LEN1_PADDED
+// floats, a whole number of 32-byte vectors. Every partition then starts
+// aligned and the SIMD kernels run over the zero padding instead of a scalar
+// tail per partition.
+#define PART_LEN1_PADDED 72
+
 // Delay estimator constants, used for logging and delay compensation if
 // if reported delays are disabled.
 enum {
@@ -50,6 +57,8 @@ typedef struct PowerLevel {
 } PowerLevel;
 
 struct AecCore {
+  void* mem_block;  // From malloc(), the AecCore sits 32-byte aligned in it.
+
   int farBufWritePos, farBufReadPos;
 
   int knownDelay;
@@ -73,8 +82,14 @@ struct AecCore {
   float dInitMinPow[PART_LEN1];
   float* noisePow;
 
-  float xfBuf[2][kExtendedNumPartitions * PART_LEN1];  // farend fft buffer
-  float wfBuf[2][kExtendedNumPartitions * PART_LEN1];  // filter fft
+  // Farend fft buffer, circular over kExtendedNumPartitions partitions and
+  // written twice, |kExtendedNumPartitions| partitions apart, so the newest
+  // |num_partitions| of them are always read without a wrap.
+  ALIGN32_BEG float ALIGN32_END
+      xfBuf[2][2 * kExtendedNumPartitions * PART_LEN1_PADDED];
+  // Filter fft.
+  ALIGN32_BEG float ALIGN32_END
+      wfBuf[2][kExtendedNumPartitions * PART_LEN1_PADDED];
   complex_t sde[PART_LEN1];  // cross-psd of nearend and error
   complex_t sxd[PART_LEN1];  // cross-psd of farend and nearend
   // Farend windowed fft buffer.
@@ -156,6 +171,15 @@ struct AecCore {
   // Suppressor.
   int extreme_filter_divergence;
 
+  // Binary trace of the core state, NULL unless attached.
+  AecTrace* trace;
+  int trace_instance;
+  int trace_block;
+  // Energy of the filter, refreshed along with |delayIdx|.
+  float trace_filter_energy;
+  // Suppression gain of the last block, before overdrive.
+  float nlp_gain;
+
 #ifdef WEBRTC_AEC_DEBUG_DUMP
   // Sequence number of this AEC instance, so that different instances can
   // choose different dump file names.
@@ -176,8 +200,8 @@ struct AecCore {
 typedef void (*WebRtcAecFilterFar)(
     int num_partitions,
     int x_fft_buf_block_pos,
-    float x_fft_buf[2][kExtendedNumPartitions * PART_LEN1],
-    float h_fft_buf[2][kExtendedNumPartitions * PART_LEN1],
+    float x_fft_buf[2][2 * kExtendedNumPartitions * PART_LEN1_PADDED],
+    float h_fft_buf[2][kExtendedNumPartitions * PART_LEN1_PADDED],
     float y_fft[2][PART_LEN1]);
 extern WebRtcAecFilterFar WebRtcAec_FilterFar;
 typedef void (*WebRtcAecScaleErrorSignal)(int extended_filter_enabled,
@@ -189,9 +213,9 @@ extern WebRtcAecScaleErrorSignal WebRtcAec_ScaleErrorSignal;
 typedef void (*WebRtcAecFilterAdaptation)(
     int num_partitions,
     int x_fft_buf_block_pos,
-    float x_fft_buf[2][kExtendedNumPartitions * PART_LEN1],
+    float x_fft_buf[2][2 * kExtendedNumPartitions * PART_LEN1_PADDED],
     float e_fft[2][PART_LEN1],
-    float h_fft_buf[2][kExtendedNumPartitions * PART_LEN1]);
+    float h_fft_buf[2][kExtendedNumPartitions * PART_LEN1_PADDED]);
 extern WebRtcAecFilterAdaptation WebRtcAec_FilterAdaptation;
 typedef void (*WebRtcAecOverdriveAndSuppress)(AecCore* aec,
                                               float hNl[PART_LEN1],
@@ -325,17 +325,13 @@ void WebRtcAec_ComfortNoise_mips(AecCore* aec,
 void WebRtcAec_FilterFar_mips(
     int num_partitions,
     int x_fft_buf_block_pos,
-    float x_fft_buf[2][kExtendedNumPartitions * PART_LEN1],
-    float h_fft_buf[2][kExtendedNumPartitions * PART_LEN1],
+    float x_fft_buf[2][2 * kExtendedNumPartitions * PART_LEN1_PADDED],
+    float h_fft_buf[2][kExtendedNumPartitions * PART_LEN1_PADDED],
     float y_fft[2][PART_LEN1]) {
   int i;
   for (i = 0; i < num_partitions; i++) {
-    int xPos = (i + x_fft_buf_block_pos) * PART_LEN1;
-    int pos = i * PART_LEN1;
-    // Check for wrap
-    if (i + x_fft_buf_block_pos >=  num_partitions) {
-      xPos -=  num_partitions * (PART_LEN1);
-    }
+    int xPos = (i + x_fft_buf_block_pos) * PART_LEN1_PADDED;
+    int pos = i * PART_LEN1_PADDED;
     float* yf0 = y_fft[0];
     float* yf1 = y_fft[1];
     float* aRe = x_fft_buf[0] + xPos;
@@ -442,20 +438,16 @@ void WebRtcAec_FilterFar_mips(
 void WebRtcAec_FilterAdaptation_mips(
     int num_partitions,
     int x_fft_buf_block_pos,
-    float x_fft_buf[2][kExtendedNumPartitions * PART_LEN1],
+    float x_fft_buf[2][2 * kExtendedNumPartitions * PART_LEN1_PADDED],
     float e_fft[2][PART_LEN1],
-    float h_fft_buf[2][kExtendedNumPartitions * PART_LEN1]) {
+    float h_fft_buf[2][kExtendedNumPartitions * PART_LEN1_PADDED]) {
   float fft[PART_LEN2];
   int i;
   for (i = 0; i < num_partitions; i++) {
-    int xPos = (i + x_fft_buf_block_pos)*(PART_LEN1);
+    int xPos = (i + x_fft_buf_block_pos) * PART_LEN1_PADDED;
     int pos;
-    // Check for wrap
-    if (i + x_fft_buf_block_pos >= num_partitions) {
-      xPos -= num_partitions * PART_LEN1;
-    }
 
-    pos = i * PART_LEN1;
+    pos = i * PART_LEN1_PADDED;
     float* aRe = x_fft_buf[0] + xPos;
     float* aIm = x_fft_buf[1] + xPos;
     float* bRe = e_fft[0];
@@ -30,53 +30,45 @@ __inline static float MulRe(float aRe, float aIm, float bRe, float bIm) {
   return aRe * bRe - aIm * bIm;
 }
 
-__inline static float MulIm(float aRe, float aIm, float bRe, float bIm) {
-  return aRe * bIm + aIm * bRe;
-}
-
 static void FilterFarNEON(
     int num_partitions,
     int x_fft_buf_block_pos,
-    float x_fft_buf[2][kExtendedNumPartitions * PART_LEN1],
-    float h_fft_buf[2][kExtendedNumPartitions * PART_LEN1],
+    float x_fft_buf[2][2 * kExtendedNumPartitions * PART_LEN1_PADDED],
+    float h_fft_buf[2][kExtendedNumPartitions * PART_LEN1_PADDED],
     float y_fft[2][PART_LEN1]) {
-  int i;
-  for (i = 0; i < num_partitions; i++) {
-    int j;
-    int xPos = (i + x_fft_buf_block_pos) * PART_LEN1;
-    int pos = i * PART_LEN1;
-    // Check for wrap
-    if (i + x_fft_buf_block_pos >= num_partitions) {
-      xPos -= num_partitions * PART_LEN1;
-    }
-
-    // vectorized code (four at once)
-    for (j = 0; j + 3 < PART_LEN1; j += 4) {
-      const float32x4_t x_fft_buf_re = vld1q_f32(&x_fft_buf[0][xPos + j]);
-      const float32x4_t x_fft_buf_im = vld1q_f32(&x_fft_buf[1][xPos + j]);
-      const float32x4_t h_fft_buf_re = vld1q_f32(&h_fft_buf[0][pos + j]);
-      const float32x4_t h_fft_buf_im = vld1q_f32(&h_fft_buf[1][pos + j]);
-      const float32x4_t y_fft_re = vld1q_f32(&y_fft[0][j]);
-      const float32x4_t y_fft_im = vld1q_f32(&y_fft[1][j]);
+  int j;
+  // Each vector of bins is accumulated over all the partitions in registers.
+  // The last one reaches into the zero padding of the partitions, only its
+  // first bin (PART_LEN) is read from and written to y_fft.
+  for (j = 0; j < PART_LEN1; j += 4) {
+    const int last = j + 4 > PART_LEN1;
+    float32x4_t y_fft_re =
+        last ? vsetq_lane_f32(y_fft[0][j], vdupq_n_f32(0.0f), 0)
+             : vld1q_f32(&y_fft[0][j]);
+    float32x4_t y_fft_im =
+        last ? vsetq_lane_f32(y_fft[1][j], vdupq_n_f32(0.0f), 0)
+             : vld1q_f32(&y_fft[1][j]);
+    int i;
+    for (i = 0; i < num_partitions; i++) {
+      const int xPos = (i + x_fft_buf_block_pos) * PART_LEN1_PADDED + j;
+      const int pos = i * PART_LEN1_PADDED + j;
+      const float32x4_t x_fft_buf_re = vld1q_f32(&x_fft_buf[0][xPos]);
+      const float32x4_t x_fft_buf_im = vld1q_f32(&x_fft_buf[1][xPos]);
+      const float32x4_t h_fft_buf_re = vld1q_f32(&h_fft_buf[0][pos]);
+      const float32x4_t h_fft_buf_im = vld1q_f32(&h_fft_buf[1][pos]);
       const float32x4_t a = vmulq_f32(x_fft_buf_re, h_fft_buf_re);
       const float32x4_t e = vmlsq_f32(a, x_fft_buf_im, h_fft_buf_im);
       const float32x4_t c = vmulq_f32(x_fft_buf_re, h_fft_buf_im);
       const float32x4_t f = vmlaq_f32(c, x_fft_buf_im, h_fft_buf_re);
-      const float32x4_t g = vaddq_f32(y_fft_re, e);
-      const float32x4_t h = vaddq_f32(y_fft_im, f);
-      vst1q_f32(&y_fft[0][j], g);
-      vst1q_f32(&y_fft[1][j], h);
+      y_fft_re = vaddq_f32(y_fft_re, e);
+      y_fft_im = vaddq_f32(y_fft_im, f);
     }
-    // scalar code for the remaining items.
-    for (; j < PART_LEN1; j++) {
-      y_fft[0][j] += MulRe(x_fft_buf[0][xPos + j],
-                           x_fft_buf[1][xPos + j],
-                           h_fft_buf[0][pos + j],
-                           h_fft_buf[1][pos + j]);
-      y_fft[1][j] += MulIm(x_fft_buf[0][xPos + j],
-                           x_fft_buf[1][xPos + j],
-                           h_fft_buf[0][pos + j],
-                           h_fft_buf[1][pos + j]);
+    if (last) {
+      vst1q_lane_f32(&y_fft[0][j], y_fft_re, 0);
+      vst1q_lane_f32(&y_fft[1][j], y_fft_im, 0);
+    } else {
+      vst1q_f32(&y_fft[0][j], y_fft_re);
+      vst1q_f32(&y_fft[1][j], y_fft_im);
     }
   }
 }
@@ -189,19 +181,15 @@ static void ScaleErrorSignalNEON(int extended_filter_enabled,
 static void FilterAdaptationNEON(
     int num_partitions,
     int x_fft_buf_block_pos,
-    float x_fft_buf[2][kExtendedNumPartitions * PART_LEN1],
+    float x_fft_buf[2][2 * kExtendedNumPartitions * PART_LEN1_PADDED],
     float e_fft[2][PART_LEN1],
-    float h_fft_buf[2][kExtendedNumPartitions * PART_LEN1]) {
+    float h_fft_buf[2][kExtendedNumPartitions * PART_LEN1_PADDED]) {
   float fft[PART_LEN2];
   int i;
   for (i = 0; i < num_partitions; i++) {
-    int xPos = (i + x_fft_buf_block_pos) * PART_LEN1;
-    int pos = i * PART_LEN1;
+    int xPos = (i + x_fft_buf_block_pos) * PART_LEN1_PADDED;
+    int pos = i * PART_LEN1_PADDED;
     int j;
-    // Check for wrap
-    if (i + x_fft_buf_block_pos >= num_partitions) {
-      xPos -= num_partitions * PART_LEN1;
-    }
 
     // Process the whole array...
     for (j = 0; j < PART_LEN; j += 4) {
@@ -464,11 +452,11 @@ static int PartitionDelayNEON(const AecCore* aec) {
 
   for (i = 0; i < aec->num_partitions; i++) {
     int j;
-    int pos = i * PART_LEN1;
+    int pos = i * PART_LEN1_PADDED;
     float wfEn = 0;
     float32x4_t vec_wfEn = vdupq_n_f32(0.0f);
-    // vectorized code (four at once)
-    for (j = 0; j + 3 < PART_LEN1; j += 4) {
+    // vectorized code (four at once), the last vector ends in zero padding.
+    for (j = 0; j < PART_LEN1; j += 4) {
       const float32x4_t vec_wfBuf0 = vld1q_f32(&aec->wfBuf[0][pos + j]);
       const float32x4_t vec_wfBuf1 = vld1q_f32(&aec->wfBuf[1][pos + j]);
       vec_wfEn = vmlaq_f32(vec_wfEn, vec_wfBuf0, vec_wfBuf0);
@@ -484,12 +472,6 @@ static int PartitionDelayNEON(const AecCore* aec) {
       wfEn = vget_lane_f32(vec_total, 0);
     }
 
-    // scalar code for the remaining items.
-    for (; j < PART_LEN1; j++) {
-      wfEn += aec->wfBuf[0][pos + j] * aec->wfBuf[0][pos + j] +
-              aec->wfBuf[1][pos + j] * aec->wfBuf[1][pos + j];
-    }
-
     if (wfEn > wfEnMax) {
       wfEnMax = wfEn;
       delay = i;
@@ -25,56 +25,45 @@ __inline static float MulRe(float aRe, float aIm, float bRe, float bIm) {
   return aRe * bRe - aIm * bIm;
 }
 
-__inline static float MulIm(float aRe, float aIm, float bRe, float bIm) {
-  return aRe * bIm + aIm * bRe;
-}
-
 static void FilterFarSSE2(
     int num_partitions,
     int x_fft_buf_block_pos,
-    float x_fft_buf[2][kExtendedNumPartitions * PART_LEN1],
-    float h_fft_buf[2][kExtendedNumPartitions * PART_LEN1],
+    float x_fft_buf[2][2 * kExtendedNumPartitions * PART_LEN1_PADDED],
+    float h_fft_buf[2][kExtendedNumPartitions * PART_LEN1_PADDED],
     float y_fft[2][PART_LEN1]) {
-
-  int i;
-  for (i = 0; i < num_partitions; i++) {
-    int j;
-    int xPos = (i + x_fft_buf_block_pos) * PART_LEN1;
-    int pos = i * PART_LEN1;
-    // Check for wrap
-    if (i + x_fft_buf_block_pos >= num_partitions) {
-      xPos -= num_partitions * (PART_LEN1);
-    }
-
-    // vectorized code (four at once)
-    for (j = 0; j + 3 < PART_LEN1; j += 4) {
-      const __m128 x_fft_buf_re = _mm_loadu_ps(&x_fft_buf[0][xPos + j]);
-      const __m128 x_fft_buf_im = _mm_loadu_ps(&x_fft_buf[1][xPos + j]);
-      const __m128 h_fft_buf_re = _mm_loadu_ps(&h_fft_buf[0][pos + j]);
-      const __m128 h_fft_buf_im = _mm_loadu_ps(&h_fft_buf[1][pos + j]);
-      const __m128 y_fft_re = _mm_loadu_ps(&y_fft[0][j]);
-      const __m128 y_fft_im = _mm_loadu_ps(&y_fft[1][j]);
+  int j;
+  // Each vector of bins is accumulated over all the partitions in registers.
+  // The last one reaches into the zero padding of the partitions, only its
+  // first bin (PART_LEN) is read from and written to y_fft.
+  for (j = 0; j < PART_LEN1; j += 4) {
+    const int last = j + 4 > PART_LEN1;
+    __m128 y_fft_re =
+        last ? _mm_load_ss(&y_fft[0][j]) : _mm_loadu_ps(&y_fft[0][j]);
+    __m128 y_fft_im =
+        last ? _mm_load_ss(&y_fft[1][j]) : _mm_loadu_ps(&y_fft[1][j]);
+    int i;
+    for (i = 0; i < num_partitions; i++) {
+      const int xPos = (i + x_fft_buf_block_pos) * PART_LEN1_PADDED + j;
+      const int pos = i * PART_LEN1_PADDED + j;
+      const __m128 x_fft_buf_re = _mm_loadu_ps(&x_fft_buf[0][xPos]);
+      const __m128 x_fft_buf_im = _mm_loadu_ps(&x_fft_buf[1][xPos]);
+      const __m128 h_fft_buf_re = _mm_loadu_ps(&h_fft_buf[0][pos]);
+      const __m128 h_fft_buf_im = _mm_loadu_ps(&h_fft_buf[1][pos]);
       const __m128 a = _mm_mul_ps(x_fft_buf_re, h_fft_buf_re);
       const __m128 b = _mm_mul_ps(x_fft_buf_im, h_fft_buf_im);
       const __m128 c = _mm_mul_ps(x_fft_buf_re, h_fft_buf_im);
       const __m128 d = _mm_mul_ps(x_fft_buf_im, h_fft_buf_re);
       const __m128 e = _mm_sub_ps(a, b);
       const __m128 f = _mm_add_ps(c, d);
-      const __m128 g = _mm_add_ps(y_fft_re, e);
-      const __m128 h = _mm_add_ps(y_fft_im, f);
-      _mm_storeu_ps(&y_fft[0][j], g);
-      _mm_storeu_ps(&y_fft[1][j], h);
+      y_fft_re = _mm_add_ps(y_fft_re, e);
+      y_fft_im = _mm_add_ps(y_fft_im, f);
     }
-    // scalar code for the remaining items.
-    for (; j < PART_LEN1; j++) {
-      y_fft[0][j] += MulRe(x_fft_buf[0][xPos + j],
-                           x_fft_buf[1][xPos + j],
-                           h_fft_buf[0][pos + j],
-                           h_fft_buf[1][pos + j]);
-      y_fft[1][j] += MulIm(x_fft_buf[0][xPos + j],
-                           x_fft_buf[1][xPos + j],
-                           h_fft_buf[0][pos + j],
-                           h_fft_buf[1][pos + j]);
+    if (last) {
+      _mm_store_ss(&y_fft[0][j], y_fft_re);
+      _mm_store_ss(&y_fft[1][j], y_fft_im);
+    } else {
+      _mm_storeu_ps(&y_fft[0][j], y_fft_re);
+      _mm_storeu_ps(&y_fft[1][j], y_fft_im);
     }
   }
 }
@@ -151,18 +140,14 @@ static void ScaleErrorSignalSSE2(int extended_filter_enabled,
 static void FilterAdaptationSSE2(
     int num_partitions,
     int x_fft_buf_block_pos,
-    float x_fft_buf[2][kExtendedNumPartitions * PART_LEN1],
+    float x_fft_buf[2][2 * kExtendedNumPartitions * PART_LEN1_PADDED],
     float e_fft[2][PART_LEN1],
-    float h_fft_buf[2][kExtendedNumPartitions * PART_LEN1]) {
+    float h_fft_buf[2][kExtendedNumPartitions * PART_LEN1_PADDED]) {
   float fft[PART_LEN2];
   int i, j;
   for (i = 0; i < num_partitions; i++) {
-    int xPos = (i + x_fft_buf_block_pos) * (PART_LEN1);
-    int pos = i * PART_LEN1;
-    // Check for wrap
-    if (i + x_fft_buf_block_pos >= num_partitions) {
-      xPos -= num_partitions * PART_LEN1;
-    }
+    int xPos = (i + x_fft_buf_block_pos) * PART_LEN1_PADDED;
+    int pos = i * PART_LEN1_PADDED;
 
     // Process the whole array...
     for (j = 0; j < PART_LEN; j += 4) {
@@ -451,11 +436,11 @@ static int PartitionDelaySSE2(const AecCore* aec) {
 
   for (i = 0; i < aec->num_partitions; i++) {
     int j;
-    int pos = i * PART_LEN1;
+    int pos = i * PART_LEN1_PADDED;
     float wfEn = 0;
     __m128 vec_wfEn = _mm_set1_ps(0.0f);
-    // vectorized code (four at once)
-    for (j = 0; j + 3 < PART_LEN1; j += 4) {
+    // vectorized code (four at once), the last vector ends in zero padding.
+    for (j = 0; j < PART_LEN1; j += 4) {
       const __m128 vec_wfBuf0 = _mm_loadu_ps(&aec->wfBuf[0][pos + j]);
       const __m128 vec_wfBuf1 = _mm_loadu_ps(&aec->wfBuf[1][pos + j]);
       vec_wfEn = _mm_add_ps(vec_wfEn, _mm_mul_ps(vec_wfBuf0, vec_wfBuf0));
@@ -463,12 +448,6 @@ static int PartitionDelaySSE2(const AecCore* aec) {
     }
     _mm_add_ps_4x1(vec_wfEn, &wfEn);
 
-    // scalar code for the remaining items.
-    for (; j < PART_LEN1; j++) {
-      wfEn += aec->wfBuf[0][pos + j] * aec->wfBuf[0][pos + j] +
-              aec->wfBuf[1][pos + j] * aec->wfBuf[1][pos + j];
-    }
-
     if (wfEn > wfEnMax) {
       wfEnMax = wfEn;
       delay = i;
@@ -15,6 +15,8 @@
 #include <stdlib.h>
 #include <time.h>
 
+#include <vector>
+
 extern "C" {
 #include "webrtc/modules/audio_processing/aec/aec_core.h"
 }
@@ -45,4 +47,66 @@ TEST(EchoCancellationTest, ApplyAecCoreHandle) {
   WebRtcAec_Free(handle);
 }
 
+namespace {
+
+const int kSampleRateHz = 16000;
+const size_t kNumSamples = kSampleRateHz / 100;
+
+// Delay agnostic, like an instance that is re-initialized for a new call.
+void InitDelayAgnostic(void* handle) {
+  WebRtcAec_enable_delay_agnostic(WebRtcAec_aec_core(handle), 1);
+  ASSERT_EQ(0, WebRtcAec_Init(handle, kSampleRateHz, kSampleRateHz));
+}
+
+// Runs |far| and its echo |near| through |handle|, returns the output.
+std::vector<float> ProcessEcho(void* handle, const std::vector<float>& far,
+                               const std::vector<float>& near) {
+  std::vector<float> out(near.size());
+  for (size_t i = 0; i + kNumSamples <= near.size(); i += kNumSamples) {
+    const float* near_bands[] = {&near[i]};
+    float* out_bands[] = {&out[i]};
+    EXPECT_EQ(0, WebRtcAec_BufferFarend(handle, &far[i], kNumSamples));
+    EXPECT_EQ(0, WebRtcAec_Process(handle, near_bands, 1, out_bands,
+                                   kNumSamples, 20, 0));
+  }
+  return out;
+}
+
+}  // namespace
+
+TEST(EchoCancellationTest, InitIsBitExactWithNewInstance) {
+  // Noise with its echo 400 ms late, then 200 ms late, both well off the
+  // reported 20 ms. The first call makes the signal based delay correction
+  // move the delay estimator lookahead far enough to miss the second echo.
+  std::vector<float> far(20 * kSampleRateHz);
+  std::vector<float> first_near(far.size()), second_near(far.size());
+  srand(17);
+  for (size_t i = 0; i < far.size(); ++i) {
+    far[i] = static_cast<float>(rand() % 20001 - 10000);
+  }
+  for (size_t i = 0; i < far.size(); ++i) {
+    const size_t first_echo = 2 * kSampleRateHz / 5;
+    const size_t second_echo = kSampleRateHz / 5;
+    first_near[i] = i < first_echo ? 0.f : 0.5f * far[i - first_echo];
+    second_near[i] = i < second_echo ? 0.f : 0.5f * far[i - second_echo];
+  }
+
+  void* reused = WebRtcAec_Create();
+  void* created = WebRtcAec_Create();
+  ASSERT_TRUE(reused);
+  ASSERT_TRUE(created);
+
+  InitDelayAgnostic(reused);
+  ProcessEcho(reused, far, first_near);
+
+  // Nothing of the first call may carry over into the second.
+  InitDelayAgnostic(reused);
+  InitDelayAgnostic(created);
+  EXPECT_EQ(ProcessEcho(created, far, second_near),
+            ProcessEcho(reused, far, second_near));
+
+  WebRtcAec_Free(reused);
+  WebRtcAec_Free(created);
+}
+
 }  // namespace webrtc
@@ -202,6 +202,43 @@ const uint16_t* WebRtcAecm_AlignedFarend(AecmCore* self,
   return &(self->far_history[buffer_position * PART_LEN1]);
 }
 
+int WebRtcAecm_FetchFarSpectrum(AecmCore* self,
+                                uint16_t* far_spectrum,
+                                int* far_q) {
+  const AecmCore* leader = self->farend_leader;
+  const int pos = self->totCount & (FAR_CACHE_LEN - 1);
+
+  // The samples are compared as well, so a leader fed a different far end or
+  // delay only costs us the lookup.
+  if (leader == NULL || leader->far_cache_block[pos] != self->totCount ||
+      memcmp(leader->far_cache_time[pos], self->xBuf,
+             sizeof(int16_t) * PART_LEN2) != 0) {
+    return 0;
+  }
+
+  memcpy(far_spectrum, leader->far_cache_spectrum[pos],
+         sizeof(uint16_t) * PART_LEN1);
+  *far_q = leader->far_cache_q[pos];
+
+  return 1;
+}
+
+void WebRtcAecm_StoreFarSpectrum(AecmCore* self,
+                                 const uint16_t* far_spectrum,
+                                 int far_q) {
+  const int pos = self->totCount & (FAR_CACHE_LEN - 1);
+
+  if (self->farend_followers == 0) {
+    return;
+  }
+
+  self->far_cache_block[pos] = self->totCount;
+  self->far_cache_q[pos] = far_q;
+  memcpy(self->far_cache_time[pos], self->xBuf, sizeof(int16_t) * PART_LEN2);
+  memcpy(self->far_cache_spectrum[pos], far_spectrum,
+         sizeof(uint16_t) * PART_LEN1);
+}
+
 // Declare function pointers.
 CalcLinearEnergies WebRtcAecm_CalcLinearEnergies;
 StoreAdaptiveChannel WebRtcAecm_StoreAdaptiveChannel;
@@ -210,6 +247,9 @@ ResetAdaptiveChannel WebRtcAecm_ResetAdaptiveChannel;
 AecmCore* WebRtcAecm_CreateCore() {
     AecmCore* aecm = malloc(sizeof(AecmCore));
 
+    aecm->farend_leader = NULL;
+    aecm->farend_followers = 0;
+
     aecm->farFrameBuf = WebRtc_CreateBuffer(FRAME_LEN + PART_LEN,
                                             sizeof(int16_t));
     if (!aecm->farFrameBuf)
@@ -436,6 +476,8 @@ int WebRtcAecm_InitCore(AecmCore* const aecm, int samplingFreq) {
     memset(aecm->far_history, 0, sizeof(uint16_t) * PART_LEN1 * MAX_DELAY);
     memset(aecm->far_q_domains, 0, sizeof(int) * MAX_DELAY);
     aecm->far_history_pos = MAX_DELAY;
+    // No block has a cached far end spectrum yet.
+    memset(aecm->far_cache_block, 0xff, sizeof(aecm->far_cache_block));
 
     aecm->nlpFlag = 1;
     aecm->fixedDelay = -1;
@@ -518,6 +560,17 @@ int WebRtcAecm_InitCore(AecmCore* const aecm, int samplingFreq) {
     WebRtcAecm_InitNeon();
 #endif
 
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+    if (WebRtc_GetCPUInfo(kSSE4_1))
+    {
+      WebRtcAecm_InitSSE41();
+      if (WebRtc_GetCPUInfo(kAVX2))
+      {
+        WebRtcAecm_InitAVX2();
+      }
+    }
+#endif
+
 #if defined(MIPS32_LE)
     WebRtcAecm_InitMips();
 #endif
@@ -533,6 +586,23 @@ int WebRtcAecm_Control(AecmCore* aecm, int delay, int nlpFlag) {
     return 0;
 }
 
+int WebRtcAecm_ShareFarendCore(AecmCore* aecm, AecmCore* leader) {
+    if (aecm == NULL || aecm == leader ||
+        (leader != NULL && leader->farend_leader != NULL)) {
+      return -1;
+    }
+
+    if (aecm->farend_leader != NULL) {
+      aecm->farend_leader->farend_followers--;
+    }
+    if (leader != NULL) {
+      leader->farend_followers++;
+    }
+    aecm->farend_leader = leader;
+
+    return 0;
+}
+
 void WebRtcAecm_FreeCore(AecmCore* aecm) {
     if (aecm == NULL) {
       return;
@@ -31,7 +31,7 @@ typedef struct {
     int16_t imag;
 } ComplexInt16;
 
-typedef struct {
+typedef struct AecmCore {
     int farBufWritePos;
     int farBufReadPos;
     int knownDelay;
@@ -58,6 +58,16 @@ typedef struct {
     int far_history_pos;
     int far_q_domains[MAX_DELAY];
 
+    // Far end spectrum sharing, see WebRtcAecm_ShareFarendCore(). A leader
+    // keeps the far end blocks and spectra it computed last, indexed by
+    // |totCount|, for its followers to pick up.
+    struct AecmCore* farend_leader;
+    int farend_followers;
+    uint32_t far_cache_block[FAR_CACHE_LEN];
+    int far_cache_q[FAR_CACHE_LEN];
+    int16_t far_cache_time[FAR_CACHE_LEN][PART_LEN2];
+    uint16_t far_cache_spectrum[FAR_CACHE_LEN][PART_LEN1];
+
     int16_t nlpFlag;
     int16_t fixedDelay;
 
@@ -169,6 +179,27 @@ void WebRtcAecm_FreeCore(AecmCore* aecm);
 
 int WebRtcAecm_Control(AecmCore* aecm, int delay, int nlpFlag);
 
+////////////////////////////////////////////////////////////////////////////////
+// WebRtcAecm_ShareFarendCore(...)
+//
+// Makes |aecm| take the far end spectrum of each block from |leader| instead
+// of computing it, for several microphones cancelling the echo of the same
+// loudspeaker. |aecm| keeps its own far end buffer, delay estimate, echo path
+// and suppression. A block is only taken over when |leader| has processed it
+// already and its far end samples match ours, otherwise |aecm| falls back to
+// its own FFT, so the output is the same as without sharing. |leader| must
+// outlive |aecm|. A NULL |leader| stops the sharing.
+//
+// Input:
+//      - aecm          : Pointer to the AECM instance
+//      - leader        : Pointer to the AECM instance to take the far end
+//                        spectrum from, or NULL
+//
+// Return value         :  0 - Ok
+//                        -1 - Error
+//
+int WebRtcAecm_ShareFarendCore(AecmCore* aecm, AecmCore* leader);
+
 ////////////////////////////////////////////////////////////////////////////////
 // WebRtcAecm_InitEchoPathCore(...)
 //
@@ -300,6 +331,42 @@ void WebRtcAecm_UpdateFarHistory(AecmCore* self,
 //
 const uint16_t* WebRtcAecm_AlignedFarend(AecmCore* self, int* far_q, int delay);
 
+////////////////////////////////////////////////////////////////////////////////
+// WebRtcAecm_FetchFarSpectrum()
+//
+// Copies the far end spectrum of the current block from the far end leader,
+// if it has computed it for the same far end samples.
+//
+// Inputs:
+//      - self              : Pointer to the AECM instance.
+//
+// Output:
+//      - far_spectrum      : The far end spectrum of the current block
+//      - far_q             : Its Q-domain
+//
+// Return value:
+//      - 1                 : Spectrum taken from the leader
+//      - 0                 : Not available, compute it locally
+//
+int WebRtcAecm_FetchFarSpectrum(AecmCore* self,
+                                uint16_t* far_spectrum,
+                                int* far_q);
+
+////////////////////////////////////////////////////////////////////////////////
+// WebRtcAecm_StoreFarSpectrum()
+//
+// Keeps the far end spectrum of the current block for the followers, if
+// there are any.
+//
+// Inputs:
+//      - self              : Pointer to the AECM instance.
+//      - far_spectrum      : The far end spectrum of the current block
+//      - far_q             : Its Q-domain
+//
+void WebRtcAecm_StoreFarSpectrum(AecmCore* self,
+                                 const uint16_t* far_spectrum,
+                                 int far_q);
+
 ///////////////////////////////////////////////////////////////////////////////
 // WebRtcAecm_CalcSuppressionGain()
 //
@@ -415,6 +482,13 @@ void WebRtcAecm_StoreAdaptiveChannelNeon(AecmCore* aecm,
 void WebRtcAecm_ResetAdaptiveChannelNeon(AecmCore* aecm);
 #endif
 
+// On x86 they are picked at runtime by these, defined in aecm_core_sse41.c and
+// aecm_core_avx2.c respectively.
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+void WebRtcAecm_InitSSE41(void);
+void WebRtcAecm_InitAVX2(void);
+#endif
+
 #if defined(MIPS32_LE)
 void WebRtcAecm_CalcLinearEnergies_mips(AecmCore* aecm,
                                         const uint16_t* far_spectrum,
@@ -0,0 +1,129 @@
+/*
+ *  Copyright (c) 2016 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+/*
+ * AVX2 versions of the AECM channel kernels, bit-exact with the C ones in
+ * aecm_core.c. Same algorithms as the SSE4.1 version, sixteen bins per pass.
+ */
+
+#include <immintrin.h>
+#include <string.h>
+
+#include "webrtc/modules/audio_processing/aecm/aecm_core.h"
+
+// Sum of the eight lanes, wrapping as the C accumulation does.
+static uint32_t AddLanes(__m256i v) {
+  __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(v),
+                              _mm256_extracti128_si256(v, 1));
+  sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+  sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+  return (uint32_t)_mm_cvtsi128_si32(sum);
+}
+
+static void CalcLinearEnergiesAVX2(AecmCore* aecm,
+                                   const uint16_t* far_spectrum,
+                                   int32_t* echo_est,
+                                   uint32_t* far_energy,
+                                   uint32_t* echo_energy_adapt,
+                                   uint32_t* echo_energy_stored) {
+  __m256i far_energy_v = _mm256_setzero_si256();
+  __m256i echo_adapt_v = _mm256_setzero_si256();
+  __m256i echo_stored_v = _mm256_setzero_si256();
+  int i;
+
+  for (i = 0; i < PART_LEN; i += 16) {
+    const __m256i spectrum =
+        _mm256_loadu_si256((const __m256i*)&far_spectrum[i]);
+    const __m256i stored =
+        _mm256_loadu_si256((const __m256i*)&aecm->channelStored[i]);
+    const __m256i adapt =
+        _mm256_loadu_si256((const __m256i*)&aecm->channelAdapt16[i]);
+    const __m256i spectrum_low =
+        _mm256_cvtepu16_epi32(_mm256_castsi256_si128(spectrum));
+    const __m256i spectrum_high =
+        _mm256_cvtepu16_epi32(_mm256_extracti128_si256(spectrum, 1));
+    const __m256i echo_est_low = _mm256_mullo_epi32(
+        _mm256_cvtepi16_epi32(_mm256_castsi256_si128(stored)), spectrum_low);
+    const __m256i echo_est_high = _mm256_mullo_epi32(
+        _mm256_cvtepi16_epi32(_mm256_extracti128_si256(stored, 1)),
+        spectrum_high);
+    const __m256i echo_adapt_low = _mm256_mullo_epi32(
+        _mm256_cvtepi16_epi32(_mm256_castsi256_si128(adapt)), spectrum_low);
+    const __m256i echo_adapt_high = _mm256_mullo_epi32(
+        _mm256_cvtepi16_epi32(_mm256_extracti128_si256(adapt, 1)),
+        spectrum_high);
+
+    _mm256_storeu_si256((__m256i*)&echo_est[i], echo_est_low);
+    _mm256_storeu_si256((__m256i*)&echo_est[i + 8], echo_est_high);
+    far_energy_v = _mm256_add_epi32(
+        far_energy_v, _mm256_add_epi32(spectrum_low, spectrum_high));
+    echo_stored_v = _mm256_add_epi32(
+        echo_stored_v, _mm256_add_epi32(echo_est_low, echo_est_high));
+    echo_adapt_v = _mm256_add_epi32(
+        echo_adapt_v, _mm256_add_epi32(echo_adapt_low, echo_adapt_high));
+  }
+
+  *far_energy += AddLanes(far_energy_v);
+  *echo_energy_stored += AddLanes(echo_stored_v);
+  *echo_energy_adapt += AddLanes(echo_adapt_v);
+
+  echo_est[PART_LEN] = WEBRTC_SPL_MUL_16_U16(aecm->channelStored[PART_LEN],
+                                             far_spectrum[PART_LEN]);
+  *far_energy += (uint32_t)far_spectrum[PART_LEN];
+  *echo_energy_adapt += aecm->channelAdapt16[PART_LEN] * far_spectrum[PART_LEN];
+  *echo_energy_stored += (uint32_t)echo_est[PART_LEN];
+}
+
+static void StoreAdaptiveChannelAVX2(AecmCore* aecm,
+                                     const uint16_t* far_spectrum,
+                                     int32_t* echo_est) {
+  int i;
+
+  // During startup we store the channel every block, and recalculate the echo
+  // estimate from it.
+  memcpy(aecm->channelStored, aecm->channelAdapt16,
+         sizeof(int16_t) * PART_LEN1);
+  for (i = 0; i < PART_LEN; i += 8) {
+    const __m128i spectrum =
+        _mm_loadu_si128((const __m128i*)&far_spectrum[i]);
+    const __m128i stored =
+        _mm_loadu_si128((const __m128i*)&aecm->channelStored[i]);
+    _mm256_storeu_si256((__m256i*)&echo_est[i],
+                        _mm256_mullo_epi32(_mm256_cvtepi16_epi32(stored),
+                                           _mm256_cvtepu16_epi32(spectrum)));
+  }
+  echo_est[PART_LEN] = WEBRTC_SPL_MUL_16_U16(aecm->channelStored[PART_LEN],
+                                             far_spectrum[PART_LEN]);
+}
+
+static void ResetAdaptiveChannelAVX2(AecmCore* aecm) {
+  int i;
+
+  // The stored channel has a significantly lower MSE than the adaptive one for
+  // two consecutive calculations. Reset the adaptive channel.
+  memcpy(aecm->channelAdapt16, aecm->channelStored,
+         sizeof(int16_t) * PART_LEN1);
+  // Restore the W32 channel.
+  for (i = 0; i < PART_LEN; i += 8) {
+    const __m128i stored =
+        _mm_loadu_si128((const __m128i*)&aecm->channelStored[i]);
+    _mm256_storeu_si256(
+        (__m256i*)&aecm->channelAdapt32[i],
+        _mm256_slli_epi32(_mm256_cvtepi16_epi32(stored), 16));
+  }
+  aecm->channelAdapt32[PART_LEN] =
+      (int32_t)aecm->channelStored[PART_LEN] << 16;
+}
+
+void WebRtcAecm_InitAVX2(void) {
+  WebRtcAecm_CalcLinearEnergies = CalcLinearEnergiesAVX2;
+  WebRtcAecm_StoreAdaptiveChannel = StoreAdaptiveChannelAVX2;
+  WebRtcAecm_ResetAdaptiveChannel = ResetAdaptiveChannelAVX2;
+}
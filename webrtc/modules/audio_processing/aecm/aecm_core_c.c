@@ -349,12 +349,17 @@ int WebRtcAecm_ProcessBlock(AecmCore* aecm,
            sizeof(int16_t) * PART_LEN);
   }
 
-  // Transform far end signal from time domain to frequency domain.
-  far_q = TimeToFrequencyDomain(aecm,
-                                aecm->xBuf,
-                                dfw,
-                                xfa,
-                                &xfaSum);
+  // Transform far end signal from time domain to frequency domain, unless
+  // the far end leader already did it for this block.
+  if (!WebRtcAecm_FetchFarSpectrum(aecm, xfa, &far_q))
+  {
+    far_q = TimeToFrequencyDomain(aecm,
+                                  aecm->xBuf,
+                                  dfw,
+                                  xfa,
+                                  &xfaSum);
+    WebRtcAecm_StoreFarSpectrum(aecm, xfa, far_q);
+  }
 
   // Transform noisy near end signal from time domain to frequency domain.
   zerosDBufNoisy = TimeToFrequencyDomain(aecm,
@@ -0,0 +1,132 @@
+/*
+ *  Copyright (c) 2016 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+/*
+ * SSE4.1 versions of the AECM channel kernels, bit-exact with the C ones in
+ * aecm_core.c. Each pass takes eight bins, widened to 32 bits for the products
+ * of the signed channel and the unsigned spectrum.
+ */
+
+#include <smmintrin.h>
+#include <string.h>
+
+#include "webrtc/modules/audio_processing/aecm/aecm_core.h"
+
+// Sum of the four lanes, wrapping as the C accumulation does.
+static uint32_t AddLanes(__m128i v) {
+  v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+  v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+  return (uint32_t)_mm_cvtsi128_si32(v);
+}
+
+static void CalcLinearEnergiesSSE41(AecmCore* aecm,
+                                    const uint16_t* far_spectrum,
+                                    int32_t* echo_est,
+                                    uint32_t* far_energy,
+                                    uint32_t* echo_energy_adapt,
+                                    uint32_t* echo_energy_stored) {
+  __m128i far_energy_v = _mm_setzero_si128();
+  __m128i echo_adapt_v = _mm_setzero_si128();
+  __m128i echo_stored_v = _mm_setzero_si128();
+  int i;
+
+  for (i = 0; i < PART_LEN; i += 8) {
+    const __m128i spectrum =
+        _mm_loadu_si128((const __m128i*)&far_spectrum[i]);
+    const __m128i stored =
+        _mm_loadu_si128((const __m128i*)&aecm->channelStored[i]);
+    const __m128i adapt =
+        _mm_loadu_si128((const __m128i*)&aecm->channelAdapt16[i]);
+    const __m128i spectrum_low = _mm_cvtepu16_epi32(spectrum);
+    const __m128i spectrum_high =
+        _mm_cvtepu16_epi32(_mm_srli_si128(spectrum, 8));
+    const __m128i echo_est_low =
+        _mm_mullo_epi32(_mm_cvtepi16_epi32(stored), spectrum_low);
+    const __m128i echo_est_high = _mm_mullo_epi32(
+        _mm_cvtepi16_epi32(_mm_srli_si128(stored, 8)), spectrum_high);
+    const __m128i echo_adapt_low =
+        _mm_mullo_epi32(_mm_cvtepi16_epi32(adapt), spectrum_low);
+    const __m128i echo_adapt_high = _mm_mullo_epi32(
+        _mm_cvtepi16_epi32(_mm_srli_si128(adapt, 8)), spectrum_high);
+
+    _mm_storeu_si128((__m128i*)&echo_est[i], echo_est_low);
+    _mm_storeu_si128((__m128i*)&echo_est[i + 4], echo_est_high);
+    far_energy_v = _mm_add_epi32(far_energy_v,
+                                 _mm_add_epi32(spectrum_low, spectrum_high));
+    echo_stored_v = _mm_add_epi32(echo_stored_v,
+                                  _mm_add_epi32(echo_est_low, echo_est_high));
+    echo_adapt_v = _mm_add_epi32(
+        echo_adapt_v, _mm_add_epi32(echo_adapt_low, echo_adapt_high));
+  }
+
+  *far_energy += AddLanes(far_energy_v);
+  *echo_energy_stored += AddLanes(echo_stored_v);
+  *echo_energy_adapt += AddLanes(echo_adapt_v);
+
+  echo_est[PART_LEN] = WEBRTC_SPL_MUL_16_U16(aecm->channelStored[PART_LEN],
+                                             far_spectrum[PART_LEN]);
+  *far_energy += (uint32_t)far_spectrum[PART_LEN];
+  *echo_energy_adapt += aecm->channelAdapt16[PART_LEN] * far_spectrum[PART_LEN];
+  *echo_energy_stored += (uint32_t)echo_est[PART_LEN];
+}
+
+static void StoreAdaptiveChannelSSE41(AecmCore* aecm,
+                                      const uint16_t* far_spectrum,
+                                      int32_t* echo_est) {
+  int i;
+
+  // During startup we store the channel every block, and recalculate the echo
+  // estimate from it.
+  memcpy(aecm->channelStored, aecm->channelAdapt16,
+         sizeof(int16_t) * PART_LEN1);
+  for (i = 0; i < PART_LEN; i += 8) {
+    const __m128i spectrum =
+        _mm_loadu_si128((const __m128i*)&far_spectrum[i]);
+    const __m128i stored =
+        _mm_loadu_si128((const __m128i*)&aecm->channelStored[i]);
+    _mm_storeu_si128(
+        (__m128i*)&echo_est[i],
+        _mm_mullo_epi32(_mm_cvtepi16_epi32(stored),
+                        _mm_cvtepu16_epi32(spectrum)));
+    _mm_storeu_si128(
+        (__m128i*)&echo_est[i + 4],
+        _mm_mullo_epi32(_mm_cvtepi16_epi32(_mm_srli_si128(stored, 8)),
+                        _mm_cvtepu16_epi32(_mm_srli_si128(spectrum, 8))));
+  }
+  echo_est[PART_LEN] = WEBRTC_SPL_MUL_16_U16(aecm->channelStored[PART_LEN],
+                                             far_spectrum[PART_LEN]);
+}
+
+static void ResetAdaptiveChannelSSE41(AecmCore* aecm) {
+  const __m128i zero = _mm_setzero_si128();
+  int i;
+
+  // The stored channel has a significantly lower MSE than the adaptive one for
+  // two consecutive calculations. Reset the adaptive channel.
+  memcpy(aecm->channelAdapt16, aecm->channelStored,
+         sizeof(int16_t) * PART_LEN1);
+  // Restore the W32 channel; interleaving with zeros shifts up by 16.
+  for (i = 0; i < PART_LEN; i += 8) {
+    const __m128i stored =
+        _mm_loadu_si128((const __m128i*)&aecm->channelStored[i]);
+    _mm_storeu_si128((__m128i*)&aecm->channelAdapt32[i],
+                     _mm_unpacklo_epi16(zero, stored));
+    _mm_storeu_si128((__m128i*)&aecm->channelAdapt32[i + 4],
+                     _mm_unpackhi_epi16(zero, stored));
+  }
+  aecm->channelAdapt32[PART_LEN] =
+      (int32_t)aecm->channelStored[PART_LEN] << 16;
+}
+
+void WebRtcAecm_InitSSE41(void) {
+  WebRtcAecm_CalcLinearEnergies = CalcLinearEnergiesSSE41;
+  WebRtcAecm_StoreAdaptiveChannel = StoreAdaptiveChannelSSE41;
+  WebRtcAecm_ResetAdaptiveChannel = ResetAdaptiveChannelSSE41;
+}
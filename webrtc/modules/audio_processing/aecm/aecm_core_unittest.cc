@@ -0,0 +1,180 @@
+/*
+ *  Copyright (c) 2016 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <string.h>
+
+#include <random>
+
+extern "C" {
+#include "webrtc/modules/audio_processing/aecm/aecm_core.h"
+}
+#include "testing/gtest/include/gtest/gtest.h"
+#include "webrtc/system_wrappers/include/cpu_features_wrapper.h"
+
+namespace webrtc {
+namespace {
+
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+
+WebRtc_CPUInfo g_cpu_info = NULL;
+
+int CPUInfoWithoutAVX2(CPUFeature feature) {
+  return feature == kAVX2 ? 0 : g_cpu_info(feature);
+}
+
+struct Kernels {
+  CalcLinearEnergies calc_linear_energies;
+  StoreAdaptiveChannel store_adaptive_channel;
+  ResetAdaptiveChannel reset_adaptive_channel;
+};
+
+// The kernels are picked by WebRtcAecm_InitCore() from the CPU features.
+void LoadKernels(WebRtc_CPUInfo cpu_info, Kernels* kernels) {
+  WebRtc_CPUInfo saved = WebRtc_GetCPUInfo;
+  AecmCore* aecm = WebRtcAecm_CreateCore();
+  ASSERT_TRUE(aecm);
+  WebRtc_GetCPUInfo = cpu_info;
+  const int error = WebRtcAecm_InitCore(aecm, 16000);
+  WebRtc_GetCPUInfo = saved;
+  WebRtcAecm_FreeCore(aecm);
+  ASSERT_EQ(0, error);
+  kernels->calc_linear_energies = WebRtcAecm_CalcLinearEnergies;
+  kernels->store_adaptive_channel = WebRtcAecm_StoreAdaptiveChannel;
+  kernels->reset_adaptive_channel = WebRtcAecm_ResetAdaptiveChannel;
+}
+
+// The SIMD kernels must match the C ones bit by bit, so that the fixed point
+// AECM gives the same output on every CPU.
+class AecmCoreTest : public ::testing::TestWithParam<bool> {
+ protected:
+  void SetUp() override {
+    g_cpu_info = WebRtc_GetCPUInfo;
+    const bool avx2 = GetParam();
+    supported_ = g_cpu_info(kSSE4_1) && (!avx2 || g_cpu_info(kAVX2));
+    if (!supported_) {
+      return;
+    }
+    LoadKernels(WebRtc_GetCPUInfoNoASM, &c_);
+    LoadKernels(avx2 ? g_cpu_info : CPUInfoWithoutAVX2, &simd_);
+    ASSERT_NE(c_.calc_linear_energies, simd_.calc_linear_energies);
+
+    aecm_c_ = WebRtcAecm_CreateCore();
+    aecm_simd_ = WebRtcAecm_CreateCore();
+    ASSERT_TRUE(aecm_c_);
+    ASSERT_TRUE(aecm_simd_);
+  }
+
+  void TearDown() override {
+    WebRtcAecm_FreeCore(aecm_c_);
+    WebRtcAecm_FreeCore(aecm_simd_);
+  }
+
+  // Random channels in both cores, over the full range of the Q-formats.
+  void FillChannels() {
+    for (int i = 0; i < PART_LEN1; ++i) {
+      aecm_c_->channelStored[i] = static_cast<int16_t>(random_());
+      aecm_c_->channelAdapt16[i] = static_cast<int16_t>(random_());
+      aecm_c_->channelAdapt32[i] = static_cast<int32_t>(random_());
+    }
+    memcpy(aecm_simd_->channelStored, aecm_c_->channelStored,
+           sizeof(int16_t) * PART_LEN1);
+    memcpy(aecm_simd_->channelAdapt16, aecm_c_->channelAdapt16,
+           sizeof(int16_t) * PART_LEN1);
+    memcpy(aecm_simd_->channelAdapt32, aecm_c_->channelAdapt32,
+           sizeof(int32_t) * PART_LEN1);
+  }
+
+  void FillSpectrum(uint16_t* spectrum) {
+    for (int i = 0; i < PART_LEN1; ++i) {
+      spectrum[i] = static_cast<uint16_t>(random_());
+    }
+  }
+
+  bool supported_ = false;
+  Kernels c_;
+  Kernels simd_;
+  AecmCore* aecm_c_ = nullptr;
+  AecmCore* aecm_simd_ = nullptr;
+  std::mt19937 random_;
+};
+
+TEST_P(AecmCoreTest, CalcLinearEnergies) {
+  if (!supported_) {
+    return;
+  }
+  uint16_t far_spectrum[PART_LEN1];
+  int32_t echo_est_c[PART_LEN1];
+  int32_t echo_est_simd[PART_LEN1];
+
+  for (int round = 0; round < 20; ++round) {
+    FillChannels();
+    FillSpectrum(far_spectrum);
+    // The energies are accumulated into what is there.
+    const uint32_t initial = random_();
+    uint32_t far_energy_c = initial;
+    uint32_t echo_adapt_c = initial;
+    uint32_t echo_stored_c = initial;
+    uint32_t far_energy_simd = initial;
+    uint32_t echo_adapt_simd = initial;
+    uint32_t echo_stored_simd = initial;
+
+    c_.calc_linear_energies(aecm_c_, far_spectrum, echo_est_c, &far_energy_c,
+                            &echo_adapt_c, &echo_stored_c);
+    simd_.calc_linear_energies(aecm_simd_, far_spectrum, echo_est_simd,
+                               &far_energy_simd, &echo_adapt_simd,
+                               &echo_stored_simd);
+    ASSERT_EQ(0, memcmp(echo_est_c, echo_est_simd, sizeof(echo_est_c)));
+    EXPECT_EQ(far_energy_c, far_energy_simd);
+    EXPECT_EQ(echo_adapt_c, echo_adapt_simd);
+    EXPECT_EQ(echo_stored_c, echo_stored_simd);
+  }
+}
+
+TEST_P(AecmCoreTest, StoreAdaptiveChannel) {
+  if (!supported_) {
+    return;
+  }
+  uint16_t far_spectrum[PART_LEN1];
+  int32_t echo_est_c[PART_LEN1];
+  int32_t echo_est_simd[PART_LEN1];
+
+  for (int round = 0; round < 20; ++round) {
+    FillChannels();
+    FillSpectrum(far_spectrum);
+    c_.store_adaptive_channel(aecm_c_, far_spectrum, echo_est_c);
+    simd_.store_adaptive_channel(aecm_simd_, far_spectrum, echo_est_simd);
+    ASSERT_EQ(0, memcmp(echo_est_c, echo_est_simd, sizeof(echo_est_c)));
+    ASSERT_EQ(0, memcmp(aecm_c_->channelStored, aecm_simd_->channelStored,
+                        sizeof(int16_t) * PART_LEN1));
+  }
+}
+
+TEST_P(AecmCoreTest, ResetAdaptiveChannel) {
+  if (!supported_) {
+    return;
+  }
+  for (int round = 0; round < 20; ++round) {
+    FillChannels();
+    c_.reset_adaptive_channel(aecm_c_);
+    simd_.reset_adaptive_channel(aecm_simd_);
+    ASSERT_EQ(0, memcmp(aecm_c_->channelAdapt16, aecm_simd_->channelAdapt16,
+                        sizeof(int16_t) * PART_LEN1));
+    ASSERT_EQ(0, memcmp(aecm_c_->channelAdapt32, aecm_simd_->channelAdapt32,
+                        sizeof(int32_t) * PART_LEN1));
+  }
+}
+
+// SSE4.1, then AVX2.
+INSTANTIATE_TEST_CASE_P(SSE41AndAVX2, AecmCoreTest, ::testing::Bool());
+
+#endif  // defined(WEBRTC_ARCH_X86_FAMILY)
+
+}  // namespace
+}  // namespace webrtc
@@ -24,6 +24,8 @@
 #define PART_LEN4       (PART_LEN << 2) /* Length of partition * 4. */
 #define FAR_BUF_LEN     PART_LEN4       /* Length of buffers. */
 #define MAX_DELAY       100
+#define FAR_CACHE_LEN   8              /* Far spectra kept for followers, */
+                                       /* power of 2. */
 
 /* Counter parameters */
 #define CONV_LEN        512          /* Convergence length used at startup. */
@@ -235,6 +235,25 @@ int32_t WebRtcAecm_BufferFarend(void *aecmInst, const int16_t *farend,
   return 0;
 }
 
+int32_t WebRtcAecm_ShareFarend(void *aecmInst, void *leaderInst)
+{
+    AecMobile* aecm = aecmInst;
+    AecMobile* leader = leaderInst;
+
+    if (aecm == NULL)
+    {
+        return -1;
+    }
+
+    if (WebRtcAecm_ShareFarendCore(aecm->aecmCore,
+                                   leader ? leader->aecmCore : NULL) != 0)
+    {
+        return AECM_BAD_PARAMETER_ERROR;
+    }
+
+    return 0;
+}
+
 int32_t WebRtcAecm_Process(void *aecmInst, const int16_t *nearendNoisy,
                            const int16_t *nearendClean, int16_t *out,
                            size_t nrOfSamples, int16_t msInSndCardBuf)
@@ -108,6 +108,28 @@ int32_t WebRtcAecm_GetBufferFarendError(void* aecmInst,
                                         const int16_t* farend,
                                         size_t nrOfSamples);
 
+/*
+ * Lets |aecmInst| take the far end spectrum of each block from |leaderInst|
+ * instead of computing its own FFT, for several microphones cancelling the
+ * echo of one loudspeaker. It pays off when both get the same farend and
+ * msInSndCardBuf and the leader is processed first on every frame; blocks
+ * the leader has not analyzed for the same samples are computed locally, so
+ * the output does not change. Pass a NULL |leaderInst| to stop sharing.
+ * The leader must outlive |aecmInst| and cannot follow another instance.
+ *
+ * Inputs                       Description
+ * -------------------------------------------------------------------
+ * void*          aecmInst      Pointer to the AECM instance
+ * void*          leaderInst    Pointer to the AECM instance analyzing
+ *                              the far end, or NULL
+ *
+ * Outputs                      Description
+ * -------------------------------------------------------------------
+ * int32_t        return        0: OK
+ *                              1200-12004,12100: error/warning
+ */
+int32_t WebRtcAecm_ShareFarend(void* aecmInst, void* leaderInst);
+
 /*
  * Runs the AECM on an 80 or 160 sample blocks of data.
  *
@@ -0,0 +1,176 @@
+/*
+ *  Copyright (c) 2016 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/modules/audio_processing/aecm/echo_control_mobile.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace webrtc {
+namespace {
+
+const int kSampleRateHz = 16000;
+const size_t kFrameSamples = 160;
+const int kNumFrames = 500;
+const int kNumMics = 3;
+const int16_t kDelayMs = 40;
+
+// A far end of a few tones, heard by each microphone with its own gain and
+// echo delay, on top of its own low level noise.
+void GenerateFrame(int frame,
+                   int16_t* far,
+                   int16_t near[kNumMics][kFrameSamples]) {
+  for (size_t i = 0; i < kFrameSamples; ++i) {
+    const int n = frame * kFrameSamples + i;
+    far[i] = static_cast<int16_t>(
+        6000 * sin(2 * M_PI * 440 * n / kSampleRateHz) +
+        3000 * sin(2 * M_PI * 1250 * n / kSampleRateHz + 0.3 * frame));
+  }
+  for (int mic = 0; mic < kNumMics; ++mic) {
+    for (size_t i = 0; i < kFrameSamples; ++i) {
+      const int n = frame * kFrameSamples + i - 160 * (mic + 2);
+      const double echo = (4000 - 1000 * mic) *
+          sin(2 * M_PI * 440 * n / kSampleRateHz);
+      near[mic][i] = static_cast<int16_t>(
+          echo + ((n * (mic + 7) * 2654435761u) >> 24) % 200 - 100);
+    }
+  }
+}
+
+// Like GenerateFrame, but every microphone hears its own loudspeaker, as with
+// one far end channel per microphone.
+void GenerateDistinctFrame(int frame,
+                           int16_t far[kNumMics][kFrameSamples],
+                           int16_t near[kNumMics][kFrameSamples]) {
+  for (int mic = 0; mic < kNumMics; ++mic) {
+    const double freq = 440 + 170 * mic;
+    for (size_t i = 0; i < kFrameSamples; ++i) {
+      const int n = frame * kFrameSamples + i;
+      far[mic][i] = static_cast<int16_t>(
+          6000 * sin(2 * M_PI * freq * n / kSampleRateHz) +
+          3000 * sin(2 * M_PI * (1250 - 90 * mic) * n / kSampleRateHz));
+    }
+    for (size_t i = 0; i < kFrameSamples; ++i) {
+      const int n = frame * kFrameSamples + i - 160 * (mic + 2);
+      const double echo = 4000 * sin(2 * M_PI * freq * n / kSampleRateHz);
+      near[mic][i] = static_cast<int16_t>(
+          echo + ((n * (mic + 7) * 2654435761u) >> 24) % 200 - 100);
+    }
+  }
+}
+
+}  // namespace
+
+TEST(EchoControlMobileTest, ShareFarendRejectsBadParameters) {
+  void* leader = WebRtcAecm_Create();
+  void* follower = WebRtcAecm_Create();
+  ASSERT_TRUE(leader);
+  ASSERT_TRUE(follower);
+
+  EXPECT_NE(0, WebRtcAecm_ShareFarend(NULL, leader));
+  EXPECT_NE(0, WebRtcAecm_ShareFarend(leader, leader));
+  EXPECT_EQ(0, WebRtcAecm_ShareFarend(follower, leader));
+  // A leader cannot follow in turn.
+  EXPECT_NE(0, WebRtcAecm_ShareFarend(leader, follower));
+  EXPECT_EQ(0, WebRtcAecm_ShareFarend(follower, NULL));
+  EXPECT_EQ(0, WebRtcAecm_ShareFarend(leader, follower));
+
+  WebRtcAecm_Free(follower);
+  WebRtcAecm_Free(leader);
+}
+
+// Instances following a far end leader must produce exactly what they
+// produce when computing the far end spectrum themselves.
+TEST(EchoControlMobileTest, SharedFarendIsBitExact) {
+  void* own[kNumMics];
+  void* shared[kNumMics];
+  int16_t far[kFrameSamples];
+  int16_t near[kNumMics][kFrameSamples];
+  int16_t own_out[kFrameSamples];
+  int16_t shared_out[kFrameSamples];
+
+  for (int mic = 0; mic < kNumMics; ++mic) {
+    own[mic] = WebRtcAecm_Create();
+    shared[mic] = WebRtcAecm_Create();
+    ASSERT_TRUE(own[mic]);
+    ASSERT_TRUE(shared[mic]);
+    ASSERT_EQ(0, WebRtcAecm_Init(own[mic], kSampleRateHz));
+    ASSERT_EQ(0, WebRtcAecm_Init(shared[mic], kSampleRateHz));
+    if (mic > 0) {
+      ASSERT_EQ(0, WebRtcAecm_ShareFarend(shared[mic], shared[0]));
+    }
+  }
+
+  for (int frame = 0; frame < kNumFrames; ++frame) {
+    GenerateFrame(frame, far, near);
+    for (int mic = 0; mic < kNumMics; ++mic) {
+      ASSERT_EQ(0, WebRtcAecm_BufferFarend(own[mic], far, kFrameSamples));
+      ASSERT_EQ(0, WebRtcAecm_BufferFarend(shared[mic], far, kFrameSamples));
+      ASSERT_EQ(0, WebRtcAecm_Process(own[mic], near[mic], NULL, own_out,
+                                      kFrameSamples, kDelayMs));
+      ASSERT_EQ(0, WebRtcAecm_Process(shared[mic], near[mic], NULL,
+                                      shared_out, kFrameSamples, kDelayMs));
+      ASSERT_EQ(0, memcmp(own_out, shared_out, sizeof(own_out)))
+          << "mic " << mic << ", frame " << frame;
+    }
+  }
+
+  for (int mic = kNumMics - 1; mic >= 0; --mic) {
+    WebRtcAecm_Free(own[mic]);
+    WebRtcAecm_Free(shared[mic]);
+  }
+}
+
+// Followers fed another far end than their leader must not take over its
+// spectra, each cancels the echo of its own far end exactly as alone.
+TEST(EchoControlMobileTest, SharedDistinctFarendsAreBitExact) {
+  void* own[kNumMics];
+  void* shared[kNumMics];
+  int16_t far[kNumMics][kFrameSamples];
+  int16_t near[kNumMics][kFrameSamples];
+  int16_t own_out[kFrameSamples];
+  int16_t shared_out[kFrameSamples];
+
+  for (int mic = 0; mic < kNumMics; ++mic) {
+    own[mic] = WebRtcAecm_Create();
+    shared[mic] = WebRtcAecm_Create();
+    ASSERT_TRUE(own[mic]);
+    ASSERT_TRUE(shared[mic]);
+    ASSERT_EQ(0, WebRtcAecm_Init(own[mic], kSampleRateHz));
+    ASSERT_EQ(0, WebRtcAecm_Init(shared[mic], kSampleRateHz));
+    if (mic > 0) {
+      ASSERT_EQ(0, WebRtcAecm_ShareFarend(shared[mic], shared[0]));
+    }
+  }
+
+  for (int frame = 0; frame < kNumFrames; ++frame) {
+    GenerateDistinctFrame(frame, far, near);
+    for (int mic = 0; mic < kNumMics; ++mic) {
+      ASSERT_EQ(0, WebRtcAecm_BufferFarend(own[mic], far[mic], kFrameSamples));
+      ASSERT_EQ(0,
+                WebRtcAecm_BufferFarend(shared[mic], far[mic], kFrameSamples));
+      ASSERT_EQ(0, WebRtcAecm_Process(own[mic], near[mic], NULL, own_out,
+                                      kFrameSamples, kDelayMs));
+      ASSERT_EQ(0, WebRtcAecm_Process(shared[mic], near[mic], NULL,
+                                      shared_out, kFrameSamples, kDelayMs));
+      ASSERT_EQ(0, memcmp(own_out, shared_out, sizeof(own_out)))
+          << "mic " << mic << ", frame " << frame;
+    }
+  }
+
+  for (int mic = kNumMics - 1; mic >= 0; --mic) {
+    WebRtcAecm_Free(own[mic]);
+    WebRtcAecm_Free(shared[mic]);
+  }
+}
+
+}  // namespace webrtc
@@ -66,41 +66,66 @@ AudioBuffer::AudioBuffer(size_t input_num_frames,
   assert(output_num_frames_ > 0);
   assert(num_input_channels_ > 0);
   assert(num_proc_channels_ > 0 && num_proc_channels_ <= num_input_channels_);
+}
 
-  if (input_num_frames_ != proc_num_frames_ ||
-      output_num_frames_ != proc_num_frames_) {
-    // Create an intermediate buffer for resampling.
-    process_buffer_.reset(new ChannelBuffer<float>(proc_num_frames_,
-                                                   num_proc_channels_));
-
-    if (input_num_frames_ != proc_num_frames_) {
-      for (size_t i = 0; i < num_proc_channels_; ++i) {
-        input_resamplers_.push_back(
-            new PushSincResampler(input_num_frames_,
-                                  proc_num_frames_));
-      }
-    }
+AudioBuffer::~AudioBuffer() {}
 
-    if (output_num_frames_ != proc_num_frames_) {
-      for (size_t i = 0; i < num_proc_channels_; ++i) {
-        output_resamplers_.push_back(
-            new PushSincResampler(proc_num_frames_,
-                                  output_num_frames_));
-      }
-    }
+void AudioBuffer::Reset() {
+  InitForNewData();
+  if (splitting_filter_) {
+    splitting_filter_->Reset();
+  }
+  for (PushSincResampler* resampler : input_resamplers_) {
+    resampler->Reset();
+  }
+  for (PushSincResampler* resampler : output_resamplers_) {
+    resampler->Reset();
   }
+}
 
-  if (num_bands_ > 1) {
+bool AudioBuffer::HasFormat(size_t input_num_frames,
+                            size_t num_input_channels,
+                            size_t process_num_frames,
+                            size_t num_process_channels,
+                            size_t output_num_frames) const {
+  return input_num_frames_ == input_num_frames &&
+         num_input_channels_ == num_input_channels &&
+         proc_num_frames_ == process_num_frames &&
+         num_proc_channels_ == num_process_channels &&
+         output_num_frames_ == output_num_frames;
+}
+
+IFChannelBuffer* AudioBuffer::split_data_buffer() const {
+  assert(num_bands_ > 1);
+  if (!split_data_) {
     split_data_.reset(new IFChannelBuffer(proc_num_frames_,
                                           num_proc_channels_,
                                           num_bands_));
-    splitting_filter_.reset(new SplittingFilter(num_proc_channels_,
-                                                num_bands_,
-                                                proc_num_frames_));
   }
+  return split_data_.get();
 }
 
-AudioBuffer::~AudioBuffer() {}
+ChannelBuffer<float>* AudioBuffer::process_buffer() {
+  if (!process_buffer_) {
+    process_buffer_.reset(new ChannelBuffer<float>(proc_num_frames_,
+                                                   num_proc_channels_));
+  }
+  return process_buffer_.get();
+}
+
+void AudioBuffer::CreateResamplers(
+    size_t source_frames,
+    size_t destination_frames,
+    ScopedVector<PushSincResampler>* resamplers) {
+  if (!resamplers->empty()) {
+    return;
+  }
+  resamplers->reserve(num_proc_channels_);
+  for (size_t i = 0; i < num_proc_channels_; ++i) {
+    resamplers->push_back(
+        new PushSincResampler(source_frames, destination_frames));
+  }
+}
 
 void AudioBuffer::CopyFrom(const float* const* data,
                            const StreamConfig& stream_config) {
@@ -130,13 +155,14 @@ void AudioBuffer::CopyFrom(const float* const* data,
 
   // Resample.
   if (input_num_frames_ != proc_num_frames_) {
+    CreateResamplers(input_num_frames_, proc_num_frames_, &input_resamplers_);
     for (size_t i = 0; i < num_proc_channels_; ++i) {
       input_resamplers_[i]->Resample(data_ptr[i],
                                      input_num_frames_,
-                                     process_buffer_->channels()[i],
+                                     process_buffer()->channels()[i],
                                      proc_num_frames_);
     }
-    data_ptr = process_buffer_->channels();
+    data_ptr = process_buffer()->channels();
   }
 
   // Convert to the S16 range.
@@ -156,7 +182,7 @@ void AudioBuffer::CopyTo(const StreamConfig& stream_config,
   float* const* data_ptr = data;
   if (output_num_frames_ != proc_num_frames_) {
     // Convert to an intermediate buffer for subsequent resampling.
-    data_ptr = process_buffer_->channels();
+    data_ptr = process_buffer()->channels();
   }
   for (size_t i = 0; i < num_channels_; ++i) {
     FloatS16ToFloat(data_->fbuf()->channels()[i],
@@ -166,6 +192,7 @@ void AudioBuffer::CopyTo(const StreamConfig& stream_config,
 
   // Resample.
   if (output_num_frames_ != proc_num_frames_) {
+    CreateResamplers(proc_num_frames_, output_num_frames_, &output_resamplers_);
     for (size_t i = 0; i < num_channels_; ++i) {
       output_resamplers_[i]->Resample(data_ptr[i],
                                       proc_num_frames_,
@@ -198,21 +225,21 @@ int16_t* const* AudioBuffer::channels() {
 }
 
 const int16_t* const* AudioBuffer::split_bands_const(size_t channel) const {
-  return split_data_.get() ?
-         split_data_->ibuf_const()->bands(channel) :
+  return num_bands_ > 1 ?
+         split_data_buffer()->ibuf_const()->bands(channel) :
          data_->ibuf_const()->bands(channel);
 }
 
 int16_t* const* AudioBuffer::split_bands(size_t channel) {
   mixed_low_pass_valid_ = false;
-  return split_data_.get() ?
-         split_data_->ibuf()->bands(channel) :
+  return num_bands_ > 1 ?
+         split_data_buffer()->ibuf()->bands(channel) :
          data_->ibuf()->bands(channel);
 }
 
 const int16_t* const* AudioBuffer::split_channels_const(Band band) const {
-  if (split_data_.get()) {
-    return split_data_->ibuf_const()->channels(band);
+  if (num_bands_ > 1) {
+    return split_data_buffer()->ibuf_const()->channels(band);
   } else {
     return band == kBand0To8kHz ? data_->ibuf_const()->channels() : nullptr;
   }
@@ -220,8 +247,8 @@ const int16_t* const* AudioBuffer::split_channels_const(Band band) const {
 
 int16_t* const* AudioBuffer::split_channels(Band band) {
   mixed_low_pass_valid_ = false;
-  if (split_data_.get()) {
-    return split_data_->ibuf()->channels(band);
+  if (num_bands_ > 1) {
+    return split_data_buffer()->ibuf()->channels(band);
   } else {
     return band == kBand0To8kHz ? data_->ibuf()->channels() : nullptr;
   }
@@ -238,11 +265,11 @@ const ChannelBuffer<int16_t>* AudioBuffer::data() const {
 
 ChannelBuffer<int16_t>* AudioBuffer::split_data() {
   mixed_low_pass_valid_ = false;
-  return split_data_.get() ? split_data_->ibuf() : data_->ibuf();
+  return num_bands_ > 1 ? split_data_buffer()->ibuf() : data_->ibuf();
 }
 
 const ChannelBuffer<int16_t>* AudioBuffer::split_data() const {
-  return split_data_.get() ? split_data_->ibuf_const() : data_->ibuf_const();
+  return num_bands_ > 1 ? split_data_buffer()->ibuf_const() : data_->ibuf_const();
 }
 
 const float* const* AudioBuffer::channels_const_f() const {
@@ -255,21 +282,21 @@ float* const* AudioBuffer::channels_f() {
 }
 
 const float* const* AudioBuffer::split_bands_const_f(size_t channel) const {
-  return split_data_.get() ?
-         split_data_->fbuf_const()->bands(channel) :
+  return num_bands_ > 1 ?
+         split_data_buffer()->fbuf_const()->bands(channel) :
          data_->fbuf_const()->bands(channel);
 }
 
 float* const* AudioBuffer::split_bands_f(size_t channel) {
   mixed_low_pass_valid_ = false;
-  return split_data_.get() ?
-         split_data_->fbuf()->bands(channel) :
+  return num_bands_ > 1 ?
+         split_data_buffer()->fbuf()->bands(channel) :
          data_->fbuf()->bands(channel);
 }
 
 const float* const* AudioBuffer::split_channels_const_f(Band band) const {
-  if (split_data_.get()) {
-    return split_data_->fbuf_const()->channels(band);
+  if (num_bands_ > 1) {
+    return split_data_buffer()->fbuf_const()->channels(band);
   } else {
     return band == kBand0To8kHz ? data_->fbuf_const()->channels() : nullptr;
   }
@@ -277,8 +304,8 @@ const float* const* AudioBuffer::split_channels_const_f(Band band) const {
 
 float* const* AudioBuffer::split_channels_f(Band band) {
   mixed_low_pass_valid_ = false;
-  if (split_data_.get()) {
-    return split_data_->fbuf()->channels(band);
+  if (num_bands_ > 1) {
+    return split_data_buffer()->fbuf()->channels(band);
   } else {
     return band == kBand0To8kHz ? data_->fbuf()->channels() : nullptr;
   }
@@ -295,11 +322,11 @@ const ChannelBuffer<float>* AudioBuffer::data_f() const {
 
 ChannelBuffer<float>* AudioBuffer::split_data_f() {
   mixed_low_pass_valid_ = false;
-  return split_data_.get() ? split_data_->fbuf() : data_->fbuf();
+  return num_bands_ > 1 ? split_data_buffer()->fbuf() : data_->fbuf();
 }
 
 const ChannelBuffer<float>* AudioBuffer::split_data_f() const {
-  return split_data_.get() ? split_data_->fbuf_const() : data_->fbuf_const();
+  return num_bands_ > 1 ? split_data_buffer()->fbuf_const() : data_->fbuf_const();
 }
 
 const int16_t* AudioBuffer::mixed_low_pass_data() {
@@ -398,6 +425,7 @@ void AudioBuffer::DeinterleaveFrom(AudioFrame* frame) {
 
   // Resample.
   if (input_num_frames_ != proc_num_frames_) {
+    CreateResamplers(input_num_frames_, proc_num_frames_, &input_resamplers_);
     for (size_t i = 0; i < num_proc_channels_; ++i) {
       input_resamplers_[i]->Resample(input_buffer_->fbuf_const()->channels()[i],
                                      input_num_frames_,
@@ -423,6 +451,7 @@ void AudioBuffer::InterleaveTo(AudioFrame* frame, bool data_changed) {
       output_buffer_.reset(
           new IFChannelBuffer(output_num_frames_, num_channels_));
     }
+    CreateResamplers(proc_num_frames_, output_num_frames_, &output_resamplers_);
     for (size_t i = 0; i < num_channels_; ++i) {
       output_resamplers_[i]->Resample(
           data_->fbuf()->channels()[i], proc_num_frames_,
@@ -457,11 +486,57 @@ void AudioBuffer::CopyLowPassToReference() {
 }
 
 void AudioBuffer::SplitIntoFrequencyBands() {
-  splitting_filter_->Analysis(data_.get(), split_data_.get());
+  if (!splitting_filter_) {
+    splitting_filter_.reset(new SplittingFilter(num_proc_channels_,
+                                                num_bands_,
+                                                proc_num_frames_));
+  }
+  splitting_filter_->Analysis(data_.get(), split_data_buffer());
 }
 
 void AudioBuffer::MergeFrequencyBands() {
-  splitting_filter_->Synthesis(split_data_.get(), data_.get());
+  assert(splitting_filter_);
+  splitting_filter_->Synthesis(split_data_buffer(), data_.get());
+}
+
+const size_t AudioBufferPool::kMaxBuffers;
+
+AudioBufferPool::AudioBufferPool() {
+  buffers_.reserve(kMaxBuffers + 1);
+}
+
+AudioBufferPool::~AudioBufferPool() {}
+
+rtc::scoped_ptr<AudioBuffer> AudioBufferPool::Get(
+    size_t input_num_frames,
+    size_t num_input_channels,
+    size_t process_num_frames,
+    size_t num_process_channels,
+    size_t output_num_frames) {
+  // The most recently put buffers are the most likely to be asked for again.
+  for (size_t i = buffers_.size(); i > 0; --i) {
+    AudioBuffer* buffer = buffers_[i - 1];
+    if (buffer->HasFormat(input_num_frames, num_input_channels,
+                          process_num_frames, num_process_channels,
+                          output_num_frames)) {
+      buffers_.weak_erase(buffers_.begin() + (i - 1));
+      buffer->Reset();
+      return rtc::scoped_ptr<AudioBuffer>(buffer);
+    }
+  }
+  return rtc::scoped_ptr<AudioBuffer>(
+      new AudioBuffer(input_num_frames, num_input_channels, process_num_frames,
+                      num_process_channels, output_num_frames));
+}
+
+void AudioBufferPool::Put(rtc::scoped_ptr<AudioBuffer> buffer) {
+  if (!buffer) {
+    return;
+  }
+  buffers_.push_back(buffer.release());
+  if (buffers_.size() > kMaxBuffers) {
+    buffers_.erase(buffers_.begin());
+  }
 }
 
 }  // namespace webrtc
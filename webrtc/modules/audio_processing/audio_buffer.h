@@ -121,10 +121,28 @@ class AudioBuffer {
   // Recombine the different bands into one signal.
   void MergeFrequencyBands();
 
+  // Returns the buffer to the state it was constructed in, keeping what it
+  // has allocated, so that it can take a new stream of the same format.
+  void Reset();
+
+  bool HasFormat(size_t input_num_frames,
+                 size_t num_input_channels,
+                 size_t process_num_frames,
+                 size_t num_process_channels,
+                 size_t output_num_frames) const;
+
  private:
   // Called from DeinterleaveFrom() and CopyFrom().
   void InitForNewData();
 
+  // The split bands, the splitting filter, the resamplers and the
+  // intermediate buffers are only allocated once they are needed.
+  IFChannelBuffer* split_data_buffer() const;
+  ChannelBuffer<float>* process_buffer();
+  void CreateResamplers(size_t source_frames,
+                        size_t destination_frames,
+                        ScopedVector<PushSincResampler>* resamplers);
+
   // The audio is passed into DeinterleaveFrom() or CopyFrom() with input
   // format (samples per channel and number of channels).
   const size_t input_num_frames_;
@@ -147,7 +165,7 @@ class AudioBuffer {
 
   const float* keyboard_data_;
   rtc::scoped_ptr<IFChannelBuffer> data_;
-  rtc::scoped_ptr<IFChannelBuffer> split_data_;
+  mutable rtc::scoped_ptr<IFChannelBuffer> split_data_;
   rtc::scoped_ptr<SplittingFilter> splitting_filter_;
   rtc::scoped_ptr<ChannelBuffer<int16_t> > mixed_low_pass_channels_;
   rtc::scoped_ptr<ChannelBuffer<int16_t> > low_pass_reference_channels_;
@@ -158,6 +176,35 @@ class AudioBuffer {
   ScopedVector<PushSincResampler> output_resamplers_;
 };
 
+// Keeps the AudioBuffers of the formats used last, so that going back to one
+// of them reuses its buffers, filters and resamplers instead of allocating
+// them again. Not thread safe.
+class AudioBufferPool {
+ public:
+  static const size_t kMaxBuffers = 4;
+
+  AudioBufferPool();
+  ~AudioBufferPool();
+
+  // Returns a buffer of the given format: one from the pool, reset, if it
+  // holds one, a new one otherwise.
+  rtc::scoped_ptr<AudioBuffer> Get(size_t input_num_frames,
+                                   size_t num_input_channels,
+                                   size_t process_num_frames,
+                                   size_t num_process_channels,
+                                   size_t output_num_frames);
+
+  // Keeps |buffer|, if any, for a later Get() of its format. The buffer put
+  // back the longest ago is dropped when the pool is full.
+  void Put(rtc::scoped_ptr<AudioBuffer> buffer);
+
+  size_t size() const { return buffers_.size(); }
+
+ private:
+  // Least recently put first.
+  ScopedVector<AudioBuffer> buffers_;
+};
+
 }  // namespace webrtc
 
 #endif  // WEBRTC_MODULES_AUDIO_PROCESSING_AUDIO_BUFFER_H_
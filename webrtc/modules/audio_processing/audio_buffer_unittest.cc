@@ -0,0 +1,125 @@
+/*
+ *  Copyright (c) 2016 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <math.h>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "testing/gtest/include/gtest/gtest.h"
+#include "webrtc/common_audio/channel_buffer.h"
+#include "webrtc/modules/audio_processing/audio_buffer.h"
+
+namespace webrtc {
+namespace {
+
+const size_t kChannels = 2;
+const int kFrames = 20;
+
+// Runs |frames| 10 ms frames of a 44.1 kHz stereo sweep through |buffer|,
+// resampled to 32 kHz and split into bands on the way, and back out at
+// 48 kHz. Returns the output of the last frame.
+std::vector<float> ProcessFrames(AudioBuffer* buffer, int frames) {
+  const StreamConfig input_config(44100, kChannels);
+  const StreamConfig output_config(48000, kChannels);
+  ChannelBuffer<float> input(input_config.num_frames(), kChannels);
+  ChannelBuffer<float> output(output_config.num_frames(), kChannels);
+  for (int frame = 0; frame < frames; ++frame) {
+    for (size_t c = 0; c < kChannels; ++c) {
+      for (size_t i = 0; i < input.num_frames(); ++i) {
+        const size_t t = frame * input.num_frames() + i;
+        input.channels()[c][i] = 0.5f * sinf(1e-5f * (c + 1) * t * t);
+      }
+    }
+    buffer->CopyFrom(input.channels(), input_config);
+    buffer->SplitIntoFrequencyBands();
+    buffer->MergeFrequencyBands();
+    buffer->CopyTo(output_config, output.channels());
+  }
+  return std::vector<float>(output.channels()[0],
+                            output.channels()[0] + output.num_frames());
+}
+
+rtc::scoped_ptr<AudioBuffer> Get(AudioBufferPool* pool,
+                                 size_t process_num_frames) {
+  return pool->Get(441, kChannels, process_num_frames, kChannels, 480);
+}
+
+}  // namespace
+
+TEST(AudioBufferTest, SplitDataIsOnlyAvailableWithBands) {
+  AudioBuffer buffer(160, 1, 160, 1, 160);
+  EXPECT_EQ(1u, buffer.num_bands());
+  EXPECT_EQ(buffer.channels_f(), buffer.split_channels_f(kBand0To8kHz));
+  EXPECT_EQ(nullptr, buffer.split_channels_f(kBand8To16kHz));
+
+  AudioBuffer split_buffer(480, 1, 480, 1, 480);
+  EXPECT_EQ(3u, split_buffer.num_bands());
+  EXPECT_NE(nullptr, split_buffer.split_channels_f(kBand16To24kHz));
+  EXPECT_EQ(0, split_buffer.split_channels_const(kBand8To16kHz)[0][0]);
+}
+
+TEST(AudioBufferPoolTest, ReusesBuffersOfTheSameFormat) {
+  AudioBufferPool pool;
+  rtc::scoped_ptr<AudioBuffer> buffer = Get(&pool, 320);
+  AudioBuffer* const buffer_320 = buffer.get();
+  pool.Put(std::move(buffer));
+  EXPECT_EQ(1u, pool.size());
+
+  buffer = Get(&pool, 160);
+  EXPECT_NE(buffer_320, buffer.get());
+  pool.Put(std::move(buffer));
+  EXPECT_EQ(2u, pool.size());
+
+  buffer = Get(&pool, 320);
+  EXPECT_EQ(buffer_320, buffer.get());
+  EXPECT_EQ(1u, pool.size());
+
+  pool.Put(rtc::scoped_ptr<AudioBuffer>());
+  EXPECT_EQ(1u, pool.size());
+}
+
+TEST(AudioBufferPoolTest, ReusedBufferProcessesLikeANewOne) {
+  AudioBufferPool pool;
+  rtc::scoped_ptr<AudioBuffer> buffer = Get(&pool, 320);
+  ProcessFrames(buffer.get(), kFrames);
+  AudioBuffer* const used = buffer.get();
+  pool.Put(std::move(buffer));
+
+  buffer = Get(&pool, 320);
+  ASSERT_EQ(used, buffer.get());
+  AudioBuffer fresh(441, kChannels, 320, kChannels, 480);
+  EXPECT_EQ(ProcessFrames(&fresh, kFrames),
+            ProcessFrames(buffer.get(), kFrames));
+}
+
+TEST(AudioBufferPoolTest, DropsTheOldestBuffers) {
+  AudioBufferPool pool;
+  const size_t kFormats = AudioBufferPool::kMaxBuffers + 2;
+  std::vector<AudioBuffer*> buffers;
+  for (size_t i = 0; i < kFormats; ++i) {
+    rtc::scoped_ptr<AudioBuffer> buffer = Get(&pool, 160 * (i + 1));
+    buffers.push_back(buffer.get());
+    pool.Put(std::move(buffer));
+    EXPECT_EQ(std::min(i + 1, AudioBufferPool::kMaxBuffers), pool.size());
+  }
+
+  // The last ones are kept, the first ones were dropped.
+  for (size_t i = kFormats; i > 0; --i) {
+    rtc::scoped_ptr<AudioBuffer> buffer = Get(&pool, 160 * i);
+    if (i > kFormats - AudioBufferPool::kMaxBuffers) {
+      EXPECT_EQ(buffers[i - 1], buffer.get());
+    }
+  }
+  EXPECT_EQ(0u, pool.size());
+}
+
+}  // namespace webrtc
@@ -11,8 +11,11 @@
 #include "webrtc/modules/audio_processing/audio_processing_impl.h"
 
 #include <assert.h>
+#include <math.h>
 #include <algorithm>
+#include <utility>
 
+#include "webrtc/base/atomicops.h"
 #include "webrtc/base/checks.h"
 #include "webrtc/base/platform_file.h"
 #include "webrtc/base/trace_event.h"
@@ -75,6 +78,22 @@ static bool LayoutHasKeyboard(AudioProcessing::ChannelLayout layout) {
   assert(false);
   return false;
 }
+
+// Frames both sides need to be silent for before capture frames are skipped,
+// long enough for the echo tail and the noise suppression to die out.
+const int kSilentFramesBeforeSkipping = 50;
+
+// Mean square of the full band channels, in the int16 range.
+float MeanSquare(const AudioBuffer& audio) {
+  float sum_square = 0.f;
+  for (size_t i = 0; i < audio.num_channels(); ++i) {
+    const float* channel = audio.channels_const_f()[i];
+    for (size_t j = 0; j < audio.num_frames(); ++j) {
+      sum_square += channel[j] * channel[j];
+    }
+  }
+  return sum_square / (audio.num_channels() * audio.num_frames());
+}
 }  // namespace
 
 // Throughout webrtc, it's assumed that success is represented by zero.
@@ -277,8 +296,8 @@ AudioProcessingImpl::~AudioProcessingImpl() {
   }
 
 #ifdef WEBRTC_AUDIOPROC_DEBUG_DUMP
-  if (debug_dump_.debug_file->Open()) {
-    debug_dump_.debug_file->CloseFile();
+  if (debug_dump_.writer) {
+    debug_dump_.writer->Stop();
   }
 #endif
 }
@@ -352,13 +371,14 @@ int AudioProcessingImpl::InitializeLocked() {
       formats_.api_format.reverse_output_stream().num_frames() == 0
           ? formats_.rev_proc_format.num_frames()
           : formats_.api_format.reverse_output_stream().num_frames();
+  render_.audio_buffer_pool.Put(std::move(render_.render_audio));
   if (formats_.api_format.reverse_input_stream().num_channels() > 0) {
-    render_.render_audio.reset(new AudioBuffer(
+    render_.render_audio = render_.audio_buffer_pool.Get(
         formats_.api_format.reverse_input_stream().num_frames(),
         formats_.api_format.reverse_input_stream().num_channels(),
         formats_.rev_proc_format.num_frames(),
         formats_.rev_proc_format.num_channels(),
-        rev_audio_buffer_out_num_frames));
+        rev_audio_buffer_out_num_frames);
     if (rev_conversion_needed()) {
       render_.render_converter = AudioConverter::Create(
           formats_.api_format.reverse_input_stream().num_channels(),
@@ -369,15 +389,15 @@ int AudioProcessingImpl::InitializeLocked() {
       render_.render_converter.reset(nullptr);
     }
   } else {
-    render_.render_audio.reset(nullptr);
     render_.render_converter.reset(nullptr);
   }
-  capture_.capture_audio.reset(
-      new AudioBuffer(formats_.api_format.input_stream().num_frames(),
-                      formats_.api_format.input_stream().num_channels(),
-                      capture_nonlocked_.fwd_proc_format.num_frames(),
-                      fwd_audio_buffer_channels,
-                      formats_.api_format.output_stream().num_frames()));
+  capture_.audio_buffer_pool.Put(std::move(capture_.capture_audio));
+  capture_.capture_audio = capture_.audio_buffer_pool.Get(
+      formats_.api_format.input_stream().num_frames(),
+      formats_.api_format.input_stream().num_channels(),
+      capture_nonlocked_.fwd_proc_format.num_frames(),
+      fwd_audio_buffer_channels,
+      formats_.api_format.output_stream().num_frames());
 
   // Initialize all components.
   for (auto item : private_submodules_->component_list) {
@@ -397,7 +417,7 @@ int AudioProcessingImpl::InitializeLocked() {
   InitializeVoiceDetection();
 
 #ifdef WEBRTC_AUDIOPROC_DEBUG_DUMP
-  if (debug_dump_.debug_file->Open()) {
+  if (debug_dump_.writer) {
     int err = WriteInitMessage();
     if (err != kNoError) {
       return err;
@@ -495,6 +515,25 @@ void AudioProcessingImpl::SetExtraOptions(const Config& config) {
     InitializeTransient();
   }
 
+  if (capture_.submodule_profiler.enabled() !=
+      config.Get<SubmoduleProfiling>().enabled) {
+    capture_.submodule_profiler.Enable(
+        config.Get<SubmoduleProfiling>().enabled);
+  }
+
+#ifdef WEBRTC_AUDIOPROC_DEBUG_DUMP
+  debug_dump_.compress = config.Get<DebugDumpCompression>().enabled;
+#endif
+
+  const SilentFrameSkipping& skipping = config.Get<SilentFrameSkipping>();
+  capture_nonlocked_.silent_frame_skipping = skipping.enabled;
+  capture_nonlocked_.silence_mean_square =
+      32768.f * 32768.f * powf(10.f, skipping.level_dbfs / 10.f);
+  if (!skipping.enabled) {
+    capture_.silent_frames = 0;
+    rtc::AtomicOps::ReleaseStore(&render_silent_frames_, 0);
+  }
+
 #ifdef WEBRTC_ANDROID_PLATFORM_BUILD
   if (capture_nonlocked_.beamformer_enabled !=
           config.Get<Beamforming>().enabled) {
@@ -621,7 +660,7 @@ int AudioProcessingImpl::ProcessStream(const float* const* src,
          formats_.api_format.input_stream().num_frames());
 
 #ifdef WEBRTC_AUDIOPROC_DEBUG_DUMP
-  if (debug_dump_.debug_file->Open()) {
+  if (debug_dump_.writer) {
     RETURN_ON_ERR(WriteConfigMessage(false));
 
     debug_dump_.capture.event_msg->set_type(audioproc::Event::STREAM);
@@ -639,15 +678,16 @@ int AudioProcessingImpl::ProcessStream(const float* const* src,
   capture_.capture_audio->CopyTo(formats_.api_format.output_stream(), dest);
 
 #ifdef WEBRTC_AUDIOPROC_DEBUG_DUMP
-  if (debug_dump_.debug_file->Open()) {
+  if (debug_dump_.writer) {
     audioproc::Stream* msg = debug_dump_.capture.event_msg->mutable_stream();
     const size_t channel_size =
         sizeof(float) * formats_.api_format.output_stream().num_frames();
     for (size_t i = 0; i < formats_.api_format.output_stream().num_channels();
          ++i)
       msg->add_output_channel(dest[i], channel_size);
-    RETURN_ON_ERR(WriteMessageToDebugFile(debug_dump_.debug_file.get(),
-                                          &crit_debug_, &debug_dump_.capture));
+    RETURN_ON_ERR(WriteMessageToDebugFile(debug_dump_.writer.get(),
+                                          DebugDumpWriter::kCaptureStream,
+                                          &debug_dump_.capture));
   }
 #endif
 
@@ -713,7 +753,7 @@ int AudioProcessingImpl::ProcessStream(AudioFrame* frame) {
   }
 
 #ifdef WEBRTC_AUDIOPROC_DEBUG_DUMP
-  if (debug_dump_.debug_file->Open()) {
+  if (debug_dump_.writer) {
     debug_dump_.capture.event_msg->set_type(audioproc::Event::STREAM);
     audioproc::Stream* msg = debug_dump_.capture.event_msg->mutable_stream();
     const size_t data_size =
@@ -728,13 +768,14 @@ int AudioProcessingImpl::ProcessStream(AudioFrame* frame) {
                                        output_copy_needed(is_data_processed()));
 
 #ifdef WEBRTC_AUDIOPROC_DEBUG_DUMP
-  if (debug_dump_.debug_file->Open()) {
+  if (debug_dump_.writer) {
     audioproc::Stream* msg = debug_dump_.capture.event_msg->mutable_stream();
     const size_t data_size =
         sizeof(int16_t) * frame->samples_per_channel_ * frame->num_channels_;
     msg->set_output_data(frame->data_, data_size);
-    RETURN_ON_ERR(WriteMessageToDebugFile(debug_dump_.debug_file.get(),
-                                          &crit_debug_, &debug_dump_.capture));
+    RETURN_ON_ERR(WriteMessageToDebugFile(debug_dump_.writer.get(),
+                                          DebugDumpWriter::kCaptureStream,
+                                          &debug_dump_.capture));
   }
 #endif
 
@@ -743,7 +784,7 @@ int AudioProcessingImpl::ProcessStream(AudioFrame* frame) {
 
 int AudioProcessingImpl::ProcessStreamLocked() {
 #ifdef WEBRTC_AUDIOPROC_DEBUG_DUMP
-  if (debug_dump_.debug_file->Open()) {
+  if (debug_dump_.writer) {
     audioproc::Stream* msg = debug_dump_.capture.event_msg->mutable_stream();
     msg->set_delay(capture_nonlocked_.stream_delay_ms);
     msg->set_drift(
@@ -756,44 +797,64 @@ int AudioProcessingImpl::ProcessStreamLocked() {
   MaybeUpdateHistograms();
 
   AudioBuffer* ca = capture_.capture_audio.get();  // For brevity.
+  if (SkipSilentCaptureFrame()) {
+    ProcessSilentStreamLocked();
+    return kNoError;
+  }
+
+  // Charges the time since the previous step to the step that just ran. Steps
+  // that are skipped altogether are not counted.
+  SubmoduleProfiler* profiler = &capture_.submodule_profiler;
+  profiler->StartFrame();
 
   if (constants_.use_new_agc &&
       public_submodules_->gain_control->is_enabled()) {
     private_submodules_->agc_manager->AnalyzePreProcess(
         ca->channels()[0], ca->num_channels(),
         capture_nonlocked_.fwd_proc_format.num_frames());
+    profiler->Lap(SubmoduleProfiler::kAgcManagerAnalysis);
   }
 
   bool data_processed = is_data_processed();
   if (analysis_needed(data_processed)) {
     ca->SplitIntoFrequencyBands();
+    profiler->Lap(SubmoduleProfiler::kBandSplit);
   }
 
   if (constants_.intelligibility_enabled) {
     public_submodules_->intelligibility_enhancer->AnalyzeCaptureAudio(
         ca->split_channels_f(kBand0To8kHz), capture_nonlocked_.split_rate,
         ca->num_channels());
+    profiler->Lap(SubmoduleProfiler::kIntelligibility);
   }
 
   if (capture_nonlocked_.beamformer_enabled) {
     private_submodules_->beamformer->ProcessChunk(*ca->split_data_f(),
                                                   ca->split_data_f());
     ca->set_num_channels(1);
+    profiler->Lap(SubmoduleProfiler::kBeamformer);
   }
 
   public_submodules_->high_pass_filter->ProcessCaptureAudio(ca);
+  profiler->Lap(SubmoduleProfiler::kHighPassFilter);
   RETURN_ON_ERR(public_submodules_->gain_control->AnalyzeCaptureAudio(ca));
+  profiler->Lap(SubmoduleProfiler::kGainControlAnalysis);
   public_submodules_->noise_suppression->AnalyzeCaptureAudio(ca);
+  profiler->Lap(SubmoduleProfiler::kNoiseSuppressionAnalysis);
   RETURN_ON_ERR(public_submodules_->echo_cancellation->ProcessCaptureAudio(ca));
+  profiler->Lap(SubmoduleProfiler::kEchoCancellation);
 
   if (public_submodules_->echo_control_mobile->is_enabled() &&
       public_submodules_->noise_suppression->is_enabled()) {
     ca->CopyLowPassToReference();
   }
   public_submodules_->noise_suppression->ProcessCaptureAudio(ca);
+  profiler->Lap(SubmoduleProfiler::kNoiseSuppression);
   RETURN_ON_ERR(
       public_submodules_->echo_control_mobile->ProcessCaptureAudio(ca));
+  profiler->Lap(SubmoduleProfiler::kEchoControlMobile);
   public_submodules_->voice_detection->ProcessCaptureAudio(ca);
+  profiler->Lap(SubmoduleProfiler::kVoiceDetection);
 
   if (constants_.use_new_agc &&
       public_submodules_->gain_control->is_enabled() &&
@@ -802,11 +863,14 @@ int AudioProcessingImpl::ProcessStreamLocked() {
     private_submodules_->agc_manager->Process(
         ca->split_bands_const(0)[kBand0To8kHz], ca->num_frames_per_band(),
         capture_nonlocked_.split_rate);
+    profiler->Lap(SubmoduleProfiler::kAgcManager);
   }
   RETURN_ON_ERR(public_submodules_->gain_control->ProcessCaptureAudio(ca));
+  profiler->Lap(SubmoduleProfiler::kGainControl);
 
   if (synthesis_needed(data_processed)) {
     ca->MergeFrequencyBands();
+    profiler->Lap(SubmoduleProfiler::kBandMerge);
   }
 
   // TODO(aluebs): Investigate if the transient suppression placement should be
@@ -822,15 +886,67 @@ int AudioProcessingImpl::ProcessStreamLocked() {
         ca->split_bands_const_f(0)[kBand0To8kHz], ca->num_frames_per_band(),
         ca->keyboard_data(), ca->num_keyboard_frames(), voice_probability,
         capture_.key_pressed);
+    profiler->Lap(SubmoduleProfiler::kTransientSuppressor);
   }
 
   // The level estimator operates on the recombined data.
   public_submodules_->level_estimator->ProcessStream(ca);
+  profiler->Lap(SubmoduleProfiler::kLevelEstimator);
+  profiler->EndFrame();
+
+#ifdef WEBRTC_AUDIOPROC_DEBUG_DUMP
+  if (debug_dump_.writer && profiler->enabled()) {
+    audioproc::Stream* msg = debug_dump_.capture.event_msg->mutable_stream();
+    for (int i = 0; i < SubmoduleProfiler::kNumSubmodules; ++i) {
+      const SubmoduleProfiler::Submodule submodule =
+          static_cast<SubmoduleProfiler::Submodule>(i);
+      const int64_t duration_ns = profiler->last_frame_duration_ns(submodule);
+      if (duration_ns >= 0) {
+        audioproc::SubmoduleTiming* timing = msg->add_submodule_timing();
+        timing->set_name(SubmoduleProfiler::Name(submodule));
+        timing->set_duration_ns(duration_ns);
+      }
+    }
+  }
+#endif
 
   capture_.was_stream_delay_set = false;
   return kNoError;
 }
 
+bool AudioProcessingImpl::SkipSilentCaptureFrame() {
+  if (!capture_nonlocked_.silent_frame_skipping) {
+    return false;
+  }
+  if (MeanSquare(*capture_.capture_audio) <
+      capture_nonlocked_.silence_mean_square) {
+    capture_.silent_frames =
+        std::min(capture_.silent_frames + 1, kSilentFramesBeforeSkipping);
+  } else {
+    capture_.silent_frames = 0;
+  }
+  if (capture_.silent_frames < kSilentFramesBeforeSkipping) {
+    return false;
+  }
+  // The far-end only matters when there is echo to cancel.
+  const bool echo_control =
+      public_submodules_->echo_cancellation->is_enabled() ||
+      public_submodules_->echo_control_mobile->is_enabled();
+  return !echo_control || rtc::AtomicOps::AcquireLoad(&render_silent_frames_) >=
+                              kSilentFramesBeforeSkipping;
+}
+
+// The echo cancellers keep buffering the far-end while capture frames are
+// skipped, which they treat like a pause in ProcessStream() calls: the far-end
+// buffer gets realigned from the reported delay when processing resumes.
+void AudioProcessingImpl::ProcessSilentStreamLocked() {
+  AudioBuffer* ca = capture_.capture_audio.get();  // For brevity.
+  public_submodules_->voice_detection->ProcessSilentCaptureAudio(ca);
+  public_submodules_->level_estimator->ProcessStream(ca);
+  ++capture_.num_skipped_silent_frames;
+  capture_.was_stream_delay_set = false;
+}
+
 int AudioProcessingImpl::AnalyzeReverseStream(const float* const* data,
                                               size_t samples_per_channel,
                                               int rev_sample_rate_hz,
@@ -891,7 +1007,7 @@ int AudioProcessingImpl::AnalyzeReverseStreamLocked(
          formats_.api_format.reverse_input_stream().num_frames());
 
 #ifdef WEBRTC_AUDIOPROC_DEBUG_DUMP
-  if (debug_dump_.debug_file->Open()) {
+  if (debug_dump_.writer) {
     debug_dump_.render.event_msg->set_type(audioproc::Event::REVERSE_STREAM);
     audioproc::ReverseStream* msg =
         debug_dump_.render.event_msg->mutable_reverse_stream();
@@ -900,8 +1016,9 @@ int AudioProcessingImpl::AnalyzeReverseStreamLocked(
     for (size_t i = 0;
          i < formats_.api_format.reverse_input_stream().num_channels(); ++i)
       msg->add_channel(src[i], channel_size);
-    RETURN_ON_ERR(WriteMessageToDebugFile(debug_dump_.debug_file.get(),
-                                          &crit_debug_, &debug_dump_.render));
+    RETURN_ON_ERR(WriteMessageToDebugFile(debug_dump_.writer.get(),
+                                          DebugDumpWriter::kRenderStream,
+                                          &debug_dump_.render));
   }
 #endif
 
@@ -961,15 +1078,16 @@ int AudioProcessingImpl::AnalyzeReverseStream(AudioFrame* frame) {
   }
 
 #ifdef WEBRTC_AUDIOPROC_DEBUG_DUMP
-  if (debug_dump_.debug_file->Open()) {
+  if (debug_dump_.writer) {
     debug_dump_.render.event_msg->set_type(audioproc::Event::REVERSE_STREAM);
     audioproc::ReverseStream* msg =
         debug_dump_.render.event_msg->mutable_reverse_stream();
     const size_t data_size =
         sizeof(int16_t) * frame->samples_per_channel_ * frame->num_channels_;
     msg->set_data(frame->data_, data_size);
-    RETURN_ON_ERR(WriteMessageToDebugFile(debug_dump_.debug_file.get(),
-                                          &crit_debug_, &debug_dump_.render));
+    RETURN_ON_ERR(WriteMessageToDebugFile(debug_dump_.writer.get(),
+                                          DebugDumpWriter::kRenderStream,
+                                          &debug_dump_.render));
   }
 #endif
   render_.render_audio->DeinterleaveFrom(frame);
@@ -978,6 +1096,7 @@ int AudioProcessingImpl::AnalyzeReverseStream(AudioFrame* frame) {
 
 int AudioProcessingImpl::ProcessReverseStreamLocked() {
   AudioBuffer* ra = render_.render_audio.get();  // For brevity.
+  UpdateRenderSilence();
   if (formats_.rev_proc_format.sample_rate_hz() == kSampleRate32kHz) {
     ra->SplitIntoFrequencyBands();
   }
@@ -1007,6 +1126,21 @@ int AudioProcessingImpl::ProcessReverseStreamLocked() {
   return kNoError;
 }
 
+void AudioProcessingImpl::UpdateRenderSilence() {
+  if (!capture_nonlocked_.silent_frame_skipping) {
+    return;
+  }
+  // The render side is the only writer.
+  int silent_frames = rtc::AtomicOps::AcquireLoad(&render_silent_frames_);
+  if (MeanSquare(*render_.render_audio) <
+      capture_nonlocked_.silence_mean_square) {
+    silent_frames = std::min(silent_frames + 1, kSilentFramesBeforeSkipping);
+  } else {
+    silent_frames = 0;
+  }
+  rtc::AtomicOps::ReleaseStore(&render_silent_frames_, silent_frames);
+}
+
 int AudioProcessingImpl::set_stream_delay_ms(int delay) {
   rtc::CritScope cs(&crit_capture_);
   Error retval = kNoError;
@@ -1066,20 +1200,15 @@ int AudioProcessingImpl::StartDebugRecording(
 
 #ifdef WEBRTC_AUDIOPROC_DEBUG_DUMP
   // Stop any ongoing recording.
-  if (debug_dump_.debug_file->Open()) {
-    if (debug_dump_.debug_file->CloseFile() == -1) {
-      return kFileError;
-    }
-  }
+  RETURN_ON_ERR(StopDebugRecordingLocked());
 
-  if (debug_dump_.debug_file->OpenFile(filename, false) == -1) {
-    debug_dump_.debug_file->CloseFile();
+  rtc::scoped_ptr<FileWrapper> debug_file(FileWrapper::Create());
+  if (debug_file->OpenFile(filename, false) == -1) {
+    debug_file->CloseFile();
     return kFileError;
   }
 
-  RETURN_ON_ERR(WriteConfigMessage(true));
-  RETURN_ON_ERR(WriteInitMessage());
-  return kNoError;
+  return StartDebugRecordingLocked(std::move(debug_file));
 #else
   return kUnsupportedFunctionError;
 #endif  // WEBRTC_AUDIOPROC_DEBUG_DUMP
@@ -1096,19 +1225,14 @@ int AudioProcessingImpl::StartDebugRecording(FILE* handle) {
 
 #ifdef WEBRTC_AUDIOPROC_DEBUG_DUMP
   // Stop any ongoing recording.
-  if (debug_dump_.debug_file->Open()) {
-    if (debug_dump_.debug_file->CloseFile() == -1) {
-      return kFileError;
-    }
-  }
+  RETURN_ON_ERR(StopDebugRecordingLocked());
 
-  if (debug_dump_.debug_file->OpenFromFileHandle(handle, true, false) == -1) {
+  rtc::scoped_ptr<FileWrapper> debug_file(FileWrapper::Create());
+  if (debug_file->OpenFromFileHandle(handle, true, false) == -1) {
     return kFileError;
   }
 
-  RETURN_ON_ERR(WriteConfigMessage(true));
-  RETURN_ON_ERR(WriteInitMessage());
-  return kNoError;
+  return StartDebugRecordingLocked(std::move(debug_file));
 #else
   return kUnsupportedFunctionError;
 #endif  // WEBRTC_AUDIOPROC_DEBUG_DUMP
@@ -1129,13 +1253,7 @@ int AudioProcessingImpl::StopDebugRecording() {
   rtc::CritScope cs_capture(&crit_capture_);
 
 #ifdef WEBRTC_AUDIOPROC_DEBUG_DUMP
-  // We just return if recording hasn't started.
-  if (debug_dump_.debug_file->Open()) {
-    if (debug_dump_.debug_file->CloseFile() == -1) {
-      return kFileError;
-    }
-  }
-  return kNoError;
+  return StopDebugRecordingLocked();
 #else
   return kUnsupportedFunctionError;
 #endif  // WEBRTC_AUDIOPROC_DEBUG_DUMP
@@ -1413,42 +1531,72 @@ void AudioProcessingImpl::UpdateHistogramsOnCallEnd() {
   capture_.last_aec_system_delay_ms = 0;
 }
 
+size_t AudioProcessingImpl::num_skipped_silent_frames() const {
+  rtc::CritScope cs(&crit_capture_);
+  return capture_.num_skipped_silent_frames;
+}
+
+size_t AudioProcessingImpl::num_dropped_debug_dump_messages() const {
 #ifdef WEBRTC_AUDIOPROC_DEBUG_DUMP
-int AudioProcessingImpl::WriteMessageToDebugFile(
-    FileWrapper* debug_file,
-    rtc::CriticalSection* crit_debug,
-    ApmDebugDumpThreadState* debug_state) {
-  int32_t size = debug_state->event_msg->ByteSize();
-  if (size <= 0) {
-    return kUnspecifiedError;
+  rtc::CritScope cs(&crit_capture_);
+  if (debug_dump_.writer) {
+    return debug_dump_.writer->num_dropped_messages();
   }
-#if defined(WEBRTC_ARCH_BIG_ENDIAN)
-// TODO(ajm): Use little-endian "on the wire". For the moment, we can be
-//            pretty safe in assuming little-endian.
-#endif
+  return debug_dump_.num_dropped_messages;
+#else
+  return 0;
+#endif  // WEBRTC_AUDIOPROC_DEBUG_DUMP
+}
 
-  if (!debug_state->event_msg->SerializeToString(&debug_state->event_str)) {
-    return kUnspecifiedError;
+int AudioProcessingImpl::GetSubmoduleTimings(
+    std::vector<SubmoduleTiming>* timings) const {
+  rtc::CritScope cs(&crit_capture_);
+  if (!capture_.submodule_profiler.enabled()) {
+    return kNotEnabledError;
   }
-
-  {
-    // Ensure atomic writes of the message.
-    rtc::CritScope cs_capture(crit_debug);
-    // Write message preceded by its size.
-    if (!debug_file->Write(&size, sizeof(int32_t))) {
-      return kFileError;
-    }
-    if (!debug_file->Write(debug_state->event_str.data(),
-                           debug_state->event_str.length())) {
-      return kFileError;
-    }
+  if (timings == nullptr) {
+    return kNullPointerError;
   }
+  timings->clear();
+  capture_.submodule_profiler.GetTimings(timings);
+  return kNoError;
+}
 
-  debug_state->event_msg->Clear();
+#ifdef WEBRTC_AUDIOPROC_DEBUG_DUMP
+int AudioProcessingImpl::WriteMessageToDebugFile(
+    DebugDumpWriter* writer,
+    DebugDumpWriter::Stream stream,
+    ApmDebugDumpThreadState* debug_state) {
+  // Serialized and written by the writer thread, which leaves a cleared
+  // message in |event_msg|.
+  writer->Write(stream, debug_state->event_msg.get());
+  return kNoError;
+}
+
+int AudioProcessingImpl::StartDebugRecordingLocked(
+    rtc::scoped_ptr<FileWrapper> debug_file) {
+  RTC_DCHECK(!debug_dump_.writer);
+  debug_dump_.writer.reset(new DebugDumpWriter(
+      std::move(debug_file), debug_dump_.compress,
+      DebugDumpWriter::kDefaultQueueSize));
+  debug_dump_.num_dropped_messages = 0;
 
+  RETURN_ON_ERR(WriteConfigMessage(true));
+  RETURN_ON_ERR(WriteInitMessage());
   return kNoError;
 }
 
+int AudioProcessingImpl::StopDebugRecordingLocked() {
+  // We just return if recording hasn't started.
+  if (!debug_dump_.writer) {
+    return kNoError;
+  }
+  const bool written = debug_dump_.writer->Stop();
+  debug_dump_.num_dropped_messages = debug_dump_.writer->num_dropped_messages();
+  debug_dump_.writer.reset();
+  return written ? kNoError : kFileError;
+}
+
 int AudioProcessingImpl::WriteInitMessage() {
   debug_dump_.capture.event_msg->set_type(audioproc::Event::INIT);
   audioproc::Init* msg = debug_dump_.capture.event_msg->mutable_init();
@@ -1467,8 +1615,9 @@ int AudioProcessingImpl::WriteInitMessage() {
   // TODO(ekmeyerson): Add reverse output fields to
   // debug_dump_.capture.event_msg.
 
-  RETURN_ON_ERR(WriteMessageToDebugFile(debug_dump_.debug_file.get(),
-                                        &crit_debug_, &debug_dump_.capture));
+  RETURN_ON_ERR(WriteMessageToDebugFile(debug_dump_.writer.get(),
+                                        DebugDumpWriter::kCaptureStream,
+                                        &debug_dump_.capture));
   return kNoError;
 }
 
@@ -1519,8 +1668,9 @@ int AudioProcessingImpl::WriteConfigMessage(bool forced) {
   debug_dump_.capture.event_msg->set_type(audioproc::Event::CONFIG);
   debug_dump_.capture.event_msg->mutable_config()->CopyFrom(config);
 
-  RETURN_ON_ERR(WriteMessageToDebugFile(debug_dump_.debug_file.get(),
-                                        &crit_debug_, &debug_dump_.capture));
+  RETURN_ON_ERR(WriteMessageToDebugFile(debug_dump_.writer.get(),
+                                        DebugDumpWriter::kCaptureStream,
+                                        &debug_dump_.capture));
   return kNoError;
 }
 #endif  // WEBRTC_AUDIOPROC_DEBUG_DUMP
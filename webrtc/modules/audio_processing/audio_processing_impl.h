@@ -20,16 +20,12 @@
 #include "webrtc/base/thread_annotations.h"
 #include "webrtc/modules/audio_processing/audio_buffer.h"
 #include "webrtc/modules/audio_processing/include/audio_processing.h"
+#include "webrtc/modules/audio_processing/submodule_profiler.h"
 #include "webrtc/system_wrappers/include/file_wrapper.h"
 
 #ifdef WEBRTC_AUDIOPROC_DEBUG_DUMP
-// Files generated at build-time by the protobuf compiler.
-#ifdef WEBRTC_ANDROID_PLATFORM_BUILD
-#include "external/webrtc/webrtc/modules/audio_processing/debug.pb.h"
-#else
-#include "webrtc/audio_processing/debug.pb.h"
+#include "webrtc/modules/audio_processing/debug_dump_writer.h"
 #endif
-#endif  // WEBRTC_AUDIOPROC_DEBUG_DUMP
 
 namespace webrtc {
 
@@ -57,6 +53,9 @@ class AudioProcessingImpl : public AudioProcessing {
   int Initialize(const ProcessingConfig& processing_config) override;
   void SetExtraOptions(const Config& config) override;
   void UpdateHistogramsOnCallEnd() override;
+  int GetSubmoduleTimings(std::vector<SubmoduleTiming>* timings) const override;
+  size_t num_skipped_silent_frames() const override;
+  size_t num_dropped_debug_dump_messages() const override;
   int StartDebugRecording(const char filename[kMaxFilenameSize]) override;
   int StartDebugRecording(FILE* handle) override;
   int StartDebugRecordingForPlatformFile(rtc::PlatformFile handle) override;
@@ -136,15 +135,18 @@ class AudioProcessingImpl : public AudioProcessing {
   struct ApmDebugDumpThreadState {
     ApmDebugDumpThreadState() : event_msg(new audioproc::Event()) {}
     rtc::scoped_ptr<audioproc::Event> event_msg;  // Protobuf message.
-    std::string event_str;  // Memory for protobuf serialization.
 
     // Serialized string of last saved APM configuration.
     std::string last_serialized_config;
   };
 
   struct ApmDebugDumpState {
-    ApmDebugDumpState() : debug_file(FileWrapper::Create()) {}
-    rtc::scoped_ptr<FileWrapper> debug_file;
+    // Null while not recording.
+    rtc::scoped_ptr<DebugDumpWriter> writer;
+    // DebugDumpCompression setting, for the next recording.
+    bool compress = false;
+    // Dropped messages of the last recording, once it has stopped.
+    size_t num_dropped_messages = 0;
     ApmDebugDumpThreadState render;
     ApmDebugDumpThreadState capture;
   };
@@ -197,6 +199,10 @@ class AudioProcessingImpl : public AudioProcessing {
   // Capture-side exclusive methods possibly running APM in a multi-threaded
   // manner that are called with the render lock already acquired.
   int ProcessStreamLocked() EXCLUSIVE_LOCKS_REQUIRED(crit_capture_);
+  // Counts the silent capture frames and tells whether the current one can be
+  // skipped, see SilentFrameSkipping.
+  bool SkipSilentCaptureFrame() EXCLUSIVE_LOCKS_REQUIRED(crit_capture_);
+  void ProcessSilentStreamLocked() EXCLUSIVE_LOCKS_REQUIRED(crit_capture_);
   bool output_copy_needed(bool is_data_processed) const
       EXCLUSIVE_LOCKS_REQUIRED(crit_capture_);
   bool is_data_processed() const EXCLUSIVE_LOCKS_REQUIRED(crit_capture_);
@@ -215,15 +221,22 @@ class AudioProcessingImpl : public AudioProcessing {
       EXCLUSIVE_LOCKS_REQUIRED(crit_render_);
   bool is_rev_processed() const EXCLUSIVE_LOCKS_REQUIRED(crit_render_);
   int ProcessReverseStreamLocked() EXCLUSIVE_LOCKS_REQUIRED(crit_render_);
+  void UpdateRenderSilence() EXCLUSIVE_LOCKS_REQUIRED(crit_render_);
 
 // Debug dump methods that are internal and called without locks.
 // TODO(peah): Make thread safe.
 #ifdef WEBRTC_AUDIOPROC_DEBUG_DUMP
   // TODO(andrew): make this more graceful. Ideally we would split this stuff
   // out into a separate class with an "enabled" and "disabled" implementation.
-  static int WriteMessageToDebugFile(FileWrapper* debug_file,
-                                     rtc::CriticalSection* crit_debug,
+  static int WriteMessageToDebugFile(DebugDumpWriter* writer,
+                                     DebugDumpWriter::Stream stream,
                                      ApmDebugDumpThreadState* debug_state);
+  // Starts a recording to |debug_file|, which must be open, when none is
+  // ongoing.
+  int StartDebugRecordingLocked(rtc::scoped_ptr<FileWrapper> debug_file)
+      EXCLUSIVE_LOCKS_REQUIRED(crit_render_, crit_capture_);
+  int StopDebugRecordingLocked()
+      EXCLUSIVE_LOCKS_REQUIRED(crit_render_, crit_capture_);
   int WriteInitMessage() EXCLUSIVE_LOCKS_REQUIRED(crit_render_, crit_capture_);
 
   // Writes Config message. If not |forced|, only writes the current config if
@@ -232,9 +245,6 @@ class AudioProcessingImpl : public AudioProcessing {
   int WriteConfigMessage(bool forced) EXCLUSIVE_LOCKS_REQUIRED(crit_capture_)
       EXCLUSIVE_LOCKS_REQUIRED(crit_capture_);
 
-  // Critical section.
-  mutable rtc::CriticalSection crit_debug_;
-
   // Debug dump state.
   ApmDebugDumpState debug_dump_;
 #endif
@@ -308,11 +318,17 @@ class AudioProcessingImpl : public AudioProcessing {
     std::vector<Point> array_geometry;
     SphericalPointf target_direction;
     rtc::scoped_ptr<AudioBuffer> capture_audio;
+    // The capture buffers of the formats used before, for reinitializations.
+    AudioBufferPool audio_buffer_pool;
     // Only the rate and samples fields of fwd_proc_format_ are used because the
     // forward processing number of channels is mutable and is tracked by the
     // capture_audio_.
     StreamConfig fwd_proc_format;
     int split_rate;
+    SubmoduleProfiler submodule_profiler;
+    // Consecutive silent capture frames, and the number of frames skipped.
+    int silent_frames = 0;
+    size_t num_skipped_silent_frames = 0;
   } capture_ GUARDED_BY(crit_capture_);
 
   struct ApmCaptureNonLockedState {
@@ -328,12 +344,21 @@ class AudioProcessingImpl : public AudioProcessing {
     int split_rate;
     int stream_delay_ms;
     bool beamformer_enabled;
+    // SilentFrameSkipping settings, also read on the render side. The level
+    // is a mean square in the int16 range.
+    bool silent_frame_skipping = false;
+    float silence_mean_square = 0.f;
   } capture_nonlocked_;
 
   struct ApmRenderState {
     rtc::scoped_ptr<AudioConverter> render_converter;
     rtc::scoped_ptr<AudioBuffer> render_audio;
+    AudioBufferPool audio_buffer_pool;
   } render_ GUARDED_BY(crit_render_);
+
+  // Consecutive silent render frames. Only written by the render side and read
+  // by the capture side without locking, through rtc::AtomicOps.
+  volatile int render_silent_frames_ = 0;
 };
 
 }  // namespace webrtc
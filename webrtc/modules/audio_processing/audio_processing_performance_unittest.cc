@@ -20,6 +20,8 @@
 #include "webrtc/base/platform_thread.h"
 #include "webrtc/base/random.h"
 #include "webrtc/base/safe_conversions.h"
+#include "webrtc/base/timeutils.h"
+#include "webrtc/common_audio/swap_queue.h"
 #include "webrtc/config.h"
 #include "webrtc/modules/audio_processing/test/test_utils.h"
 #include "webrtc/modules/include/module_common_types.h"
@@ -707,6 +709,120 @@ bool TimedThreadApiProcessor::Process() {
   return !test_->MaybeEndTest();
 }
 
+// Simulator for the render to capture queue that the echo cancellers and the
+// gain control use: the render thread inserts frames while the capture thread
+// removes them, both as fast as they can so that every call contends with one
+// on the other side. The duration of each successful call is stored.
+template <typename Queue>
+class RenderQueueContentionSimulator {
+ public:
+  RenderQueueContentionSimulator()
+      : queue_(kQueueSize, std::vector<float>(kFrameSize)),
+        render_frame_(kFrameSize),
+        capture_frame_(kFrameSize),
+        render_thread_(RenderThreadFunc, this, "render"),
+        capture_thread_(CaptureThreadFunc, this, "capture") {
+    insert_durations_.reserve(kNumFrames);
+    remove_durations_.reserve(kNumFrames);
+  }
+
+  void Run() {
+    render_thread_.Start();
+    capture_thread_.Start();
+    // Both thread functions return once all frames have passed.
+    render_thread_.Stop();
+    capture_thread_.Stop();
+  }
+
+  void PrintStatistics(const std::string& queue_name) const {
+    EXPECT_EQ(static_cast<size_t>(kNumFrames), insert_durations_.size());
+    EXPECT_EQ(static_cast<size_t>(kNumFrames), remove_durations_.size());
+    PrintDurationStatistics(queue_name + "_insert", insert_durations_);
+    PrintDurationStatistics(queue_name + "_remove", remove_durations_);
+  }
+
+ private:
+  static const size_t kQueueSize = 100;
+  static const size_t kFrameSize = 480;
+  static const int kNumFrames = 20000;
+
+  static bool RenderThreadFunc(void* context) {
+    static_cast<RenderQueueContentionSimulator*>(context)->Render();
+    return false;
+  }
+
+  static bool CaptureThreadFunc(void* context) {
+    static_cast<RenderQueueContentionSimulator*>(context)->Capture();
+    return false;
+  }
+
+  void Render() {
+    for (int n = 0; n < kNumFrames; ++n) {
+      render_frame_[0] = static_cast<float>(n);
+      while (true) {
+        const uint64_t start_time = rtc::TimeNanos();
+        const bool inserted = queue_.Insert(&render_frame_);
+        if (inserted) {
+          insert_durations_.push_back(rtc::TimeNanos() - start_time);
+          break;
+        }
+        // The capture side is behind, let it run on single core machines.
+        SleepMs(0);
+      }
+    }
+  }
+
+  void Capture() {
+    for (int n = 0; n < kNumFrames; ++n) {
+      while (true) {
+        const uint64_t start_time = rtc::TimeNanos();
+        const bool removed = queue_.Remove(&capture_frame_);
+        if (removed) {
+          remove_durations_.push_back(rtc::TimeNanos() - start_time);
+          break;
+        }
+        SleepMs(0);
+      }
+      EXPECT_EQ(static_cast<float>(n), capture_frame_[0]);
+    }
+  }
+
+  static void PrintDurationStatistics(const std::string& trace,
+                                      const std::vector<uint64_t>& durations) {
+    if (durations.empty()) {
+      return;
+    }
+    double mean = 0.0;
+    uint64_t max_duration = 0;
+    for (uint64_t duration : durations) {
+      mean += duration;
+      max_duration = std::max(max_duration, duration);
+    }
+    mean /= durations.size();
+    double variance = 0.0;
+    for (uint64_t duration : durations) {
+      variance += (duration - mean) * (duration - mean);
+    }
+    variance /= durations.size();
+
+    webrtc::test::PrintResultMeanAndError(
+        "apm_render_queue", "", trace,
+        std::to_string(static_cast<int64_t>(mean)) + ", " +
+            std::to_string(static_cast<int64_t>(sqrt(variance))),
+        "ns", false);
+    webrtc::test::PrintResult("apm_render_queue_max", "", trace,
+                              static_cast<size_t>(max_duration), "ns", false);
+  }
+
+  Queue queue_;
+  std::vector<float> render_frame_;
+  std::vector<float> capture_frame_;
+  std::vector<uint64_t> insert_durations_;
+  std::vector<uint64_t> remove_durations_;
+  rtc::PlatformThread render_thread_;
+  rtc::PlatformThread capture_thread_;
+};
+
 const float CallSimulator::kRenderInputFloatLevel = 0.5f;
 const float CallSimulator::kCaptureInputFloatLevel = 0.03125f;
 }  // anonymous namespace
@@ -716,6 +832,22 @@ TEST_P(CallSimulator, ApiCallDurationTest) {
   EXPECT_EQ(kEventSignaled, Run());
 }
 
+// Compares the jitter of the locked and of the lock-free queue for the far-end
+// data, with the render and the capture side contending on every call.
+TEST(AudioProcessingPerformanceTest, RenderQueueContention) {
+  {
+    RenderQueueContentionSimulator<SwapQueue<std::vector<float>>> simulator;
+    simulator.Run();
+    simulator.PrintStatistics("swap_queue");
+  }
+  {
+    RenderQueueContentionSimulator<SpscSwapQueue<std::vector<float>>>
+        simulator;
+    simulator.Run();
+    simulator.PrintStatistics("spsc_swap_queue");
+  }
+}
+
 INSTANTIATE_TEST_CASE_P(
     AudioProcessingPerformanceTest,
     CallSimulator,
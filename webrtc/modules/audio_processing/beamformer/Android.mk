@@ -19,9 +19,15 @@ LOCAL_MODULE_TAGS := optional
 LOCAL_CPP_EXTENSION := .cc
 LOCAL_SRC_FILES := \
     array_util.cc \
+    bin_quadratic_forms.cc \
     covariance_matrix_generator.cc \
     nonlinear_beamformer.cc \
 
+ifeq ($(TARGET_ARCH),$(filter $(TARGET_ARCH),x86 x86_64))
+LOCAL_SRC_FILES += \
+    bin_quadratic_forms_sse2.cc
+endif
+
 # Flags passed to both C and C++ files.
 LOCAL_CFLAGS := \
     $(MY_WEBRTC_COMMON_DEFS)
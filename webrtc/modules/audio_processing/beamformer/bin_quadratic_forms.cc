@@ -0,0 +1,187 @@
+/*
+ *  Copyright (c) 2016 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/modules/audio_processing/beamformer/bin_quadratic_forms.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "webrtc/base/checks.h"
+#include "webrtc/system_wrappers/include/cpu_features_wrapper.h"
+
+namespace webrtc {
+
+// static
+const size_t BinQuadraticForms::kBinAlignment;
+
+BinQuadraticForms::BinQuadraticForms(size_t num_channels,
+                                     size_t num_bins,
+                                     size_t num_matrices)
+    : num_channels_(num_channels),
+      num_bins_(num_bins),
+      num_matrices_(num_matrices),
+      stride_((num_bins + kBinAlignment - 1) & ~(kBinAlignment - 1)),
+      normalize_kernel_(NormalizeC),
+      quadratic_form_kernel_(QuadraticFormC),
+      dot_product_power_kernel_(DotProductPowerC),
+      matrices_(num_matrices * num_channels * num_channels * 2 * stride_),
+      row_vectors_(num_channels * 2 * stride_),
+      vectors_(num_channels * 2 * stride_),
+      results_((num_matrices + 1) * stride_) {
+  RTC_CHECK_GT(num_channels, 0u);
+  RTC_CHECK_GT(num_bins, 0u);
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+  if (WebRtc_GetCPUInfo(kAVX2)) {
+    normalize_kernel_ = NormalizeAVX2;
+    quadratic_form_kernel_ = QuadraticFormAVX2;
+    dot_product_power_kernel_ = DotProductPowerAVX2;
+  } else if (WebRtc_GetCPUInfo(kSSE2)) {
+    normalize_kernel_ = NormalizeSSE2;
+    quadratic_form_kernel_ = QuadraticFormSSE2;
+    dot_product_power_kernel_ = DotProductPowerSSE2;
+  }
+#elif defined(WEBRTC_HAS_NEON)
+  normalize_kernel_ = NormalizeNEON;
+  quadratic_form_kernel_ = QuadraticFormNEON;
+  dot_product_power_kernel_ = DotProductPowerNEON;
+#elif defined(WEBRTC_DETECT_NEON)
+  if ((WebRtc_GetCPUFeaturesARM() & kCPUFeatureNEON) != 0) {
+    normalize_kernel_ = NormalizeNEON;
+    quadratic_form_kernel_ = QuadraticFormNEON;
+    dot_product_power_kernel_ = DotProductPowerNEON;
+  }
+#endif
+}
+
+BinQuadraticForms::~BinQuadraticForms() {}
+
+void BinQuadraticForms::SetMatrix(size_t index,
+                                  size_t bin,
+                                  const ComplexMatrix<float>& mat) {
+  RTC_CHECK_LT(index, num_matrices_);
+  RTC_CHECK_LT(bin, num_bins_);
+  RTC_CHECK_EQ(num_channels_, mat.num_rows());
+  RTC_CHECK_EQ(num_channels_, mat.num_columns());
+  float* planes =
+      &matrices_[index * num_channels_ * num_channels_ * 2 * stride_];
+  const complex<float>* const* elements = mat.elements();
+  for (size_t i = 0; i < num_channels_; ++i) {
+    for (size_t j = 0; j < num_channels_; ++j) {
+      const size_t k = i * num_channels_ + j;
+      planes[2 * k * stride_ + bin] = elements[i][j].real();
+      planes[(2 * k + 1) * stride_ + bin] = elements[i][j].imag();
+    }
+  }
+}
+
+void BinQuadraticForms::SetRowVector(size_t bin,
+                                     const ComplexMatrix<float>& vec) {
+  RTC_CHECK_LT(bin, num_bins_);
+  RTC_CHECK_EQ(1u, vec.num_rows());
+  RTC_CHECK_EQ(num_channels_, vec.num_columns());
+  for (size_t c = 0; c < num_channels_; ++c) {
+    row_vectors_[2 * c * stride_ + bin] = vec.elements()[0][c].real();
+    row_vectors_[(2 * c + 1) * stride_ + bin] = vec.elements()[0][c].imag();
+  }
+}
+
+void BinQuadraticForms::Process(const complex<float>* const* input,
+                                size_t first_bin) {
+  // The padding bins past |num_bins_| stay zero.
+  for (size_t c = 0; c < num_channels_; ++c) {
+    float* re = &vectors_[2 * c * stride_];
+    float* im = &vectors_[(2 * c + 1) * stride_];
+    const complex<float>* channel = &input[c][first_bin];
+    for (size_t bin = 0; bin < num_bins_; ++bin) {
+      re[bin] = channel[bin].real();
+      im[bin] = channel[bin].imag();
+    }
+  }
+  normalize_kernel_(num_channels_, stride_, &vectors_[0]);
+
+  const size_t matrix_size = num_channels_ * num_channels_ * 2 * stride_;
+  for (size_t i = 0; i < num_matrices_; ++i) {
+    quadratic_form_kernel_(&matrices_[i * matrix_size], &vectors_[0],
+                           num_channels_, stride_, &results_[i * stride_]);
+  }
+  dot_product_power_kernel_(&row_vectors_[0], &vectors_[0], num_channels_,
+                            stride_, &results_[num_matrices_ * stride_]);
+}
+
+void BinQuadraticForms::NormalizeC(size_t num_channels,
+                                   size_t stride,
+                                   float* vec) {
+  for (size_t bin = 0; bin < stride; ++bin) {
+    float sum_squares = 0.f;
+    for (size_t c = 0; c < num_channels; ++c) {
+      const float re = vec[2 * c * stride + bin];
+      const float im = vec[(2 * c + 1) * stride + bin];
+      sum_squares += re * re + im * im;
+    }
+    const float norm = std::sqrt(sum_squares);
+    if (norm != 0.f) {
+      const float scale = 1.f / norm;
+      for (size_t c = 0; c < 2 * num_channels; ++c) {
+        vec[c * stride + bin] *= scale;
+      }
+    }
+  }
+}
+
+// The form is Re(u * x.') for u = conj(x) * M, where u_j is the sum over i of
+//   conj(x_i) * M_ij = x_re * m_re + x_im * m_im + j(x_re * m_im - x_im * m_re)
+// as in Norm() of the nonlinear beamformer.
+void BinQuadraticForms::QuadraticFormC(const float* mat,
+                                       const float* vec,
+                                       size_t num_channels,
+                                       size_t stride,
+                                       float* out) {
+  for (size_t bin = 0; bin < stride; ++bin) {
+    float form = 0.f;
+    for (size_t j = 0; j < num_channels; ++j) {
+      float u_re = 0.f;
+      float u_im = 0.f;
+      for (size_t i = 0; i < num_channels; ++i) {
+        const float x_re = vec[2 * i * stride + bin];
+        const float x_im = vec[(2 * i + 1) * stride + bin];
+        const size_t k = i * num_channels + j;
+        const float m_re = mat[2 * k * stride + bin];
+        const float m_im = mat[(2 * k + 1) * stride + bin];
+        u_re += x_re * m_re + x_im * m_im;
+        u_im += x_re * m_im - x_im * m_re;
+      }
+      form += u_re * vec[2 * j * stride + bin] -
+              u_im * vec[(2 * j + 1) * stride + bin];
+    }
+    out[bin] = std::max(form, 0.f);
+  }
+}
+
+void BinQuadraticForms::DotProductPowerC(const float* row,
+                                         const float* vec,
+                                         size_t num_channels,
+                                         size_t stride,
+                                         float* out) {
+  for (size_t bin = 0; bin < stride; ++bin) {
+    float dot_re = 0.f;
+    float dot_im = 0.f;
+    for (size_t c = 0; c < num_channels; ++c) {
+      const float w_re = row[2 * c * stride + bin];
+      const float w_im = row[(2 * c + 1) * stride + bin];
+      const float x_re = vec[2 * c * stride + bin];
+      const float x_im = vec[(2 * c + 1) * stride + bin];
+      dot_re += w_re * x_re + w_im * x_im;
+      dot_im += w_re * x_im - w_im * x_re;
+    }
+    out[bin] = dot_re * dot_re + dot_im * dot_im;
+  }
+}
+
+}  // namespace webrtc
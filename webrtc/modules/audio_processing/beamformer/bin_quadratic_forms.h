@@ -0,0 +1,146 @@
+/*
+ *  Copyright (c) 2016 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef WEBRTC_MODULES_AUDIO_PROCESSING_BEAMFORMER_BIN_QUADRATIC_FORMS_H_
+#define WEBRTC_MODULES_AUDIO_PROCESSING_BEAMFORMER_BIN_QUADRATIC_FORMS_H_
+
+#include <vector>
+
+#include "webrtc/modules/audio_processing/beamformer/complex_matrix.h"
+#include "webrtc/typedefs.h"
+
+namespace webrtc {
+
+// Evaluates the small complex quadratic forms of the nonlinear beamformer
+// postfilter for a range of frequency bins at once. The matrices and vectors
+// of all the bins are kept as separate real and imaginary planes with the bin
+// innermost, so the SIMD kernels work on several bins per instruction for any
+// number of channels, without the row pointers of ComplexMatrix. The kernels
+// are unrolled for arrays of 2, 4 and 8 microphones.
+class BinQuadraticForms final {
+ public:
+  // Holds |num_matrices| |num_channels| x |num_channels| matrices M_i and one
+  // row vector w of |num_channels| for each of |num_bins| bins.
+  BinQuadraticForms(size_t num_channels,
+                    size_t num_bins,
+                    size_t num_matrices);
+  ~BinQuadraticForms();
+
+  size_t num_channels() const { return num_channels_; }
+  size_t num_bins() const { return num_bins_; }
+  size_t num_matrices() const { return num_matrices_; }
+
+  void SetMatrix(size_t index, size_t bin, const ComplexMatrix<float>& mat);
+  void SetRowVector(size_t bin, const ComplexMatrix<float>& vec);
+
+  // Takes the bins |first_bin| to |first_bin| + num_bins() - 1 of the channels
+  // of |input| as the row vectors x of the bins, each scaled to unit norm
+  // unless it is zero, and evaluates for every bin:
+  //   quadratic_form(i)[bin] = max(Re(conj(x) * M_i * x.'), 0)
+  //   conjugate_dot_product_power()[bin] = |conj(w) * x.'|^2
+  void Process(const complex<float>* const* input, size_t first_bin);
+
+  // Of length num_bins(), valid until the next Process().
+  const float* quadratic_form(size_t index) const {
+    return &results_[index * stride_];
+  }
+  const float* conjugate_dot_product_power() const {
+    return &results_[num_matrices_ * stride_];
+  }
+
+ private:
+  // The kernels work on planes of |stride| floats, the real part of element
+  // (or channel) k in plane 2 * k and the imaginary part in plane 2 * k + 1.
+  // |stride| is a multiple of kBinAlignment.
+  typedef void (*NormalizeKernel)(size_t num_channels,
+                                  size_t stride,
+                                  float* vec);
+  typedef void (*QuadraticFormKernel)(const float* mat,
+                                      const float* vec,
+                                      size_t num_channels,
+                                      size_t stride,
+                                      float* out);
+  typedef void (*DotProductPowerKernel)(const float* row,
+                                        const float* vec,
+                                        size_t num_channels,
+                                        size_t stride,
+                                        float* out);
+
+  // The widest SIMD kernel handles 8 bins at a time.
+  static const size_t kBinAlignment = 8;
+
+  static void NormalizeC(size_t num_channels, size_t stride, float* vec);
+  static void QuadraticFormC(const float* mat,
+                             const float* vec,
+                             size_t num_channels,
+                             size_t stride,
+                             float* out);
+  static void DotProductPowerC(const float* row,
+                               const float* vec,
+                               size_t num_channels,
+                               size_t stride,
+                               float* out);
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+  static void NormalizeSSE2(size_t num_channels, size_t stride, float* vec);
+  static void QuadraticFormSSE2(const float* mat,
+                                const float* vec,
+                                size_t num_channels,
+                                size_t stride,
+                                float* out);
+  static void DotProductPowerSSE2(const float* row,
+                                  const float* vec,
+                                  size_t num_channels,
+                                  size_t stride,
+                                  float* out);
+  static void NormalizeAVX2(size_t num_channels, size_t stride, float* vec);
+  static void QuadraticFormAVX2(const float* mat,
+                                const float* vec,
+                                size_t num_channels,
+                                size_t stride,
+                                float* out);
+  static void DotProductPowerAVX2(const float* row,
+                                  const float* vec,
+                                  size_t num_channels,
+                                  size_t stride,
+                                  float* out);
+#endif
+#if defined(WEBRTC_HAS_NEON) || defined(WEBRTC_DETECT_NEON)
+  static void NormalizeNEON(size_t num_channels, size_t stride, float* vec);
+  static void QuadraticFormNEON(const float* mat,
+                                const float* vec,
+                                size_t num_channels,
+                                size_t stride,
+                                float* out);
+  static void DotProductPowerNEON(const float* row,
+                                  const float* vec,
+                                  size_t num_channels,
+                                  size_t stride,
+                                  float* out);
+#endif
+
+  const size_t num_channels_;
+  const size_t num_bins_;
+  const size_t num_matrices_;
+  const size_t stride_;
+  NormalizeKernel normalize_kernel_;
+  QuadraticFormKernel quadratic_form_kernel_;
+  DotProductPowerKernel dot_product_power_kernel_;
+  // |num_matrices_| matrices of |num_channels_|^2 elements in row-major
+  // order.
+  std::vector<float> matrices_;
+  std::vector<float> row_vectors_;
+  std::vector<float> vectors_;
+  // The quadratic forms of each matrix, then the dot product powers.
+  std::vector<float> results_;
+};
+
+}  // namespace webrtc
+
+#endif  // WEBRTC_MODULES_AUDIO_PROCESSING_BEAMFORMER_BIN_QUADRATIC_FORMS_H_
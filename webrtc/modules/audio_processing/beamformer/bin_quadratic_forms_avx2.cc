@@ -0,0 +1,125 @@
+/*
+ *  Copyright (c) 2016 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+// The quadratic form kernels on eight bins at a time. Built with FMA, so the
+// results may differ from the generic ones by rounding.
+
+#include "webrtc/modules/audio_processing/beamformer/bin_quadratic_forms.h"
+
+#include <immintrin.h>
+
+namespace webrtc {
+namespace {
+
+// |kNumChannels| is 0 for any number of channels, which is then taken from
+// |num_channels|.
+template <size_t kNumChannels>
+void QuadraticForm(const float* mat,
+                   const float* vec,
+                   size_t num_channels,
+                   size_t stride,
+                   float* out) {
+  const size_t n = kNumChannels ? kNumChannels : num_channels;
+  for (size_t bin = 0; bin < stride; bin += 8) {
+    __m256 form = _mm256_setzero_ps();
+    for (size_t j = 0; j < n; ++j) {
+      __m256 u_re = _mm256_setzero_ps();
+      __m256 u_im = _mm256_setzero_ps();
+      for (size_t i = 0; i < n; ++i) {
+        const __m256 x_re = _mm256_loadu_ps(&vec[2 * i * stride + bin]);
+        const __m256 x_im = _mm256_loadu_ps(&vec[(2 * i + 1) * stride + bin]);
+        const size_t k = i * n + j;
+        const __m256 m_re = _mm256_loadu_ps(&mat[2 * k * stride + bin]);
+        const __m256 m_im = _mm256_loadu_ps(&mat[(2 * k + 1) * stride + bin]);
+        u_re = _mm256_fmadd_ps(x_re, m_re, _mm256_fmadd_ps(x_im, m_im, u_re));
+        u_im = _mm256_fmadd_ps(x_re, m_im, _mm256_fnmadd_ps(x_im, m_re, u_im));
+      }
+      form = _mm256_fmadd_ps(
+          u_re, _mm256_loadu_ps(&vec[2 * j * stride + bin]),
+          _mm256_fnmadd_ps(u_im,
+                           _mm256_loadu_ps(&vec[(2 * j + 1) * stride + bin]),
+                           form));
+    }
+    _mm256_storeu_ps(&out[bin], _mm256_max_ps(form, _mm256_setzero_ps()));
+  }
+}
+
+}  // namespace
+
+void BinQuadraticForms::NormalizeAVX2(size_t num_channels,
+                                      size_t stride,
+                                      float* vec) {
+  const __m256 zero = _mm256_setzero_ps();
+  const __m256 one = _mm256_set1_ps(1.f);
+  for (size_t bin = 0; bin < stride; bin += 8) {
+    __m256 sum_squares = _mm256_setzero_ps();
+    for (size_t c = 0; c < num_channels; ++c) {
+      const __m256 re = _mm256_loadu_ps(&vec[2 * c * stride + bin]);
+      const __m256 im = _mm256_loadu_ps(&vec[(2 * c + 1) * stride + bin]);
+      sum_squares =
+          _mm256_fmadd_ps(re, re, _mm256_fmadd_ps(im, im, sum_squares));
+    }
+    // The bins of zero norm are divided by one instead.
+    const __m256 norm = _mm256_sqrt_ps(sum_squares);
+    const __m256 is_zero = _mm256_cmp_ps(norm, zero, _CMP_EQ_OQ);
+    const __m256 scale =
+        _mm256_div_ps(one, _mm256_blendv_ps(norm, one, is_zero));
+    for (size_t c = 0; c < 2 * num_channels; ++c) {
+      float* x = &vec[c * stride + bin];
+      _mm256_storeu_ps(x, _mm256_mul_ps(_mm256_loadu_ps(x), scale));
+    }
+  }
+}
+
+void BinQuadraticForms::QuadraticFormAVX2(const float* mat,
+                                          const float* vec,
+                                          size_t num_channels,
+                                          size_t stride,
+                                          float* out) {
+  switch (num_channels) {
+    case 2:
+      QuadraticForm<2>(mat, vec, num_channels, stride, out);
+      break;
+    case 4:
+      QuadraticForm<4>(mat, vec, num_channels, stride, out);
+      break;
+    case 8:
+      QuadraticForm<8>(mat, vec, num_channels, stride, out);
+      break;
+    default:
+      QuadraticForm<0>(mat, vec, num_channels, stride, out);
+      break;
+  }
+}
+
+void BinQuadraticForms::DotProductPowerAVX2(const float* row,
+                                            const float* vec,
+                                            size_t num_channels,
+                                            size_t stride,
+                                            float* out) {
+  for (size_t bin = 0; bin < stride; bin += 8) {
+    __m256 dot_re = _mm256_setzero_ps();
+    __m256 dot_im = _mm256_setzero_ps();
+    for (size_t c = 0; c < num_channels; ++c) {
+      const __m256 w_re = _mm256_loadu_ps(&row[2 * c * stride + bin]);
+      const __m256 w_im = _mm256_loadu_ps(&row[(2 * c + 1) * stride + bin]);
+      const __m256 x_re = _mm256_loadu_ps(&vec[2 * c * stride + bin]);
+      const __m256 x_im = _mm256_loadu_ps(&vec[(2 * c + 1) * stride + bin]);
+      dot_re = _mm256_fmadd_ps(w_re, x_re, _mm256_fmadd_ps(w_im, x_im, dot_re));
+      dot_im =
+          _mm256_fmadd_ps(w_re, x_im, _mm256_fnmadd_ps(w_im, x_re, dot_im));
+    }
+    _mm256_storeu_ps(&out[bin],
+                     _mm256_fmadd_ps(dot_re, dot_re,
+                                     _mm256_mul_ps(dot_im, dot_im)));
+  }
+}
+
+}  // namespace webrtc
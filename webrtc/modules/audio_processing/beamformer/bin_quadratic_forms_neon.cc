@@ -0,0 +1,123 @@
+/*
+ *  Copyright (c) 2016 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+// The quadratic form kernels on four bins at a time.
+
+#include "webrtc/modules/audio_processing/beamformer/bin_quadratic_forms.h"
+
+#include <arm_neon.h>
+
+namespace webrtc {
+namespace {
+
+// |kNumChannels| is 0 for any number of channels, which is then taken from
+// |num_channels|.
+template <size_t kNumChannels>
+void QuadraticForm(const float* mat,
+                   const float* vec,
+                   size_t num_channels,
+                   size_t stride,
+                   float* out) {
+  const size_t n = kNumChannels ? kNumChannels : num_channels;
+  for (size_t bin = 0; bin < stride; bin += 4) {
+    float32x4_t form = vdupq_n_f32(0.f);
+    for (size_t j = 0; j < n; ++j) {
+      float32x4_t u_re = vdupq_n_f32(0.f);
+      float32x4_t u_im = vdupq_n_f32(0.f);
+      for (size_t i = 0; i < n; ++i) {
+        const float32x4_t x_re = vld1q_f32(&vec[2 * i * stride + bin]);
+        const float32x4_t x_im = vld1q_f32(&vec[(2 * i + 1) * stride + bin]);
+        const size_t k = i * n + j;
+        const float32x4_t m_re = vld1q_f32(&mat[2 * k * stride + bin]);
+        const float32x4_t m_im = vld1q_f32(&mat[(2 * k + 1) * stride + bin]);
+        u_re = vmlaq_f32(vmlaq_f32(u_re, x_re, m_re), x_im, m_im);
+        u_im = vmlsq_f32(vmlaq_f32(u_im, x_re, m_im), x_im, m_re);
+      }
+      form = vmlaq_f32(form, u_re, vld1q_f32(&vec[2 * j * stride + bin]));
+      form = vmlsq_f32(form, u_im, vld1q_f32(&vec[(2 * j + 1) * stride + bin]));
+    }
+    vst1q_f32(&out[bin], vmaxq_f32(form, vdupq_n_f32(0.f)));
+  }
+}
+
+}  // namespace
+
+void BinQuadraticForms::NormalizeNEON(size_t num_channels,
+                                      size_t stride,
+                                      float* vec) {
+  const float32x4_t zero = vdupq_n_f32(0.f);
+  const float32x4_t one = vdupq_n_f32(1.f);
+  for (size_t bin = 0; bin < stride; bin += 4) {
+    float32x4_t sum_squares = vdupq_n_f32(0.f);
+    for (size_t c = 0; c < num_channels; ++c) {
+      const float32x4_t re = vld1q_f32(&vec[2 * c * stride + bin]);
+      const float32x4_t im = vld1q_f32(&vec[(2 * c + 1) * stride + bin]);
+      sum_squares = vmlaq_f32(vmlaq_f32(sum_squares, re, re), im, im);
+    }
+    // There is no division in ARMv7 NEON; two Newton-Raphson steps refine the
+    // reciprocal square root estimate to about full precision. The bins of
+    // zero norm are scaled by one instead.
+    const uint32x4_t is_zero = vceqq_f32(sum_squares, zero);
+    const float32x4_t divisor = vbslq_f32(is_zero, one, sum_squares);
+    float32x4_t scale = vrsqrteq_f32(divisor);
+    scale = vmulq_f32(scale,
+                      vrsqrtsq_f32(vmulq_f32(divisor, scale), scale));
+    scale = vmulq_f32(scale,
+                      vrsqrtsq_f32(vmulq_f32(divisor, scale), scale));
+    for (size_t c = 0; c < 2 * num_channels; ++c) {
+      float* x = &vec[c * stride + bin];
+      vst1q_f32(x, vmulq_f32(vld1q_f32(x), scale));
+    }
+  }
+}
+
+void BinQuadraticForms::QuadraticFormNEON(const float* mat,
+                                          const float* vec,
+                                          size_t num_channels,
+                                          size_t stride,
+                                          float* out) {
+  switch (num_channels) {
+    case 2:
+      QuadraticForm<2>(mat, vec, num_channels, stride, out);
+      break;
+    case 4:
+      QuadraticForm<4>(mat, vec, num_channels, stride, out);
+      break;
+    case 8:
+      QuadraticForm<8>(mat, vec, num_channels, stride, out);
+      break;
+    default:
+      QuadraticForm<0>(mat, vec, num_channels, stride, out);
+      break;
+  }
+}
+
+void BinQuadraticForms::DotProductPowerNEON(const float* row,
+                                            const float* vec,
+                                            size_t num_channels,
+                                            size_t stride,
+                                            float* out) {
+  for (size_t bin = 0; bin < stride; bin += 4) {
+    float32x4_t dot_re = vdupq_n_f32(0.f);
+    float32x4_t dot_im = vdupq_n_f32(0.f);
+    for (size_t c = 0; c < num_channels; ++c) {
+      const float32x4_t w_re = vld1q_f32(&row[2 * c * stride + bin]);
+      const float32x4_t w_im = vld1q_f32(&row[(2 * c + 1) * stride + bin]);
+      const float32x4_t x_re = vld1q_f32(&vec[2 * c * stride + bin]);
+      const float32x4_t x_im = vld1q_f32(&vec[(2 * c + 1) * stride + bin]);
+      dot_re = vmlaq_f32(vmlaq_f32(dot_re, w_re, x_re), w_im, x_im);
+      dot_im = vmlsq_f32(vmlaq_f32(dot_im, w_re, x_im), w_im, x_re);
+    }
+    vst1q_f32(&out[bin],
+              vmlaq_f32(vmulq_f32(dot_re, dot_re), dot_im, dot_im));
+  }
+}
+
+}  // namespace webrtc
@@ -0,0 +1,128 @@
+/*
+ *  Copyright (c) 2016 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+// The quadratic form kernels on four bins at a time, with the same arithmetic
+// as the generic ones.
+
+#include "webrtc/modules/audio_processing/beamformer/bin_quadratic_forms.h"
+
+#include <xmmintrin.h>
+
+namespace webrtc {
+namespace {
+
+// |kNumChannels| is 0 for any number of channels, which is then taken from
+// |num_channels|.
+template <size_t kNumChannels>
+void QuadraticForm(const float* mat,
+                   const float* vec,
+                   size_t num_channels,
+                   size_t stride,
+                   float* out) {
+  const size_t n = kNumChannels ? kNumChannels : num_channels;
+  for (size_t bin = 0; bin < stride; bin += 4) {
+    __m128 form = _mm_setzero_ps();
+    for (size_t j = 0; j < n; ++j) {
+      __m128 u_re = _mm_setzero_ps();
+      __m128 u_im = _mm_setzero_ps();
+      for (size_t i = 0; i < n; ++i) {
+        const __m128 x_re = _mm_loadu_ps(&vec[2 * i * stride + bin]);
+        const __m128 x_im = _mm_loadu_ps(&vec[(2 * i + 1) * stride + bin]);
+        const size_t k = i * n + j;
+        const __m128 m_re = _mm_loadu_ps(&mat[2 * k * stride + bin]);
+        const __m128 m_im = _mm_loadu_ps(&mat[(2 * k + 1) * stride + bin]);
+        u_re = _mm_add_ps(
+            u_re, _mm_add_ps(_mm_mul_ps(x_re, m_re), _mm_mul_ps(x_im, m_im)));
+        u_im = _mm_add_ps(
+            u_im, _mm_sub_ps(_mm_mul_ps(x_re, m_im), _mm_mul_ps(x_im, m_re)));
+      }
+      form = _mm_add_ps(
+          form,
+          _mm_sub_ps(
+              _mm_mul_ps(u_re, _mm_loadu_ps(&vec[2 * j * stride + bin])),
+              _mm_mul_ps(u_im,
+                         _mm_loadu_ps(&vec[(2 * j + 1) * stride + bin]))));
+    }
+    _mm_storeu_ps(&out[bin], _mm_max_ps(form, _mm_setzero_ps()));
+  }
+}
+
+}  // namespace
+
+void BinQuadraticForms::NormalizeSSE2(size_t num_channels,
+                                      size_t stride,
+                                      float* vec) {
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 one = _mm_set1_ps(1.f);
+  for (size_t bin = 0; bin < stride; bin += 4) {
+    __m128 sum_squares = _mm_setzero_ps();
+    for (size_t c = 0; c < num_channels; ++c) {
+      const __m128 re = _mm_loadu_ps(&vec[2 * c * stride + bin]);
+      const __m128 im = _mm_loadu_ps(&vec[(2 * c + 1) * stride + bin]);
+      sum_squares = _mm_add_ps(
+          sum_squares, _mm_add_ps(_mm_mul_ps(re, re), _mm_mul_ps(im, im)));
+    }
+    // The bins of zero norm are divided by one instead.
+    const __m128 norm = _mm_sqrt_ps(sum_squares);
+    const __m128 is_zero = _mm_cmpeq_ps(norm, zero);
+    const __m128 scale = _mm_div_ps(
+        one, _mm_or_ps(_mm_and_ps(is_zero, one), _mm_andnot_ps(is_zero, norm)));
+    for (size_t c = 0; c < 2 * num_channels; ++c) {
+      float* x = &vec[c * stride + bin];
+      _mm_storeu_ps(x, _mm_mul_ps(_mm_loadu_ps(x), scale));
+    }
+  }
+}
+
+void BinQuadraticForms::QuadraticFormSSE2(const float* mat,
+                                          const float* vec,
+                                          size_t num_channels,
+                                          size_t stride,
+                                          float* out) {
+  switch (num_channels) {
+    case 2:
+      QuadraticForm<2>(mat, vec, num_channels, stride, out);
+      break;
+    case 4:
+      QuadraticForm<4>(mat, vec, num_channels, stride, out);
+      break;
+    case 8:
+      QuadraticForm<8>(mat, vec, num_channels, stride, out);
+      break;
+    default:
+      QuadraticForm<0>(mat, vec, num_channels, stride, out);
+      break;
+  }
+}
+
+void BinQuadraticForms::DotProductPowerSSE2(const float* row,
+                                            const float* vec,
+                                            size_t num_channels,
+                                            size_t stride,
+                                            float* out) {
+  for (size_t bin = 0; bin < stride; bin += 4) {
+    __m128 dot_re = _mm_setzero_ps();
+    __m128 dot_im = _mm_setzero_ps();
+    for (size_t c = 0; c < num_channels; ++c) {
+      const __m128 w_re = _mm_loadu_ps(&row[2 * c * stride + bin]);
+      const __m128 w_im = _mm_loadu_ps(&row[(2 * c + 1) * stride + bin]);
+      const __m128 x_re = _mm_loadu_ps(&vec[2 * c * stride + bin]);
+      const __m128 x_im = _mm_loadu_ps(&vec[(2 * c + 1) * stride + bin]);
+      dot_re = _mm_add_ps(
+          dot_re, _mm_add_ps(_mm_mul_ps(w_re, x_re), _mm_mul_ps(w_im, x_im)));
+      dot_im = _mm_add_ps(
+          dot_im, _mm_sub_ps(_mm_mul_ps(w_re, x_im), _mm_mul_ps(w_im, x_re)));
+    }
+    _mm_storeu_ps(&out[bin], _mm_add_ps(_mm_mul_ps(dot_re, dot_re),
+                                        _mm_mul_ps(dot_im, dot_im)));
+  }
+}
+
+}  // namespace webrtc
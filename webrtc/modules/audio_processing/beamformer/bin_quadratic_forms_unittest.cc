@@ -0,0 +1,211 @@
+/*
+ *  Copyright (c) 2016 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/modules/audio_processing/beamformer/bin_quadratic_forms.h"
+
+#include <math.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "testing/gtest/include/gtest/gtest.h"
+#include "webrtc/base/scoped_ptr.h"
+#include "webrtc/system_wrappers/include/cpu_features_wrapper.h"
+#include "webrtc/system_wrappers/include/scoped_vector.h"
+
+namespace webrtc {
+namespace {
+
+const size_t kFirstBin = 3;
+const size_t kNumMatrices = 3;
+
+// Random Hermitian matrices and vectors, as the covariance matrices and the
+// delay sum masks of the beamformer, and random input with one silent bin.
+class BinQuadraticFormsTest : public ::testing::Test {
+ protected:
+  void Init(size_t num_channels, size_t num_bins) {
+    num_channels_ = num_channels;
+    num_bins_ = num_bins;
+    std::uniform_real_distribution<float> dist(-1.f, 1.f);
+    matrices_.clear();
+    row_vectors_.clear();
+    for (size_t i = 0; i < kNumMatrices * num_bins; ++i) {
+      matrices_.push_back(new ComplexMatrix<float>(num_channels, num_channels));
+    }
+    for (size_t b = 0; b < num_bins; ++b) {
+      row_vectors_.push_back(new ComplexMatrix<float>(1, num_channels));
+    }
+    for (size_t b = 0; b < num_bins; ++b) {
+      for (size_t m = 0; m < kNumMatrices; ++m) {
+        complex<float>* const* elements =
+            matrices_[m * num_bins + b]->elements();
+        for (size_t i = 0; i < num_channels; ++i) {
+          elements[i][i] = complex<float>(1.f + dist(random_), 0.f);
+          for (size_t j = 0; j < i; ++j) {
+            elements[i][j] = complex<float>(dist(random_), dist(random_));
+            elements[j][i] = conj(elements[i][j]);
+          }
+        }
+      }
+      for (size_t c = 0; c < num_channels; ++c) {
+        row_vectors_[b]->elements()[0][c] =
+            complex<float>(dist(random_), dist(random_));
+      }
+    }
+    input_.assign(num_channels,
+                  std::vector<complex<float>>(kFirstBin + num_bins));
+    input_pointers_.clear();
+    for (size_t c = 0; c < num_channels; ++c) {
+      for (size_t b = 0; b < input_[c].size(); ++b) {
+        input_[c][b] =
+            complex<float>(1000.f * dist(random_), 1000.f * dist(random_));
+      }
+      input_[c][kFirstBin] = complex<float>(0.f, 0.f);
+      input_pointers_.push_back(input_[c].data());
+    }
+  }
+
+  rtc::scoped_ptr<BinQuadraticForms> Create(WebRtc_CPUInfo cpu_info) {
+    WebRtc_CPUInfo saved = WebRtc_GetCPUInfo;
+    WebRtc_GetCPUInfo = cpu_info;
+    rtc::scoped_ptr<BinQuadraticForms> forms(
+        new BinQuadraticForms(num_channels_, num_bins_, kNumMatrices));
+    WebRtc_GetCPUInfo = saved;
+    for (size_t b = 0; b < num_bins_; ++b) {
+      for (size_t m = 0; m < kNumMatrices; ++m) {
+        forms->SetMatrix(m, b, *matrices_[m * num_bins_ + b]);
+      }
+      forms->SetRowVector(b, *row_vectors_[b]);
+    }
+    forms->Process(input_pointers_.data(), kFirstBin);
+    return forms;
+  }
+
+  // The forms in double precision, as the beamformer defines them.
+  void ExpectNearReference(const BinQuadraticForms& forms, double tolerance) {
+    for (size_t b = 0; b < num_bins_; ++b) {
+      std::vector<complex<double>> x(num_channels_);
+      double norm = 0.0;
+      for (size_t c = 0; c < num_channels_; ++c) {
+        x[c] = complex<double>(input_[c][kFirstBin + b]);
+        norm += std::norm(x[c]);
+      }
+      norm = sqrt(norm);
+      for (size_t c = 0; c < num_channels_ && norm != 0.0; ++c) {
+        x[c] /= norm;
+      }
+      for (size_t m = 0; m < kNumMatrices; ++m) {
+        const complex<float>* const* elements =
+            matrices_[m * num_bins_ + b]->elements();
+        complex<double> form = 0.0;
+        for (size_t i = 0; i < num_channels_; ++i) {
+          for (size_t j = 0; j < num_channels_; ++j) {
+            form += conj(x[i]) * complex<double>(elements[i][j]) * x[j];
+          }
+        }
+        EXPECT_NEAR(std::max(form.real(), 0.0), forms.quadratic_form(m)[b],
+                    tolerance)
+            << "matrix " << m << " bin " << b;
+      }
+      complex<double> dot = 0.0;
+      for (size_t c = 0; c < num_channels_; ++c) {
+        const complex<double> w(row_vectors_[b]->elements()[0][c]);
+        dot += conj(w) * x[c];
+      }
+      EXPECT_NEAR(std::norm(dot), forms.conjugate_dot_product_power()[b],
+                  tolerance)
+          << "bin " << b;
+    }
+  }
+
+  void ExpectEqual(const BinQuadraticForms& expected,
+                   const BinQuadraticForms& actual,
+                   float tolerance) {
+    for (size_t b = 0; b < num_bins_; ++b) {
+      for (size_t m = 0; m < kNumMatrices; ++m) {
+        EXPECT_NEAR(expected.quadratic_form(m)[b], actual.quadratic_form(m)[b],
+                    tolerance);
+      }
+      EXPECT_NEAR(expected.conjugate_dot_product_power()[b],
+                  actual.conjugate_dot_product_power()[b], tolerance);
+    }
+  }
+
+  size_t num_channels_;
+  size_t num_bins_;
+  ScopedVector<ComplexMatrix<float>> matrices_;
+  ScopedVector<ComplexMatrix<float>> row_vectors_;
+  std::vector<std::vector<complex<float>>> input_;
+  std::vector<const complex<float>*> input_pointers_;
+  std::mt19937 random_;
+};
+
+const size_t kNumChannels[] = {1, 2, 3, 4, 8};
+const size_t kNumBins[] = {1, 13, 102};
+
+}  // namespace
+
+TEST_F(BinQuadraticFormsTest, MatchesReference) {
+  for (size_t num_channels : kNumChannels) {
+    for (size_t num_bins : kNumBins) {
+      SCOPED_TRACE(num_channels);
+      SCOPED_TRACE(num_bins);
+      Init(num_channels, num_bins);
+      rtc::scoped_ptr<BinQuadraticForms> forms = Create(WebRtc_GetCPUInfo);
+      ExpectNearReference(*forms, 1e-5 * num_channels);
+      // The silent bin is left silent.
+      for (size_t m = 0; m < kNumMatrices; ++m) {
+        EXPECT_EQ(0.f, forms->quadratic_form(m)[0]);
+      }
+      EXPECT_EQ(0.f, forms->conjugate_dot_product_power()[0]);
+    }
+  }
+}
+
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+TEST_F(BinQuadraticFormsTest, SSE2MatchesGeneric) {
+  if (!WebRtc_GetCPUInfo(kSSE2)) {
+    return;
+  }
+  for (size_t num_channels : kNumChannels) {
+    for (size_t num_bins : kNumBins) {
+      SCOPED_TRACE(num_channels);
+      SCOPED_TRACE(num_bins);
+      Init(num_channels, num_bins);
+      rtc::scoped_ptr<BinQuadraticForms> generic =
+          Create(WebRtc_GetCPUInfoNoASM);
+      rtc::scoped_ptr<BinQuadraticForms> sse2 = Create(
+          [](CPUFeature feature) { return feature == kSSE2 ? 1 : 0; });
+      ExpectEqual(*generic, *sse2, 0.f);
+    }
+  }
+}
+
+TEST_F(BinQuadraticFormsTest, AVX2MatchesGeneric) {
+  if (!WebRtc_GetCPUInfo(kAVX2)) {
+    return;
+  }
+  for (size_t num_channels : kNumChannels) {
+    for (size_t num_bins : kNumBins) {
+      SCOPED_TRACE(num_channels);
+      SCOPED_TRACE(num_bins);
+      Init(num_channels, num_bins);
+      rtc::scoped_ptr<BinQuadraticForms> generic =
+          Create(WebRtc_GetCPUInfoNoASM);
+      rtc::scoped_ptr<BinQuadraticForms> avx2 = Create(WebRtc_GetCPUInfo);
+      // Fused multiply-adds round differently.
+      ExpectEqual(*generic, *avx2, 1e-5f * num_channels);
+    }
+  }
+}
+#endif  // WEBRTC_ARCH_X86_FAMILY
+
+}  // namespace webrtc
@@ -134,19 +134,6 @@ float SumAbs(const ComplexMatrix<float>& mat) {
   return sum_abs;
 }
 
-// Calculates the sum of squares of a complex matrix.
-float SumSquares(const ComplexMatrix<float>& mat) {
-  float sum_squares = 0.f;
-  const complex<float>* const* mat_els = mat.elements();
-  for (size_t i = 0; i < mat.num_rows(); ++i) {
-    for (size_t j = 0; j < mat.num_columns(); ++j) {
-      float abs_value = std::abs(mat_els[i][j]);
-      sum_squares += abs_value * abs_value;
-    }
-  }
-  return sum_squares;
-}
-
 // Does |out| = |in|.' * conj(|in|) for row vector |in|.
 void TransposedConjugatedProduct(const ComplexMatrix<float>& in,
                                  ComplexMatrix<float>* out) {
@@ -366,6 +353,20 @@ void NonlinearBeamformer::NormalizeCovMats() {
   }
 }
 
+void NonlinearBeamformer::InitQuadraticForms() {
+  const size_t num_bins = high_mean_end_bin_ - low_mean_start_bin_ + 1;
+  quadratic_forms_.reset(new BinQuadraticForms(
+      num_input_channels_, num_bins, 1 + interf_angles_radians_.size()));
+  for (size_t bin = 0; bin < num_bins; ++bin) {
+    const size_t i = low_mean_start_bin_ + bin;
+    quadratic_forms_->SetMatrix(0, bin, target_cov_mats_[i]);
+    for (size_t j = 0; j < interf_angles_radians_.size(); ++j) {
+      quadratic_forms_->SetMatrix(1 + j, bin, *interf_cov_mats_[i][j]);
+    }
+    quadratic_forms_->SetRowVector(bin, delay_sum_masks_[i]);
+  }
+}
+
 void NonlinearBeamformer::ProcessChunk(const ChannelBuffer<float>& input,
                                        ChannelBuffer<float>* output) {
   RTC_DCHECK_EQ(input.num_channels(), num_input_channels_);
@@ -398,6 +399,7 @@ void NonlinearBeamformer::AimAt(const SphericalPointf& target_direction) {
   InitTargetCovMats();
   InitInterfCovMats();
   NormalizeCovMats();
+  InitQuadraticForms();
 }
 
 bool NonlinearBeamformer::IsInBeam(const SphericalPointf& spherical_point) {
@@ -418,33 +420,28 @@ void NonlinearBeamformer::ProcessAudioBlock(const complex_f* const* input,
 
   // Calculating the post-filter masks. Note that we need two for each
   // frequency bin to account for the positive and negative interferer
-  // angle.
+  // angle. The norms with the normalized input of all the bins are evaluated
+  // at once.
+  quadratic_forms_->Process(input, low_mean_start_bin_);
+  const float* rxims = quadratic_forms_->quadratic_form(0);
+  const float* rmws = quadratic_forms_->conjugate_dot_product_power();
   for (size_t i = low_mean_start_bin_; i <= high_mean_end_bin_; ++i) {
-    eig_m_.CopyFromColumn(input, i, num_input_channels_);
-    float eig_m_norm_factor = std::sqrt(SumSquares(eig_m_));
-    if (eig_m_norm_factor != 0.f) {
-      eig_m_.Scale(1.f / eig_m_norm_factor);
-    }
-
-    float rxim = Norm(target_cov_mats_[i], eig_m_);
+    const size_t bin = i - low_mean_start_bin_;
+    float rxim = rxims[bin];
     float ratio_rxiw_rxim = 0.f;
     if (rxim > 0.f) {
       ratio_rxiw_rxim = rxiws_[i] / rxim;
     }
 
-    complex_f rmw = abs(ConjugateDotProduct(delay_sum_masks_[i], eig_m_));
-    rmw *= rmw;
-    float rmw_r = rmw.real();
+    float rmw_r = rmws[bin];
 
-    new_mask_[i] = CalculatePostfilterMask(*interf_cov_mats_[i][0],
-                                           rpsiws_[i][0],
-                                           ratio_rxiw_rxim,
-                                           rmw_r);
+    new_mask_[i] = CalculatePostfilterMask(
+        quadratic_forms_->quadratic_form(1)[bin], rpsiws_[i][0],
+        ratio_rxiw_rxim, rmw_r);
     for (size_t j = 1; j < interf_angles_radians_.size(); ++j) {
-      float tmp_mask = CalculatePostfilterMask(*interf_cov_mats_[i][j],
-                                               rpsiws_[i][j],
-                                               ratio_rxiw_rxim,
-                                               rmw_r);
+      float tmp_mask = CalculatePostfilterMask(
+          quadratic_forms_->quadratic_form(1 + j)[bin], rpsiws_[i][j],
+          ratio_rxiw_rxim, rmw_r);
       if (tmp_mask < new_mask_[i]) {
         new_mask_[i] = tmp_mask;
       }
@@ -459,13 +456,10 @@ void NonlinearBeamformer::ProcessAudioBlock(const complex_f* const* input,
   ApplyMasks(input, output);
 }
 
-float NonlinearBeamformer::CalculatePostfilterMask(
-    const ComplexMatrixF& interf_cov_mat,
-    float rpsiw,
-    float ratio_rxiw_rxim,
-    float rmw_r) {
-  float rpsim = Norm(interf_cov_mat, eig_m_);
-
+float NonlinearBeamformer::CalculatePostfilterMask(float rpsim,
+                                                   float rpsiw,
+                                                   float ratio_rxiw_rxim,
+                                                   float rmw_r) {
   float ratio = 0.f;
   if (rpsim > 0.f) {
     ratio = rpsiw / rpsim;
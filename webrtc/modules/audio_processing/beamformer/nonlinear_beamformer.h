@@ -20,6 +20,7 @@
 #include "webrtc/common_audio/lapped_transform.h"
 #include "webrtc/common_audio/channel_buffer.h"
 #include "webrtc/modules/audio_processing/beamformer/beamformer.h"
+#include "webrtc/modules/audio_processing/beamformer/bin_quadratic_forms.h"
 #include "webrtc/modules/audio_processing/beamformer/complex_matrix.h"
 #include "webrtc/system_wrappers/include/scoped_vector.h"
 
@@ -88,10 +89,11 @@ class NonlinearBeamformer
   void InitDiffuseCovMats();
   void InitInterfCovMats();
   void NormalizeCovMats();
+  void InitQuadraticForms();
 
   // Calculates postfilter masks that minimize the mean squared error of our
   // estimation of the desired signal.
-  float CalculatePostfilterMask(const ComplexMatrixF& interf_cov_mat,
+  float CalculatePostfilterMask(float rpsim,
                                 float rpsiw,
                                 float ratio_rxiw_rxim,
                                 float rmxi_r);
@@ -180,8 +182,10 @@ class NonlinearBeamformer
   // The vector has a size equal to the number of interferer scenarios.
   std::vector<float> rpsiws_[kNumFreqBins];
 
-  // The microphone normalization factor.
-  ComplexMatrixF eig_m_;
+  // The target covariance matrix, then the interferer covariance matrices and
+  // the delay sum mask of the bins from |low_mean_start_bin_| to
+  // |high_mean_end_bin_|, to evaluate the postfilter norms of a whole block.
+  rtc::scoped_ptr<BinQuadraticForms> quadratic_forms_;
 
   // For processing the high-frequency input signal.
   float high_pass_postfilter_mask_;
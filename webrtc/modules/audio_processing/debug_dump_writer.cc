@@ -0,0 +1,178 @@
+/*
+ *  Copyright (c) 2016 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/modules/audio_processing/debug_dump_writer.h"
+
+#include <utility>
+
+#include "third_party/zlib/zlib.h"
+#include "webrtc/base/atomicops.h"
+#include "webrtc/base/checks.h"
+
+namespace webrtc {
+namespace {
+
+// The writer thread is not woken up by Write(), as that would take a lock on
+// the audio threads; it looks at the queues this often instead.
+const int kPollIntervalMs = 20;
+
+const size_t kZBufferSize = 16384;
+
+}  // namespace
+
+const size_t DebugDumpWriter::kDefaultQueueSize;
+
+DebugDumpWriter::DebugDumpWriter(rtc::scoped_ptr<FileWrapper> file,
+                                 bool compress,
+                                 size_t queue_size)
+    : file_(std::move(file)),
+      wake_up_(false, false),
+      thread_(&DebugDumpWriter::Run, this, "DebugDumpWriter") {
+  RTC_DCHECK(file_->Open());
+  for (size_t i = 0; i < kNumStreams; ++i) {
+    queues_[i].reset(new SpscSwapQueue<Message>(queue_size));
+    has_consumer_message_[i] = false;
+  }
+  if (compress) {
+    zstream_.reset(new z_stream());
+    // A gzip header, for a window of 32 kB.
+    if (deflateInit2(zstream_.get(), Z_BEST_SPEED, Z_DEFLATED, 15 + 16, 8,
+                     Z_DEFAULT_STRATEGY) != Z_OK) {
+      zstream_.reset();
+      write_failed_ = true;
+    }
+    zbuffer_.resize(kZBufferSize);
+  }
+  thread_.Start();
+}
+
+DebugDumpWriter::~DebugDumpWriter() {
+  Stop();
+}
+
+void DebugDumpWriter::Write(Stream stream, audioproc::Event* event) {
+  Message* message = &producer_messages_[stream];
+  // Swapping exchanges the internals of the messages, without copying.
+  message->event->Swap(event);
+  message->sequence_number =
+      rtc::AtomicOps::Increment(&next_sequence_number_);
+  if (!queues_[stream]->Insert(message)) {
+    message->event->Clear();
+    rtc::AtomicOps::Increment(&num_dropped_messages_);
+  }
+}
+
+bool DebugDumpWriter::Stop() {
+  if (stopped_) {
+    return !write_failed_;
+  }
+  stopped_ = true;
+  wake_up_.Set();
+  thread_.Stop();
+  // Whatever was handed over since the last look of the thread.
+  WriteQueuedMessages();
+  if (zstream_) {
+    if (!Deflate(Z_FINISH)) {
+      write_failed_ = true;
+    }
+    deflateEnd(zstream_.get());
+    zstream_.reset();
+  }
+  if (file_->Flush() == -1 || file_->CloseFile() == -1) {
+    write_failed_ = true;
+  }
+  return !write_failed_;
+}
+
+size_t DebugDumpWriter::num_dropped_messages() const {
+  return static_cast<size_t>(rtc::AtomicOps::AcquireLoad(
+      &num_dropped_messages_));
+}
+
+bool DebugDumpWriter::Run(void* obj) {
+  DebugDumpWriter* writer = static_cast<DebugDumpWriter*>(obj);
+  writer->wake_up_.Wait(kPollIntervalMs);
+  writer->WriteQueuedMessages();
+  return true;
+}
+
+void DebugDumpWriter::WriteQueuedMessages() {
+  while (true) {
+    // The message at hand that was handed over first. A message that is being
+    // handed over right now may be overtaken by a later one of the other
+    // stream, as with two threads writing to the file directly.
+    int next = -1;
+    for (size_t i = 0; i < kNumStreams; ++i) {
+      if (!has_consumer_message_[i]) {
+        // Leaves the message written last in the queue, for reuse.
+        has_consumer_message_[i] = queues_[i]->Remove(&consumer_messages_[i]);
+      }
+      if (has_consumer_message_[i] &&
+          (next < 0 ||
+           static_cast<int>(
+               static_cast<unsigned>(consumer_messages_[i].sequence_number) -
+               static_cast<unsigned>(
+                   consumer_messages_[next].sequence_number)) < 0)) {
+        next = static_cast<int>(i);
+      }
+    }
+    if (next < 0) {
+      return;
+    }
+
+    audioproc::Event* event = consumer_messages_[next].event.get();
+    has_consumer_message_[next] = false;
+    if (!event->SerializeToString(&event_str_) || event_str_.empty()) {
+      event->Clear();
+      continue;
+    }
+    event->Clear();
+#if defined(WEBRTC_ARCH_BIG_ENDIAN)
+// TODO(ajm): Use little-endian "on the wire". For the moment, we can be
+//            pretty safe in assuming little-endian.
+#endif
+    // The message preceded by its size.
+    const int32_t size = static_cast<int32_t>(event_str_.size());
+    if (!WriteToFile(&size, sizeof(size)) ||
+        !WriteToFile(event_str_.data(), event_str_.size())) {
+      write_failed_ = true;
+    }
+  }
+}
+
+bool DebugDumpWriter::WriteToFile(const void* data, size_t length) {
+  if (!zstream_) {
+    return file_->Write(data, length);
+  }
+  zstream_->next_in =
+      const_cast<Bytef*>(static_cast<const Bytef*>(data));
+  zstream_->avail_in = static_cast<uInt>(length);
+  return Deflate(Z_NO_FLUSH);
+}
+
+bool DebugDumpWriter::Deflate(int flush) {
+  int result;
+  do {
+    zstream_->next_out = reinterpret_cast<Bytef*>(&zbuffer_[0]);
+    zstream_->avail_out = static_cast<uInt>(zbuffer_.size());
+    result = deflate(zstream_.get(), flush);
+    if (result == Z_STREAM_ERROR) {
+      return false;
+    }
+    const size_t length = zbuffer_.size() - zstream_->avail_out;
+    if (length > 0 && !file_->Write(zbuffer_.data(), length)) {
+      return false;
+    }
+  } while (zstream_->avail_out == 0 ||
+           (flush == Z_FINISH && result != Z_STREAM_END));
+  return true;
+}
+
+}  // namespace webrtc
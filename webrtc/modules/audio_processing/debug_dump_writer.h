@@ -0,0 +1,108 @@
+/*
+ *  Copyright (c) 2016 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef WEBRTC_MODULES_AUDIO_PROCESSING_DEBUG_DUMP_WRITER_H_
+#define WEBRTC_MODULES_AUDIO_PROCESSING_DEBUG_DUMP_WRITER_H_
+
+#include <string>
+
+#include "webrtc/base/event.h"
+#include "webrtc/base/platform_thread.h"
+#include "webrtc/base/scoped_ptr.h"
+#include "webrtc/common_audio/swap_queue.h"
+#include "webrtc/system_wrappers/include/file_wrapper.h"
+
+// Files generated at build-time by the protobuf compiler.
+#ifdef WEBRTC_ANDROID_PLATFORM_BUILD
+#include "external/webrtc/webrtc/modules/audio_processing/debug.pb.h"
+#else
+#include "webrtc/audio_processing/debug.pb.h"
+#endif
+
+typedef struct z_stream_s z_stream;
+
+namespace webrtc {
+
+// Writes the messages of the APM debug dump to a file on a thread of its own,
+// so that the render and capture threads never wait for the disk. Each of them
+// hands its messages over through a lock-free queue of preallocated messages;
+// the writer thread serializes them and writes them out in the order they were
+// handed over. A message that finds its queue full is dropped and counted, so
+// a slow disk costs messages rather than audio glitches.
+class DebugDumpWriter {
+ public:
+  enum Stream { kRenderStream, kCaptureStream, kNumStreams };
+
+  // About one second of 10 ms frames.
+  static const size_t kDefaultQueueSize = 100;
+
+  // Starts writing to |file|, which must be open and is closed by Stop().
+  // With |compress| the file is the gzip compressed dump, which gunzip turns
+  // back into the plain one. Each stream buffers up to |queue_size| messages.
+  DebugDumpWriter(rtc::scoped_ptr<FileWrapper> file,
+                  bool compress,
+                  size_t queue_size);
+  // Calls Stop().
+  ~DebugDumpWriter();
+
+  // Hands |*event| over to the writer thread and leaves a cleared message in
+  // its place, or clears |*event| if the queue of |stream| is full. Neither
+  // blocks nor allocates. Calls for the same stream must not overlap.
+  void Write(Stream stream, audioproc::Event* event);
+
+  // Writes out every message handed over so far, stops the writer thread and
+  // closes the file. Returns false if any write to the file failed.
+  bool Stop();
+
+  // Messages that Write() has dropped so far.
+  size_t num_dropped_messages() const;
+
+ private:
+  // A queue slot; every slot owns a message from construction on, and
+  // swapping two of them exchanges their messages.
+  struct Message {
+    Message() : event(new audioproc::Event()) {}
+    rtc::scoped_ptr<audioproc::Event> event;
+    int sequence_number = 0;
+  };
+
+  static bool Run(void* obj);
+
+  // Writes the queued messages by sequence number until the queues are empty.
+  void WriteQueuedMessages();
+  bool WriteToFile(const void* data, size_t length);
+  bool Deflate(int flush);
+
+  rtc::scoped_ptr<FileWrapper> file_;
+  rtc::scoped_ptr<z_stream> zstream_;
+  std::string event_str_;
+  std::string zbuffer_;
+  bool write_failed_ = false;
+  bool stopped_ = false;
+
+  // Only touched by the producer of each stream.
+  Message producer_messages_[kNumStreams];
+  // Only touched by the writer thread; the head of each queue, if taken out.
+  Message consumer_messages_[kNumStreams];
+  bool has_consumer_message_[kNumStreams];
+
+  rtc::scoped_ptr<SpscSwapQueue<Message>> queues_[kNumStreams];
+  volatile int next_sequence_number_ = 0;
+  volatile int num_dropped_messages_ = 0;
+
+  rtc::Event wake_up_;
+  rtc::PlatformThread thread_;
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(DebugDumpWriter);
+};
+
+}  // namespace webrtc
+
+#endif  // WEBRTC_MODULES_AUDIO_PROCESSING_DEBUG_DUMP_WRITER_H_
@@ -0,0 +1,219 @@
+/*
+ *  Copyright (c) 2016 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/modules/audio_processing/debug_dump_writer.h"
+
+#include <stdio.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "testing/gtest/include/gtest/gtest.h"
+#include "third_party/zlib/zlib.h"
+#include "webrtc/base/platform_thread.h"
+#include "webrtc/base/scoped_ptr.h"
+#include "webrtc/modules/audio_processing/test/protobuf_utils.h"
+#include "webrtc/test/testsupport/fileutils.h"
+
+namespace webrtc {
+namespace {
+
+const int kNumMessages = 1000;
+
+// Render messages carry their index as data, capture messages as delay.
+void FillMessage(DebugDumpWriter::Stream stream,
+                 int index,
+                 audioproc::Event* event) {
+  if (stream == DebugDumpWriter::kRenderStream) {
+    event->set_type(audioproc::Event::REVERSE_STREAM);
+    event->mutable_reverse_stream()->set_data(std::to_string(index));
+  } else {
+    event->set_type(audioproc::Event::STREAM);
+    event->mutable_stream()->set_delay(index);
+  }
+}
+
+rtc::scoped_ptr<DebugDumpWriter> CreateWriter(const std::string& file_name,
+                                              bool compress,
+                                              size_t queue_size) {
+  rtc::scoped_ptr<FileWrapper> file(FileWrapper::Create());
+  EXPECT_EQ(0, file->OpenFile(file_name.c_str(), false));
+  return rtc::scoped_ptr<DebugDumpWriter>(
+      new DebugDumpWriter(std::move(file), compress, queue_size));
+}
+
+std::vector<audioproc::Event> ReadMessages(const std::string& file_name) {
+  std::vector<audioproc::Event> events;
+  FILE* file = fopen(file_name.c_str(), "rb");
+  EXPECT_TRUE(file);
+  audioproc::Event event;
+  while (ReadMessageFromFile(file, &event)) {
+    events.push_back(event);
+  }
+  fclose(file);
+  return events;
+}
+
+std::string ReadFile(const std::string& file_name, bool gzipped) {
+  std::string contents;
+  char buffer[4096];
+  if (gzipped) {
+    gzFile file = gzopen(file_name.c_str(), "rb");
+    EXPECT_TRUE(file);
+    int length;
+    while ((length = gzread(file, buffer, sizeof(buffer))) > 0) {
+      contents.append(buffer, length);
+    }
+    gzclose(file);
+  } else {
+    FILE* file = fopen(file_name.c_str(), "rb");
+    EXPECT_TRUE(file);
+    size_t length;
+    while ((length = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+      contents.append(buffer, length);
+    }
+    fclose(file);
+  }
+  return contents;
+}
+
+// Writes the messages of one stream from a thread of its own.
+struct StreamWriter {
+  static bool Run(void* obj) {
+    StreamWriter* writer = static_cast<StreamWriter*>(obj);
+    audioproc::Event event;
+    for (int i = 0; i < kNumMessages; ++i) {
+      FillMessage(writer->stream, i, &event);
+      writer->dump_writer->Write(writer->stream, &event);
+      EXPECT_FALSE(event.has_type());
+    }
+    return false;
+  }
+
+  DebugDumpWriter* dump_writer;
+  DebugDumpWriter::Stream stream;
+};
+
+}  // namespace
+
+TEST(DebugDumpWriterTest, WritesMessagesInTheOrderTheyAreHandedOver) {
+  const std::string file_name = test::TempFilename(test::OutputPath(), "dump");
+  rtc::scoped_ptr<DebugDumpWriter> writer =
+      CreateWriter(file_name, false, kNumMessages);
+  audioproc::Event event;
+  for (int i = 0; i < kNumMessages; ++i) {
+    const DebugDumpWriter::Stream stream = i % 3
+                                               ? DebugDumpWriter::kCaptureStream
+                                               : DebugDumpWriter::kRenderStream;
+    FillMessage(stream, i, &event);
+    writer->Write(stream, &event);
+    // The message is handed over, not copied.
+    EXPECT_FALSE(event.has_type());
+  }
+  EXPECT_TRUE(writer->Stop());
+  EXPECT_EQ(0u, writer->num_dropped_messages());
+
+  std::vector<audioproc::Event> events = ReadMessages(file_name);
+  ASSERT_EQ(static_cast<size_t>(kNumMessages), events.size());
+  for (int i = 0; i < kNumMessages; ++i) {
+    if (i % 3) {
+      ASSERT_EQ(audioproc::Event::STREAM, events[i].type());
+      EXPECT_EQ(i, events[i].stream().delay());
+    } else {
+      ASSERT_EQ(audioproc::Event::REVERSE_STREAM, events[i].type());
+      EXPECT_EQ(std::to_string(i), events[i].reverse_stream().data());
+    }
+  }
+  remove(file_name.c_str());
+}
+
+TEST(DebugDumpWriterTest, DropsMessagesWhenTheQueueIsFull) {
+  const std::string file_name = test::TempFilename(test::OutputPath(), "dump");
+  // Far more messages than the writer thread can take out in between.
+  rtc::scoped_ptr<DebugDumpWriter> writer = CreateWriter(file_name, false, 2);
+  audioproc::Event event;
+  for (int i = 0; i < kNumMessages; ++i) {
+    FillMessage(DebugDumpWriter::kCaptureStream, i, &event);
+    writer->Write(DebugDumpWriter::kCaptureStream, &event);
+    EXPECT_FALSE(event.has_type());
+  }
+  EXPECT_TRUE(writer->Stop());
+  EXPECT_LT(0u, writer->num_dropped_messages());
+
+  // The messages that made it are complete and in order.
+  std::vector<audioproc::Event> events = ReadMessages(file_name);
+  EXPECT_EQ(static_cast<size_t>(kNumMessages),
+            events.size() + writer->num_dropped_messages());
+  for (size_t i = 1; i < events.size(); ++i) {
+    EXPECT_LT(events[i - 1].stream().delay(), events[i].stream().delay());
+  }
+  remove(file_name.c_str());
+}
+
+TEST(DebugDumpWriterTest, TakesMessagesFromTwoThreads) {
+  const std::string file_name = test::TempFilename(test::OutputPath(), "dump");
+  rtc::scoped_ptr<DebugDumpWriter> writer = CreateWriter(
+      file_name, false, DebugDumpWriter::kDefaultQueueSize);
+  StreamWriter render = {writer.get(), DebugDumpWriter::kRenderStream};
+  StreamWriter capture = {writer.get(), DebugDumpWriter::kCaptureStream};
+  rtc::PlatformThread render_thread(&StreamWriter::Run, &render, "render");
+  rtc::PlatformThread capture_thread(&StreamWriter::Run, &capture, "capture");
+  render_thread.Start();
+  capture_thread.Start();
+  render_thread.Stop();
+  capture_thread.Stop();
+  EXPECT_TRUE(writer->Stop());
+
+  // Each stream keeps its order.
+  std::vector<audioproc::Event> events = ReadMessages(file_name);
+  EXPECT_EQ(static_cast<size_t>(2 * kNumMessages),
+            events.size() + writer->num_dropped_messages());
+  int last_render = -1;
+  int last_capture = -1;
+  for (const audioproc::Event& event : events) {
+    if (event.type() == audioproc::Event::STREAM) {
+      EXPECT_LT(last_capture, event.stream().delay());
+      last_capture = event.stream().delay();
+    } else {
+      ASSERT_EQ(audioproc::Event::REVERSE_STREAM, event.type());
+      const int index = std::stoi(event.reverse_stream().data());
+      EXPECT_LT(last_render, index);
+      last_render = index;
+    }
+  }
+  remove(file_name.c_str());
+}
+
+TEST(DebugDumpWriterTest, CompressedDumpUnzipsToThePlainOne) {
+  std::string file_names[2];
+  std::string contents[2];
+  for (int compress = 0; compress < 2; ++compress) {
+    file_names[compress] = test::TempFilename(test::OutputPath(), "dump");
+    rtc::scoped_ptr<DebugDumpWriter> writer =
+        CreateWriter(file_names[compress], compress != 0, kNumMessages);
+    audioproc::Event event;
+    for (int i = 0; i < kNumMessages; ++i) {
+      FillMessage(DebugDumpWriter::kRenderStream, i, &event);
+      writer->Write(DebugDumpWriter::kRenderStream, &event);
+    }
+    EXPECT_TRUE(writer->Stop());
+    EXPECT_EQ(0u, writer->num_dropped_messages());
+    contents[compress] = ReadFile(file_names[compress], compress != 0);
+  }
+  EXPECT_FALSE(contents[0].empty());
+  EXPECT_EQ(contents[0], contents[1]);
+  // And it is smaller.
+  EXPECT_LT(ReadFile(file_names[1], false).size(), contents[0].size());
+  remove(file_names[0].c_str());
+  remove(file_names[1].c_str());
+}
+
+}  // namespace webrtc
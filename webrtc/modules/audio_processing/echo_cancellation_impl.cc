@@ -18,6 +18,7 @@ extern "C" {
 }
 #include "webrtc/modules/audio_processing/aec/echo_cancellation.h"
 #include "webrtc/modules/audio_processing/audio_buffer.h"
+#include "webrtc/modules/audio_processing/logging/aec_trace.h"
 
 namespace webrtc {
 
@@ -77,13 +78,16 @@ EchoCancellationImpl::EchoCancellationImpl(const AudioProcessing* apm,
       delay_logging_enabled_(false),
       extended_filter_enabled_(false),
       delay_agnostic_enabled_(false),
+      trace_(NULL),
       render_queue_element_max_size_(0) {
   RTC_DCHECK(apm);
   RTC_DCHECK(crit_render);
   RTC_DCHECK(crit_capture);
 }
 
-EchoCancellationImpl::~EchoCancellationImpl() {}
+EchoCancellationImpl::~EchoCancellationImpl() {
+  WebRtcAecTrace_Free(trace_);
+}
 
 int EchoCancellationImpl::ProcessRenderAudio(const AudioBuffer* audio) {
   rtc::CritScope cs_render(crit_render_);
@@ -392,6 +396,41 @@ int EchoCancellationImpl::GetDelayMetrics(int* median, int* std,
   return AudioProcessing::kNoError;
 }
 
+int EchoCancellationImpl::StartTrace(FILE* handle) {
+  if (handle == NULL) {
+    return AudioProcessing::kNullPointerError;
+  }
+  // Created before the locks are taken, as it starts a thread.
+  AecTrace* trace = WebRtcAecTrace_Create(handle, kAecTraceDefaultCapacity);
+  if (trace == NULL) {
+    return AudioProcessing::kFileError;
+  }
+  AecTrace* old_trace;
+  {
+    rtc::CritScope cs_render(crit_render_);
+    rtc::CritScope cs_capture(crit_capture_);
+    old_trace = trace_;
+    trace_ = trace;
+    Configure();
+  }
+  WebRtcAecTrace_Free(old_trace);
+  return AudioProcessing::kNoError;
+}
+
+int EchoCancellationImpl::StopTrace() {
+  AecTrace* trace;
+  {
+    rtc::CritScope cs_render(crit_render_);
+    rtc::CritScope cs_capture(crit_capture_);
+    trace = trace_;
+    trace_ = NULL;
+    Configure();
+  }
+  // Writing out the rest is left for after the locks are released.
+  return WebRtcAecTrace_Free(trace) == 0 ? AudioProcessing::kNoError
+                                         : AudioProcessing::kFileError;
+}
+
 struct AecCore* EchoCancellationImpl::aec_core() const {
   rtc::CritScope cs(crit_capture_);
   if (!is_component_enabled()) {
@@ -431,7 +470,8 @@ void EchoCancellationImpl::AllocateRenderQueue() {
     std::vector<float> template_queue_element(render_queue_element_max_size_);
 
     render_signal_queue_.reset(
-        new SwapQueue<std::vector<float>, RenderQueueItemVerifier<float>>(
+        new SpscSwapQueue<std::vector<float>,
+                          RenderQueueItemVerifier<float>>(
             kMaxNumFramesToBuffer, template_queue_element,
             RenderQueueItemVerifier<float>(render_queue_element_max_size_)));
 
@@ -486,6 +526,13 @@ int EchoCancellationImpl::ConfigureHandle(void* handle) const {
   WebRtcAec_enable_delay_agnostic(
       WebRtcAec_aec_core(static_cast<Handle*>(handle)),
       delay_agnostic_enabled_ ? 1 : 0);
+  // The records of each core are told apart by its handle index.
+  size_t index = 0;
+  while (index < num_handles() && this->handle(index) != handle) {
+    index++;
+  }
+  WebRtcAec_SetTrace(WebRtcAec_aec_core(static_cast<Handle*>(handle)), trace_,
+                     static_cast<int>(index));
   return WebRtcAec_set_config(static_cast<Handle*>(handle), config);
 }
 
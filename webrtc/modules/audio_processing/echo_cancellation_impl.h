@@ -17,6 +17,8 @@
 #include "webrtc/modules/audio_processing/include/audio_processing.h"
 #include "webrtc/modules/audio_processing/processing_component.h"
 
+struct AecTrace;
+
 namespace webrtc {
 
 class AudioBuffer;
@@ -64,6 +66,8 @@ class EchoCancellationImpl : public EchoCancellation,
   int GetDelayMetrics(int* median,
                       int* std,
                       float* fraction_poor_delays) override;
+  int StartTrace(FILE* handle) override;
+  int StopTrace() override;
 
   struct AecCore* aec_core() const override;
 
@@ -92,14 +96,17 @@ class EchoCancellationImpl : public EchoCancellation,
   bool delay_logging_enabled_ GUARDED_BY(crit_capture_);
   bool extended_filter_enabled_ GUARDED_BY(crit_capture_);
   bool delay_agnostic_enabled_ GUARDED_BY(crit_capture_);
+  AecTrace* trace_ GUARDED_BY(crit_capture_);
 
   size_t render_queue_element_max_size_ GUARDED_BY(crit_render_)
       GUARDED_BY(crit_capture_);
   std::vector<float> render_queue_buffer_ GUARDED_BY(crit_render_);
   std::vector<float> capture_queue_buffer_ GUARDED_BY(crit_capture_);
 
-  // Lock protection not needed.
-  rtc::scoped_ptr<SwapQueue<std::vector<float>, RenderQueueItemVerifier<float>>>
+  // Lock protection not needed: it is only written to under crit_render_ and
+  // only read from under crit_capture_.
+  rtc::scoped_ptr<
+      SpscSwapQueue<std::vector<float>, RenderQueueItemVerifier<float>>>
       render_signal_queue_;
 };
 
@@ -80,9 +80,10 @@ class EchoControlMobileImpl : public EchoControlMobile,
   std::vector<int16_t> render_queue_buffer_ GUARDED_BY(crit_render_);
   std::vector<int16_t> capture_queue_buffer_ GUARDED_BY(crit_capture_);
 
-  // Lock protection not needed.
+  // Lock protection not needed: it is only written to under crit_render_ and
+  // only read from under crit_capture_.
   rtc::scoped_ptr<
-      SwapQueue<std::vector<int16_t>, RenderQueueItemVerifier<int16_t>>>
+      SpscSwapQueue<std::vector<int16_t>, RenderQueueItemVerifier<int16_t>>>
       render_signal_queue_;
 };
 }  // namespace webrtc
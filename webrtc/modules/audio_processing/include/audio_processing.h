@@ -150,6 +150,52 @@ struct Intelligibility {
   bool enabled;
 };
 
+// Use to time the steps of AudioProcessing::ProcessStream(), see
+// AudioProcessing::GetSubmoduleTimings(). The statistics start over every time
+// it is enabled. When a debug recording is running, the duration of every step
+// is also stored with each frame. It can be set in the constructor or using
+// AudioProcessing::SetExtraOptions().
+struct SubmoduleProfiling {
+  SubmoduleProfiling() : enabled(false) {}
+  explicit SubmoduleProfiling(bool enabled) : enabled(enabled) {}
+  static const ConfigOptionID identifier = ConfigOptionID::kSubmoduleProfiling;
+  bool enabled;
+};
+
+// Use to let ProcessStream() skip most of the processing while both the
+// near-end and the far-end have stayed below |level_dbfs| for half a second,
+// e.g. for a muted microphone during a silent hold. The far-end is only
+// checked when an echo canceller is enabled. Skipped frames are output
+// as they came in. The echo cancellers, noise suppression and gain control
+// keep the state they had, the level estimator still runs and the voice
+// detection reports no voice. Processing resumes with the first frame above
+// the level on either side. Skipped frames are not included in the submodule
+// timings. It can be set in the constructor or using
+// AudioProcessing::SetExtraOptions().
+struct SilentFrameSkipping {
+  static const int kDefaultLevelDbfs = -70;
+  SilentFrameSkipping() : enabled(false), level_dbfs(kDefaultLevelDbfs) {}
+  explicit SilentFrameSkipping(bool enabled)
+      : enabled(enabled), level_dbfs(kDefaultLevelDbfs) {}
+  SilentFrameSkipping(bool enabled, int level_dbfs)
+      : enabled(enabled), level_dbfs(level_dbfs) {}
+  static const ConfigOptionID identifier =
+      ConfigOptionID::kSilentFrameSkipping;
+  bool enabled;
+  int level_dbfs;
+};
+
+// Use to write debug recordings gzip compressed, see
+// AudioProcessing::StartDebugRecording(). Takes effect with the next recording.
+// It can be set in the constructor or using AudioProcessing::SetExtraOptions().
+struct DebugDumpCompression {
+  DebugDumpCompression() : enabled(false) {}
+  explicit DebugDumpCompression(bool enabled) : enabled(enabled) {}
+  static const ConfigOptionID identifier =
+      ConfigOptionID::kDebugDumpCompression;
+  bool enabled;
+};
+
 // The Audio Processing Module (APM) provides a collection of voice processing
 // components designed for real-time communications software.
 //
@@ -415,7 +461,10 @@ class AudioProcessing {
   // Starts recording debugging information to a file specified by |filename|,
   // a NULL-terminated string. If there is an ongoing recording, the old file
   // will be closed, and recording will continue in the newly specified file.
-  // An already existing file will be overwritten without warning.
+  // An already existing file will be overwritten without warning. The file is
+  // written on a thread of its own: messages it cannot keep up with are
+  // dropped, see num_dropped_debug_dump_messages(), and a failed write is
+  // reported by StopDebugRecording().
   static const size_t kMaxFilenameSize = 1024;
   virtual int StartDebugRecording(const char filename[kMaxFilenameSize]) = 0;
 
@@ -438,6 +487,33 @@ class AudioProcessing {
   // specific member variables are reset.
   virtual void UpdateHistogramsOnCallEnd() = 0;
 
+  // Processing time of one step of ProcessStream(), in nanoseconds. |p99_ns|
+  // comes from a histogram and is accurate to about 12%.
+  struct SubmoduleTiming {
+    const char* name;
+    int num_calls;
+    int64_t min_ns;
+    int64_t mean_ns;
+    int64_t p99_ns;
+    int64_t max_ns;
+  };
+
+  // Fills |timings| with the steps of ProcessStream() that have run since
+  // SubmoduleProfiling was enabled, in processing order, followed by the
+  // "total" of the whole capture processing. Submodules that are turned off
+  // are still listed, with the cost of skipping them. Returns
+  // |kNotEnabledError| if SubmoduleProfiling is not enabled.
+  virtual int GetSubmoduleTimings(
+      std::vector<SubmoduleTiming>* timings) const = 0;
+
+  // Number of frames that ProcessStream() has skipped as silent, see
+  // SilentFrameSkipping.
+  virtual size_t num_skipped_silent_frames() const = 0;
+
+  // Number of messages the ongoing or last debug recording has dropped because
+  // the disk did not keep up, see StartDebugRecording().
+  virtual size_t num_dropped_debug_dump_messages() const = 0;
+
   // These provide access to the component interfaces and should never return
   // NULL. The pointers will be valid for the lifetime of the APM instance.
   // The memory for these objects is entirely managed internally.
@@ -689,6 +765,17 @@ class EchoCancellation {
   virtual int GetDelayMetrics(int* median, int* std,
                               float* fraction_poor_delays) = 0;
 
+  // Starts a binary trace of the internal state of the AEC to |handle|, one
+  // record per block and AEC instance, see logging/aec_trace.h for the format.
+  // Takes ownership of |handle| and closes it at StopTrace(); an ongoing trace
+  // is stopped first. The file is written on a thread of its own and records
+  // it cannot keep up with are dropped, so it is cheap enough to leave on.
+  virtual int StartTrace(FILE* handle) = 0;
+
+  // Stops the trace, if any, and writes out what it holds. Returns kFileError
+  // if a write to the file failed.
+  virtual int StopTrace() = 0;
+
   // Returns a pointer to the low level AEC component.  In case of multiple
   // channels, the pointer to the first one is returned.  A NULL pointer is
   // returned when the AEC component is disabled or has not been initialized
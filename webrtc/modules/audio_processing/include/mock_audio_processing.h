@@ -50,6 +50,10 @@ class MockEchoCancellation : public EchoCancellation {
       int(int* median, int* std));
   MOCK_METHOD3(GetDelayMetrics,
       int(int* median, int* std, float* fraction_poor_delays));
+  MOCK_METHOD1(StartTrace,
+      int(FILE* handle));
+  MOCK_METHOD0(StopTrace,
+      int());
   MOCK_CONST_METHOD0(aec_core,
       struct AecCore*());
 };
@@ -257,6 +261,10 @@ class MockAudioProcessing : public AudioProcessing {
   MOCK_METHOD0(StopDebugRecording,
       int());
   MOCK_METHOD0(UpdateHistogramsOnCallEnd, void());
+  MOCK_CONST_METHOD1(GetSubmoduleTimings,
+      int(std::vector<SubmoduleTiming>* timings));
+  MOCK_CONST_METHOD0(num_skipped_silent_frames, size_t());
+  MOCK_CONST_METHOD0(num_dropped_debug_dump_messages, size_t());
   virtual MockEchoCancellation* echo_cancellation() const {
     return echo_cancellation_.get();
   }
@@ -0,0 +1,227 @@
+/*
+ *  Copyright (c) 2016 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/modules/audio_processing/logging/aec_trace.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "webrtc/base/atomicops.h"
+#include "webrtc/base/checks.h"
+#include "webrtc/base/event.h"
+#include "webrtc/base/platform_thread.h"
+#include "webrtc/modules/audio_processing/aec/aec_core.h"
+
+namespace {
+
+// The writer thread is not woken up by the cores, as that would take a lock on
+// the audio thread; it looks at the ring buffer this often instead.
+const int kPollIntervalMs = 100;
+
+const char kMagic[8] = {'A', 'E', 'C', 'T', 'R', 'A', 'C', 'E'};
+
+struct Column {
+  const char* name;
+  AecTraceColumnType type;
+  size_t offset;
+};
+
+#define COLUMN(field, type) {#field, type, offsetof(AecTraceRecord, field)}
+const Column kColumns[] = {
+    COLUMN(instance, kAecTraceInt32),
+    COLUMN(block, kAecTraceInt32),
+    COLUMN(sample_rate_hz, kAecTraceInt32),
+    COLUMN(system_delay, kAecTraceInt32),
+    COLUMN(known_delay, kAecTraceInt32),
+    COLUMN(filter_delay, kAecTraceInt32),
+    COLUMN(filter_energy, kAecTraceFloat32),
+    COLUMN(erle_db, kAecTraceFloat32),
+    COLUMN(nlp_gain, kAecTraceFloat32),
+    COLUMN(nlp_gain_min, kAecTraceFloat32),
+    COLUMN(overdrive, kAecTraceFloat32),
+    COLUMN(echo_state, kAecTraceInt32),
+    COLUMN(near_state, kAecTraceInt32),
+    COLUMN(diverge_state, kAecTraceInt32),
+};
+#undef COLUMN
+const size_t kNumColumns = sizeof(kColumns) / sizeof(kColumns[0]);
+
+static_assert(sizeof(AecTraceRecord) == kNumColumns * sizeof(uint32_t),
+              "every field of AecTraceRecord must be a column of 32 bits");
+
+}  // namespace
+
+struct AecTrace {
+  AecTrace(FILE* file, size_t capacity)
+      : file(file),
+        records(capacity),
+        columns(kNumColumns * kAecTraceChunkRows),
+        wake_up(false, false),
+        thread(&AecTrace::Run, this, "AecTrace") {}
+
+  static bool Run(void* obj) {
+    AecTrace* trace = static_cast<AecTrace*>(obj);
+    trace->wake_up.Wait(kPollIntervalMs);
+    trace->WriteChunks(false);
+    return true;
+  }
+
+  // The records from |index| on are at |index| modulo the capacity; the
+  // indices run modulo twice the capacity, so that a full ring buffer can be
+  // told from an empty one.
+  size_t NextIndex(size_t index) const {
+    return index + 1 == 2 * records.size() ? 0 : index + 1;
+  }
+  size_t NumRecords(size_t write_index, size_t read_index) const {
+    return write_index >= read_index
+               ? write_index - read_index
+               : write_index + 2 * records.size() - read_index;
+  }
+  const AecTraceRecord& Record(size_t index) const {
+    return records[index < records.size() ? index : index - records.size()];
+  }
+
+  bool Write(const void* data, size_t length) {
+    return fwrite(data, 1, length, file) == length;
+  }
+
+  bool WriteHeader();
+
+  // Writes out whole chunks, and with |all| the remaining records as well.
+  void WriteChunks(bool all);
+
+  FILE* file;
+  std::vector<AecTraceRecord> records;
+  // Only written by the core, the writer thread and the core respectively.
+  volatile int write_index = 0;
+  volatile int read_index = 0;
+  volatile int num_dropped = 0;
+
+  // The values of one chunk, column by column.
+  std::vector<uint32_t> columns;
+  bool write_failed = false;
+
+  rtc::Event wake_up;
+  rtc::PlatformThread thread;
+};
+
+bool AecTrace::WriteHeader() {
+  const uint32_t header[] = {kAecTraceVersion, PART_LEN, kNumColumns};
+  if (!Write(kMagic, sizeof(kMagic)) || !Write(header, sizeof(header))) {
+    return false;
+  }
+  for (const Column& column : kColumns) {
+    char name[kAecTraceNameLength] = {0};
+    strncpy(name, column.name, sizeof(name) - 1);
+    const uint32_t type = column.type;
+    if (!Write(name, sizeof(name)) || !Write(&type, sizeof(type))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void AecTrace::WriteChunks(bool all) {
+  const size_t write_index =
+      static_cast<size_t>(rtc::AtomicOps::AcquireLoad(&this->write_index));
+  size_t index = static_cast<size_t>(this->read_index);
+  size_t num_records = NumRecords(write_index, index);
+  while (num_records >= kAecTraceChunkRows || (all && num_records > 0)) {
+    const size_t num_rows =
+        std::min(num_records, static_cast<size_t>(kAecTraceChunkRows));
+    // Transposes the records into the columns.
+    for (size_t row = 0; row < num_rows; ++row) {
+      const char* record = reinterpret_cast<const char*>(&Record(index));
+      for (size_t c = 0; c < kNumColumns; ++c) {
+        memcpy(&columns[c * num_rows + row], record + kColumns[c].offset,
+               sizeof(uint32_t));
+      }
+      index = NextIndex(index);
+    }
+    // The records are copied, so their slots can be reused.
+    rtc::AtomicOps::ReleaseStore(&this->read_index, static_cast<int>(index));
+    num_records -= num_rows;
+
+    const uint32_t chunk_header[] = {
+        static_cast<uint32_t>(num_rows),
+        static_cast<uint32_t>(rtc::AtomicOps::AcquireLoad(&num_dropped))};
+    if (!Write(chunk_header, sizeof(chunk_header)) ||
+        !Write(columns.data(), kNumColumns * num_rows * sizeof(uint32_t))) {
+      write_failed = true;
+    }
+  }
+}
+
+AecTrace* WebRtcAecTrace_Create(FILE* file, size_t capacity) {
+  if (!file) {
+    return NULL;
+  }
+  if (capacity == 0) {
+    fclose(file);
+    return NULL;
+  }
+  AecTrace* trace = new AecTrace(file, capacity);
+  if (!trace->WriteHeader()) {
+    fclose(file);
+    delete trace;
+    return NULL;
+  }
+  trace->thread.Start();
+  return trace;
+}
+
+int WebRtcAecTrace_Free(AecTrace* trace) {
+  if (!trace) {
+    return 0;
+  }
+  trace->wake_up.Set();
+  trace->thread.Stop();
+  trace->WriteChunks(true);
+  const bool closed = fclose(trace->file) == 0;
+  const bool write_failed = trace->write_failed || !closed;
+  delete trace;
+  return write_failed ? -1 : 0;
+}
+
+void WebRtcAecTrace_Add(AecTrace* trace, const AecTraceRecord* record) {
+  const size_t write_index = static_cast<size_t>(trace->write_index);
+  const size_t read_index =
+      static_cast<size_t>(rtc::AtomicOps::AcquireLoad(&trace->read_index));
+  if (trace->NumRecords(write_index, read_index) == trace->records.size()) {
+    rtc::AtomicOps::Increment(&trace->num_dropped);
+    return;
+  }
+  trace->records[write_index < trace->records.size()
+                     ? write_index
+                     : write_index - trace->records.size()] = *record;
+  // Publishes the record.
+  rtc::AtomicOps::ReleaseStore(
+      &trace->write_index, static_cast<int>(trace->NextIndex(write_index)));
+}
+
+size_t WebRtcAecTrace_dropped(const AecTrace* trace) {
+  return static_cast<size_t>(rtc::AtomicOps::AcquireLoad(&trace->num_dropped));
+}
+
+size_t WebRtcAecTrace_num_columns(void) {
+  return kNumColumns;
+}
+
+const char* WebRtcAecTrace_column_name(size_t column) {
+  RTC_DCHECK_LT(column, kNumColumns);
+  return kColumns[column].name;
+}
+
+AecTraceColumnType WebRtcAecTrace_column_type(size_t column) {
+  RTC_DCHECK_LT(column, kNumColumns);
+  return kColumns[column].type;
+}
@@ -0,0 +1,90 @@
+/*
+ *  Copyright (c) 2016 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+// A binary trace of the internal state of the AEC cores, one record per block,
+// that can be switched on and off at runtime. Unlike the RTC_AEC_DEBUG_*
+// dumps it is built in always and writes a single file: the cores add their
+// records to a lock-free ring buffer and a thread of the trace writes them out.
+//
+// The file is self-describing and columnar, all little-endian:
+//   "AECTRACE", uint32 version, uint32 block length in samples,
+//   uint32 number of columns, and per column a zero padded name of
+//   kAecTraceNameLength chars and a uint32 AecTraceColumnType.
+// Then chunks of up to kAecTraceChunkRows records until the end of the file:
+//   uint32 number of rows, uint32 records dropped so far in total,
+//   and per column the 32 bit values of all rows.
+
+#ifndef WEBRTC_MODULES_AUDIO_PROCESSING_LOGGING_AEC_TRACE_H_
+#define WEBRTC_MODULES_AUDIO_PROCESSING_LOGGING_AEC_TRACE_H_
+
+#include <stddef.h>
+#include <stdio.h>
+
+#include "webrtc/typedefs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum {
+  kAecTraceVersion = 1,
+  kAecTraceNameLength = 24,
+  kAecTraceChunkRows = 256,
+  // About four seconds of blocks of one core at 16 kHz.
+  kAecTraceDefaultCapacity = 1024
+};
+
+typedef enum { kAecTraceInt32, kAecTraceFloat32 } AecTraceColumnType;
+
+// The state of an AEC core after one block. Every field is a column.
+typedef struct {
+  int32_t instance;
+  int32_t block;           // Blocks since the core was initialized.
+  int32_t sample_rate_hz;  // Of the core, whose blocks are in the lowest band.
+  int32_t system_delay;    // Far-end samples buffered in the AEC.
+  int32_t known_delay;     // Far-end samples that the filter is offset by.
+  int32_t filter_delay;    // Filter partition with the most energy.
+  float filter_energy;     // Of all partitions, updated with filter_delay.
+  float erle_db;           // Near-end over echo subtractor output.
+  float nlp_gain;          // Suppression gain of the NLP, before overdrive.
+  float nlp_gain_min;      // Its tracked minimum.
+  float overdrive;         // Smoothed overdrive of the suppression.
+  int32_t echo_state;
+  int32_t near_state;
+  int32_t diverge_state;
+} AecTraceRecord;
+
+typedef struct AecTrace AecTrace;
+
+// Starts a trace to |file|, which it takes ownership of, buffering up to
+// |capacity| records. Returns NULL on failure.
+AecTrace* WebRtcAecTrace_Create(FILE* file, size_t capacity);
+
+// Writes out the records added so far, stops the writer thread and closes the
+// file. Returns 0, or -1 if any write to the file failed.
+int WebRtcAecTrace_Free(AecTrace* trace);
+
+// Adds |record| to the trace, or drops it if the ring buffer is full. Neither
+// blocks nor allocates. Calls must not overlap.
+void WebRtcAecTrace_Add(AecTrace* trace, const AecTraceRecord* record);
+
+// Records dropped so far.
+size_t WebRtcAecTrace_dropped(const AecTrace* trace);
+
+// The columns of the file, in AecTraceRecord order.
+size_t WebRtcAecTrace_num_columns(void);
+const char* WebRtcAecTrace_column_name(size_t column);
+AecTraceColumnType WebRtcAecTrace_column_type(size_t column);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // WEBRTC_MODULES_AUDIO_PROCESSING_LOGGING_AEC_TRACE_H_
@@ -0,0 +1,243 @@
+/*
+ *  Copyright (c) 2016 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/modules/audio_processing/logging/aec_trace.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "testing/gtest/include/gtest/gtest.h"
+extern "C" {
+#include "webrtc/modules/audio_processing/aec/aec_core.h"
+}
+#include "webrtc/modules/audio_processing/aec/echo_cancellation.h"
+#include "webrtc/test/testsupport/fileutils.h"
+
+namespace webrtc {
+namespace {
+
+// The contents of a trace file, the rows of all chunks joined.
+struct TraceFile {
+  uint32_t version = 0;
+  uint32_t block_length = 0;
+  std::vector<std::string> names;
+  std::vector<uint32_t> types;
+  // Column by column.
+  std::vector<std::vector<uint32_t>> columns;
+  std::vector<uint32_t> chunk_rows;
+  std::vector<uint32_t> chunk_dropped;
+
+  int32_t Int(size_t column, size_t row) const {
+    return static_cast<int32_t>(columns[column][row]);
+  }
+  float Float(size_t column, size_t row) const {
+    float value;
+    memcpy(&value, &columns[column][row], sizeof(value));
+    return value;
+  }
+};
+
+bool ReadTraceFile(const std::string& file_name, TraceFile* trace) {
+  FILE* file = fopen(file_name.c_str(), "rb");
+  if (!file) {
+    return false;
+  }
+  char magic[8];
+  uint32_t header[3];
+  if (fread(magic, sizeof(magic), 1, file) != 1 ||
+      memcmp(magic, "AECTRACE", sizeof(magic)) != 0 ||
+      fread(header, sizeof(header), 1, file) != 1) {
+    fclose(file);
+    return false;
+  }
+  trace->version = header[0];
+  trace->block_length = header[1];
+  for (uint32_t i = 0; i < header[2]; ++i) {
+    char name[kAecTraceNameLength];
+    uint32_t type;
+    if (fread(name, sizeof(name), 1, file) != 1 ||
+        fread(&type, sizeof(type), 1, file) != 1) {
+      fclose(file);
+      return false;
+    }
+    trace->names.push_back(std::string(name, strnlen(name, sizeof(name))));
+    trace->types.push_back(type);
+  }
+  trace->columns.resize(header[2]);
+
+  uint32_t chunk_header[2];
+  while (fread(chunk_header, sizeof(chunk_header), 1, file) == 1) {
+    trace->chunk_rows.push_back(chunk_header[0]);
+    trace->chunk_dropped.push_back(chunk_header[1]);
+    std::vector<uint32_t> values(chunk_header[0]);
+    for (std::vector<uint32_t>& column : trace->columns) {
+      if (fread(values.data(), sizeof(uint32_t), values.size(), file) !=
+          values.size()) {
+        fclose(file);
+        return false;
+      }
+      column.insert(column.end(), values.begin(), values.end());
+    }
+  }
+  fclose(file);
+  return true;
+}
+
+size_t FindColumn(const TraceFile& trace, const char* name) {
+  for (size_t i = 0; i < trace.names.size(); ++i) {
+    if (trace.names[i] == name) {
+      return i;
+    }
+  }
+  ADD_FAILURE() << "No column " << name;
+  return 0;
+}
+
+AecTraceRecord MakeRecord(int block) {
+  AecTraceRecord record;
+  memset(&record, 0, sizeof(record));
+  record.instance = 2;
+  record.block = block;
+  record.erle_db = 0.5f * block;
+  return record;
+}
+
+}  // namespace
+
+TEST(AecTraceTest, WritesSelfDescribingColumns) {
+  const std::string file_name = test::TempFilename(test::OutputPath(), "aec");
+  AecTrace* trace = WebRtcAecTrace_Create(fopen(file_name.c_str(), "wb"),
+                                          kAecTraceDefaultCapacity);
+  ASSERT_TRUE(trace != NULL);
+  // Not a whole number of chunks.
+  const int kNumRecords = 2 * kAecTraceChunkRows + 10;
+  for (int i = 0; i < kNumRecords; ++i) {
+    const AecTraceRecord record = MakeRecord(i);
+    WebRtcAecTrace_Add(trace, &record);
+  }
+  EXPECT_EQ(0u, WebRtcAecTrace_dropped(trace));
+  EXPECT_EQ(0, WebRtcAecTrace_Free(trace));
+
+  TraceFile file;
+  ASSERT_TRUE(ReadTraceFile(file_name, &file));
+  EXPECT_EQ(static_cast<uint32_t>(kAecTraceVersion), file.version);
+  EXPECT_EQ(static_cast<uint32_t>(PART_LEN), file.block_length);
+  ASSERT_EQ(WebRtcAecTrace_num_columns(), file.names.size());
+  for (size_t i = 0; i < file.names.size(); ++i) {
+    EXPECT_EQ(WebRtcAecTrace_column_name(i), file.names[i]);
+    EXPECT_EQ(static_cast<uint32_t>(WebRtcAecTrace_column_type(i)),
+              file.types[i]);
+  }
+  for (uint32_t rows : file.chunk_rows) {
+    EXPECT_LE(rows, static_cast<uint32_t>(kAecTraceChunkRows));
+  }
+
+  const size_t instance = FindColumn(file, "instance");
+  const size_t block = FindColumn(file, "block");
+  const size_t erle = FindColumn(file, "erle_db");
+  EXPECT_EQ(kAecTraceFloat32, static_cast<int>(file.types[erle]));
+  ASSERT_EQ(static_cast<size_t>(kNumRecords), file.columns[block].size());
+  for (int i = 0; i < kNumRecords; ++i) {
+    EXPECT_EQ(2, file.Int(instance, i));
+    EXPECT_EQ(i, file.Int(block, i));
+    EXPECT_EQ(0.5f * i, file.Float(erle, i));
+  }
+  remove(file_name.c_str());
+}
+
+TEST(AecTraceTest, DropsRecordsWhenTheRingBufferIsFull) {
+  const std::string file_name = test::TempFilename(test::OutputPath(), "aec");
+  // Far more records than the writer thread can take out in between.
+  AecTrace* trace = WebRtcAecTrace_Create(fopen(file_name.c_str(), "wb"), 4);
+  ASSERT_TRUE(trace != NULL);
+  const int kNumRecords = 1000;
+  for (int i = 0; i < kNumRecords; ++i) {
+    const AecTraceRecord record = MakeRecord(i);
+    WebRtcAecTrace_Add(trace, &record);
+  }
+  const size_t dropped = WebRtcAecTrace_dropped(trace);
+  EXPECT_LT(0u, dropped);
+  EXPECT_EQ(0, WebRtcAecTrace_Free(trace));
+
+  // The records that made it are in order, and the chunks account for the
+  // others.
+  TraceFile file;
+  ASSERT_TRUE(ReadTraceFile(file_name, &file));
+  const size_t block = FindColumn(file, "block");
+  EXPECT_EQ(static_cast<size_t>(kNumRecords),
+            file.columns[block].size() + dropped);
+  for (size_t i = 1; i < file.columns[block].size(); ++i) {
+    EXPECT_LT(file.Int(block, i - 1), file.Int(block, i));
+  }
+  ASSERT_FALSE(file.chunk_dropped.empty());
+  EXPECT_EQ(dropped, file.chunk_dropped.back());
+  remove(file_name.c_str());
+}
+
+TEST(AecTraceTest, RejectsMissingFile) {
+  EXPECT_TRUE(WebRtcAecTrace_Create(NULL, kAecTraceDefaultCapacity) == NULL);
+  EXPECT_EQ(0, WebRtcAecTrace_Free(NULL));
+}
+
+TEST(AecTraceTest, TracesEveryBlockOfAnAttachedCore) {
+  const std::string file_name = test::TempFilename(test::OutputPath(), "aec");
+  AecTrace* trace = WebRtcAecTrace_Create(fopen(file_name.c_str(), "wb"),
+                                          kAecTraceDefaultCapacity);
+  ASSERT_TRUE(trace != NULL);
+
+  const int kSampleRateHz = 16000;
+  const size_t kNumSamples = 160;
+  const int kNumFrames = 100;
+  void* handle = WebRtcAec_Create();
+  ASSERT_TRUE(handle != NULL);
+  ASSERT_EQ(0, WebRtcAec_Init(handle, kSampleRateHz, 48000));
+  WebRtcAec_SetTrace(WebRtcAec_aec_core(handle), trace, 3);
+
+  float farend[kNumSamples];
+  float nearend[kNumSamples];
+  float out[kNumSamples];
+  const float* near_ptr = nearend;
+  float* out_ptr = out;
+  for (int i = 0; i < kNumFrames; ++i) {
+    for (size_t j = 0; j < kNumSamples; ++j) {
+      farend[j] = 1000.f * ((i * kNumSamples + j) % 17) - 8000.f;
+      nearend[j] = 0.5f * farend[j];
+    }
+    ASSERT_EQ(0, WebRtcAec_BufferFarend(handle, farend, kNumSamples));
+    ASSERT_EQ(0, WebRtcAec_Process(handle, &near_ptr, 1, &out_ptr,
+                                   kNumSamples, 10, 0));
+  }
+  WebRtcAec_SetTrace(WebRtcAec_aec_core(handle), NULL, 0);
+  WebRtcAec_Free(handle);
+  EXPECT_EQ(0, WebRtcAecTrace_Free(trace));
+
+  TraceFile file;
+  ASSERT_TRUE(ReadTraceFile(file_name, &file));
+  const size_t instance = FindColumn(file, "instance");
+  const size_t block = FindColumn(file, "block");
+  const size_t sample_rate_hz = FindColumn(file, "sample_rate_hz");
+  const size_t filter_energy = FindColumn(file, "filter_energy");
+  const size_t num_rows = file.columns[block].size();
+  // All blocks but the ones of the startup phase and the ones still buffered.
+  EXPECT_LE(num_rows, kNumFrames * kNumSamples / PART_LEN);
+  EXPECT_GE(num_rows, kNumFrames * kNumSamples / PART_LEN / 2);
+  for (size_t i = 0; i < num_rows; ++i) {
+    EXPECT_EQ(3, file.Int(instance, i));
+    EXPECT_EQ(static_cast<int32_t>(i), file.Int(block, i));
+    EXPECT_EQ(kSampleRateHz, file.Int(sample_rate_hz, i));
+    EXPECT_LE(0.f, file.Float(filter_energy, i));
+  }
+  remove(file_name.c_str());
+}
+
+}  // namespace webrtc
@@ -25,6 +25,11 @@ LOCAL_SRC_FILES := \
     nsx_core.c \
     nsx_core_c.c \
 
+ifeq ($(TARGET_ARCH),$(filter $(TARGET_ARCH),x86 x86_64))
+LOCAL_SRC_FILES += \
+    ns_core_sse2.c
+endif
+
 # TODO: nsx_core.S, nsx_core_mips.c
 
 # Files for floating point.
@@ -70,7 +75,9 @@ LOCAL_MODULE_TAGS := optional
 
 ifeq ($(TARGET_ARCH), arm64)
 # new nsx_core_neon.S does not compile with clang or gas.
-LOCAL_SRC_FILES := nsx_core_neon.c
+LOCAL_SRC_FILES := \
+    nsx_core_neon.c \
+    ns_core_neon.c
 
 else
 GEN := $(LOCAL_PATH)/nsx_core_neon_offsets.h
@@ -86,7 +93,9 @@ $(intermediates)/nsx_core_neon_offsets.S: $(LOCAL_PATH)/nsx_core_neon_offsets.c
             $(TARGET_C_INCLUDES)) -S -o $@ $^
 
 LOCAL_GENERATED_SOURCES := $(GEN)
-LOCAL_SRC_FILES := nsx_core_neon.S
+LOCAL_SRC_FILES := \
+    nsx_core_neon.S \
+    ns_core_neon.c
 endif
 
 # Flags passed to both C and C++ files.
@@ -112,3 +121,40 @@ endif
 
 include $(BUILD_STATIC_LIBRARY)
 endif # ifeq ($(WEBRTC_BUILD_NEON_LIBS),true)
+
+#########################
+# Build the SSE4.1 kernels of the fixed point core, picked at runtime.
+ifneq (,$(filter x86 x86_64,$(TARGET_ARCH)))
+
+include $(CLEAR_VARS)
+
+include $(LOCAL_PATH)/../../../../android-webrtc.mk
+
+LOCAL_MODULE_CLASS := STATIC_LIBRARIES
+LOCAL_MODULE := libwebrtc_ns_sse41
+LOCAL_MODULE_TAGS := optional
+LOCAL_SRC_FILES := nsx_core_sse41.c
+
+# Flags passed to both C and C++ files.
+LOCAL_CFLAGS := \
+    $(MY_WEBRTC_COMMON_DEFS) \
+    -msse4.1
+
+LOCAL_CFLAGS_x86 := $(MY_WEBRTC_COMMON_DEFS_x86)
+LOCAL_CFLAGS_x86_64 := $(MY_WEBRTC_COMMON_DEFS_x86_64)
+
+LOCAL_C_INCLUDES := \
+    $(LOCAL_PATH)/include \
+    $(LOCAL_PATH)/../utility \
+    $(LOCAL_PATH)/../../../.. \
+    $(LOCAL_PATH)/../../../common_audio/signal_processing/include
+
+ifdef WEBRTC_STL
+LOCAL_NDK_STL_VARIANT := $(WEBRTC_STL)
+LOCAL_SDK_VERSION := 14
+LOCAL_MODULE := $(LOCAL_MODULE)_$(WEBRTC_STL)
+endif
+
+include $(BUILD_STATIC_LIBRARY)
+
+endif # x86 or x86_64
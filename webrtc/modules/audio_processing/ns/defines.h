@@ -24,10 +24,6 @@
 #define FACTOR              (float)40.0
 #define WIDTH               (float)0.01
 
-// Length of fft work arrays.
-#define IP_LENGTH (ANAL_BLOCKL_MAX >> 1) // must be at least ceil(2 + sqrt(ANAL_BLOCKL_MAX/2))
-#define W_LENGTH (ANAL_BLOCKL_MAX >> 1)
-
 //PARAMETERS FOR NEW METHOD
 #define DD_PR_SNR           (float)0.98 // DD update of prior SNR
 #define LRT_TAVG            (float)0.50 // tavg parameter for LRT (previously 0.90)
@@ -13,6 +13,7 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "webrtc/common_audio/rdft.h"
 #include "webrtc/common_audio/signal_processing/include/signal_processing_library.h"
 #include "webrtc/modules/audio_processing/ns/defines.h"
 #include "webrtc/modules/audio_processing/ns/ns_core.h"
@@ -20,10 +21,14 @@
 NsHandle* WebRtcNs_Create() {
   NoiseSuppressionC* self = malloc(sizeof(NoiseSuppressionC));
   self->initFlag = 0;
+  self->rdft = NULL;
   return (NsHandle*)self;
 }
 
 void WebRtcNs_Free(NsHandle* NS_inst) {
+  if (NS_inst) {
+    WebRtcRdft_Free(((NoiseSuppressionC*)NS_inst)->rdft);
+  }
   free(NS_inst);
 }
 
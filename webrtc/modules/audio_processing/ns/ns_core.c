@@ -13,11 +13,99 @@
 #include <string.h>
 #include <stdlib.h>
 
-#include "webrtc/common_audio/fft4g.h"
+#include "webrtc/common_audio/rdft.h"
 #include "webrtc/common_audio/signal_processing/include/signal_processing_library.h"
 #include "webrtc/modules/audio_processing/ns/noise_suppression.h"
 #include "webrtc/modules/audio_processing/ns/ns_core.h"
 #include "webrtc/modules/audio_processing/ns/windows_private.h"
+#include "webrtc/system_wrappers/include/cpu_features_wrapper.h"
+
+WebRtcNsLogSpectrum WebRtcNs_LogSpectrum;
+WebRtcNsExpSpectrum WebRtcNs_ExpSpectrum;
+WebRtcNsUpdateQuantile WebRtcNs_UpdateQuantile;
+WebRtcNsUpdateLogLrt WebRtcNs_UpdateLogLrt;
+WebRtcNsSpeechProbability WebRtcNs_SpeechProbability;
+
+static void LogSpectrum(const float* in, size_t length, float* out) {
+  size_t i;
+
+  for (i = 0; i < length; i++) {
+    out[i] = (float)log(in[i]);
+  }
+}
+
+static void ExpSpectrum(const float* in, size_t length, float* out) {
+  size_t i;
+
+  for (i = 0; i < length; i++) {
+    out[i] = (float)exp(in[i]);
+  }
+}
+
+// newquantest(...)
+static void UpdateQuantile(const float* lmagn,
+                           size_t length,
+                           int counter,
+                           float* lquantile,
+                           float* density) {
+  size_t i;
+  float delta;
+
+  for (i = 0; i < length; i++) {
+    // Compute delta.
+    if (density[i] > 1.0) {
+      delta = FACTOR * 1.f / density[i];
+    } else {
+      delta = FACTOR;
+    }
+
+    // Update log quantile estimate.
+    if (lmagn[i] > lquantile[i]) {
+      lquantile[i] += QUANTILE * delta / (float)(counter + 1);
+    } else {
+      lquantile[i] -= (1.f - QUANTILE) * delta / (float)(counter + 1);
+    }
+
+    // Update density estimate.
+    if (fabs(lmagn[i] - lquantile[i]) < WIDTH) {
+      density[i] = ((float)counter * density[i] + 1.f / (2.f * WIDTH)) /
+                   (float)(counter + 1);
+    }
+  }  // End loop over magnitude spectrum.
+}
+
+static float UpdateLogLrt(const float* snrLocPrior,
+                          const float* snrLocPost,
+                          size_t length,
+                          float* logLrtTimeAvg) {
+  size_t i;
+  float tmpFloat1, tmpFloat2, besselTmp;
+  float logLrtTimeAvgKsum = 0.0;
+
+  for (i = 0; i < length; i++) {
+    tmpFloat1 = 1.f + 2.f * snrLocPrior[i];
+    tmpFloat2 = 2.f * snrLocPrior[i] / (tmpFloat1 + 0.0001f);
+    besselTmp = (snrLocPost[i] + 1.f) * tmpFloat2;
+    logLrtTimeAvg[i] +=
+        LRT_TAVG * (besselTmp - (float)log(tmpFloat1) - logLrtTimeAvg[i]);
+    logLrtTimeAvgKsum += logLrtTimeAvg[i];
+  }
+  return logLrtTimeAvgKsum;
+}
+
+static void SpeechProbability(const float* logLrtTimeAvg,
+                              float gainPrior,
+                              size_t length,
+                              float* probSpeechFinal) {
+  size_t i;
+  float invLrt;
+
+  for (i = 0; i < length; i++) {
+    invLrt = (float)exp(-logLrtTimeAvg[i]);
+    invLrt = (float)gainPrior * invLrt;
+    probSpeechFinal[i] = 1.f / (1.f + invLrt);
+  }
+}
 
 // Set Feature Extraction Parameters.
 static void set_feature_extraction_parameters(NoiseSuppressionC* self) {
@@ -97,10 +185,34 @@ int WebRtcNs_InitCore(NoiseSuppressionC* self, uint32_t fs) {
   }
   self->magnLen = self->anaLen / 2 + 1;  // Number of frequency bins.
 
-  // Initialize FFT work arrays.
-  self->ip[0] = 0;  // Setting this triggers initialization.
-  memset(self->dataBuf, 0, sizeof(float) * ANAL_BLOCKL_MAX);
-  WebRtc_rdft(self->anaLen, 1, self->dataBuf, self->ip, self->wfft);
+  WebRtcNs_LogSpectrum = LogSpectrum;
+  WebRtcNs_ExpSpectrum = ExpSpectrum;
+  WebRtcNs_UpdateQuantile = UpdateQuantile;
+  WebRtcNs_UpdateLogLrt = UpdateLogLrt;
+  WebRtcNs_SpeechProbability = SpeechProbability;
+
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+  if (WebRtc_GetCPUInfo(kSSE2)) {
+    WebRtcNs_InitCore_SSE2();
+  }
+#endif
+
+#if defined(WEBRTC_HAS_NEON)
+  WebRtcNs_InitCore_neon();
+#elif defined(WEBRTC_DETECT_NEON)
+  if ((WebRtc_GetCPUFeaturesARM() & kCPUFeatureNEON) != 0) {
+    WebRtcNs_InitCore_neon();
+  }
+#endif
+
+  // The transform is only created again when the sample rate changes it.
+  if (!self->rdft || WebRtcRdft_length(self->rdft) != self->anaLen) {
+    WebRtcRdft_Free(self->rdft);
+    self->rdft = WebRtcRdft_Create(self->anaLen);
+    if (!self->rdft) {
+      return -1;
+    }
+  }
 
   memset(self->analyzeBuf, 0, sizeof(float) * ANAL_BLOCKL_MAX);
   memset(self->dataBuf, 0, sizeof(float) * ANAL_BLOCKL_MAX);
@@ -214,57 +326,28 @@ int WebRtcNs_InitCore(NoiseSuppressionC* self, uint32_t fs) {
 }
 
 // Estimate noise.
+// |lmagn| is the log of the magnitude spectrum.
 static void NoiseEstimation(NoiseSuppressionC* self,
-                            float* magn,
+                            const float* lmagn,
                             float* noise) {
-  size_t i, s, offset;
-  float lmagn[HALF_ANAL_BLOCKL], delta;
+  size_t s, offset;
 
   if (self->updates < END_STARTUP_LONG) {
     self->updates++;
   }
 
-  for (i = 0; i < self->magnLen; i++) {
-    lmagn[i] = (float)log(magn[i]);
-  }
-
   // Loop over simultaneous estimates.
   for (s = 0; s < SIMULT; s++) {
     offset = s * self->magnLen;
 
-    // newquantest(...)
-    for (i = 0; i < self->magnLen; i++) {
-      // Compute delta.
-      if (self->density[offset + i] > 1.0) {
-        delta = FACTOR * 1.f / self->density[offset + i];
-      } else {
-        delta = FACTOR;
-      }
-
-      // Update log quantile estimate.
-      if (lmagn[i] > self->lquantile[offset + i]) {
-        self->lquantile[offset + i] +=
-            QUANTILE * delta / (float)(self->counter[s] + 1);
-      } else {
-        self->lquantile[offset + i] -=
-            (1.f - QUANTILE) * delta / (float)(self->counter[s] + 1);
-      }
-
-      // Update density estimate.
-      if (fabs(lmagn[i] - self->lquantile[offset + i]) < WIDTH) {
-        self->density[offset + i] =
-            ((float)self->counter[s] * self->density[offset + i] +
-             1.f / (2.f * WIDTH)) /
-            (float)(self->counter[s] + 1);
-      }
-    }  // End loop over magnitude spectrum.
+    WebRtcNs_UpdateQuantile(lmagn, self->magnLen, self->counter[s],
+                            &self->lquantile[offset], &self->density[offset]);
 
     if (self->counter[s] >= END_STARTUP_LONG) {
       self->counter[s] = 0;
       if (self->updates >= END_STARTUP_LONG) {
-        for (i = 0; i < self->magnLen; i++) {
-          self->quantile[i] = (float)exp(self->lquantile[offset + i]);
-        }
+        WebRtcNs_ExpSpectrum(&self->lquantile[offset], self->magnLen,
+                             self->quantile);
       }
     }
 
@@ -274,14 +357,11 @@ static void NoiseEstimation(NoiseSuppressionC* self,
   // Sequentially update the noise during startup.
   if (self->updates < END_STARTUP_LONG) {
     // Use the last "s" to get noise during startup that differ from zero.
-    for (i = 0; i < self->magnLen; i++) {
-      self->quantile[i] = (float)exp(self->lquantile[offset + i]);
-    }
+    WebRtcNs_ExpSpectrum(&self->lquantile[offset], self->magnLen,
+                         self->quantile);
   }
 
-  for (i = 0; i < self->magnLen; i++) {
-    noise[i] = self->quantile[i];
-  }
+  memcpy(noise, self->quantile, sizeof(*noise) * self->magnLen);
 }
 
 // Extract thresholds for feature parameters.
@@ -518,10 +598,11 @@ static void FeatureParameterExtraction(NoiseSuppressionC* self, int flag) {
 }
 
 // Compute spectral flatness on input spectrum.
-// |magnIn| is the magnitude spectrum.
+// |magnIn| is the magnitude spectrum and |lmagnIn| its log.
 // Spectral flatness is returned in self->featureData[0].
 static void ComputeSpectralFlatness(NoiseSuppressionC* self,
-                                    const float* magnIn) {
+                                    const float* magnIn,
+                                    const float* lmagnIn) {
   size_t i;
   size_t shiftLP = 1;  // Option to remove first bin(s) from spectral measures.
   float avgSpectralFlatnessNum, avgSpectralFlatnessDen, spectralTmp;
@@ -536,13 +617,14 @@ static void ComputeSpectralFlatness(NoiseSuppressionC* self,
   // Compute log of ratio of the geometric to arithmetic mean: check for log(0)
   // case.
   for (i = shiftLP; i < self->magnLen; i++) {
-    if (magnIn[i] > 0.0) {
-      avgSpectralFlatnessNum += (float)log(magnIn[i]);
-    } else {
+    if (!(magnIn[i] > 0.0)) {
       self->featureData[0] -= SPECT_FL_TAVG * self->featureData[0];
       return;
     }
   }
+  for (i = shiftLP; i < self->magnLen; i++) {
+    avgSpectralFlatnessNum += lmagnIn[i];
+  }
   // Normalize.
   avgSpectralFlatnessDen = avgSpectralFlatnessDen / self->magnLen;
   avgSpectralFlatnessNum = avgSpectralFlatnessNum / self->magnLen;
@@ -643,12 +725,11 @@ static void SpeechNoiseProb(NoiseSuppressionC* self,
                             float* probSpeechFinal,
                             const float* snrLocPrior,
                             const float* snrLocPost) {
-  size_t i;
   int sgnMap;
-  float invLrt, gainPrior, indPrior;
-  float logLrtTimeAvgKsum, besselTmp;
+  float gainPrior, indPrior;
+  float logLrtTimeAvgKsum;
   float indicator0, indicator1, indicator2;
-  float tmpFloat1, tmpFloat2;
+  float tmpFloat1;
   float weightIndPrior0, weightIndPrior1, weightIndPrior2;
   float threshPrior0, threshPrior1, threshPrior2;
   float widthPrior, widthPrior0, widthPrior1, widthPrior2;
@@ -673,15 +754,8 @@ static void SpeechNoiseProb(NoiseSuppressionC* self,
 
   // Compute feature based on average LR factor.
   // This is the average over all frequencies of the smooth log LRT.
-  logLrtTimeAvgKsum = 0.0;
-  for (i = 0; i < self->magnLen; i++) {
-    tmpFloat1 = 1.f + 2.f * snrLocPrior[i];
-    tmpFloat2 = 2.f * snrLocPrior[i] / (tmpFloat1 + 0.0001f);
-    besselTmp = (snrLocPost[i] + 1.f) * tmpFloat2;
-    self->logLrtTimeAvg[i] +=
-        LRT_TAVG * (besselTmp - (float)log(tmpFloat1) - self->logLrtTimeAvg[i]);
-    logLrtTimeAvgKsum += self->logLrtTimeAvg[i];
-  }
+  logLrtTimeAvgKsum = WebRtcNs_UpdateLogLrt(snrLocPrior, snrLocPost,
+                                            self->magnLen, self->logLrtTimeAvg);
   logLrtTimeAvgKsum = (float)logLrtTimeAvgKsum / (self->magnLen);
   self->featureData[3] = logLrtTimeAvgKsum;
   // Done with computation of LR factor.
@@ -742,22 +816,21 @@ static void SpeechNoiseProb(NoiseSuppressionC* self,
 
   // Final speech probability: combine prior model with LR factor:.
   gainPrior = (1.f - self->priorSpeechProb) / (self->priorSpeechProb + 0.0001f);
-  for (i = 0; i < self->magnLen; i++) {
-    invLrt = (float)exp(-self->logLrtTimeAvg[i]);
-    invLrt = (float)gainPrior * invLrt;
-    probSpeechFinal[i] = 1.f / (1.f + invLrt);
-  }
+  WebRtcNs_SpeechProbability(self->logLrtTimeAvg, gainPrior, self->magnLen,
+                             probSpeechFinal);
 }
 
 // Update the noise features.
 // Inputs:
 //   * |magn| is the signal magnitude spectrum estimate.
+//   * |lmagn| is the log of |magn|.
 //   * |updateParsFlag| is an update flag for parameters.
 static void FeatureUpdate(NoiseSuppressionC* self,
                           const float* magn,
+                          const float* lmagn,
                           int updateParsFlag) {
   // Compute spectral flatness on input spectrum.
-  ComputeSpectralFlatness(self, magn);
+  ComputeSpectralFlatness(self, magn, lmagn);
   // Compute difference of input spectrum with learned/estimated noise spectrum.
   ComputeSpectralDifference(self, magn);
   // Compute histograms for parameter decisions (thresholds and weights for
@@ -895,7 +968,7 @@ static void FFT(NoiseSuppressionC* self,
 
   assert(magnitude_length == time_data_length / 2 + 1);
 
-  WebRtc_rdft(time_data_length, 1, time_data, self->ip, self->wfft);
+  WebRtcRdft_Forward(self->rdft, time_data);
 
   imag[0] = 0;
   real[0] = time_data[0];
@@ -937,7 +1010,7 @@ static void IFFT(NoiseSuppressionC* self,
     time_data[2 * i] = real[i];
     time_data[2 * i + 1] = imag[i];
   }
-  WebRtc_rdft(time_data_length, -1, time_data, self->ip, self->wfft);
+  WebRtcRdft_Inverse(self->rdft, time_data);
 
   for (i = 0; i < time_data_length; ++i) {
     time_data[i] *= 2.f / time_data_length;  // FFT scaling.
@@ -1050,7 +1123,8 @@ void WebRtcNs_AnalyzeCore(NoiseSuppressionC* self, const float* speechFrame) {
   float sumMagn = 0.f;
   float tmpFloat1, tmpFloat2, tmpFloat3;
   float winData[ANAL_BLOCKL_MAX];
-  float magn[HALF_ANAL_BLOCKL], noise[HALF_ANAL_BLOCKL];
+  float magn[HALF_ANAL_BLOCKL], lmagn[HALF_ANAL_BLOCKL];
+  float noise[HALF_ANAL_BLOCKL];
   float snrLocPost[HALF_ANAL_BLOCKL], snrLocPrior[HALF_ANAL_BLOCKL];
   float real[ANAL_BLOCKL_MAX], imag[HALF_ANAL_BLOCKL];
   // Variables during startup.
@@ -1104,8 +1178,10 @@ void WebRtcNs_AnalyzeCore(NoiseSuppressionC* self, const float* speechFrame) {
   self->signalEnergy = signalEnergy;
   self->sumMagn = sumMagn;
 
+  // Log magnitude, shared by the quantile estimate and the flatness feature.
+  WebRtcNs_LogSpectrum(magn, self->magnLen, lmagn);
   // Quantile noise estimate.
-  NoiseEstimation(self, magn, noise);
+  NoiseEstimation(self, lmagn, noise);
   // Compute simplified noise model during startup.
   if (self->blockInd < END_STARTUP_SHORT) {
     // Estimate White noise.
@@ -1172,7 +1248,7 @@ void WebRtcNs_AnalyzeCore(NoiseSuppressionC* self, const float* speechFrame) {
   // Post and prior SNR needed for SpeechNoiseProb.
   ComputeSnr(self, magn, noise, snrLocPrior, snrLocPost);
 
-  FeatureUpdate(self, magn, updateParsFlag);
+  FeatureUpdate(self, magn, lmagn, updateParsFlag);
   SpeechNoiseProb(self, self->speechProb, snrLocPrior, snrLocPost);
   UpdateNoiseEstimate(self, magn, snrLocPrior, snrLocPost, noise);
 
@@ -12,6 +12,7 @@
 #define WEBRTC_MODULES_AUDIO_PROCESSING_NS_NS_CORE_H_
 
 #include "webrtc/modules/audio_processing/ns/defines.h"
+#include "webrtc/typedefs.h"
 
 typedef struct NSParaExtract_ {
   // Bin size of histogram.
@@ -73,9 +74,8 @@ typedef struct NoiseSuppressionC_ {
   float overdrive;
   float denoiseBound;
   int gainmap;
-  // FFT work arrays.
-  size_t ip[IP_LENGTH];
-  float wfft[W_LENGTH];
+  // Transform of anaLen points.
+  struct WebRtcRdft* rdft;
 
   // Parameters for new method: some not needed, will reduce/cleanup later.
   int32_t blockInd;  // Frame index counter.
@@ -184,6 +184,51 @@ void WebRtcNs_ProcessCore(NoiseSuppressionC* self,
                           size_t num_bands,
                           float* const* outFrame);
 
+/****************************************************************************
+ * Function pointers for the per-bin loops of the analysis, picked for the CPU
+ * by WebRtcNs_InitCore(). The generic C versions give the same results as
+ * the scalar loops always did; the SIMD versions use polynomial log/exp
+ * approximations (about 1e-7 relative error) and sum in a different order.
+ */
+// Natural logarithm of |length| positive values, |in| and |out| may alias.
+typedef void (*WebRtcNsLogSpectrum)(const float* in, size_t length, float* out);
+extern WebRtcNsLogSpectrum WebRtcNs_LogSpectrum;
+
+// Exponential of |length| values, |in| and |out| may alias.
+typedef void (*WebRtcNsExpSpectrum)(const float* in, size_t length, float* out);
+extern WebRtcNsExpSpectrum WebRtcNs_ExpSpectrum;
+
+// One step of a quantile noise estimate: moves |lquantile| towards the log
+// magnitude |lmagn| and updates its |density|. |counter| is the number of
+// frames the estimate has seen.
+typedef void (*WebRtcNsUpdateQuantile)(const float* lmagn,
+                                       size_t length,
+                                       int counter,
+                                       float* lquantile,
+                                       float* density);
+extern WebRtcNsUpdateQuantile WebRtcNs_UpdateQuantile;
+
+// Time-smooths the log likelihood ratio of each bin into |logLrtTimeAvg| and
+// returns its sum over the bins.
+typedef float (*WebRtcNsUpdateLogLrt)(const float* snrLocPrior,
+                                      const float* snrLocPost,
+                                      size_t length,
+                                      float* logLrtTimeAvg);
+extern WebRtcNsUpdateLogLrt WebRtcNs_UpdateLogLrt;
+
+// Combines the smoothed log LRT with the prior gain into the final speech
+// probability of each bin.
+typedef void (*WebRtcNsSpeechProbability)(const float* logLrtTimeAvg,
+                                          float gainPrior,
+                                          size_t length,
+                                          float* probSpeechFinal);
+extern WebRtcNsSpeechProbability WebRtcNs_SpeechProbability;
+
+void WebRtcNs_InitCore_SSE2(void);
+#if defined(WEBRTC_DETECT_NEON) || defined(WEBRTC_HAS_NEON)
+void WebRtcNs_InitCore_neon(void);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,243 @@
+/*
+ *  Copyright (c) 2016 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+/*
+ * The core noise suppression algorithm, NEON version of the per-bin loops.
+ * Same approximations as ns_core_sse2.c.
+ */
+
+#include <arm_neon.h>
+#include <math.h>
+
+#include "webrtc/modules/audio_processing/ns/defines.h"
+#include "webrtc/modules/audio_processing/ns/ns_core.h"
+
+// ARM64's arm_neon.h has already defined vdivq_f32.
+#if !defined(WEBRTC_ARCH_ARM64)
+static float32x4_t vdivq_f32(float32x4_t a, float32x4_t b) {
+  int i;
+  float32x4_t x = vrecpeq_f32(b);
+  // The Newton-Raphson iteration x[n+1] = x[n] * (2 - d * x[n]) converges to
+  // 1 / d from the VRECPE estimate; two steps reach float precision.
+  for (i = 0; i < 2; i++) {
+    x = vmulq_f32(vrecpsq_f32(b, x), x);
+  }
+  return vmulq_f32(a, x);
+}
+#endif
+
+// Natural logarithm of four positive, normal floats, see LogSSE2().
+static float32x4_t LogNEON(float32x4_t x) {
+  // Exponent bias of a mantissa in [0.5, 1) rather than [1, 2).
+  const int32x4_t exponent_bias = vdupq_n_s32(0x7E);
+  const uint32x4_t mantissa_mask = vdupq_n_u32(0x007FFFFF);
+  const uint32x4_t half_bits = vdupq_n_u32(0x3F000000);
+  const float32x4_t one = vdupq_n_f32(1.f);
+  const uint32x4_t bits = vreinterpretq_u32_f32(x);
+  // Mantissa in [0.5, 1) and the matching exponent.
+  const float32x4_t m =
+      vreinterpretq_f32_u32(vorrq_u32(vandq_u32(bits, mantissa_mask),
+                                      half_bits));
+  float32x4_t e = vcvtq_f32_s32(
+      vsubq_s32(vreinterpretq_s32_u32(vshrq_n_u32(bits, 23)), exponent_bias));
+  // Move m into [sqrt(1/2), sqrt(2)) and take f = m - 1.
+  const uint32x4_t below = vcltq_f32(m, vdupq_n_f32(0.707106781186547524f));
+  float32x4_t f, f2, y;
+  e = vsubq_f32(e, vbslq_f32(below, one, vdupq_n_f32(0.f)));
+  f = vsubq_f32(vaddq_f32(m, vbslq_f32(below, m, vdupq_n_f32(0.f))), one);
+  f2 = vmulq_f32(f, f);
+
+  y = vdupq_n_f32(7.0376836292e-2f);
+  y = vmlaq_f32(vdupq_n_f32(-1.1514610310e-1f), y, f);
+  y = vmlaq_f32(vdupq_n_f32(1.1676998740e-1f), y, f);
+  y = vmlaq_f32(vdupq_n_f32(-1.2420140846e-1f), y, f);
+  y = vmlaq_f32(vdupq_n_f32(1.4249322787e-1f), y, f);
+  y = vmlaq_f32(vdupq_n_f32(-1.6668057665e-1f), y, f);
+  y = vmlaq_f32(vdupq_n_f32(2.0000714765e-1f), y, f);
+  y = vmlaq_f32(vdupq_n_f32(-2.4999993993e-1f), y, f);
+  y = vmlaq_f32(vdupq_n_f32(3.3333331174e-1f), y, f);
+  y = vmulq_f32(vmulq_f32(y, f), f2);
+
+  y = vmlaq_f32(y, e, vdupq_n_f32(-2.12194440e-4f));
+  y = vmlsq_f32(y, f2, vdupq_n_f32(0.5f));
+  return vmlaq_f32(vaddq_f32(f, y), e, vdupq_n_f32(0.693359375f));
+}
+
+// Exponential of four floats, clamped to the range of normal floats, see
+// ExpSSE2().
+static float32x4_t ExpNEON(float32x4_t x) {
+  const float32x4_t one = vdupq_n_f32(1.f);
+  float32x4_t n, r, r2, y;
+  int32x4_t t;
+
+  x = vminq_f32(x, vdupq_n_f32(88.f));
+  x = vmaxq_f32(x, vdupq_n_f32(-87.3365478515625f));
+
+  // n = floor(x / log(2) + 1 / 2); the conversion truncates towards zero.
+  n = vmlaq_f32(vdupq_n_f32(0.5f), x, vdupq_n_f32(1.44269504088896341f));
+  r = vcvtq_f32_s32(vcvtq_s32_f32(n));
+  n = vsubq_f32(r, vbslq_f32(vcgtq_f32(r, n), one, vdupq_n_f32(0.f)));
+
+  r = vmlsq_f32(x, n, vdupq_n_f32(0.693359375f));
+  r = vmlsq_f32(r, n, vdupq_n_f32(-2.12194440e-4f));
+  r2 = vmulq_f32(r, r);
+
+  y = vdupq_n_f32(1.9875691500e-4f);
+  y = vmlaq_f32(vdupq_n_f32(1.3981999507e-3f), y, r);
+  y = vmlaq_f32(vdupq_n_f32(8.3334519073e-3f), y, r);
+  y = vmlaq_f32(vdupq_n_f32(4.1665795894e-2f), y, r);
+  y = vmlaq_f32(vdupq_n_f32(1.6666665459e-1f), y, r);
+  y = vmlaq_f32(vdupq_n_f32(5.0000001201e-1f), y, r);
+  y = vaddq_f32(vmlaq_f32(r, y, r2), one);
+
+  // Scale by 2^n, built directly in the exponent field.
+  t = vshlq_n_s32(vaddq_s32(vcvtq_s32_f32(n), vdupq_n_s32(0x7F)), 23);
+  return vmulq_f32(y, vreinterpretq_f32_s32(t));
+}
+
+static void LogSpectrumNEON(const float* in, size_t length, float* out) {
+  size_t i;
+
+  for (i = 0; i + 4 <= length; i += 4) {
+    vst1q_f32(&out[i], LogNEON(vld1q_f32(&in[i])));
+  }
+  for (; i < length; i++) {
+    out[i] = logf(in[i]);
+  }
+}
+
+static void ExpSpectrumNEON(const float* in, size_t length, float* out) {
+  size_t i;
+
+  for (i = 0; i + 4 <= length; i += 4) {
+    vst1q_f32(&out[i], ExpNEON(vld1q_f32(&in[i])));
+  }
+  for (; i < length; i++) {
+    out[i] = expf(in[i]);
+  }
+}
+
+static void UpdateQuantileNEON(const float* lmagn,
+                               size_t length,
+                               int counter,
+                               float* lquantile,
+                               float* density) {
+  const float counter_plus_one = (float)(counter + 1);
+  const float32x4_t one = vdupq_n_f32(1.f);
+  const float32x4_t factor = vdupq_n_f32(FACTOR);
+  const float32x4_t width = vdupq_n_f32(WIDTH);
+  const float32x4_t up = vdupq_n_f32(QUANTILE / counter_plus_one);
+  const float32x4_t down = vdupq_n_f32(-(1.f - QUANTILE) / counter_plus_one);
+  const float32x4_t count = vdupq_n_f32((float)counter);
+  const float32x4_t inv_count_plus_one = vdupq_n_f32(1.f / counter_plus_one);
+  const float32x4_t density_step = vdupq_n_f32(1.f / (2.f * WIDTH));
+  size_t i;
+
+  for (i = 0; i + 4 <= length; i += 4) {
+    const float32x4_t lmagn_v = vld1q_f32(&lmagn[i]);
+    float32x4_t lquantile_v = vld1q_f32(&lquantile[i]);
+    float32x4_t density_v = vld1q_f32(&density[i]);
+    // delta = FACTOR / max(density, 1), the step the quantile takes.
+    const float32x4_t delta = vdivq_f32(factor, vmaxq_f32(density_v, one));
+    const float32x4_t step =
+        vbslq_f32(vcgtq_f32(lmagn_v, lquantile_v), up, down);
+    uint32x4_t close;
+    float32x4_t updated;
+    lquantile_v = vmlaq_f32(lquantile_v, delta, step);
+
+    // Only update the density where the quantile is close to the input.
+    close = vcltq_f32(vabsq_f32(vsubq_f32(lmagn_v, lquantile_v)), width);
+    updated = vmulq_f32(vmlaq_f32(density_step, count, density_v),
+                        inv_count_plus_one);
+    density_v = vbslq_f32(close, updated, density_v);
+
+    vst1q_f32(&lquantile[i], lquantile_v);
+    vst1q_f32(&density[i], density_v);
+  }
+
+  for (; i < length; i++) {
+    const float delta = density[i] > 1.f ? FACTOR / density[i] : FACTOR;
+    if (lmagn[i] > lquantile[i]) {
+      lquantile[i] += delta * (QUANTILE / counter_plus_one);
+    } else {
+      lquantile[i] -= delta * ((1.f - QUANTILE) / counter_plus_one);
+    }
+    if (fabsf(lmagn[i] - lquantile[i]) < WIDTH) {
+      density[i] = ((float)counter * density[i] + 1.f / (2.f * WIDTH)) *
+                   (1.f / counter_plus_one);
+    }
+  }
+}
+
+static float UpdateLogLrtNEON(const float* snrLocPrior,
+                              const float* snrLocPost,
+                              size_t length,
+                              float* logLrtTimeAvg) {
+  const float32x4_t one = vdupq_n_f32(1.f);
+  const float32x4_t eps = vdupq_n_f32(0.0001f);
+  const float32x4_t lrt_tavg = vdupq_n_f32(LRT_TAVG);
+  float32x4_t sum = vdupq_n_f32(0.f);
+  float sum_out[4];
+  float sum_tail = 0.f;
+  size_t i;
+
+  for (i = 0; i + 4 <= length; i += 4) {
+    const float32x4_t prior =
+        vmulq_f32(vdupq_n_f32(2.f), vld1q_f32(&snrLocPrior[i]));
+    const float32x4_t post = vld1q_f32(&snrLocPost[i]);
+    const float32x4_t tmp1 = vaddq_f32(one, prior);
+    const float32x4_t bessel = vmulq_f32(
+        vaddq_f32(post, one), vdivq_f32(prior, vaddq_f32(tmp1, eps)));
+    float32x4_t lrt = vld1q_f32(&logLrtTimeAvg[i]);
+    lrt = vmlaq_f32(
+        lrt, lrt_tavg,
+        vsubq_f32(vsubq_f32(bessel, LogNEON(tmp1)), lrt));
+    vst1q_f32(&logLrtTimeAvg[i], lrt);
+    sum = vaddq_f32(sum, lrt);
+  }
+
+  for (; i < length; i++) {
+    const float tmp1 = 1.f + 2.f * snrLocPrior[i];
+    const float bessel =
+        (snrLocPost[i] + 1.f) * (2.f * snrLocPrior[i] / (tmp1 + 0.0001f));
+    logLrtTimeAvg[i] +=
+        LRT_TAVG * (bessel - logf(tmp1) - logLrtTimeAvg[i]);
+    sum_tail += logLrtTimeAvg[i];
+  }
+
+  vst1q_f32(sum_out, sum);
+  return (sum_out[0] + sum_out[1]) + (sum_out[2] + sum_out[3]) + sum_tail;
+}
+
+static void SpeechProbabilityNEON(const float* logLrtTimeAvg,
+                                  float gainPrior,
+                                  size_t length,
+                                  float* probSpeechFinal) {
+  const float32x4_t one = vdupq_n_f32(1.f);
+  const float32x4_t gain = vdupq_n_f32(gainPrior);
+  size_t i;
+
+  for (i = 0; i + 4 <= length; i += 4) {
+    const float32x4_t lrt = vld1q_f32(&logLrtTimeAvg[i]);
+    const float32x4_t inv_lrt = vmulq_f32(gain, ExpNEON(vnegq_f32(lrt)));
+    vst1q_f32(&probSpeechFinal[i], vdivq_f32(one, vaddq_f32(one, inv_lrt)));
+  }
+  for (; i < length; i++) {
+    probSpeechFinal[i] = 1.f / (1.f + gainPrior * expf(-logLrtTimeAvg[i]));
+  }
+}
+
+void WebRtcNs_InitCore_neon(void) {
+  WebRtcNs_LogSpectrum = LogSpectrumNEON;
+  WebRtcNs_ExpSpectrum = ExpSpectrumNEON;
+  WebRtcNs_UpdateQuantile = UpdateQuantileNEON;
+  WebRtcNs_UpdateLogLrt = UpdateLogLrtNEON;
+  WebRtcNs_SpeechProbability = SpeechProbabilityNEON;
+}
@@ -0,0 +1,242 @@
+/*
+ *  Copyright (c) 2016 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+/*
+ * The core noise suppression algorithm, SSE2 version of the per-bin loops.
+ */
+
+#include <emmintrin.h>
+#include <math.h>
+
+#include "webrtc/modules/audio_processing/ns/defines.h"
+#include "webrtc/modules/audio_processing/ns/ns_core.h"
+
+// Natural logarithm of four positive, normal floats.
+//   x = m * 2^e with m in [sqrt(1/2), sqrt(2)), log(x) = log(m) + e * log(2),
+//   and log(m) = log(1 + f) is the Cephes minimax polynomial in f.
+static __m128 LogSSE2(__m128 x) {
+  // Exponent bias of a mantissa in [0.5, 1) rather than [1, 2).
+  const __m128i exponent_bias = _mm_set1_epi32(0x7E);
+  const __m128i mantissa_mask = _mm_set1_epi32(0x007FFFFF);
+  const __m128 one = _mm_set1_ps(1.f);
+  const __m128 half = _mm_set1_ps(0.5f);
+  const __m128 sqrt_half = _mm_set1_ps(0.707106781186547524f);
+  const __m128i bits = _mm_castps_si128(x);
+  // Mantissa in [0.5, 1) and the matching exponent.
+  __m128 m = _mm_or_ps(_mm_castsi128_ps(_mm_and_si128(bits, mantissa_mask)),
+                       half);
+  __m128 e =
+      _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), exponent_bias));
+  // Move m into [sqrt(1/2), sqrt(2)) and take f = m - 1.
+  const __m128 below = _mm_cmplt_ps(m, sqrt_half);
+  __m128 f, f2, y;
+  e = _mm_sub_ps(e, _mm_and_ps(below, one));
+  f = _mm_sub_ps(_mm_add_ps(m, _mm_and_ps(below, m)), one);
+  f2 = _mm_mul_ps(f, f);
+
+  y = _mm_set1_ps(7.0376836292e-2f);
+  y = _mm_add_ps(_mm_mul_ps(y, f), _mm_set1_ps(-1.1514610310e-1f));
+  y = _mm_add_ps(_mm_mul_ps(y, f), _mm_set1_ps(1.1676998740e-1f));
+  y = _mm_add_ps(_mm_mul_ps(y, f), _mm_set1_ps(-1.2420140846e-1f));
+  y = _mm_add_ps(_mm_mul_ps(y, f), _mm_set1_ps(1.4249322787e-1f));
+  y = _mm_add_ps(_mm_mul_ps(y, f), _mm_set1_ps(-1.6668057665e-1f));
+  y = _mm_add_ps(_mm_mul_ps(y, f), _mm_set1_ps(2.0000714765e-1f));
+  y = _mm_add_ps(_mm_mul_ps(y, f), _mm_set1_ps(-2.4999993993e-1f));
+  y = _mm_add_ps(_mm_mul_ps(y, f), _mm_set1_ps(3.3333331174e-1f));
+  y = _mm_mul_ps(_mm_mul_ps(y, f), f2);
+
+  // log(2) is split in two so that e * log(2) is exact in the first part.
+  y = _mm_add_ps(y, _mm_mul_ps(e, _mm_set1_ps(-2.12194440e-4f)));
+  y = _mm_sub_ps(y, _mm_mul_ps(f2, half));
+  return _mm_add_ps(_mm_add_ps(f, y), _mm_mul_ps(e, _mm_set1_ps(0.693359375f)));
+}
+
+// Exponential of four floats, clamped to the range of normal floats.
+//   exp(x) = 2^n * exp(r) with n = round(x / log(2)), |r| <= log(2) / 2, and
+//   exp(r) is the Cephes minimax polynomial in r.
+static __m128 ExpSSE2(__m128 x) {
+  const __m128 one = _mm_set1_ps(1.f);
+  __m128 n, r, r2, y;
+  __m128i t;
+
+  x = _mm_min_ps(x, _mm_set1_ps(88.f));
+  x = _mm_max_ps(x, _mm_set1_ps(-87.3365478515625f));
+
+  // n = floor(x / log(2) + 1 / 2); the conversion truncates towards zero.
+  n = _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(1.44269504088896341f)),
+                 _mm_set1_ps(0.5f));
+  t = _mm_cvttps_epi32(n);
+  r = _mm_cvtepi32_ps(t);
+  n = _mm_sub_ps(r, _mm_and_ps(_mm_cmpgt_ps(r, n), one));
+
+  r = _mm_sub_ps(x, _mm_mul_ps(n, _mm_set1_ps(0.693359375f)));
+  r = _mm_sub_ps(r, _mm_mul_ps(n, _mm_set1_ps(-2.12194440e-4f)));
+  r2 = _mm_mul_ps(r, r);
+
+  y = _mm_set1_ps(1.9875691500e-4f);
+  y = _mm_add_ps(_mm_mul_ps(y, r), _mm_set1_ps(1.3981999507e-3f));
+  y = _mm_add_ps(_mm_mul_ps(y, r), _mm_set1_ps(8.3334519073e-3f));
+  y = _mm_add_ps(_mm_mul_ps(y, r), _mm_set1_ps(4.1665795894e-2f));
+  y = _mm_add_ps(_mm_mul_ps(y, r), _mm_set1_ps(1.6666665459e-1f));
+  y = _mm_add_ps(_mm_mul_ps(y, r), _mm_set1_ps(5.0000001201e-1f));
+  y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(y, r2), r), one);
+
+  // Scale by 2^n, built directly in the exponent field.
+  t = _mm_slli_epi32(_mm_add_epi32(_mm_cvttps_epi32(n), _mm_set1_epi32(0x7F)),
+                     23);
+  return _mm_mul_ps(y, _mm_castsi128_ps(t));
+}
+
+static void LogSpectrumSSE2(const float* in, size_t length, float* out) {
+  size_t i;
+
+  for (i = 0; i + 4 <= length; i += 4) {
+    _mm_storeu_ps(&out[i], LogSSE2(_mm_loadu_ps(&in[i])));
+  }
+  for (; i < length; i++) {
+    out[i] = logf(in[i]);
+  }
+}
+
+static void ExpSpectrumSSE2(const float* in, size_t length, float* out) {
+  size_t i;
+
+  for (i = 0; i + 4 <= length; i += 4) {
+    _mm_storeu_ps(&out[i], ExpSSE2(_mm_loadu_ps(&in[i])));
+  }
+  for (; i < length; i++) {
+    out[i] = expf(in[i]);
+  }
+}
+
+static void UpdateQuantileSSE2(const float* lmagn,
+                               size_t length,
+                               int counter,
+                               float* lquantile,
+                               float* density) {
+  const float counter_plus_one = (float)(counter + 1);
+  const __m128 one = _mm_set1_ps(1.f);
+  const __m128 factor = _mm_set1_ps(FACTOR);
+  const __m128 width = _mm_set1_ps(WIDTH);
+  const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+  const __m128 up = _mm_set1_ps(QUANTILE / counter_plus_one);
+  const __m128 down = _mm_set1_ps(-(1.f - QUANTILE) / counter_plus_one);
+  const __m128 count = _mm_set1_ps((float)counter);
+  const __m128 inv_count_plus_one = _mm_set1_ps(1.f / counter_plus_one);
+  const __m128 density_step = _mm_set1_ps(1.f / (2.f * WIDTH));
+  size_t i;
+
+  for (i = 0; i + 4 <= length; i += 4) {
+    const __m128 lmagn_v = _mm_loadu_ps(&lmagn[i]);
+    __m128 lquantile_v = _mm_loadu_ps(&lquantile[i]);
+    __m128 density_v = _mm_loadu_ps(&density[i]);
+    // delta = FACTOR / max(density, 1), the step the quantile takes.
+    const __m128 delta = _mm_div_ps(factor, _mm_max_ps(density_v, one));
+    const __m128 above = _mm_cmpgt_ps(lmagn_v, lquantile_v);
+    const __m128 step =
+        _mm_or_ps(_mm_and_ps(above, up), _mm_andnot_ps(above, down));
+    __m128 close, updated;
+    lquantile_v = _mm_add_ps(lquantile_v, _mm_mul_ps(delta, step));
+
+    // Only update the density where the quantile is close to the input.
+    close = _mm_cmplt_ps(
+        _mm_and_ps(_mm_sub_ps(lmagn_v, lquantile_v), abs_mask), width);
+    updated = _mm_mul_ps(
+        _mm_add_ps(_mm_mul_ps(count, density_v), density_step),
+        inv_count_plus_one);
+    density_v = _mm_or_ps(_mm_and_ps(close, updated),
+                          _mm_andnot_ps(close, density_v));
+
+    _mm_storeu_ps(&lquantile[i], lquantile_v);
+    _mm_storeu_ps(&density[i], density_v);
+  }
+
+  for (; i < length; i++) {
+    const float delta = density[i] > 1.f ? FACTOR / density[i] : FACTOR;
+    if (lmagn[i] > lquantile[i]) {
+      lquantile[i] += delta * (QUANTILE / counter_plus_one);
+    } else {
+      lquantile[i] -= delta * ((1.f - QUANTILE) / counter_plus_one);
+    }
+    if (fabsf(lmagn[i] - lquantile[i]) < WIDTH) {
+      density[i] = ((float)counter * density[i] + 1.f / (2.f * WIDTH)) *
+                   (1.f / counter_plus_one);
+    }
+  }
+}
+
+static float UpdateLogLrtSSE2(const float* snrLocPrior,
+                              const float* snrLocPost,
+                              size_t length,
+                              float* logLrtTimeAvg) {
+  const __m128 one = _mm_set1_ps(1.f);
+  const __m128 two = _mm_set1_ps(2.f);
+  const __m128 eps = _mm_set1_ps(0.0001f);
+  const __m128 lrt_tavg = _mm_set1_ps(LRT_TAVG);
+  __m128 sum = _mm_setzero_ps();
+  float sum_out[4];
+  float sum_tail = 0.f;
+  size_t i;
+
+  for (i = 0; i + 4 <= length; i += 4) {
+    const __m128 prior = _mm_mul_ps(two, _mm_loadu_ps(&snrLocPrior[i]));
+    const __m128 post = _mm_loadu_ps(&snrLocPost[i]);
+    const __m128 tmp1 = _mm_add_ps(one, prior);
+    const __m128 bessel = _mm_mul_ps(_mm_add_ps(post, one),
+                                     _mm_div_ps(prior, _mm_add_ps(tmp1, eps)));
+    __m128 lrt = _mm_loadu_ps(&logLrtTimeAvg[i]);
+    lrt = _mm_add_ps(lrt, _mm_mul_ps(lrt_tavg,
+                                     _mm_sub_ps(_mm_sub_ps(bessel,
+                                                           LogSSE2(tmp1)),
+                                                lrt)));
+    _mm_storeu_ps(&logLrtTimeAvg[i], lrt);
+    sum = _mm_add_ps(sum, lrt);
+  }
+
+  for (; i < length; i++) {
+    const float tmp1 = 1.f + 2.f * snrLocPrior[i];
+    const float bessel =
+        (snrLocPost[i] + 1.f) * (2.f * snrLocPrior[i] / (tmp1 + 0.0001f));
+    logLrtTimeAvg[i] +=
+        LRT_TAVG * (bessel - logf(tmp1) - logLrtTimeAvg[i]);
+    sum_tail += logLrtTimeAvg[i];
+  }
+
+  _mm_storeu_ps(sum_out, sum);
+  return (sum_out[0] + sum_out[1]) + (sum_out[2] + sum_out[3]) + sum_tail;
+}
+
+static void SpeechProbabilitySSE2(const float* logLrtTimeAvg,
+                                  float gainPrior,
+                                  size_t length,
+                                  float* probSpeechFinal) {
+  const __m128 one = _mm_set1_ps(1.f);
+  const __m128 gain = _mm_set1_ps(gainPrior);
+  size_t i;
+
+  for (i = 0; i + 4 <= length; i += 4) {
+    const __m128 lrt = _mm_loadu_ps(&logLrtTimeAvg[i]);
+    const __m128 inv_lrt =
+        _mm_mul_ps(gain, ExpSSE2(_mm_sub_ps(_mm_setzero_ps(), lrt)));
+    _mm_storeu_ps(&probSpeechFinal[i],
+                  _mm_div_ps(one, _mm_add_ps(one, inv_lrt)));
+  }
+  for (; i < length; i++) {
+    probSpeechFinal[i] = 1.f / (1.f + gainPrior * expf(-logLrtTimeAvg[i]));
+  }
+}
+
+void WebRtcNs_InitCore_SSE2(void) {
+  WebRtcNs_LogSpectrum = LogSpectrumSSE2;
+  WebRtcNs_ExpSpectrum = ExpSpectrumSSE2;
+  WebRtcNs_UpdateQuantile = UpdateQuantileSSE2;
+  WebRtcNs_UpdateLogLrt = UpdateLogLrtSSE2;
+  WebRtcNs_SpeechProbability = SpeechProbabilitySSE2;
+}
@@ -0,0 +1,264 @@
+/*
+ *  Copyright (c) 2016 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include <random>
+#include <vector>
+
+extern "C" {
+#include "webrtc/modules/audio_processing/ns/noise_suppression.h"
+#include "webrtc/modules/audio_processing/ns/ns_core.h"
+}
+#include "testing/gtest/include/gtest/gtest.h"
+#include "webrtc/system_wrappers/include/cpu_features_wrapper.h"
+
+namespace webrtc {
+namespace {
+
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+
+// The SIMD log/exp approximations are good to a few float ulps.
+const float kTolerance = 2e-6f;
+const size_t kLength = HALF_ANAL_BLOCKL;
+
+struct Kernels {
+  WebRtcNsLogSpectrum log_spectrum;
+  WebRtcNsExpSpectrum exp_spectrum;
+  WebRtcNsUpdateQuantile update_quantile;
+  WebRtcNsUpdateLogLrt update_log_lrt;
+  WebRtcNsSpeechProbability speech_probability;
+};
+
+// The kernels are picked by WebRtcNs_InitCore() from the CPU features, and
+// stay selected for all instances until the next one is initialized.
+void LoadKernels(WebRtc_CPUInfo cpu_info, Kernels* kernels) {
+  WebRtc_CPUInfo saved = WebRtc_GetCPUInfo;
+  NsHandle* ns = WebRtcNs_Create();
+  ASSERT_TRUE(ns);
+  WebRtc_GetCPUInfo = cpu_info;
+  const int error = WebRtcNs_Init(ns, 16000);
+  WebRtc_GetCPUInfo = saved;
+  WebRtcNs_Free(ns);
+  ASSERT_EQ(0, error);
+  kernels->log_spectrum = WebRtcNs_LogSpectrum;
+  kernels->exp_spectrum = WebRtcNs_ExpSpectrum;
+  kernels->update_quantile = WebRtcNs_UpdateQuantile;
+  kernels->update_log_lrt = WebRtcNs_UpdateLogLrt;
+  kernels->speech_probability = WebRtcNs_SpeechProbability;
+}
+
+void SelectKernels(const Kernels& kernels) {
+  WebRtcNs_LogSpectrum = kernels.log_spectrum;
+  WebRtcNs_ExpSpectrum = kernels.exp_spectrum;
+  WebRtcNs_UpdateQuantile = kernels.update_quantile;
+  WebRtcNs_UpdateLogLrt = kernels.update_log_lrt;
+  WebRtcNs_SpeechProbability = kernels.speech_probability;
+}
+
+void ExpectNear(const float* expected,
+                const float* actual,
+                size_t size,
+                float tolerance = kTolerance) {
+  for (size_t i = 0; i < size; ++i) {
+    ASSERT_NEAR(expected[i], actual[i], tolerance * (1.f + fabsf(expected[i])))
+        << "at " << i;
+  }
+}
+
+class NsCoreTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    has_sse2_ = WebRtc_GetCPUInfo(kSSE2) != 0;
+    if (!has_sse2_) {
+      return;
+    }
+    LoadKernels(WebRtc_GetCPUInfoNoASM, &generic_);
+    LoadKernels(WebRtc_GetCPUInfo, &sse2_);
+    ASSERT_NE(generic_.log_spectrum, sse2_.log_spectrum);
+  }
+
+  void Fill(float* data, size_t size, float min, float max) {
+    std::uniform_real_distribution<float> dist(min, max);
+    for (size_t i = 0; i < size; ++i) {
+      data[i] = dist(random_);
+    }
+  }
+
+  bool has_sse2_;
+  Kernels generic_;
+  Kernels sse2_;
+  std::mt19937 random_;
+};
+
+TEST_F(NsCoreTest, LogSpectrum) {
+  if (!has_sse2_) {
+    return;
+  }
+  float magn[kLength];
+  float log_generic[kLength];
+  float log_sse2[kLength];
+
+  for (int round = 0; round < 20; ++round) {
+    // Magnitudes from 1 up to what a full scale signal gives.
+    Fill(magn, kLength, 0.f, 14.f);
+    for (size_t i = 0; i < kLength; ++i) {
+      magn[i] = expf(magn[i]);
+    }
+    generic_.log_spectrum(magn, kLength, log_generic);
+    sse2_.log_spectrum(magn, kLength, log_sse2);
+    ExpectNear(log_generic, log_sse2, kLength);
+  }
+}
+
+TEST_F(NsCoreTest, ExpSpectrum) {
+  if (!has_sse2_) {
+    return;
+  }
+  float lquantile[kLength];
+  float exp_generic[kLength];
+  float exp_sse2[kLength];
+
+  for (int round = 0; round < 20; ++round) {
+    Fill(lquantile, kLength, -30.f, 30.f);
+    generic_.exp_spectrum(lquantile, kLength, exp_generic);
+    sse2_.exp_spectrum(lquantile, kLength, exp_sse2);
+    for (size_t i = 0; i < kLength; ++i) {
+      ASSERT_NEAR(1.f, exp_sse2[i] / exp_generic[i], kTolerance) << "at " << i;
+    }
+  }
+}
+
+TEST_F(NsCoreTest, UpdateQuantile) {
+  if (!has_sse2_) {
+    return;
+  }
+  float lmagn[kLength];
+  float lquantile_generic[kLength], lquantile_sse2[kLength];
+  float density_generic[kLength], density_sse2[kLength];
+
+  for (int counter = 0; counter < 200; counter += 7) {
+    Fill(lmagn, kLength, 0.f, 14.f);
+    // Half of the estimates sit within WIDTH of the input.
+    for (size_t i = 0; i < kLength; ++i) {
+      lquantile_generic[i] = lmagn[i] + (i % 2 ? 0.5f : 0.f);
+    }
+    Fill(density_generic, kLength, 0.f, 60.f);
+    memcpy(lquantile_sse2, lquantile_generic, sizeof(lquantile_generic));
+    memcpy(density_sse2, density_generic, sizeof(density_generic));
+
+    generic_.update_quantile(lmagn, kLength, counter, lquantile_generic,
+                             density_generic);
+    sse2_.update_quantile(lmagn, kLength, counter, lquantile_sse2,
+                          density_sse2);
+    ExpectNear(lquantile_generic, lquantile_sse2, kLength);
+    ExpectNear(density_generic, density_sse2, kLength);
+  }
+}
+
+TEST_F(NsCoreTest, UpdateLogLrt) {
+  if (!has_sse2_) {
+    return;
+  }
+  float snr_prior[kLength], snr_post[kLength];
+  float lrt_generic[kLength], lrt_sse2[kLength];
+
+  for (int round = 0; round < 20; ++round) {
+    Fill(snr_prior, kLength, 0.f, 100.f);
+    Fill(snr_post, kLength, 0.f, 100.f);
+    Fill(lrt_generic, kLength, -1.f, 50.f);
+    memcpy(lrt_sse2, lrt_generic, sizeof(lrt_generic));
+
+    const float sum_generic = generic_.update_log_lrt(snr_prior, snr_post,
+                                                      kLength, lrt_generic);
+    const float sum_sse2 =
+        sse2_.update_log_lrt(snr_prior, snr_post, kLength, lrt_sse2);
+    ExpectNear(lrt_generic, lrt_sse2, kLength);
+    EXPECT_NEAR(sum_generic, sum_sse2, kTolerance * fabsf(sum_generic));
+  }
+}
+
+TEST_F(NsCoreTest, SpeechProbability) {
+  if (!has_sse2_) {
+    return;
+  }
+  float lrt[kLength];
+  float prob_generic[kLength], prob_sse2[kLength];
+
+  for (int round = 0; round < 20; ++round) {
+    float gain_prior;
+    Fill(&gain_prior, 1, 0.f, 99.f);
+    Fill(lrt, kLength, -5.f, 50.f);
+    generic_.speech_probability(lrt, gain_prior, kLength, prob_generic);
+    sse2_.speech_probability(lrt, gain_prior, kLength, prob_sse2);
+    ExpectNear(prob_generic, prob_sse2, kLength);
+  }
+}
+
+// The whole suppressor: the approximations must not move the noise estimate
+// or the gains audibly, over a stream long enough for the estimates to settle.
+TEST_F(NsCoreTest, ProcessMatchesGeneric) {
+  if (!has_sse2_) {
+    return;
+  }
+  const int kFs = 16000;
+  const size_t kFrameLength = kFs / 100;
+  const int kFrames = 600;
+  NsHandle* ns_generic = WebRtcNs_Create();
+  NsHandle* ns_sse2 = WebRtcNs_Create();
+  ASSERT_TRUE(ns_generic);
+  ASSERT_TRUE(ns_sse2);
+  ASSERT_EQ(0, WebRtcNs_Init(ns_generic, kFs));
+  ASSERT_EQ(0, WebRtcNs_Init(ns_sse2, kFs));
+  ASSERT_EQ(0, WebRtcNs_set_policy(ns_generic, 2));
+  ASSERT_EQ(0, WebRtcNs_set_policy(ns_sse2, 2));
+
+  std::normal_distribution<float> noise(0.f, 300.f);
+  std::vector<float> in(kFrameLength), out_generic(kFrameLength),
+      out_sse2(kFrameLength);
+  double energy = 0.0, error = 0.0;
+  for (int frame = 0; frame < kFrames; ++frame) {
+    // Noise with a tone switching on and off as the "speech".
+    const float amplitude = (frame / 50) % 2 ? 3000.f : 0.f;
+    for (size_t i = 0; i < kFrameLength; ++i) {
+      const size_t t = frame * kFrameLength + i;
+      in[i] = noise(random_) + amplitude * sinf(0.1f * t);
+    }
+    const float* in_bands[] = {in.data()};
+    float* out_bands_generic[] = {out_generic.data()};
+    float* out_bands_sse2[] = {out_sse2.data()};
+
+    // The kernels are global, select them for each instance in turn.
+    SelectKernels(generic_);
+    WebRtcNs_Analyze(ns_generic, in.data());
+    WebRtcNs_Process(ns_generic, in_bands, 1, out_bands_generic);
+    SelectKernels(sse2_);
+    WebRtcNs_Analyze(ns_sse2, in.data());
+    WebRtcNs_Process(ns_sse2, in_bands, 1, out_bands_sse2);
+
+    for (size_t i = 0; i < kFrameLength; ++i) {
+      const double diff = out_generic[i] - out_sse2[i];
+      energy += out_generic[i] * out_generic[i];
+      error += diff * diff;
+    }
+  }
+  // At least 60 dB between the output and the difference.
+  EXPECT_LT(error, 1e-6 * energy);
+
+  SelectKernels(sse2_);
+  WebRtcNs_Free(ns_generic);
+  WebRtcNs_Free(ns_sse2);
+}
+
+#endif  // WEBRTC_ARCH_X86_FAMILY
+
+}  // namespace
+}  // namespace webrtc
@@ -775,6 +775,12 @@ int32_t WebRtcNsx_InitCore(NoiseSuppressionFixedC* inst, uint32_t fs) {
   WebRtcNsx_InitMips();
 #endif
 
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+  if (WebRtc_GetCPUInfo(kSSE4_1)) {
+    WebRtcNsx_InitSSE41();
+  }
+#endif
+
   inst->initFlag = 1;
 
   return 0;
@@ -233,6 +233,12 @@ void WebRtcNsx_PrepareSpectrumNeon(NoiseSuppressionFixedC* inst,
                                    int16_t* freq_buff);
 #endif
 
+// On x86 all but the noise estimation are picked at runtime by this, defined
+// in nsx_core_sse41.c.
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+void WebRtcNsx_InitSSE41(void);
+#endif
+
 #if defined(MIPS32_LE)
 // For the above function pointers, functions for generic platforms are declared
 // and defined as static in file nsx_core.c, while those for MIPS platforms
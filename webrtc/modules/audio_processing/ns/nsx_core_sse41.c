@@ -0,0 +1,175 @@
+/*
+ *  Copyright (c) 2016 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+/*
+ * SSE4.1 versions of the NSX time and frequency domain kernels, bit-exact with
+ * the C ones in nsx_core.c. The Q14 and Q13 products are formed in 32 bits and
+ * truncated or saturated back to 16 bits the way the C code casts them.
+ */
+
+#include <smmintrin.h>
+#include <string.h>
+
+#include "webrtc/modules/audio_processing/ns/nsx_core.h"
+
+// The eight products |a| * |b| with (1 << (shift - 1)) added when |round| is
+// set, shifted down by |shift|, as 32 bit values in |low| and |high|.
+static void MulShift(__m128i a,
+                     __m128i b,
+                     int shift,
+                     int round,
+                     __m128i* low,
+                     __m128i* high) {
+  const __m128i product_low = _mm_mullo_epi16(a, b);
+  const __m128i product_high = _mm_mulhi_epi16(a, b);
+  const __m128i count = _mm_cvtsi32_si128(shift);
+  __m128i result_low = _mm_unpacklo_epi16(product_low, product_high);
+  __m128i result_high = _mm_unpackhi_epi16(product_low, product_high);
+  if (round) {
+    const __m128i rounding = _mm_set1_epi32(1 << (shift - 1));
+    result_low = _mm_add_epi32(result_low, rounding);
+    result_high = _mm_add_epi32(result_high, rounding);
+  }
+  *low = _mm_sra_epi32(result_low, count);
+  *high = _mm_sra_epi32(result_high, count);
+}
+
+// Packs the lower 16 bits of the 32 bit lanes, as an (int16_t) cast does.
+static __m128i PackTruncate(__m128i low, __m128i high) {
+  const __m128i mask = _mm_set1_epi32(0xFFFF);
+  return _mm_packus_epi32(_mm_and_si128(low, mask), _mm_and_si128(high, mask));
+}
+
+static void PrepareSpectrumSSE41(NoiseSuppressionFixedC* inst,
+                                 int16_t* freq_buf) {
+  const __m128i zero = _mm_setzero_si128();
+  size_t i;
+
+  // anaLen2 is a multiple of eight; its bin is the last one of magnLen.
+  for (i = 0; i < inst->anaLen2; i += 8) {
+    const __m128i filter =
+        _mm_loadu_si128((const __m128i*)&inst->noiseSupFilter[i]);
+    __m128i low, high, real, imag;
+    MulShift(_mm_loadu_si128((const __m128i*)&inst->real[i]), filter, 14, 0,
+             &low, &high);
+    real = PackTruncate(low, high);
+    MulShift(_mm_loadu_si128((const __m128i*)&inst->imag[i]), filter, 14, 0,
+             &low, &high);
+    imag = PackTruncate(low, high);
+    _mm_storeu_si128((__m128i*)&inst->real[i], real);
+    _mm_storeu_si128((__m128i*)&inst->imag[i], imag);
+
+    imag = _mm_sub_epi16(zero, imag);
+    _mm_storeu_si128((__m128i*)&freq_buf[2 * i],
+                     _mm_unpacklo_epi16(real, imag));
+    _mm_storeu_si128((__m128i*)&freq_buf[2 * i + 8],
+                     _mm_unpackhi_epi16(real, imag));
+  }
+  inst->real[i] = (int16_t)((inst->real[i] *
+      (int16_t)(inst->noiseSupFilter[i])) >> 14);  // Q(normData-stages)
+  inst->imag[i] = (int16_t)((inst->imag[i] *
+      (int16_t)(inst->noiseSupFilter[i])) >> 14);  // Q(normData-stages)
+  freq_buf[inst->anaLen] = inst->real[inst->anaLen2];
+  freq_buf[inst->anaLen + 1] = -inst->imag[inst->anaLen2];
+}
+
+static void DenormalizeSSE41(NoiseSuppressionFixedC* inst,
+                             int16_t* in,
+                             int factor) {
+  const int shift = factor - inst->normData;
+  const __m128i count = _mm_cvtsi32_si128(shift >= 0 ? shift : -shift);
+  size_t i;
+
+  for (i = 0; i < inst->anaLen; i += 8) {
+    const __m128i x = _mm_loadu_si128((const __m128i*)&in[i]);
+    __m128i low = _mm_cvtepi16_epi32(x);
+    __m128i high = _mm_cvtepi16_epi32(_mm_srli_si128(x, 8));
+    if (shift >= 0) {
+      low = _mm_sll_epi32(low, count);
+      high = _mm_sll_epi32(high, count);
+    } else {
+      low = _mm_sra_epi32(low, count);
+      high = _mm_sra_epi32(high, count);
+    }
+    _mm_storeu_si128((__m128i*)&inst->real[i], _mm_packs_epi32(low, high));
+  }
+}
+
+static void SynthesisUpdateSSE41(NoiseSuppressionFixedC* inst,
+                                 int16_t* out_frame,
+                                 int16_t gain_factor) {
+  const __m128i gain = _mm_set1_epi16(gain_factor);
+  size_t i;
+
+  // synthesis
+  for (i = 0; i < inst->anaLen; i += 8) {
+    __m128i low, high, windowed, buffer;
+    MulShift(_mm_loadu_si128((const __m128i*)&inst->window[i]),
+             _mm_loadu_si128((const __m128i*)&inst->real[i]), 14, 1, &low,
+             &high);
+    windowed = PackTruncate(low, high);  // Q0, window in Q14
+    MulShift(windowed, gain, 13, 1, &low, &high);
+    buffer = _mm_loadu_si128((const __m128i*)&inst->synthesisBuffer[i]);
+    _mm_storeu_si128((__m128i*)&inst->synthesisBuffer[i],
+                     _mm_adds_epi16(buffer, _mm_packs_epi32(low, high)));
+  }
+
+  // read out fully processed segment
+  memcpy(out_frame, inst->synthesisBuffer,
+         inst->blockLen10ms * sizeof(*inst->synthesisBuffer));
+
+  // update synthesis buffer
+  memcpy(inst->synthesisBuffer, inst->synthesisBuffer + inst->blockLen10ms,
+      (inst->anaLen - inst->blockLen10ms) * sizeof(*inst->synthesisBuffer));
+  memset(inst->synthesisBuffer + inst->anaLen - inst->blockLen10ms, 0,
+         inst->blockLen10ms * sizeof(*inst->synthesisBuffer));
+}
+
+static void AnalysisUpdateSSE41(NoiseSuppressionFixedC* inst,
+                                int16_t* out,
+                                int16_t* new_speech) {
+  size_t i;
+
+  // For lower band update analysis buffer.
+  memcpy(inst->analysisBuffer, inst->analysisBuffer + inst->blockLen10ms,
+      (inst->anaLen - inst->blockLen10ms) * sizeof(*inst->analysisBuffer));
+  memcpy(inst->analysisBuffer + inst->anaLen - inst->blockLen10ms, new_speech,
+      inst->blockLen10ms * sizeof(*inst->analysisBuffer));
+
+  // Window data before FFT.
+  for (i = 0; i < inst->anaLen; i += 8) {
+    __m128i low, high;
+    MulShift(_mm_loadu_si128((const __m128i*)&inst->window[i]),
+             _mm_loadu_si128((const __m128i*)&inst->analysisBuffer[i]), 14, 1,
+             &low, &high);
+    _mm_storeu_si128((__m128i*)&out[i], PackTruncate(low, high));  // Q0
+  }
+}
+
+static void NormalizeRealBufferSSE41(NoiseSuppressionFixedC* inst,
+                                     const int16_t* in,
+                                     int16_t* out) {
+  const __m128i count = _mm_cvtsi32_si128(inst->normData);
+  size_t i;
+
+  for (i = 0; i < inst->anaLen; i += 8) {
+    _mm_storeu_si128(
+        (__m128i*)&out[i],
+        _mm_sll_epi16(_mm_loadu_si128((const __m128i*)&in[i]), count));
+  }
+}
+
+void WebRtcNsx_InitSSE41(void) {
+  WebRtcNsx_PrepareSpectrum = PrepareSpectrumSSE41;
+  WebRtcNsx_SynthesisUpdate = SynthesisUpdateSSE41;
+  WebRtcNsx_AnalysisUpdate = AnalysisUpdateSSE41;
+  WebRtcNsx_Denormalize = DenormalizeSSE41;
+  WebRtcNsx_NormalizeRealBuffer = NormalizeRealBufferSSE41;
+}
@@ -0,0 +1,219 @@
+/*
+ *  Copyright (c) 2016 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <string.h>
+
+#include <random>
+
+extern "C" {
+#include "webrtc/modules/audio_processing/ns/noise_suppression_x.h"
+#include "webrtc/modules/audio_processing/ns/nsx_core.h"
+}
+#include "testing/gtest/include/gtest/gtest.h"
+#include "webrtc/system_wrappers/include/cpu_features_wrapper.h"
+
+namespace webrtc {
+namespace {
+
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+
+struct Kernels {
+  PrepareSpectrum prepare_spectrum;
+  SynthesisUpdate synthesis_update;
+  AnalysisUpdate analysis_update;
+  Denormalize denormalize;
+  NormalizeRealBuffer normalize_real_buffer;
+};
+
+// The kernels are picked by WebRtcNsx_InitCore() from the CPU features, and
+// stay selected for all instances until the next one is initialized.
+void LoadKernels(WebRtc_CPUInfo cpu_info, Kernels* kernels) {
+  WebRtc_CPUInfo saved = WebRtc_GetCPUInfo;
+  NsxHandle* nsx = WebRtcNsx_Create();
+  ASSERT_TRUE(nsx);
+  WebRtc_GetCPUInfo = cpu_info;
+  const int error = WebRtcNsx_Init(nsx, 16000);
+  WebRtc_GetCPUInfo = saved;
+  WebRtcNsx_Free(nsx);
+  ASSERT_EQ(0, error);
+  kernels->prepare_spectrum = WebRtcNsx_PrepareSpectrum;
+  kernels->synthesis_update = WebRtcNsx_SynthesisUpdate;
+  kernels->analysis_update = WebRtcNsx_AnalysisUpdate;
+  kernels->denormalize = WebRtcNsx_Denormalize;
+  kernels->normalize_real_buffer = WebRtcNsx_NormalizeRealBuffer;
+}
+
+// The SSE4.1 kernels must match the C ones bit by bit, at both analysis
+// lengths.
+class NsxCoreTest : public ::testing::TestWithParam<uint32_t> {
+ protected:
+  void SetUp() override {
+    has_sse41_ = WebRtc_GetCPUInfo(kSSE4_1) != 0;
+    if (!has_sse41_) {
+      return;
+    }
+    LoadKernels(WebRtc_GetCPUInfoNoASM, &c_);
+    LoadKernels(WebRtc_GetCPUInfo, &sse41_);
+    ASSERT_NE(c_.prepare_spectrum, sse41_.prepare_spectrum);
+
+    nsx_c_ = WebRtcNsx_Create();
+    nsx_sse41_ = WebRtcNsx_Create();
+    ASSERT_TRUE(nsx_c_);
+    ASSERT_TRUE(nsx_sse41_);
+    ASSERT_EQ(0, WebRtcNsx_Init(nsx_c_, GetParam()));
+    ASSERT_EQ(0, WebRtcNsx_Init(nsx_sse41_, GetParam()));
+    inst_c_ = reinterpret_cast<NoiseSuppressionFixedC*>(nsx_c_);
+    inst_sse41_ = reinterpret_cast<NoiseSuppressionFixedC*>(nsx_sse41_);
+  }
+
+  void TearDown() override {
+    WebRtcNsx_Free(nsx_c_);
+    WebRtcNsx_Free(nsx_sse41_);
+  }
+
+  // Random values over the full range, the same in both instances.
+  void Fill(int16_t* data_c, int16_t* data_sse41, size_t size) {
+    for (size_t i = 0; i < size; ++i) {
+      data_c[i] = static_cast<int16_t>(random_());
+    }
+    memcpy(data_sse41, data_c, size * sizeof(*data_c));
+  }
+  void Fill(uint16_t* data_c, uint16_t* data_sse41, size_t size) {
+    Fill(reinterpret_cast<int16_t*>(data_c),
+         reinterpret_cast<int16_t*>(data_sse41), size);
+  }
+
+  void ExpectEqual(const int16_t* expected,
+                   const int16_t* actual,
+                   size_t size) {
+    for (size_t i = 0; i < size; ++i) {
+      ASSERT_EQ(expected[i], actual[i]) << "at " << i;
+    }
+  }
+
+  bool has_sse41_;
+  Kernels c_;
+  Kernels sse41_;
+  NsxHandle* nsx_c_ = nullptr;
+  NsxHandle* nsx_sse41_ = nullptr;
+  NoiseSuppressionFixedC* inst_c_ = nullptr;
+  NoiseSuppressionFixedC* inst_sse41_ = nullptr;
+  std::mt19937 random_;
+};
+
+TEST_P(NsxCoreTest, PrepareSpectrum) {
+  if (!has_sse41_) {
+    return;
+  }
+  int16_t freq_buf_c[ANAL_BLOCKL_MAX + 2];
+  int16_t freq_buf_sse41[ANAL_BLOCKL_MAX + 2];
+  const size_t magn_len = inst_c_->magnLen;
+
+  for (int round = 0; round < 20; ++round) {
+    Fill(inst_c_->real, inst_sse41_->real, magn_len);
+    Fill(inst_c_->imag, inst_sse41_->imag, magn_len);
+    Fill(inst_c_->noiseSupFilter, inst_sse41_->noiseSupFilter, magn_len);
+    c_.prepare_spectrum(inst_c_, freq_buf_c);
+    sse41_.prepare_spectrum(inst_sse41_, freq_buf_sse41);
+    ExpectEqual(inst_c_->real, inst_sse41_->real, magn_len);
+    ExpectEqual(inst_c_->imag, inst_sse41_->imag, magn_len);
+    ExpectEqual(freq_buf_c, freq_buf_sse41, inst_c_->anaLen + 2);
+  }
+}
+
+TEST_P(NsxCoreTest, Denormalize) {
+  if (!has_sse41_) {
+    return;
+  }
+  int16_t in[ANAL_BLOCKL_MAX];
+  const size_t ana_len = inst_c_->anaLen;
+
+  // Down and up shifts, saturating on the way up.
+  for (int norm_data = 0; norm_data < 16; norm_data += 3) {
+    for (int factor = 0; factor < 16; factor += 2) {
+      Fill(in, in, ana_len);
+      inst_c_->normData = norm_data;
+      inst_sse41_->normData = norm_data;
+      c_.denormalize(inst_c_, in, factor);
+      sse41_.denormalize(inst_sse41_, in, factor);
+      ExpectEqual(inst_c_->real, inst_sse41_->real, ana_len);
+    }
+  }
+}
+
+TEST_P(NsxCoreTest, SynthesisUpdate) {
+  if (!has_sse41_) {
+    return;
+  }
+  int16_t out_c[ANAL_BLOCKL_MAX];
+  int16_t out_sse41[ANAL_BLOCKL_MAX];
+  const size_t ana_len = inst_c_->anaLen;
+
+  for (int round = 0; round < 20; ++round) {
+    Fill(inst_c_->real, inst_sse41_->real, ana_len);
+    // Large buffered values make the additions saturate.
+    Fill(inst_c_->synthesisBuffer, inst_sse41_->synthesisBuffer, ana_len);
+    const int16_t gain_factor = static_cast<int16_t>(random_() % 16384);
+    c_.synthesis_update(inst_c_, out_c, gain_factor);
+    sse41_.synthesis_update(inst_sse41_, out_sse41, gain_factor);
+    ExpectEqual(out_c, out_sse41, inst_c_->blockLen10ms);
+    ExpectEqual(inst_c_->synthesisBuffer, inst_sse41_->synthesisBuffer,
+                ana_len);
+  }
+}
+
+TEST_P(NsxCoreTest, AnalysisUpdate) {
+  if (!has_sse41_) {
+    return;
+  }
+  int16_t new_speech[ANAL_BLOCKL_MAX];
+  int16_t out_c[ANAL_BLOCKL_MAX];
+  int16_t out_sse41[ANAL_BLOCKL_MAX];
+  const size_t ana_len = inst_c_->anaLen;
+
+  // Enough blocks to fill the whole analysis buffer with new speech.
+  for (int round = 0; round < 20; ++round) {
+    Fill(new_speech, new_speech, inst_c_->blockLen10ms);
+    c_.analysis_update(inst_c_, out_c, new_speech);
+    sse41_.analysis_update(inst_sse41_, out_sse41, new_speech);
+    ExpectEqual(out_c, out_sse41, ana_len);
+    ExpectEqual(inst_c_->analysisBuffer, inst_sse41_->analysisBuffer,
+                ana_len);
+  }
+}
+
+TEST_P(NsxCoreTest, NormalizeRealBuffer) {
+  if (!has_sse41_) {
+    return;
+  }
+  int16_t in[ANAL_BLOCKL_MAX];
+  int16_t out_c[ANAL_BLOCKL_MAX];
+  int16_t out_sse41[ANAL_BLOCKL_MAX];
+  const size_t ana_len = inst_c_->anaLen;
+
+  for (int norm_data = 0; norm_data < 16; ++norm_data) {
+    Fill(in, in, ana_len);
+    inst_c_->normData = norm_data;
+    inst_sse41_->normData = norm_data;
+    c_.normalize_real_buffer(inst_c_, in, out_c);
+    sse41_.normalize_real_buffer(inst_sse41_, in, out_sse41);
+    ExpectEqual(out_c, out_sse41, ana_len);
+  }
+}
+
+// 8 kHz has an analysis length of 128, the other rates one of 256.
+INSTANTIATE_TEST_CASE_P(SampleRates,
+                        NsxCoreTest,
+                        ::testing::Values(8000u, 16000u));
+
+#endif  // defined(WEBRTC_ARCH_X86_FAMILY)
+
+}  // namespace
+}  // namespace webrtc
@@ -10,6 +10,8 @@
 
 #include "webrtc/modules/audio_processing/splitting_filter.h"
 
+#include <algorithm>
+
 #include "webrtc/base/checks.h"
 #include "webrtc/common_audio/signal_processing/include/signal_processing_library.h"
 #include "webrtc/common_audio/channel_buffer.h"
@@ -56,6 +58,14 @@ void SplittingFilter::Synthesis(const IFChannelBuffer* bands,
   }
 }
 
+void SplittingFilter::Reset() {
+  std::fill(two_bands_states_.begin(), two_bands_states_.end(),
+            TwoBandsStates());
+  for (ThreeBandFilterBank* filter_bank : three_band_filter_banks_) {
+    filter_bank->Reset();
+  }
+}
+
 void SplittingFilter::TwoBandsAnalysis(const IFChannelBuffer* data,
                                        IFChannelBuffer* bands) {
   RTC_DCHECK_EQ(two_bands_states_.size(), data->num_channels());
@@ -50,6 +50,9 @@ class SplittingFilter {
   void Analysis(const IFChannelBuffer* data, IFChannelBuffer* bands);
   void Synthesis(const IFChannelBuffer* bands, IFChannelBuffer* data);
 
+  // Clears the filter states, as if newly constructed.
+  void Reset();
+
  private:
   // Two-band analysis and synthesis work for 640 samples or less.
   void TwoBandsAnalysis(const IFChannelBuffer* data, IFChannelBuffer* bands);
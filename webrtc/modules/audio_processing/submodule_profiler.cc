@@ -0,0 +1,165 @@
+/*
+ *  Copyright (c) 2016 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/modules/audio_processing/submodule_profiler.h"
+
+#include <math.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "webrtc/base/checks.h"
+#include "webrtc/base/timeutils.h"
+
+namespace webrtc {
+
+namespace {
+
+const char* const kSubmoduleNames[] = {
+    "agc_manager_analysis",
+    "band_split",
+    "intelligibility",
+    "beamformer",
+    "high_pass_filter",
+    "gain_control_analysis",
+    "noise_suppression_analysis",
+    "echo_cancellation",
+    "noise_suppression",
+    "echo_control_mobile",
+    "voice_detection",
+    "agc_manager",
+    "gain_control",
+    "band_merge",
+    "transient_suppressor",
+    "level_estimator",
+    "total",
+};
+
+static_assert(sizeof(kSubmoduleNames) / sizeof(kSubmoduleNames[0]) ==
+                  SubmoduleProfiler::kNumSubmodules,
+              "A name is needed for every submodule.");
+
+const float kPercentile = 0.99f;
+
+}  // namespace
+
+SubmoduleProfiler::SubmoduleProfiler()
+    : enabled_(false), frame_start_ns_(0), lap_start_ns_(0) {
+  std::fill(last_frame_durations_ns_,
+            last_frame_durations_ns_ + kNumSubmodules, -1);
+  memset(stats_, 0, sizeof(stats_));
+}
+
+SubmoduleProfiler::~SubmoduleProfiler() {}
+
+void SubmoduleProfiler::Enable(bool enable) {
+  enabled_ = enable;
+  std::fill(last_frame_durations_ns_,
+            last_frame_durations_ns_ + kNumSubmodules, -1);
+  memset(stats_, 0, sizeof(stats_));
+  if (enable) {
+    histograms_.assign(kNumSubmodules * kNumBuckets, 0);
+  } else {
+    std::vector<uint32_t>().swap(histograms_);
+  }
+}
+
+void SubmoduleProfiler::GetTimings(
+    std::vector<AudioProcessing::SubmoduleTiming>* timings) const {
+  for (int i = 0; i < kNumSubmodules; ++i) {
+    const Stats& stats = stats_[i];
+    if (stats.num_calls == 0) {
+      continue;
+    }
+    AudioProcessing::SubmoduleTiming timing;
+    timing.name = kSubmoduleNames[i];
+    timing.num_calls = stats.num_calls;
+    timing.min_ns = static_cast<int64_t>(stats.min_ns);
+    timing.mean_ns = static_cast<int64_t>(stats.total_ns / stats.num_calls);
+    timing.p99_ns = static_cast<int64_t>(
+        Percentile(static_cast<Submodule>(i), kPercentile));
+    timing.max_ns = static_cast<int64_t>(stats.max_ns);
+    timings->push_back(timing);
+  }
+}
+
+const char* SubmoduleProfiler::Name(Submodule submodule) {
+  RTC_DCHECK_LT(submodule, kNumSubmodules);
+  return kSubmoduleNames[submodule];
+}
+
+// Durations below 2 * kBucketsPerOctave ns get a bucket each, above that every
+// octave is split into kBucketsPerOctave buckets.
+size_t SubmoduleProfiler::BucketIndex(uint64_t duration_ns) {
+  size_t octave = 0;
+  while ((duration_ns >> octave) >= 2 * kBucketsPerOctave) {
+    ++octave;
+  }
+  const size_t index =
+      octave * kBucketsPerOctave + static_cast<size_t>(duration_ns >> octave);
+  return std::min(index, kNumBuckets - 1);
+}
+
+uint64_t SubmoduleProfiler::BucketUpperBound(size_t index) {
+  if (index < 2 * kBucketsPerOctave) {
+    return index;
+  }
+  const size_t octave = index / kBucketsPerOctave - 1;
+  const uint64_t mantissa = index % kBucketsPerOctave + kBucketsPerOctave;
+  return ((mantissa + 1) << octave) - 1;
+}
+
+void SubmoduleProfiler::StartFrameEnabled() {
+  std::fill(last_frame_durations_ns_,
+            last_frame_durations_ns_ + kNumSubmodules, -1);
+  frame_start_ns_ = rtc::TimeNanos();
+  lap_start_ns_ = frame_start_ns_;
+}
+
+void SubmoduleProfiler::LapEnabled(Submodule submodule) {
+  const uint64_t now_ns = rtc::TimeNanos();
+  Add(submodule, now_ns - lap_start_ns_);
+  lap_start_ns_ = now_ns;
+}
+
+void SubmoduleProfiler::EndFrameEnabled() {
+  Add(kTotal, rtc::TimeNanos() - frame_start_ns_);
+}
+
+void SubmoduleProfiler::Add(Submodule submodule, uint64_t duration_ns) {
+  RTC_DCHECK_LT(submodule, kNumSubmodules);
+  Stats& stats = stats_[submodule];
+  if (stats.num_calls == 0 || duration_ns < stats.min_ns) {
+    stats.min_ns = duration_ns;
+  }
+  stats.max_ns = std::max(stats.max_ns, duration_ns);
+  stats.total_ns += duration_ns;
+  ++stats.num_calls;
+  ++histograms_[submodule * kNumBuckets + BucketIndex(duration_ns)];
+  last_frame_durations_ns_[submodule] = static_cast<int64_t>(duration_ns);
+}
+
+uint64_t SubmoduleProfiler::Percentile(Submodule submodule,
+                                       float fraction) const {
+  const Stats& stats = stats_[submodule];
+  const uint32_t* histogram = &histograms_[submodule * kNumBuckets];
+  const uint64_t target =
+      static_cast<uint64_t>(ceil(fraction * stats.num_calls));
+  uint64_t count = 0;
+  for (size_t i = 0; i < kNumBuckets; ++i) {
+    count += histogram[i];
+    if (count >= target) {
+      return std::min(BucketUpperBound(i), stats.max_ns);
+    }
+  }
+  return stats.max_ns;
+}
+
+}  // namespace webrtc
@@ -0,0 +1,115 @@
+/*
+ *  Copyright (c) 2016 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef WEBRTC_MODULES_AUDIO_PROCESSING_SUBMODULE_PROFILER_H_
+#define WEBRTC_MODULES_AUDIO_PROCESSING_SUBMODULE_PROFILER_H_
+
+#include <vector>
+
+#include "webrtc/modules/audio_processing/include/audio_processing.h"
+#include "webrtc/typedefs.h"
+
+namespace webrtc {
+
+// Accumulates the time spent in each step of the capture processing. The steps
+// are timed as laps: StartFrame() starts the clock and every Lap() charges the
+// time since the previous lap to the given step, so that one clock read per
+// step is all it costs. Nothing is timed or allocated while disabled.
+class SubmoduleProfiler {
+ public:
+  // The steps of AudioProcessingImpl::ProcessStreamLocked(), in order.
+  enum Submodule {
+    kAgcManagerAnalysis,
+    kBandSplit,
+    kIntelligibility,
+    kBeamformer,
+    kHighPassFilter,
+    kGainControlAnalysis,
+    kNoiseSuppressionAnalysis,
+    kEchoCancellation,
+    kNoiseSuppression,
+    kEchoControlMobile,
+    kVoiceDetection,
+    kAgcManager,
+    kGainControl,
+    kBandMerge,
+    kTransientSuppressor,
+    kLevelEstimator,
+    kTotal,  // From StartFrame() to EndFrame().
+    kNumSubmodules
+  };
+
+  SubmoduleProfiler();
+  ~SubmoduleProfiler();
+
+  // Enabling clears the statistics.
+  void Enable(bool enable);
+  bool enabled() const { return enabled_; }
+
+  void StartFrame() {
+    if (enabled_) {
+      StartFrameEnabled();
+    }
+  }
+  void Lap(Submodule submodule) {
+    if (enabled_) {
+      LapEnabled(submodule);
+    }
+  }
+  void EndFrame() {
+    if (enabled_) {
+      EndFrameEnabled();
+    }
+  }
+
+  // Duration of |submodule| in the last frame, or -1 if it did not run.
+  int64_t last_frame_duration_ns(Submodule submodule) const {
+    return last_frame_durations_ns_[submodule];
+  }
+
+  // Appends the statistics of the submodules that have run at least once.
+  void GetTimings(std::vector<AudioProcessing::SubmoduleTiming>* timings) const;
+
+  static const char* Name(Submodule submodule);
+
+ private:
+  // 8 histogram buckets per octave of durations, up to about a minute.
+  static const int kBucketsPerOctave = 8;
+  static const int kNumOctaves = 34;
+  static const size_t kNumBuckets = kBucketsPerOctave * kNumOctaves;
+
+  struct Stats {
+    int num_calls;
+    uint64_t total_ns;
+    uint64_t min_ns;
+    uint64_t max_ns;
+  };
+
+  static size_t BucketIndex(uint64_t duration_ns);
+  static uint64_t BucketUpperBound(size_t index);
+
+  void StartFrameEnabled();
+  void LapEnabled(Submodule submodule);
+  void EndFrameEnabled();
+  void Add(Submodule submodule, uint64_t duration_ns);
+  uint64_t Percentile(Submodule submodule, float fraction) const;
+
+  bool enabled_;
+  uint64_t frame_start_ns_;
+  uint64_t lap_start_ns_;
+  int64_t last_frame_durations_ns_[kNumSubmodules];
+  Stats stats_[kNumSubmodules];
+  // |kNumBuckets| counts per submodule, only allocated while enabled.
+  std::vector<uint32_t> histograms_;
+};
+
+}  // namespace webrtc
+
+#endif  // WEBRTC_MODULES_AUDIO_PROCESSING_SUBMODULE_PROFILER_H_
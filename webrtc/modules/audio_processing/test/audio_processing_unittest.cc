@@ -10,6 +10,7 @@
 
 #include <math.h>
 #include <stdio.h>
+#include <string.h>
 #include <algorithm>
 #include <limits>
 #include <queue>
@@ -1544,6 +1545,91 @@ TEST_F(ApmTest, AllProcessingDisabledByDefault) {
   EXPECT_FALSE(apm_->voice_detection()->is_enabled());
 }
 
+TEST_F(ApmTest, SubmoduleTimings) {
+  std::vector<AudioProcessing::SubmoduleTiming> timings;
+  EXPECT_EQ(apm_->kNotEnabledError, apm_->GetSubmoduleTimings(&timings));
+
+  Config config;
+  config.Set<SubmoduleProfiling>(new SubmoduleProfiling(true));
+  apm_->SetExtraOptions(config);
+  EnableAllComponents();
+  const int kNumFrames = 100;
+  for (int i = 0; i < kNumFrames; ++i) {
+    SetFrameTo(frame_, 1000);
+    ProcessWithDefaultStreamParameters(frame_);
+  }
+
+  EXPECT_EQ(apm_->kNoError, apm_->GetSubmoduleTimings(&timings));
+  ASSERT_FALSE(timings.empty());
+  EXPECT_STREQ("total", timings.back().name);
+  bool echo_cancellation_timed = false;
+  for (const auto& timing : timings) {
+    EXPECT_EQ(kNumFrames, timing.num_calls) << timing.name;
+    EXPECT_LE(timing.min_ns, timing.mean_ns) << timing.name;
+    EXPECT_LE(timing.mean_ns, timing.max_ns) << timing.name;
+    EXPECT_LE(timing.min_ns, timing.p99_ns) << timing.name;
+    EXPECT_LE(timing.p99_ns, timing.max_ns) << timing.name;
+    EXPECT_LE(timing.mean_ns, timings.back().mean_ns) << timing.name;
+    echo_cancellation_timed |= strcmp("echo_cancellation", timing.name) == 0;
+  }
+  EXPECT_TRUE(echo_cancellation_timed);
+
+  // Enabling it again starts over.
+  apm_->SetExtraOptions(Config());
+  EXPECT_EQ(apm_->kNotEnabledError, apm_->GetSubmoduleTimings(&timings));
+  apm_->SetExtraOptions(config);
+  EXPECT_EQ(apm_->kNoError, apm_->GetSubmoduleTimings(&timings));
+  EXPECT_TRUE(timings.empty());
+}
+
+TEST_F(ApmTest, SilentFrameSkipping) {
+  Config config;
+  config.Set<SilentFrameSkipping>(new SilentFrameSkipping(true));
+  apm_->SetExtraOptions(config);
+  EnableAllComponents();
+
+  // Silence on both sides is skipped after a while, and stays silent.
+  const int kNumFrames = 100;
+  SetFrameTo(frame_, 0);
+  AudioFrame silent_frame;
+  silent_frame.CopyFrom(*frame_);
+  for (int i = 0; i < kNumFrames; ++i) {
+    SetFrameTo(revframe_, 0);
+    EXPECT_EQ(apm_->kNoError, apm_->ProcessReverseStream(revframe_));
+    SetFrameTo(frame_, 0);
+    ProcessWithDefaultStreamParameters(frame_);
+    EXPECT_TRUE(FrameDataAreEqual(silent_frame, *frame_)) << i;
+  }
+  const size_t num_skipped = apm_->num_skipped_silent_frames();
+  EXPECT_GT(num_skipped, 0u);
+  EXPECT_LT(num_skipped, static_cast<size_t>(kNumFrames));
+  EXPECT_FALSE(apm_->voice_detection()->stream_has_voice());
+  EXPECT_EQ(AudioFrame::kVadPassive, frame_->vad_activity_);
+
+  // Sound on the near-end is processed right away.
+  SetFrameTo(revframe_, 0);
+  EXPECT_EQ(apm_->kNoError, apm_->ProcessReverseStream(revframe_));
+  SetFrameTo(frame_, 1000);
+  ProcessWithDefaultStreamParameters(frame_);
+  EXPECT_EQ(num_skipped, apm_->num_skipped_silent_frames());
+
+  // As is a silent near-end while the far-end is talking.
+  SetFrameTo(revframe_, 1000);
+  EXPECT_EQ(apm_->kNoError, apm_->ProcessReverseStream(revframe_));
+  for (int i = 0; i < kNumFrames; ++i) {
+    SetFrameTo(frame_, 0);
+    ProcessWithDefaultStreamParameters(frame_);
+  }
+  EXPECT_EQ(num_skipped, apm_->num_skipped_silent_frames());
+
+  // Without echo control the far-end does not matter.
+  EXPECT_EQ(apm_->kNoError, apm_->echo_cancellation()->Enable(false));
+  EXPECT_EQ(apm_->kNoError, apm_->echo_control_mobile()->Enable(false));
+  SetFrameTo(frame_, 0);
+  ProcessWithDefaultStreamParameters(frame_);
+  EXPECT_EQ(num_skipped + 1, apm_->num_skipped_silent_frames());
+}
+
 TEST_F(ApmTest, NoProcessingWhenAllComponentsDisabled) {
   for (size_t i = 0; i < arraysize(kSampleRates); i++) {
     Init(kSampleRates[i], kSampleRates[i], kSampleRates[i], 2, 2, 2, false);
@@ -29,31 +29,33 @@
 // accumulated to get the downsampled bands.
 //
 // A similar logic can be applied to the synthesis stage.
+//
+// All filters of one phase see the same input with a different delay, so the
+// filtering and the modulation of a frame run as one pass over it, with all
+// the filter outputs of a sample (or of a vector of them) kept in registers.
+// The generic kernels do the same arithmetic, in the same order, as filtering
+// with a SparseFIRFilter per polyphase branch and modulating its output
+// afterwards.
 
 // MSVC++ requires this to be set before any other includes to get M_PI.
 #define _USE_MATH_DEFINES
 
 #include "webrtc/modules/audio_processing/three_band_filter_bank.h"
 
+#include <algorithm>
 #include <cmath>
 
 #include "webrtc/base/checks.h"
+#include "webrtc/system_wrappers/include/cpu_features_wrapper.h"
 
 namespace webrtc {
 namespace {
 
-const size_t kNumBands = 3;
-const size_t kSparsity = 4;
-
-// Factors to take into account when choosing |kNumCoeffs|:
-//   1. Higher |kNumCoeffs|, means faster transition, which ensures less
-//      aliasing. This is especially important when there is non-linear
-//      processing between the splitting and merging.
-//   2. The delay that this filter bank introduces is
-//      |kNumBands| * |kSparsity| * |kNumCoeffs| / 2, so it increases linearly
-//      with |kNumCoeffs|.
-//   3. The computation complexity also increases linearly with |kNumCoeffs|.
-const size_t kNumCoeffs = 4;
+const size_t kNumBands = ThreeBandFilterBank::kNumBands;
+const size_t kSparsity = ThreeBandFilterBank::kSparsity;
+const size_t kNumCoeffs = ThreeBandFilterBank::kNumCoeffs;
+const size_t kNumFilters = ThreeBandFilterBank::kNumFilters;
+const size_t kStateLength = ThreeBandFilterBank::kStateLength;
 
 // The Matlab code to generate these |kLowpassCoeffs| is:
 //
@@ -68,7 +70,10 @@ const size_t kNumCoeffs = 4;
 // A Kaiser window is used because of its flexibility and the alpha is set to
 // 3.5, since that sets a stop band attenuation of 40dB ensuring a fast
 // transition.
-const float kLowpassCoeffs[kNumBands * kSparsity][kNumCoeffs] =
+//
+// Row |i| + |j| * |kNumBands| is the filter of phase |i| delayed by |j|
+// samples.
+const float kLowpassCoeffs[kNumFilters][kNumCoeffs] =
     {{-0.00047749f, -0.00496888f, +0.16547118f, +0.00425496f},
      {-0.00173287f, -0.01585778f, +0.14989004f, +0.00994113f},
      {-0.00304815f, -0.02536082f, +0.12154542f, +0.01157993f},
@@ -82,51 +87,56 @@ const float kLowpassCoeffs[kNumBands * kSparsity][kNumCoeffs] =
      {+0.00994113f, +0.14989004f, -0.01585778f, -0.00173287f},
      {+0.00425496f, +0.16547118f, -0.00496888f, -0.00047749f}};
 
-// Downsamples |in| into |out|, taking one every |kNumbands| starting from
-// |offset|. |split_length| is the |out| length. |in| has to be at least
-// |kNumBands| * |split_length| long.
-void Downsample(const float* in,
-                size_t split_length,
-                size_t offset,
-                float* out) {
-  for (size_t i = 0; i < split_length; ++i) {
-    out[i] = in[kNumBands * i + offset];
-  }
-}
-
-// Upsamples |in| into |out|, scaling by |kNumBands| and accumulating it every
-// |kNumBands| starting from |offset|. |split_length| is the |in| length. |out|
-// has to be at least |kNumBands| * |split_length| long.
-void Upsample(const float* in, size_t split_length, size_t offset, float* out) {
-  for (size_t i = 0; i < split_length; ++i) {
-    out[kNumBands * i + offset] += kNumBands * in[i];
-  }
-}
-
 }  // namespace
 
+const size_t ThreeBandFilterBank::kNumBands;
+const size_t ThreeBandFilterBank::kSparsity;
+const size_t ThreeBandFilterBank::kNumCoeffs;
+const size_t ThreeBandFilterBank::kNumFilters;
+const size_t ThreeBandFilterBank::kStateLength;
+
 // Because the low-pass filter prototype has half bandwidth it is possible to
 // use a DCT to shift it in both directions at the same time, to the center
 // frequencies [1 / 12, 3 / 12, 5 / 12].
 ThreeBandFilterBank::ThreeBandFilterBank(size_t length)
-    : in_buffer_(rtc::CheckedDivExact(length, kNumBands)),
-      out_buffer_(in_buffer_.size()) {
-  for (size_t i = 0; i < kSparsity; ++i) {
+    : split_length_(rtc::CheckedDivExact(length, kNumBands)),
+      analysis_kernel_(AnalysisC),
+      synthesis_kernel_(SynthesisC),
+      analysis_state_(kNumBands * (kStateLength + split_length_), 0.f),
+      synthesis_state_(kNumFilters * (kStateLength + split_length_), 0.f),
+      synthesis_out_(kNumBands * split_length_) {
+  for (size_t i = 0; i < kNumFilters; ++i) {
     for (size_t j = 0; j < kNumBands; ++j) {
-      analysis_filters_.push_back(new SparseFIRFilter(
-          kLowpassCoeffs[i * kNumBands + j], kNumCoeffs, kSparsity, i));
-      synthesis_filters_.push_back(new SparseFIRFilter(
-          kLowpassCoeffs[i * kNumBands + j], kNumCoeffs, kSparsity, i));
+      modulation_[i * kNumBands + j] =
+          2.f * cos(2.f * M_PI * i * (2.f * j + 1.f) / kNumFilters);
     }
   }
-  dct_modulation_.resize(kNumBands * kSparsity);
-  for (size_t i = 0; i < dct_modulation_.size(); ++i) {
-    dct_modulation_[i].resize(kNumBands);
-    for (size_t j = 0; j < kNumBands; ++j) {
-      dct_modulation_[i][j] =
-          2.f * cos(2.f * M_PI * i * (2.f * j + 1.f) / dct_modulation_.size());
-    }
+  for (size_t i = 0; i < kNumBands; ++i) {
+    analysis_in_[i] = &analysis_state_[i * (kStateLength + split_length_)];
+    synthesis_phases_[i] = &synthesis_out_[i * split_length_];
+  }
+  for (size_t i = 0; i < kNumFilters; ++i) {
+    synthesis_modulated_[i] =
+        &synthesis_state_[i * (kStateLength + split_length_)];
+  }
+
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+  if (WebRtc_GetCPUInfo(kAVX2)) {
+    analysis_kernel_ = AnalysisAVX2;
+    synthesis_kernel_ = SynthesisAVX2;
+  } else if (WebRtc_GetCPUInfo(kSSE2)) {
+    analysis_kernel_ = AnalysisSSE2;
+    synthesis_kernel_ = SynthesisSSE2;
   }
+#elif defined(WEBRTC_HAS_NEON)
+  analysis_kernel_ = AnalysisNEON;
+  synthesis_kernel_ = SynthesisNEON;
+#elif defined(WEBRTC_DETECT_NEON)
+  if ((WebRtc_GetCPUFeaturesARM() & kCPUFeatureNEON) != 0) {
+    analysis_kernel_ = AnalysisNEON;
+    synthesis_kernel_ = SynthesisNEON;
+  }
+#endif
 }
 
 // The analysis can be separated in these steps:
@@ -135,23 +145,21 @@ ThreeBandFilterBank::ThreeBandFilterBank(size_t length)
 //      decomposition of the low-pass prototype filter and upsampled by a factor
 //      of |kSparsity|.
 //   3. Modulating with cosines and accumulating to get the desired band.
+// The kernels do the last two steps.
 void ThreeBandFilterBank::Analysis(const float* in,
                                    size_t length,
                                    float* const* out) {
-  RTC_CHECK_EQ(in_buffer_.size(), rtc::CheckedDivExact(length, kNumBands));
-  for (size_t i = 0; i < kNumBands; ++i) {
-    memset(out[i], 0, in_buffer_.size() * sizeof(*out[i]));
-  }
+  RTC_CHECK_EQ(split_length_, rtc::CheckedDivExact(length, kNumBands));
   for (size_t i = 0; i < kNumBands; ++i) {
-    Downsample(in, in_buffer_.size(), kNumBands - i - 1, &in_buffer_[0]);
-    for (size_t j = 0; j < kSparsity; ++j) {
-      const size_t offset = i + j * kNumBands;
-      analysis_filters_[offset]->Filter(&in_buffer_[0],
-                                        in_buffer_.size(),
-                                        &out_buffer_[0]);
-      DownModulate(&out_buffer_[0], out_buffer_.size(), offset, out);
+    float* phase = &analysis_in_[i][kStateLength];
+    const float* in_phase = &in[kNumBands - i - 1];
+    for (size_t j = 0; j < split_length_; ++j) {
+      phase[j] = in_phase[kNumBands * j];
     }
   }
+  analysis_kernel_(analysis_in_, split_length_, &kLowpassCoeffs[0][0],
+                   modulation_, out);
+  UpdateState(analysis_in_, kNumBands);
 }
 
 // The synthesis can be separated in these steps:
@@ -160,52 +168,142 @@ void ThreeBandFilterBank::Analysis(const float* in,
 //      prototype filter upsampled by a factor of |kSparsity| and accumulating
 //      |kSparsity| signals with different delays.
 //   3. Parallel to serial upsampling by a factor of |kNumBands|.
+// The kernels do the first two steps.
 void ThreeBandFilterBank::Synthesis(const float* const* in,
                                     size_t split_length,
                                     float* out) {
-  RTC_CHECK_EQ(in_buffer_.size(), split_length);
-  memset(out, 0, kNumBands * in_buffer_.size() * sizeof(*out));
+  RTC_CHECK_EQ(split_length_, split_length);
+  synthesis_kernel_(in, split_length_, &kLowpassCoeffs[0][0], modulation_,
+                    synthesis_modulated_, synthesis_phases_);
+  UpdateState(synthesis_modulated_, kNumFilters);
   for (size_t i = 0; i < kNumBands; ++i) {
-    for (size_t j = 0; j < kSparsity; ++j) {
-      const size_t offset = i + j * kNumBands;
-      UpModulate(in, in_buffer_.size(), offset, &in_buffer_[0]);
-      synthesis_filters_[offset]->Filter(&in_buffer_[0],
-                                         in_buffer_.size(),
-                                         &out_buffer_[0]);
-      Upsample(&out_buffer_[0], out_buffer_.size(), i, out);
+    const float* phase = synthesis_phases_[i];
+    float* out_phase = &out[i];
+    for (size_t j = 0; j < split_length_; ++j) {
+      out_phase[kNumBands * j] = phase[j];
+    }
+  }
+}
+
+void ThreeBandFilterBank::Reset() {
+  std::fill(analysis_state_.begin(), analysis_state_.end(), 0.f);
+  std::fill(synthesis_state_.begin(), synthesis_state_.end(), 0.f);
+}
+
+// Filters each phase of |in| with its |kSparsity| filters and accumulates
+// their outputs, modulated by |modulation|, in each of the |kNumBands| bands
+// of |out|.
+void ThreeBandFilterBank::AnalysisC(const float* const* in,
+                                    size_t split_length,
+                                    const float* coeffs,
+                                    const float* modulation,
+                                    float* const* out) {
+  for (size_t n = 0; n < split_length; ++n) {
+    float bands[kNumBands] = {0.f};
+    for (size_t i = 0; i < kNumBands; ++i) {
+      const float* phase = &in[i][kStateLength + n];
+      for (size_t j = 0; j < kSparsity; ++j) {
+        const size_t offset = i + j * kNumBands;
+        const float* filter = &coeffs[offset * kNumCoeffs];
+        float filtered = 0.f;
+        for (size_t k = 0; k < kNumCoeffs; ++k) {
+          filtered += *(phase - j - k * kSparsity) * filter[k];
+        }
+        for (size_t b = 0; b < kNumBands; ++b) {
+          bands[b] += modulation[offset * kNumBands + b] * filtered;
+        }
+      }
+    }
+    for (size_t b = 0; b < kNumBands; ++b) {
+      out[b][n] = bands[b];
     }
   }
 }
 
+// Modulates the |kNumBands| bands of |in| into the input of each filter in
+// |modulated|, then filters those and accumulates them, scaled by |kNumBands|,
+// in each of the |kNumBands| phases of |out|.
+void ThreeBandFilterBank::SynthesisC(const float* const* in,
+                                     size_t split_length,
+                                     const float* coeffs,
+                                     const float* modulation,
+                                     float* const* modulated,
+                                     float* const* out) {
+  for (size_t i = 0; i < kNumFilters; ++i) {
+    const float* factors = &modulation[i * kNumBands];
+    for (size_t n = 0; n < split_length; ++n) {
+      float sum = 0.f;
+      for (size_t b = 0; b < kNumBands; ++b) {
+        sum += factors[b] * in[b][n];
+      }
+      modulated[i][kStateLength + n] = sum;
+    }
+  }
+  for (size_t n = 0; n < split_length; ++n) {
+    for (size_t i = 0; i < kNumBands; ++i) {
+      float sum = 0.f;
+      for (size_t j = 0; j < kSparsity; ++j) {
+        const size_t offset = i + j * kNumBands;
+        const float* filter = &coeffs[offset * kNumCoeffs];
+        const float* filter_in = &modulated[offset][kStateLength + n];
+        float filtered = 0.f;
+        for (size_t k = 0; k < kNumCoeffs; ++k) {
+          filtered += *(filter_in - j - k * kSparsity) * filter[k];
+        }
+        sum += kNumBands * filtered;
+      }
+      out[i][n] = sum;
+    }
+  }
+}
 
-// Modulates |in| by |dct_modulation_| and accumulates it in each of the
-// |kNumBands| bands of |out|. |offset| is the index in the period of the
-// cosines used for modulation. |split_length| is the length of |in| and each
-// band of |out|.
-void ThreeBandFilterBank::DownModulate(const float* in,
+void ThreeBandFilterBank::AnalysisTail(const float* const* in,
                                        size_t split_length,
-                                       size_t offset,
+                                       size_t start,
+                                       const float* coeffs,
+                                       const float* modulation,
                                        float* const* out) {
+  if (start >= split_length) {
+    return;
+  }
+  const float* in_tail[kNumBands];
+  float* out_tail[kNumBands];
   for (size_t i = 0; i < kNumBands; ++i) {
-    for (size_t j = 0; j < split_length; ++j) {
-      out[i][j] += dct_modulation_[offset][i] * in[j];
-    }
+    in_tail[i] = in[i] + start;
+    out_tail[i] = out[i] + start;
   }
+  AnalysisC(in_tail, split_length - start, coeffs, modulation, out_tail);
 }
 
-// Modulates each of the |kNumBands| bands of |in| by |dct_modulation_| and
-// accumulates them in |out|. |out| is cleared before starting to accumulate.
-// |offset| is the index in the period of the cosines used for modulation.
-// |split_length| is the length of each band of |in| and |out|.
-void ThreeBandFilterBank::UpModulate(const float* const* in,
-                                     size_t split_length,
-                                     size_t offset,
-                                     float* out) {
-  memset(out, 0, split_length * sizeof(*out));
+void ThreeBandFilterBank::SynthesisTail(const float* const* in,
+                                        size_t split_length,
+                                        size_t start,
+                                        const float* coeffs,
+                                        const float* modulation,
+                                        float* const* modulated,
+                                        float* const* out) {
+  if (start >= split_length) {
+    return;
+  }
+  const float* in_tail[kNumBands];
+  float* out_tail[kNumBands];
+  float* modulated_tail[kNumFilters];
   for (size_t i = 0; i < kNumBands; ++i) {
-    for (size_t j = 0; j < split_length; ++j) {
-      out[j] += dct_modulation_[offset][i] * in[i][j];
-    }
+    in_tail[i] = in[i] + start;
+    out_tail[i] = out[i] + start;
+  }
+  for (size_t i = 0; i < kNumFilters; ++i) {
+    modulated_tail[i] = modulated[i] + start;
+  }
+  SynthesisC(in_tail, split_length - start, coeffs, modulation,
+             modulated_tail, out_tail);
+}
+
+void ThreeBandFilterBank::UpdateState(float* const* buffers,
+                                      size_t num_buffers) {
+  for (size_t i = 0; i < num_buffers; ++i) {
+    memmove(buffers[i], &buffers[i][split_length_],
+            kStateLength * sizeof(buffers[i][0]));
   }
 }
 
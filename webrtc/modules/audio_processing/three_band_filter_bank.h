@@ -14,8 +14,7 @@
 #include <cstring>
 #include <vector>
 
-#include "webrtc/common_audio/sparse_fir_filter.h"
-#include "webrtc/system_wrappers/include/scoped_vector.h"
+#include "webrtc/typedefs.h"
 
 namespace webrtc {
 
@@ -34,6 +33,22 @@ namespace webrtc {
 // depending on the input signal after compensating for the delay.
 class ThreeBandFilterBank final {
  public:
+  static const size_t kNumBands = 3;
+  static const size_t kSparsity = 4;
+  // Factors to take into account when choosing |kNumCoeffs|:
+  //   1. Higher |kNumCoeffs|, means faster transition, which ensures less
+  //      aliasing. This is especially important when there is non-linear
+  //      processing between the splitting and merging.
+  //   2. The delay that this filter bank introduces is
+  //      |kNumBands| * |kSparsity| * |kNumCoeffs| / 2, so it increases
+  //      linearly with |kNumCoeffs|.
+  //   3. The computation complexity also increases linearly with |kNumCoeffs|.
+  static const size_t kNumCoeffs = 4;
+  // One polyphase filter per band phase and delay.
+  static const size_t kNumFilters = kNumBands * kSparsity;
+  // The filters reach back this many samples into the previous frames.
+  static const size_t kStateLength = kSparsity * kNumCoeffs - 1;
+
   explicit ThreeBandFilterBank(size_t length);
 
   // Splits |in| into 3 downsampled frequency bands in |out|.
@@ -46,21 +61,109 @@ class ThreeBandFilterBank final {
   // least a length of 3 * |split_length|.
   void Synthesis(const float* const* in, size_t split_length, float* out);
 
+  // Clears the filter states, as if newly constructed.
+  void Reset();
+
  private:
-  void DownModulate(const float* in,
-                    size_t split_length,
-                    size_t offset,
-                    float* const* out);
-  void UpModulate(const float* const* in,
-                  size_t split_length,
-                  size_t offset,
-                  float* out);
-
-  std::vector<float> in_buffer_;
-  std::vector<float> out_buffer_;
-  ScopedVector<SparseFIRFilter> analysis_filters_;
-  ScopedVector<SparseFIRFilter> synthesis_filters_;
-  std::vector<std::vector<float>> dct_modulation_;
+  // The kernels run the filters and the modulation of a whole frame in one
+  // pass on deinterleaved data, see three_band_filter_bank.cc. Each buffer of
+  // |in| and |modulated| starts with the last |kStateLength| samples of the
+  // previous frame. |coeffs| holds the |kNumCoeffs| coefficients of each
+  // filter and |modulation| its |kNumBands| modulation factors.
+  typedef void (*AnalysisKernel)(const float* const* in,
+                                 size_t split_length,
+                                 const float* coeffs,
+                                 const float* modulation,
+                                 float* const* out);
+  typedef void (*SynthesisKernel)(const float* const* in,
+                                  size_t split_length,
+                                  const float* coeffs,
+                                  const float* modulation,
+                                  float* const* modulated,
+                                  float* const* out);
+
+  static void AnalysisC(const float* const* in,
+                        size_t split_length,
+                        const float* coeffs,
+                        const float* modulation,
+                        float* const* out);
+  static void SynthesisC(const float* const* in,
+                         size_t split_length,
+                         const float* coeffs,
+                         const float* modulation,
+                         float* const* modulated,
+                         float* const* out);
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+  static void AnalysisSSE2(const float* const* in,
+                           size_t split_length,
+                           const float* coeffs,
+                           const float* modulation,
+                           float* const* out);
+  static void SynthesisSSE2(const float* const* in,
+                            size_t split_length,
+                            const float* coeffs,
+                            const float* modulation,
+                            float* const* modulated,
+                            float* const* out);
+  static void AnalysisAVX2(const float* const* in,
+                           size_t split_length,
+                           const float* coeffs,
+                           const float* modulation,
+                           float* const* out);
+  static void SynthesisAVX2(const float* const* in,
+                            size_t split_length,
+                            const float* coeffs,
+                            const float* modulation,
+                            float* const* modulated,
+                            float* const* out);
+#endif
+#if defined(WEBRTC_HAS_NEON) || defined(WEBRTC_DETECT_NEON)
+  static void AnalysisNEON(const float* const* in,
+                           size_t split_length,
+                           const float* coeffs,
+                           const float* modulation,
+                           float* const* out);
+  static void SynthesisNEON(const float* const* in,
+                            size_t split_length,
+                            const float* coeffs,
+                            const float* modulation,
+                            float* const* modulated,
+                            float* const* out);
+#endif
+
+  // Runs the generic kernels from sample |start| on, for the samples the
+  // SIMD kernels leave over.
+  static void AnalysisTail(const float* const* in,
+                           size_t split_length,
+                           size_t start,
+                           const float* coeffs,
+                           const float* modulation,
+                           float* const* out);
+  static void SynthesisTail(const float* const* in,
+                            size_t split_length,
+                            size_t start,
+                            const float* coeffs,
+                            const float* modulation,
+                            float* const* modulated,
+                            float* const* out);
+
+  // Keeps the last |kStateLength| samples of each buffer in front of it for
+  // the next frame.
+  void UpdateState(float* const* buffers, size_t num_buffers);
+
+  const size_t split_length_;
+  AnalysisKernel analysis_kernel_;
+  SynthesisKernel synthesis_kernel_;
+  float modulation_[kNumFilters * kNumBands];
+  // The input of the analysis split in its |kNumBands| phases.
+  std::vector<float> analysis_state_;
+  float* analysis_in_[kNumBands];
+  // The input of each synthesis filter, and the output of the synthesis in
+  // its |kNumBands| phases.
+  std::vector<float> synthesis_state_;
+  float* synthesis_modulated_[kNumFilters];
+  std::vector<float> synthesis_out_;
+  float* synthesis_phases_[kNumBands];
 };
 
 }  // namespace webrtc
@@ -0,0 +1,102 @@
+/*
+ *  Copyright (c) 2016 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+// The filter bank kernels on eight samples at a time. Built with FMA enabled,
+// so the compiler may fuse some of the multiplies and adds.
+
+#include "webrtc/modules/audio_processing/three_band_filter_bank.h"
+
+#include <immintrin.h>
+
+namespace webrtc {
+
+void ThreeBandFilterBank::AnalysisAVX2(const float* const* in,
+                                       size_t split_length,
+                                       const float* coeffs,
+                                       const float* modulation,
+                                       float* const* out) {
+  const size_t vector_length = split_length & ~static_cast<size_t>(7);
+  for (size_t n = 0; n < vector_length; n += 8) {
+    __m256 bands[kNumBands];
+    for (size_t b = 0; b < kNumBands; ++b) {
+      bands[b] = _mm256_setzero_ps();
+    }
+    for (size_t i = 0; i < kNumBands; ++i) {
+      const float* phase = &in[i][kStateLength + n];
+      for (size_t j = 0; j < kSparsity; ++j) {
+        const size_t offset = i + j * kNumBands;
+        const float* filter = &coeffs[offset * kNumCoeffs];
+        __m256 filtered = _mm256_setzero_ps();
+        for (size_t k = 0; k < kNumCoeffs; ++k) {
+          filtered = _mm256_add_ps(
+              filtered,
+              _mm256_mul_ps(_mm256_loadu_ps(phase - j - k * kSparsity),
+                            _mm256_broadcast_ss(&filter[k])));
+        }
+        for (size_t b = 0; b < kNumBands; ++b) {
+          bands[b] = _mm256_add_ps(
+              bands[b], _mm256_mul_ps(_mm256_broadcast_ss(
+                                          &modulation[offset * kNumBands + b]),
+                                      filtered));
+        }
+      }
+    }
+    for (size_t b = 0; b < kNumBands; ++b) {
+      _mm256_storeu_ps(&out[b][n], bands[b]);
+    }
+  }
+  AnalysisTail(in, split_length, vector_length, coeffs, modulation, out);
+}
+
+void ThreeBandFilterBank::SynthesisAVX2(const float* const* in,
+                                        size_t split_length,
+                                        const float* coeffs,
+                                        const float* modulation,
+                                        float* const* modulated,
+                                        float* const* out) {
+  const size_t vector_length = split_length & ~static_cast<size_t>(7);
+  for (size_t i = 0; i < kNumFilters; ++i) {
+    const float* factors = &modulation[i * kNumBands];
+    float* filter_in = &modulated[i][kStateLength];
+    for (size_t n = 0; n < vector_length; n += 8) {
+      __m256 sum = _mm256_setzero_ps();
+      for (size_t b = 0; b < kNumBands; ++b) {
+        sum = _mm256_add_ps(sum,
+                            _mm256_mul_ps(_mm256_broadcast_ss(&factors[b]),
+                                          _mm256_loadu_ps(&in[b][n])));
+      }
+      _mm256_storeu_ps(&filter_in[n], sum);
+    }
+  }
+  const __m256 scale = _mm256_set1_ps(kNumBands);
+  for (size_t n = 0; n < vector_length; n += 8) {
+    for (size_t i = 0; i < kNumBands; ++i) {
+      __m256 sum = _mm256_setzero_ps();
+      for (size_t j = 0; j < kSparsity; ++j) {
+        const size_t offset = i + j * kNumBands;
+        const float* filter = &coeffs[offset * kNumCoeffs];
+        const float* filter_in = &modulated[offset][kStateLength + n];
+        __m256 filtered = _mm256_setzero_ps();
+        for (size_t k = 0; k < kNumCoeffs; ++k) {
+          filtered = _mm256_add_ps(
+              filtered,
+              _mm256_mul_ps(_mm256_loadu_ps(filter_in - j - k * kSparsity),
+                            _mm256_broadcast_ss(&filter[k])));
+        }
+        sum = _mm256_add_ps(sum, _mm256_mul_ps(scale, filtered));
+      }
+      _mm256_storeu_ps(&out[i][n], sum);
+    }
+  }
+  SynthesisTail(in, split_length, vector_length, coeffs, modulation,
+                modulated, out);
+}
+
+}  // namespace webrtc
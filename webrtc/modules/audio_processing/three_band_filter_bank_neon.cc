@@ -0,0 +1,95 @@
+/*
+ *  Copyright (c) 2016 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+// The filter bank kernels on four samples at a time.
+
+#include "webrtc/modules/audio_processing/three_band_filter_bank.h"
+
+#include <arm_neon.h>
+
+namespace webrtc {
+
+void ThreeBandFilterBank::AnalysisNEON(const float* const* in,
+                                       size_t split_length,
+                                       const float* coeffs,
+                                       const float* modulation,
+                                       float* const* out) {
+  const size_t vector_length = split_length & ~static_cast<size_t>(3);
+  for (size_t n = 0; n < vector_length; n += 4) {
+    float32x4_t bands[kNumBands];
+    for (size_t b = 0; b < kNumBands; ++b) {
+      bands[b] = vdupq_n_f32(0.f);
+    }
+    for (size_t i = 0; i < kNumBands; ++i) {
+      const float* phase = &in[i][kStateLength + n];
+      for (size_t j = 0; j < kSparsity; ++j) {
+        const size_t offset = i + j * kNumBands;
+        const float* filter = &coeffs[offset * kNumCoeffs];
+        float32x4_t filtered = vdupq_n_f32(0.f);
+        for (size_t k = 0; k < kNumCoeffs; ++k) {
+          filtered = vmlaq_f32(filtered, vld1q_f32(phase - j - k * kSparsity),
+                               vld1q_dup_f32(&filter[k]));
+        }
+        for (size_t b = 0; b < kNumBands; ++b) {
+          bands[b] = vmlaq_f32(
+              bands[b], vld1q_dup_f32(&modulation[offset * kNumBands + b]),
+              filtered);
+        }
+      }
+    }
+    for (size_t b = 0; b < kNumBands; ++b) {
+      vst1q_f32(&out[b][n], bands[b]);
+    }
+  }
+  AnalysisTail(in, split_length, vector_length, coeffs, modulation, out);
+}
+
+void ThreeBandFilterBank::SynthesisNEON(const float* const* in,
+                                        size_t split_length,
+                                        const float* coeffs,
+                                        const float* modulation,
+                                        float* const* modulated,
+                                        float* const* out) {
+  const size_t vector_length = split_length & ~static_cast<size_t>(3);
+  for (size_t i = 0; i < kNumFilters; ++i) {
+    const float* factors = &modulation[i * kNumBands];
+    float* filter_in = &modulated[i][kStateLength];
+    for (size_t n = 0; n < vector_length; n += 4) {
+      float32x4_t sum = vdupq_n_f32(0.f);
+      for (size_t b = 0; b < kNumBands; ++b) {
+        sum = vmlaq_f32(sum, vld1q_dup_f32(&factors[b]), vld1q_f32(&in[b][n]));
+      }
+      vst1q_f32(&filter_in[n], sum);
+    }
+  }
+  const float32x4_t scale = vdupq_n_f32(kNumBands);
+  for (size_t n = 0; n < vector_length; n += 4) {
+    for (size_t i = 0; i < kNumBands; ++i) {
+      float32x4_t sum = vdupq_n_f32(0.f);
+      for (size_t j = 0; j < kSparsity; ++j) {
+        const size_t offset = i + j * kNumBands;
+        const float* filter = &coeffs[offset * kNumCoeffs];
+        const float* filter_in = &modulated[offset][kStateLength + n];
+        float32x4_t filtered = vdupq_n_f32(0.f);
+        for (size_t k = 0; k < kNumCoeffs; ++k) {
+          filtered =
+              vmlaq_f32(filtered, vld1q_f32(filter_in - j - k * kSparsity),
+                        vld1q_dup_f32(&filter[k]));
+        }
+        sum = vmlaq_f32(sum, scale, filtered);
+      }
+      vst1q_f32(&out[i][n], sum);
+    }
+  }
+  SynthesisTail(in, split_length, vector_length, coeffs, modulation,
+                modulated, out);
+}
+
+}  // namespace webrtc
@@ -0,0 +1,99 @@
+/*
+ *  Copyright (c) 2016 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+// The filter bank kernels on four samples at a time, with the same arithmetic
+// as the generic ones.
+
+#include "webrtc/modules/audio_processing/three_band_filter_bank.h"
+
+#include <xmmintrin.h>
+
+namespace webrtc {
+
+void ThreeBandFilterBank::AnalysisSSE2(const float* const* in,
+                                       size_t split_length,
+                                       const float* coeffs,
+                                       const float* modulation,
+                                       float* const* out) {
+  const size_t vector_length = split_length & ~static_cast<size_t>(3);
+  for (size_t n = 0; n < vector_length; n += 4) {
+    __m128 bands[kNumBands];
+    for (size_t b = 0; b < kNumBands; ++b) {
+      bands[b] = _mm_setzero_ps();
+    }
+    for (size_t i = 0; i < kNumBands; ++i) {
+      const float* phase = &in[i][kStateLength + n];
+      for (size_t j = 0; j < kSparsity; ++j) {
+        const size_t offset = i + j * kNumBands;
+        const float* filter = &coeffs[offset * kNumCoeffs];
+        __m128 filtered = _mm_setzero_ps();
+        for (size_t k = 0; k < kNumCoeffs; ++k) {
+          filtered = _mm_add_ps(
+              filtered, _mm_mul_ps(_mm_loadu_ps(phase - j - k * kSparsity),
+                                   _mm_load1_ps(&filter[k])));
+        }
+        for (size_t b = 0; b < kNumBands; ++b) {
+          bands[b] = _mm_add_ps(
+              bands[b],
+              _mm_mul_ps(_mm_load1_ps(&modulation[offset * kNumBands + b]),
+                         filtered));
+        }
+      }
+    }
+    for (size_t b = 0; b < kNumBands; ++b) {
+      _mm_storeu_ps(&out[b][n], bands[b]);
+    }
+  }
+  AnalysisTail(in, split_length, vector_length, coeffs, modulation, out);
+}
+
+void ThreeBandFilterBank::SynthesisSSE2(const float* const* in,
+                                        size_t split_length,
+                                        const float* coeffs,
+                                        const float* modulation,
+                                        float* const* modulated,
+                                        float* const* out) {
+  const size_t vector_length = split_length & ~static_cast<size_t>(3);
+  for (size_t i = 0; i < kNumFilters; ++i) {
+    const float* factors = &modulation[i * kNumBands];
+    float* filter_in = &modulated[i][kStateLength];
+    for (size_t n = 0; n < vector_length; n += 4) {
+      __m128 sum = _mm_setzero_ps();
+      for (size_t b = 0; b < kNumBands; ++b) {
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_load1_ps(&factors[b]),
+                                         _mm_loadu_ps(&in[b][n])));
+      }
+      _mm_storeu_ps(&filter_in[n], sum);
+    }
+  }
+  const __m128 scale = _mm_set1_ps(kNumBands);
+  for (size_t n = 0; n < vector_length; n += 4) {
+    for (size_t i = 0; i < kNumBands; ++i) {
+      __m128 sum = _mm_setzero_ps();
+      for (size_t j = 0; j < kSparsity; ++j) {
+        const size_t offset = i + j * kNumBands;
+        const float* filter = &coeffs[offset * kNumCoeffs];
+        const float* filter_in = &modulated[offset][kStateLength + n];
+        __m128 filtered = _mm_setzero_ps();
+        for (size_t k = 0; k < kNumCoeffs; ++k) {
+          filtered = _mm_add_ps(
+              filtered, _mm_mul_ps(_mm_loadu_ps(filter_in - j - k * kSparsity),
+                                   _mm_load1_ps(&filter[k])));
+        }
+        sum = _mm_add_ps(sum, _mm_mul_ps(scale, filtered));
+      }
+      _mm_storeu_ps(&out[i][n], sum);
+    }
+  }
+  SynthesisTail(in, split_length, vector_length, coeffs, modulation,
+                modulated, out);
+}
+
+}  // namespace webrtc
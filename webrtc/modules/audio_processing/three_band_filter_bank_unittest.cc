@@ -0,0 +1,116 @@
+/*
+ *  Copyright (c) 2016 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <math.h>
+
+#include <random>
+#include <vector>
+
+#include "testing/gtest/include/gtest/gtest.h"
+#include "webrtc/base/scoped_ptr.h"
+#include "webrtc/modules/audio_processing/three_band_filter_bank.h"
+#include "webrtc/system_wrappers/include/cpu_features_wrapper.h"
+
+namespace webrtc {
+namespace {
+
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+
+const size_t kNumBands = 3;
+const int kNumFrames = 50;
+// Relative to the largest output sample. The AVX2 kernels may fuse multiplies
+// and adds, the SSE2 ones round exactly like the generic ones.
+const float kTolerance = 1e-6f;
+
+WebRtc_CPUInfo g_cpu_info = NULL;
+
+int CPUInfoSSE2Only(CPUFeature feature) {
+  return feature == kSSE2 ? g_cpu_info(feature) : 0;
+}
+
+// The kernels are picked by the constructor from the CPU features.
+ThreeBandFilterBank* CreateFilterBank(WebRtc_CPUInfo cpu_info, size_t length) {
+  WebRtc_CPUInfo saved = WebRtc_GetCPUInfo;
+  WebRtc_GetCPUInfo = cpu_info;
+  ThreeBandFilterBank* filter_bank = new ThreeBandFilterBank(length);
+  WebRtc_GetCPUInfo = saved;
+  return filter_bank;
+}
+
+void ExpectNear(const std::vector<float>& expected,
+                const std::vector<float>& actual) {
+  float max_abs = 0.f;
+  for (size_t i = 0; i < expected.size(); ++i) {
+    max_abs = fmaxf(max_abs, fabsf(expected[i]));
+  }
+  for (size_t i = 0; i < expected.size(); ++i) {
+    ASSERT_NEAR(expected[i], actual[i], kTolerance * (1.f + max_abs))
+        << "at " << i;
+  }
+}
+
+// Runs the generic filter bank and the one of |cpu_info| on the same random
+// frames and checks that they split and merge them alike. The lengths that
+// are not a multiple of the vector width exercise the generic tails, and the
+// shortest one has less samples per band than the filter state.
+void VerifyMatchesGeneric(WebRtc_CPUInfo cpu_info) {
+  const size_t kSplitLengths[] = {160, 83, 7};
+  std::mt19937 random;
+  std::uniform_real_distribution<float> dist(-32768.f, 32767.f);
+  for (size_t split_length : kSplitLengths) {
+    SCOPED_TRACE(split_length);
+    const size_t length = kNumBands * split_length;
+    rtc::scoped_ptr<ThreeBandFilterBank> generic(
+        CreateFilterBank(WebRtc_GetCPUInfoNoASM, length));
+    rtc::scoped_ptr<ThreeBandFilterBank> simd(
+        CreateFilterBank(cpu_info, length));
+    std::vector<float> in(length);
+    std::vector<float> bands_generic(length), bands_simd(length);
+    std::vector<float> out_generic(length), out_simd(length);
+    float* split_generic[kNumBands];
+    float* split_simd[kNumBands];
+    for (size_t i = 0; i < kNumBands; ++i) {
+      split_generic[i] = &bands_generic[i * split_length];
+      split_simd[i] = &bands_simd[i * split_length];
+    }
+    for (int frame = 0; frame < kNumFrames; ++frame) {
+      for (size_t i = 0; i < length; ++i) {
+        in[i] = dist(random);
+      }
+      generic->Analysis(&in[0], length, split_generic);
+      simd->Analysis(&in[0], length, split_simd);
+      ExpectNear(bands_generic, bands_simd);
+      // Merge the same bands, so that only the synthesis is compared.
+      generic->Synthesis(split_generic, split_length, &out_generic[0]);
+      simd->Synthesis(split_generic, split_length, &out_simd[0]);
+      ExpectNear(out_generic, out_simd);
+    }
+  }
+}
+
+TEST(ThreeBandFilterBankTest, SSE2MatchesGeneric) {
+  g_cpu_info = WebRtc_GetCPUInfo;
+  if (!g_cpu_info(kSSE2)) {
+    return;
+  }
+  VerifyMatchesGeneric(CPUInfoSSE2Only);
+}
+
+TEST(ThreeBandFilterBankTest, AVX2MatchesGeneric) {
+  if (!WebRtc_GetCPUInfo(kAVX2)) {
+    return;
+  }
+  VerifyMatchesGeneric(WebRtc_GetCPUInfo);
+}
+
+#endif  // WEBRTC_ARCH_X86_FAMILY
+
+}  // namespace
+}  // namespace webrtc
@@ -24,6 +24,11 @@ LOCAL_SRC_FILES := \
     wpd_node.cc \
     wpd_tree.cc \
 
+ifeq ($(TARGET_ARCH),$(filter $(TARGET_ARCH),x86 x86_64))
+LOCAL_SRC_FILES += \
+    wpd_node_sse2.cc
+endif
+
 # Flags passed to both C and C++ files.
 LOCAL_CFLAGS := \
     $(MY_WEBRTC_COMMON_DEFS)
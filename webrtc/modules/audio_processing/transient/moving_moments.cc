@@ -10,6 +10,7 @@
 
 #include "webrtc/modules/audio_processing/transient/moving_moments.h"
 
+#include <assert.h>
 #include <math.h>
 #include <string.h>
 
@@ -19,13 +20,12 @@ namespace webrtc {
 
 MovingMoments::MovingMoments(size_t length)
     : length_(length),
-      queue_(),
+      queue_(new float[length]),
+      queue_index_(0),
       sum_(0.0),
       sum_of_squares_(0.0) {
   assert(length > 0);
-  for (size_t i = 0; i < length; ++i) {
-    queue_.push(0.0);
-  }
+  memset(queue_.get(), 0, length * sizeof(queue_[0]));
 }
 
 MovingMoments::~MovingMoments() {}
@@ -35,9 +35,11 @@ void MovingMoments::CalculateMoments(const float* in, size_t in_length,
   assert(in && in_length > 0 && first && second);
 
   for (size_t i = 0; i < in_length; ++i) {
-    const float old_value = queue_.front();
-    queue_.pop();
-    queue_.push(in[i]);
+    const float old_value = queue_[queue_index_];
+    queue_[queue_index_] = in[i];
+    if (++queue_index_ == length_) {
+      queue_index_ = 0;
+    }
 
     sum_ += in[i] - old_value;
     sum_of_squares_ += in[i] * in[i] - old_value * old_value;
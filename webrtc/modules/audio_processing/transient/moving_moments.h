@@ -11,7 +11,7 @@
 #ifndef WEBRTC_MODULES_AUDIO_PROCESSING_TRANSIENT_MOVING_MOMENTS_H_
 #define WEBRTC_MODULES_AUDIO_PROCESSING_TRANSIENT_MOVING_MOMENTS_H_
 
-#include <queue>
+#include <stddef.h>
 
 #include "webrtc/base/scoped_ptr.h"
 
@@ -38,8 +38,10 @@ class MovingMoments {
 
  private:
   size_t length_;
-  // A queue holding the |length_| latest input values.
-  std::queue<float> queue_;
+  // A circular buffer holding the |length_| latest input values, the oldest at
+  // |queue_index_|.
+  rtc::scoped_ptr<float[]> queue_;
+  size_t queue_index_;
   // Sum of the values of the queue.
   float sum_;
   // Sum of the squares of the values of the queue.
@@ -18,7 +18,6 @@
 #include <set>
 
 #include "webrtc/base/scoped_ptr.h"
-#include "webrtc/common_audio/fft4g.h"
 #include "webrtc/common_audio/include/audio_util.h"
 #include "webrtc/common_audio/signal_processing/include/signal_processing_library.h"
 #include "webrtc/modules/audio_processing/transient/common.h"
@@ -122,12 +121,10 @@ int TransientSuppressor::Initialize(int sample_rate_hz,
   memset(out_buffer_.get(),
          0,
          analysis_length_ * num_channels_ * sizeof(out_buffer_[0]));
-  // ip[0] must be zero to trigger initialization using rdft().
-  size_t ip_length = 2 + sqrtf(analysis_length_);
-  ip_.reset(new size_t[ip_length]());
-  memset(ip_.get(), 0, ip_length * sizeof(ip_[0]));
-  wfft_.reset(new float[complex_analysis_length_ - 1]);
-  memset(wfft_.get(), 0, (complex_analysis_length_ - 1) * sizeof(wfft_[0]));
+  rdft_.reset(WebRtcRdft_Create(analysis_length_));
+  if (!rdft_) {
+    return -1;
+  }
   spectral_mean_.reset(new float[complex_analysis_length_ * num_channels_]);
   memset(spectral_mean_.get(),
          0,
@@ -238,9 +235,9 @@ void TransientSuppressor::Suppress(float* in_ptr,
     fft_buffer_[i] = in_ptr[i] * window_[i];
   }
 
-  WebRtc_rdft(analysis_length_, 1, fft_buffer_.get(), ip_.get(), wfft_.get());
+  WebRtcRdft_Forward(rdft_.get(), fft_buffer_.get());
 
-  // Since WebRtc_rdft puts R[n/2] in fft_buffer_[1], we move it to the end
+  // Since WebRtcRdft puts R[n/2] in fft_buffer_[1], we move it to the end
   // for convenience.
   fft_buffer_[analysis_length_] = fft_buffer_[1];
   fft_buffer_[analysis_length_ + 1] = 0.f;
@@ -269,11 +266,7 @@ void TransientSuppressor::Suppress(float* in_ptr,
   // Put R[n/2] back in fft_buffer_[1].
   fft_buffer_[1] = fft_buffer_[analysis_length_];
 
-  WebRtc_rdft(analysis_length_,
-              -1,
-              fft_buffer_.get(),
-              ip_.get(),
-              wfft_.get());
+  WebRtcRdft_Inverse(rdft_.get(), fft_buffer_.get());
   const float fft_scaling = 2.f / analysis_length_;
 
   for (size_t i = 0; i < analysis_length_; ++i) {
@@ -15,6 +15,7 @@
 #include <set>
 
 #include "webrtc/base/scoped_ptr.h"
+#include "webrtc/common_audio/rdft.h"
 #include "webrtc/test/testsupport/gtest_prod_util.h"
 #include "webrtc/typedefs.h"
 
@@ -85,9 +86,7 @@ class TransientSuppressor {
   // Output buffer where the restored samples are stored.
   rtc::scoped_ptr<float[]> out_buffer_;
 
-  // Arrays for fft.
-  rtc::scoped_ptr<size_t[]> ip_;
-  rtc::scoped_ptr<float[]> wfft_;
+  rtc::scoped_ptr<WebRtcRdft, RdftDeleter> rdft_;
 
   rtc::scoped_ptr<float[]> spectral_mean_;
 
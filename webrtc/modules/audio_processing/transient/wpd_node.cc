@@ -15,41 +15,81 @@
 #include <string.h>
 
 #include "webrtc/base/scoped_ptr.h"
-#include "webrtc/common_audio/fir_filter.h"
-#include "webrtc/modules/audio_processing/transient/dyadic_decimator.h"
+#include "webrtc/system_wrappers/include/cpu_features_wrapper.h"
 
 namespace webrtc {
 
 WPDNode::WPDNode(size_t length,
                  const float* coefficients,
                  size_t coefficients_length)
-    : // The data buffer has parent data length to be able to contain and filter
-      // it.
-      data_(new float[2 * length + 1]),
+    : data_(new float[length]),
       length_(length),
-      filter_(FIRFilter::Create(coefficients,
-                                coefficients_length,
-                                2 * length + 1)) {
+      decimate_kernel_(DecimateC),
+      coefficients_(new float[coefficients_length]),
+      coefficients_length_(coefficients_length),
+      state_(new float[coefficients_length - 1]),
+      // Each phase holds half of the state and of the longest parent data.
+      phase_buffer_(new float[2 * (length + coefficients_length / 2 + 1)]) {
   assert(length > 0 && coefficients && coefficients_length > 0);
-  memset(data_.get(), 0.f, (2 * length + 1) * sizeof(data_[0]));
+  memset(data_.get(), 0.f, length * sizeof(data_[0]));
+  memcpy(coefficients_.get(), coefficients,
+         coefficients_length * sizeof(coefficients_[0]));
+  memset(state_.get(), 0.f, (coefficients_length - 1) * sizeof(state_[0]));
+  phases_[0] = phase_buffer_.get();
+  phases_[1] = phase_buffer_.get() + length + coefficients_length / 2 + 1;
+
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+  if (WebRtc_GetCPUInfo(kSSE2)) {
+    decimate_kernel_ = DecimateSSE2;
+  }
+#elif defined(WEBRTC_HAS_NEON)
+  decimate_kernel_ = DecimateNEON;
+#elif defined(WEBRTC_DETECT_NEON)
+  if ((WebRtc_GetCPUFeaturesARM() & kCPUFeatureNEON) != 0) {
+    decimate_kernel_ = DecimateNEON;
+  }
+#endif
 }
 
 WPDNode::~WPDNode() {}
 
+// Filtering the parent data and keeping its odd samples is done in one pass,
+// without computing the even samples that would be dropped:
+//   1. The state and the parent data are split in their even and odd samples.
+//   2. Output sample j is the sum of |coefficients_|[k] times parent sample
+//      2 * j + 1 - k, which is sample j + (L - k) / 2 of phase (L - k) % 2 when
+//      the phases start with the L - 1 state samples.
+// The kernels do the last step.
 int WPDNode::Update(const float* parent_data, size_t parent_data_length) {
   if (!parent_data || (parent_data_length / 2) != length_) {
     return -1;
   }
 
-  // Filter data.
-  filter_->Filter(parent_data, parent_data_length, data_.get());
+  const size_t state_length = coefficients_length_ - 1;
+  for (size_t i = 0; i < state_length; ++i) {
+    phases_[i & 1][i >> 1] = state_[i];
+  }
+  // Parent sample i is sample (L - 1 + i) / 2 of phase (L - 1 + i) % 2.
+  for (size_t p = 0; p < 2; ++p) {
+    const size_t first = (state_length + p) & 1;
+    float* phase = &phases_[p][(state_length + first) >> 1];
+    for (size_t i = first; i < parent_data_length; i += 2) {
+      *phase++ = parent_data[i];
+    }
+  }
 
-  // Decimate data.
-  const bool kOddSequence = true;
-  size_t output_samples = DyadicDecimate(
-      data_.get(), parent_data_length, kOddSequence, data_.get(), length_);
-  if (output_samples != length_) {
-    return -1;
+  decimate_kernel_(phases_, length_, coefficients_.get(), coefficients_length_,
+                   data_.get());
+
+  // Update current state.
+  if (parent_data_length >= state_length) {
+    memcpy(state_.get(), &parent_data[parent_data_length - state_length],
+           state_length * sizeof(state_[0]));
+  } else {
+    memmove(state_.get(), &state_[parent_data_length],
+            (state_length - parent_data_length) * sizeof(state_[0]));
+    memcpy(&state_[state_length - parent_data_length], parent_data,
+           parent_data_length * sizeof(state_[0]));
   }
 
   // Get abs to all values.
@@ -68,4 +108,28 @@ int WPDNode::set_data(const float* new_data, size_t length) {
   return 0;
 }
 
+void WPDNode::DecimateC(const float* const* phases,
+                        size_t length,
+                        const float* coefficients,
+                        size_t coefficients_length,
+                        float* out) {
+  DecimateTail(phases, length, 0, coefficients, coefficients_length, out);
+}
+
+void WPDNode::DecimateTail(const float* const* phases,
+                           size_t length,
+                           size_t start,
+                           const float* coefficients,
+                           size_t coefficients_length,
+                           float* out) {
+  for (size_t j = start; j < length; ++j) {
+    float sum = 0.f;
+    for (size_t k = 0; k < coefficients_length; ++k) {
+      const size_t n = coefficients_length - k;
+      sum += coefficients[k] * phases[n & 1][(n >> 1) + j];
+    }
+    out[j] = sum;
+  }
+}
+
 }  // namespace webrtc
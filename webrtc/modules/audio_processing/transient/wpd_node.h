@@ -16,8 +16,6 @@
 
 namespace webrtc {
 
-class FIRFilter;
-
 // A single node of a Wavelet Packet Decomposition (WPD) tree.
 class WPDNode {
  public:
@@ -36,9 +34,55 @@ class WPDNode {
   size_t length() const { return length_; }
 
  private:
+  // The kernels filter and decimate in one pass, computing only the odd output
+  // samples that are kept. |phases| holds the even and the odd samples of the
+  // parent data, preceded by the last |coefficients_length| - 1 samples of the
+  // previous parent data; see wpd_node.cc.
+  typedef void (*DecimateKernel)(const float* const* phases,
+                                 size_t length,
+                                 const float* coefficients,
+                                 size_t coefficients_length,
+                                 float* out);
+
+  static void DecimateC(const float* const* phases,
+                        size_t length,
+                        const float* coefficients,
+                        size_t coefficients_length,
+                        float* out);
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+  static void DecimateSSE2(const float* const* phases,
+                           size_t length,
+                           const float* coefficients,
+                           size_t coefficients_length,
+                           float* out);
+#endif
+#if defined(WEBRTC_HAS_NEON) || defined(WEBRTC_DETECT_NEON)
+  static void DecimateNEON(const float* const* phases,
+                           size_t length,
+                           const float* coefficients,
+                           size_t coefficients_length,
+                           float* out);
+#endif
+
+  // Runs the generic kernel from output sample |start| on, for the samples the
+  // SIMD kernels leave over.
+  static void DecimateTail(const float* const* phases,
+                           size_t length,
+                           size_t start,
+                           const float* coefficients,
+                           size_t coefficients_length,
+                           float* out);
+
   rtc::scoped_ptr<float[]> data_;
   size_t length_;
-  rtc::scoped_ptr<FIRFilter> filter_;
+  DecimateKernel decimate_kernel_;
+  rtc::scoped_ptr<float[]> coefficients_;
+  size_t coefficients_length_;
+  // The last |coefficients_length_| - 1 samples of the parent data.
+  rtc::scoped_ptr<float[]> state_;
+  // The state and the parent data split in their even and odd samples.
+  rtc::scoped_ptr<float[]> phase_buffer_;
+  float* phases_[2];
 };
 
 }  // namespace webrtc
@@ -0,0 +1,59 @@
+/*
+ *  Copyright (c) 2016 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+// The decimating filter on four output samples per vector, four vectors side
+// by side as in the SSE2 version. The products are added separately rather
+// than with VMLA, so that they round like the generic ones.
+
+#include "webrtc/modules/audio_processing/transient/wpd_node.h"
+
+#include <arm_neon.h>
+
+namespace webrtc {
+
+void WPDNode::DecimateNEON(const float* const* phases,
+                           size_t length,
+                           const float* coefficients,
+                           size_t coefficients_length,
+                           float* out) {
+  const size_t block_length = length & ~static_cast<size_t>(15);
+  const size_t vector_length = length & ~static_cast<size_t>(3);
+  size_t j = 0;
+  for (; j < block_length; j += 16) {
+    float32x4_t sums[4];
+    for (size_t i = 0; i < 4; ++i) {
+      sums[i] = vdupq_n_f32(0.f);
+    }
+    for (size_t k = 0; k < coefficients_length; ++k) {
+      const size_t n = coefficients_length - k;
+      const float* phase = &phases[n & 1][(n >> 1) + j];
+      for (size_t i = 0; i < 4; ++i) {
+        sums[i] = vaddq_f32(
+            sums[i], vmulq_n_f32(vld1q_f32(&phase[4 * i]), coefficients[k]));
+      }
+    }
+    for (size_t i = 0; i < 4; ++i) {
+      vst1q_f32(&out[j + 4 * i], sums[i]);
+    }
+  }
+  for (; j < vector_length; j += 4) {
+    float32x4_t sum = vdupq_n_f32(0.f);
+    for (size_t k = 0; k < coefficients_length; ++k) {
+      const size_t n = coefficients_length - k;
+      sum = vaddq_f32(sum, vmulq_n_f32(vld1q_f32(&phases[n & 1][(n >> 1) + j]),
+                                       coefficients[k]));
+    }
+    vst1q_f32(&out[j], sum);
+  }
+  DecimateTail(phases, length, vector_length, coefficients,
+               coefficients_length, out);
+}
+
+}  // namespace webrtc
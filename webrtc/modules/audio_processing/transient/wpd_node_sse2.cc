@@ -0,0 +1,61 @@
+/*
+ *  Copyright (c) 2016 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+// The decimating filter on four output samples per vector, with the same
+// arithmetic as the generic one. Four vectors are summed side by side so that
+// the additions do not wait on each other.
+
+#include "webrtc/modules/audio_processing/transient/wpd_node.h"
+
+#include <xmmintrin.h>
+
+namespace webrtc {
+
+void WPDNode::DecimateSSE2(const float* const* phases,
+                           size_t length,
+                           const float* coefficients,
+                           size_t coefficients_length,
+                           float* out) {
+  const size_t block_length = length & ~static_cast<size_t>(15);
+  const size_t vector_length = length & ~static_cast<size_t>(3);
+  size_t j = 0;
+  for (; j < block_length; j += 16) {
+    __m128 sums[4];
+    for (size_t i = 0; i < 4; ++i) {
+      sums[i] = _mm_setzero_ps();
+    }
+    for (size_t k = 0; k < coefficients_length; ++k) {
+      const size_t n = coefficients_length - k;
+      const float* phase = &phases[n & 1][(n >> 1) + j];
+      const __m128 coefficient = _mm_load1_ps(&coefficients[k]);
+      for (size_t i = 0; i < 4; ++i) {
+        sums[i] = _mm_add_ps(
+            sums[i], _mm_mul_ps(coefficient, _mm_loadu_ps(&phase[4 * i])));
+      }
+    }
+    for (size_t i = 0; i < 4; ++i) {
+      _mm_storeu_ps(&out[j + 4 * i], sums[i]);
+    }
+  }
+  for (; j < vector_length; j += 4) {
+    __m128 sum = _mm_setzero_ps();
+    for (size_t k = 0; k < coefficients_length; ++k) {
+      const size_t n = coefficients_length - k;
+      sum = _mm_add_ps(sum,
+                       _mm_mul_ps(_mm_load1_ps(&coefficients[k]),
+                                  _mm_loadu_ps(&phases[n & 1][(n >> 1) + j])));
+    }
+    _mm_storeu_ps(&out[j], sum);
+  }
+  DecimateTail(phases, length, vector_length, coefficients,
+               coefficients_length, out);
+}
+
+}  // namespace webrtc
@@ -10,10 +10,16 @@
 
 #include "webrtc/modules/audio_processing/transient/wpd_node.h"
 
+#include <math.h>
 #include <string.h>
 
+#include <random>
+#include <vector>
+
 #include "testing/gtest/include/gtest/gtest.h"
 #include "webrtc/base/scoped_ptr.h"
+#include "webrtc/modules/audio_processing/transient/daubechies_8_wavelet_coeffs.h"
+#include "webrtc/system_wrappers/include/cpu_features_wrapper.h"
 
 namespace webrtc {
 
@@ -55,6 +61,80 @@ TEST(WPDNodeTest, UpdateWithArbitraryDataAndArbitraryFilter) {
   EXPECT_NEAR(0.94f, node.data()[4], kTolerance);
 }
 
+TEST(WPDNodeTest, UpdateMatchesFilterAndDecimateOfStream) {
+  // Consecutive updates must filter the parent data as one stream, also when
+  // the parent data has an odd length, and keep the odd samples of each.
+  const size_t kLength = 13;
+  const int kNumUpdates = 20;
+  WPDNode node(kLength, kDaubechies8LowPassCoefficients,
+               kDaubechies8CoefficientsLength);
+  std::mt19937 random;
+  std::uniform_real_distribution<float> dist(-32768.f, 32767.f);
+  std::vector<float> stream;
+  for (int update = 0; update < kNumUpdates; ++update) {
+    const size_t parent_length = 2 * kLength + update % 2;
+    const size_t offset = stream.size();
+    for (size_t i = 0; i < parent_length; ++i) {
+      stream.push_back(dist(random));
+    }
+    ASSERT_EQ(0, node.Update(&stream[offset], parent_length));
+    for (size_t j = 0; j < kLength; ++j) {
+      const size_t n = offset + 2 * j + 1;
+      double expected = 0.0;
+      for (size_t k = 0; k < kDaubechies8CoefficientsLength && k <= n; ++k) {
+        expected += kDaubechies8LowPassCoefficients[k] * stream[n - k];
+      }
+      ASSERT_NEAR(fabs(expected), node.data()[j], 1e-6 * 32768.f)
+          << "update " << update << ", sample " << j;
+    }
+  }
+}
+
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+
+// The kernel is picked by the constructor from the CPU features.
+WPDNode* CreateNode(WebRtc_CPUInfo cpu_info,
+                    size_t length,
+                    const float* coefficients,
+                    size_t coefficients_length) {
+  WebRtc_CPUInfo saved = WebRtc_GetCPUInfo;
+  WebRtc_GetCPUInfo = cpu_info;
+  WPDNode* node = new WPDNode(length, coefficients, coefficients_length);
+  WebRtc_GetCPUInfo = saved;
+  return node;
+}
+
+TEST(WPDNodeTest, SSE2MatchesGeneric) {
+  if (!WebRtc_GetCPUInfo(kSSE2)) {
+    return;
+  }
+  // The lengths that are not a multiple of four exercise the generic tail.
+  const size_t kLengths[] = {40, 13, 2};
+  std::mt19937 random;
+  std::uniform_real_distribution<float> dist(-32768.f, 32767.f);
+  for (size_t length : kLengths) {
+    rtc::scoped_ptr<WPDNode> generic(
+        CreateNode(WebRtc_GetCPUInfoNoASM, length,
+                   kDaubechies8HighPassCoefficients,
+                   kDaubechies8CoefficientsLength));
+    rtc::scoped_ptr<WPDNode> sse2(
+        CreateNode(WebRtc_GetCPUInfo, length, kDaubechies8HighPassCoefficients,
+                   kDaubechies8CoefficientsLength));
+    std::vector<float> parent(2 * length);
+    for (int update = 0; update < 10; ++update) {
+      for (size_t i = 0; i < parent.size(); ++i) {
+        parent[i] = dist(random);
+      }
+      ASSERT_EQ(0, generic->Update(&parent[0], parent.size()));
+      ASSERT_EQ(0, sse2->Update(&parent[0], parent.size()));
+      ASSERT_EQ(0, memcmp(generic->data(), sse2->data(),
+                          length * sizeof(generic->data()[0])));
+    }
+  }
+}
+
+#endif  // defined(WEBRTC_ARCH_X86_FAMILY)
+
 TEST(WPDNodeTest, ExpectedErrorReturnValue) {
   WPDNode node(kDataLength, kCoefficients, kCoefficientsLength);
   EXPECT_EQ(-1, node.Update(kParentData, kParentDataLength - 1));
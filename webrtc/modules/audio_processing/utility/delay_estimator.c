@@ -14,6 +14,8 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "webrtc/system_wrappers/include/cpu_features_wrapper.h"
+
 // Number of right shifts for scaling is linearly depending on number of bits in
 // the far-end binary spectrum.
 static const int kShiftsAtZero = 13;  // Right shifts at zero binary spectrum.
@@ -46,6 +48,11 @@ static int BitCount(uint32_t u32) {
   return ((int) tmp);
 }
 
+// Same for a 64-bit word.
+static int BitCount64(uint64_t u64) {
+  return BitCount((uint32_t) u64) + BitCount((uint32_t) (u64 >> 32));
+}
+
 // Compares the |binary_vector| with all rows of the |binary_matrix| and counts
 // per row the number of times they have the same value.
 //
@@ -59,18 +66,39 @@ static int BitCount(uint32_t u32) {
 //                            row the number of times the matrix row and the
 //                            input vector have the same value
 //
-static void BitCountComparison(uint32_t binary_vector,
-                               const uint32_t* binary_matrix,
-                               int matrix_size,
-                               int32_t* bit_counts) {
+static void BitCountComparisonC(uint64_t binary_vector,
+                                const uint64_t* binary_matrix,
+                                int matrix_size,
+                                int32_t* bit_counts) {
   int n = 0;
 
   // Compare |binary_vector| with all rows of the |binary_matrix|
   for (; n < matrix_size; n++) {
-    bit_counts[n] = (int32_t) BitCount(binary_vector ^ binary_matrix[n]);
+    bit_counts[n] = (int32_t) BitCount64(binary_vector ^ binary_matrix[n]);
   }
 }
 
+WebRtcBitCountComparison WebRtc_BitCountComparison;
+
+// Picks the bit count comparison for the CPU, the widest first.
+static void InitBitCountComparison(void) {
+  WebRtc_BitCountComparison = BitCountComparisonC;
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+  if (WebRtc_GetCPUInfo(kAVX2)) {
+    WebRtc_InitDelayEstimatorAVX2();
+  } else if (WebRtc_GetCPUInfo(kPOPCNT)) {
+    WebRtc_InitDelayEstimatorPopcnt();
+  }
+#endif
+#if defined(WEBRTC_DETECT_NEON)
+  if ((WebRtc_GetCPUFeaturesARM() & kCPUFeatureNEON) != 0) {
+    WebRtc_InitDelayEstimatorNeon();
+  }
+#elif defined(WEBRTC_HAS_NEON)
+  WebRtc_InitDelayEstimatorNeon();
+#endif
+}
+
 // Collects necessary statistics for the HistogramBasedValidation().  This
 // function has to be called prior to calling HistogramBasedValidation().  The
 // statistics updated and used by the HistogramBasedValidation() are:
@@ -283,8 +311,10 @@ BinaryDelayEstimatorFarend* WebRtc_CreateBinaryDelayEstimatorFarend(
   }
 
   self->history_size = 0;
+  self->num_bands = kBinarySpectrumBands;
   self->binary_far_history = NULL;
   self->far_bit_counts = NULL;
+  InitBitCountComparison();
   if (WebRtc_AllocateFarendBufferMemory(self, history_size) == 0) {
     WebRtc_FreeBinaryDelayEstimatorFarend(self);
     self = NULL;
@@ -321,7 +351,8 @@ int WebRtc_AllocateFarendBufferMemory(BinaryDelayEstimatorFarend* self,
 
 void WebRtc_InitBinaryDelayEstimatorFarend(BinaryDelayEstimatorFarend* self) {
   assert(self != NULL);
-  memset(self->binary_far_history, 0, sizeof(uint32_t) * self->history_size);
+  memset(self->binary_far_history, 0,
+         sizeof(*self->binary_far_history) * self->history_size);
   memset(self->far_bit_counts, 0, sizeof(int) * self->history_size);
 }
 
@@ -359,18 +390,18 @@ void WebRtc_SoftResetBinaryDelayEstimatorFarend(
 }
 
 void WebRtc_AddBinaryFarSpectrum(BinaryDelayEstimatorFarend* handle,
-                                 uint32_t binary_far_spectrum) {
+                                 uint64_t binary_far_spectrum) {
   assert(handle != NULL);
   // Shift binary spectrum history and insert current |binary_far_spectrum|.
   memmove(&(handle->binary_far_history[1]), &(handle->binary_far_history[0]),
-          (handle->history_size - 1) * sizeof(uint32_t));
+          (handle->history_size - 1) * sizeof(uint64_t));
   handle->binary_far_history[0] = binary_far_spectrum;
 
   // Shift history of far-end binary spectrum bit counts and insert bit count
   // of current |binary_far_spectrum|.
   memmove(&(handle->far_bit_counts[1]), &(handle->far_bit_counts[0]),
           (handle->history_size - 1) * sizeof(int));
-  handle->far_bit_counts[0] = BitCount(binary_far_spectrum);
+  handle->far_bit_counts[0] = BitCount64(binary_far_spectrum);
 }
 
 void WebRtc_FreeBinaryDelayEstimator(BinaryDelayEstimator* self) {
@@ -482,7 +513,7 @@ void WebRtc_InitBinaryDelayEstimator(BinaryDelayEstimator* self) {
   memset(self->bit_counts, 0, sizeof(int32_t) * self->history_size);
   memset(self->binary_near_history,
          0,
-         sizeof(uint32_t) * self->near_history_size);
+         sizeof(uint64_t) * self->near_history_size);
   for (i = 0; i <= self->history_size; ++i) {
     self->mean_bit_counts[i] = (20 << 9);  // 20 in Q9.
     self->histogram[i] = 0.f;
@@ -515,10 +546,12 @@ int WebRtc_SoftResetBinaryDelayEstimator(BinaryDelayEstimator* self,
 }
 
 int WebRtc_ProcessBinarySpectrum(BinaryDelayEstimator* self,
-                                 uint32_t binary_near_spectrum) {
+                                 uint64_t binary_near_spectrum) {
   int i = 0;
   int candidate_delay = -1;
   int valid_candidate = 0;
+  // Bit counts of wide spectra are halved to the scale of 32 bands.
+  int wide = 0;
 
   int32_t value_best_candidate = kMaxBitCountsQ9;
   int32_t value_worst_candidate = 0;
@@ -533,20 +566,22 @@ int WebRtc_ProcessBinarySpectrum(BinaryDelayEstimator* self,
     // If we apply lookahead, shift near-end binary spectrum history. Insert
     // current |binary_near_spectrum| and pull out the delayed one.
     memmove(&(self->binary_near_history[1]), &(self->binary_near_history[0]),
-            (self->near_history_size - 1) * sizeof(uint32_t));
+            (self->near_history_size - 1) * sizeof(uint64_t));
     self->binary_near_history[0] = binary_near_spectrum;
     binary_near_spectrum = self->binary_near_history[self->lookahead];
   }
 
   // Compare with delayed spectra and store the |bit_counts| for each delay.
-  BitCountComparison(binary_near_spectrum, self->farend->binary_far_history,
-                     self->history_size, self->bit_counts);
+  WebRtc_BitCountComparison(binary_near_spectrum,
+                            self->farend->binary_far_history,
+                            self->history_size, self->bit_counts);
+  wide = (self->farend->num_bands == kWideBinarySpectrumBands);
 
   // Update |mean_bit_counts|, which is the smoothed version of |bit_counts|.
   for (i = 0; i < self->history_size; i++) {
-    // |bit_counts| is constrained to [0, 32], meaning we can smooth with a
-    // factor up to 2^26. We use Q9.
-    int32_t bit_count = (self->bit_counts[i] << 9);  // Q9.
+    // |bit_counts| is constrained to [0, 32], or [0, 64] before scaling,
+    // meaning we can smooth with a factor up to 2^26. We use Q9.
+    int32_t bit_count = (self->bit_counts[i] << (9 - wide));  // Q9.
 
     // Update |mean_bit_counts| only when far-end signal has something to
     // contribute. If |far_bit_counts| is zero the far-end signal is weak and
@@ -554,7 +589,8 @@ int WebRtc_ProcessBinarySpectrum(BinaryDelayEstimator* self,
     if (self->farend->far_bit_counts[i] > 0) {
       // Make number of right shifts piecewise linear w.r.t. |far_bit_counts|.
       int shifts = kShiftsAtZero;
-      shifts -= (kShiftsLinearSlope * self->farend->far_bit_counts[i]) >> 4;
+      shifts -= (kShiftsLinearSlope * self->farend->far_bit_counts[i]) >>
+          (4 + wide);
       WebRtc_MeanEstimatorFix(bit_count, shifts, &(self->mean_bit_counts[i]));
     }
   }
@@ -18,12 +18,21 @@
 
 static const int32_t kMaxBitCountsQ9 = (32 << 9);  // 32 matching bits in Q9.
 
+// Number of bands of the binary spectra. The wide ones are compared at the
+// same cost with hardware popcount, and their bit counts are scaled to 32
+// bands so that all Q9 values, as |kMaxBitCountsQ9|, hold for both.
+enum { kBinarySpectrumBands = 32 };
+enum { kWideBinarySpectrumBands = 64 };
+
 typedef struct {
   // Pointer to bit counts.
   int* far_bit_counts;
   // Binary history variables.
-  uint32_t* binary_far_history;
+  uint64_t* binary_far_history;
   int history_size;
+  // |kBinarySpectrumBands| or |kWideBinarySpectrumBands|. Set before any
+  // spectrum is added.
+  int num_bands;
 } BinaryDelayEstimatorFarend;
 
 typedef struct {
@@ -34,7 +43,7 @@ typedef struct {
   int32_t* bit_counts;
 
   // Binary history variables.
-  uint32_t* binary_near_history;
+  uint64_t* binary_near_history;
   int near_history_size;
   int history_size;
 
@@ -132,7 +141,7 @@ void WebRtc_SoftResetBinaryDelayEstimatorFarend(
 //    - self                  : Updated far-end instance.
 //
 void WebRtc_AddBinaryFarSpectrum(BinaryDelayEstimatorFarend* self,
-                                 uint32_t binary_far_spectrum);
+                                 uint64_t binary_far_spectrum);
 
 // Releases the memory allocated by WebRtc_CreateBinaryDelayEstimator(...).
 //
@@ -210,7 +219,7 @@ int WebRtc_SoftResetBinaryDelayEstimator(BinaryDelayEstimator* self,
 //                              -2    - Insufficient data for estimation.
 //
 int WebRtc_ProcessBinarySpectrum(BinaryDelayEstimator* self,
-                                 uint32_t binary_near_spectrum);
+                                 uint64_t binary_near_spectrum);
 
 // Returns the last calculated delay updated by the function
 // WebRtc_ProcessBinarySpectrum(...).
@@ -248,4 +257,24 @@ void WebRtc_MeanEstimatorFix(int32_t new_value,
                              int factor,
                              int32_t* mean_value);
 
+// Compares the |binary_vector| with all |matrix_size| rows of the
+// |binary_matrix|, i.e., with the far-end spectra at all delays, and stores
+// per row the number of bits in which they differ in |bit_counts|.
+typedef void (*WebRtcBitCountComparison)(uint64_t binary_vector,
+                                         const uint64_t* binary_matrix,
+                                         int matrix_size,
+                                         int32_t* bit_counts);
+extern WebRtcBitCountComparison WebRtc_BitCountComparison;
+
+// The generic version is picked by WebRtc_CreateBinaryDelayEstimatorFarend(),
+// or one of these when the CPU has the instructions. They are defined in
+// delay_estimator_{popcnt,avx2,neon}.c.
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+void WebRtc_InitDelayEstimatorPopcnt(void);
+void WebRtc_InitDelayEstimatorAVX2(void);
+#endif
+#if defined(WEBRTC_DETECT_NEON) || defined(WEBRTC_HAS_NEON)
+void WebRtc_InitDelayEstimatorNeon(void);
+#endif
+
 #endif  // WEBRTC_MODULES_AUDIO_PROCESSING_UTILITY_DELAY_ESTIMATOR_H_
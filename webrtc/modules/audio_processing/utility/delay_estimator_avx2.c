@@ -0,0 +1,66 @@
+/*
+ *  Copyright (c) 2016 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+/*
+ * AVX2 version of the bit count comparison, four delays per pass. The bytes
+ * are counted through a nibble lookup table and summed per delay with SAD.
+ */
+
+#include <immintrin.h>
+#include <string.h>
+
+#include "webrtc/modules/audio_processing/utility/delay_estimator.h"
+
+// Number of set bits in each of the four 64-bit lanes of |v|, as 32-bit
+// values in the lower half of the result.
+static __m128i PopCount4(__m256i v) {
+  const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3,
+                                          1, 2, 2, 3, 2, 3, 3, 4,
+                                          0, 1, 1, 2, 1, 2, 2, 3,
+                                          1, 2, 2, 3, 2, 3, 3, 4);
+  const __m256i low_mask = _mm256_set1_epi8(0x0F);
+  const __m256i low = _mm256_and_si256(v, low_mask);
+  const __m256i high = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask);
+  const __m256i counts = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, low),
+                                         _mm256_shuffle_epi8(lookup, high));
+  const __m256i sums = _mm256_sad_epu8(counts, _mm256_setzero_si256());
+  return _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(
+      sums, _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7)));
+}
+
+static void BitCountComparisonAVX2(uint64_t binary_vector,
+                                   const uint64_t* binary_matrix,
+                                   int matrix_size,
+                                   int32_t* bit_counts) {
+  const __m256i vector = _mm256_set1_epi64x((long long)binary_vector);
+  int n = 0;
+
+  for (; n + 4 <= matrix_size; n += 4) {
+    const __m256i rows =
+        _mm256_loadu_si256((const __m256i*)&binary_matrix[n]);
+    _mm_storeu_si128((__m128i*)&bit_counts[n],
+                     PopCount4(_mm256_xor_si256(vector, rows)));
+  }
+
+  // The last delays through a zero padded copy.
+  if (n < matrix_size) {
+    uint64_t rows[4] = {0};
+    int32_t counts[4];
+    memcpy(rows, &binary_matrix[n], sizeof(*rows) * (matrix_size - n));
+    _mm_storeu_si128((__m128i*)counts,
+                     PopCount4(_mm256_xor_si256(
+                         vector, _mm256_loadu_si256((const __m256i*)rows))));
+    memcpy(&bit_counts[n], counts, sizeof(*counts) * (matrix_size - n));
+  }
+}
+
+void WebRtc_InitDelayEstimatorAVX2(void) {
+  WebRtc_BitCountComparison = BitCountComparisonAVX2;
+}
@@ -0,0 +1,45 @@
+/*
+ *  Copyright (c) 2016 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+/*
+ * NEON version of the bit count comparison, two delays per pass. The bytes
+ * are counted with VCNT and summed per delay by pairwise widening adds.
+ */
+
+#include <arm_neon.h>
+
+#include "webrtc/modules/audio_processing/utility/delay_estimator.h"
+
+static void BitCountComparisonNeon(uint64_t binary_vector,
+                                   const uint64_t* binary_matrix,
+                                   int matrix_size,
+                                   int32_t* bit_counts) {
+  const uint64x2_t vector = vdupq_n_u64(binary_vector);
+  int n = 0;
+
+  for (; n + 2 <= matrix_size; n += 2) {
+    const uint64x2_t rows = vld1q_u64(&binary_matrix[n]);
+    const uint8x16_t counts =
+        vcntq_u8(vreinterpretq_u8_u64(veorq_u64(vector, rows)));
+    const uint64x2_t sums = vpaddlq_u32(vpaddlq_u16(vpaddlq_u8(counts)));
+    vst1_s32(&bit_counts[n], vreinterpret_s32_u32(vmovn_u64(sums)));
+  }
+
+  if (n < matrix_size) {
+    const uint8x8_t counts =
+        vcnt_u8(vcreate_u8(binary_vector ^ binary_matrix[n]));
+    bit_counts[n] = (int32_t)vget_lane_u64(
+        vpaddl_u32(vpaddl_u16(vpaddl_u8(counts))), 0);
+  }
+}
+
+void WebRtc_InitDelayEstimatorNeon(void) {
+  WebRtc_BitCountComparison = BitCountComparisonNeon;
+}
@@ -0,0 +1,41 @@
+/*
+ *  Copyright (c) 2016 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+/*
+ * Bit count comparison with the POPCNT instruction, for the x86 CPUs that have
+ * it but not AVX2. One instruction per delay on 64-bit builds, two otherwise.
+ */
+
+#include <nmmintrin.h>
+
+#include "webrtc/modules/audio_processing/utility/delay_estimator.h"
+
+static __inline int32_t PopCount64(uint64_t u64) {
+#if defined(WEBRTC_ARCH_64_BITS)
+  return (int32_t)_mm_popcnt_u64(u64);
+#else
+  return _mm_popcnt_u32((uint32_t)u64) + _mm_popcnt_u32((uint32_t)(u64 >> 32));
+#endif
+}
+
+static void BitCountComparisonPopcnt(uint64_t binary_vector,
+                                     const uint64_t* binary_matrix,
+                                     int matrix_size,
+                                     int32_t* bit_counts) {
+  int n = 0;
+
+  for (; n < matrix_size; n++) {
+    bit_counts[n] = PopCount64(binary_vector ^ binary_matrix[n]);
+  }
+}
+
+void WebRtc_InitDelayEstimatorPopcnt(void) {
+  WebRtc_BitCountComparison = BitCountComparisonPopcnt;
+}
@@ -8,6 +8,8 @@
  *  be found in the AUTHORS file in the root of the source tree.
  */
 
+#include <random>
+
 #include "testing/gtest/include/gtest/gtest.h"
 
 extern "C" {
@@ -15,6 +17,7 @@ extern "C" {
 #include "webrtc/modules/audio_processing/utility/delay_estimator_internal.h"
 #include "webrtc/modules/audio_processing/utility/delay_estimator_wrapper.h"
 }
+#include "webrtc/system_wrappers/include/cpu_features_wrapper.h"
 #include "webrtc/typedefs.h"
 
 namespace {
@@ -60,7 +63,7 @@ class DelayEstimatorTest : public ::testing::Test {
   float near_f_[kSpectrumSize];
   uint16_t far_u16_[kSpectrumSize];
   uint16_t near_u16_[kSpectrumSize];
-  uint32_t binary_spectrum_[kSequenceLength + kHistorySize];
+  uint64_t binary_spectrum_[kSequenceLength + kHistorySize];
 };
 
 DelayEstimatorTest::DelayEstimatorTest()
@@ -81,7 +84,7 @@ DelayEstimatorTest::DelayEstimatorTest()
   // the initialized state.
   binary_spectrum_[0] = 1;
   for (int i = 1; i < (kSequenceLength + kHistorySize); i++) {
-    binary_spectrum_[i] = 3 * binary_spectrum_[i - 1];
+    binary_spectrum_[i] = static_cast<uint32_t>(3 * binary_spectrum_[i - 1]);
   }
 }
 
@@ -233,6 +236,13 @@ TEST_F(DelayEstimatorTest, CorrectErrorReturnsOfWrapper) {
   EXPECT_TRUE(handle == NULL);
   handle = WebRtc_CreateDelayEstimatorFarend(kSpectrumSize, 1);
   EXPECT_TRUE(handle == NULL);
+  // Wide binary spectra use bin 64, and only 32 or 64 bands are supported.
+  handle = WebRtc_CreateDelayEstimatorFarendWithBands(
+      kSpectrumSize - 1, kHistorySize, kWideBinarySpectrumBands);
+  EXPECT_TRUE(handle == NULL);
+  handle = WebRtc_CreateDelayEstimatorFarendWithBands(kSpectrumSize,
+                                                      kHistorySize, 48);
+  EXPECT_TRUE(handle == NULL);
 
   handle = handle_;
   handle = WebRtc_CreateDelayEstimator(NULL, kLookahead);
@@ -537,6 +547,54 @@ TEST_F(DelayEstimatorTest, ExactDelayEstimateMultipleNearSameSpectrum) {
   }
 }
 
+TEST_F(DelayEstimatorTest, ExactDelayEstimateWideBinarySpectra) {
+  // In this test we use the same setup as above, with 64 bands in the binary
+  // spectra. The sequence now also fills the upper 32 bits.
+  uint64_t binary_spectrum = 1;
+  for (int i = 0; i < (kSequenceLength + kHistorySize); i++) {
+    binary_spectrum_[i] = binary_spectrum;
+    binary_spectrum *= 3;
+  }
+  binary_farend_->num_bands = kWideBinarySpectrumBands;
+
+  for (size_t i = 0; i < kSizeEnable; ++i) {
+    for (size_t j = 0; j < kSizeEnable; ++j) {
+      RunBinarySpectraTest(0, 0, kEnable[i], kEnable[j]);
+    }
+  }
+}
+
+TEST_F(DelayEstimatorTest, WideBinarySpectraLeaveInitialState) {
+  // In this test we verify that the wrapper with wide binary spectra leaves the
+  // initialized state, for both floating and fixed point spectra.
+  void* farend_handle = WebRtc_CreateDelayEstimatorFarendWithBands(
+      kSpectrumSize, kHistorySize, kWideBinarySpectrumBands);
+  ASSERT_TRUE(farend_handle != NULL);
+  void* handle = WebRtc_CreateDelayEstimator(farend_handle, kLookahead);
+  ASSERT_TRUE(handle != NULL);
+
+  EXPECT_EQ(0, WebRtc_InitDelayEstimatorFarend(farend_handle));
+  EXPECT_EQ(0, WebRtc_InitDelayEstimator(handle));
+  for (int i = 0; i < 200 && WebRtc_last_delay(handle) == -2; i++) {
+    EXPECT_EQ(0, WebRtc_AddFarSpectrumFloat(farend_handle, far_f_,
+                                            spectrum_size_));
+    WebRtc_DelayEstimatorProcessFloat(handle, near_f_, spectrum_size_);
+  }
+  EXPECT_NE(-2, WebRtc_last_delay(handle));
+
+  EXPECT_EQ(0, WebRtc_InitDelayEstimatorFarend(farend_handle));
+  EXPECT_EQ(0, WebRtc_InitDelayEstimator(handle));
+  for (int i = 0; i < 200 && WebRtc_last_delay(handle) == -2; i++) {
+    EXPECT_EQ(0, WebRtc_AddFarSpectrumFix(farend_handle, far_u16_,
+                                          spectrum_size_, 0));
+    WebRtc_DelayEstimatorProcessFix(handle, near_u16_, spectrum_size_, 0);
+  }
+  EXPECT_NE(-2, WebRtc_last_delay(handle));
+
+  WebRtc_FreeDelayEstimator(handle);
+  WebRtc_FreeDelayEstimatorFarend(farend_handle);
+}
+
 TEST_F(DelayEstimatorTest, ExactDelayEstimateMultipleNearDifferentSpectrum) {
   // In this test we use the same setup as above, but we now feed the two Binary
   // Delay Estimators with different signals, so they should output different
@@ -618,4 +676,68 @@ TEST_F(DelayEstimatorTest, VerifyHistorySizeIsSetAndKeptAfterInit) {
 
 // TODO(bjornv): Add tests for SoftReset...(...).
 
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+
+WebRtc_CPUInfo g_cpu_info = NULL;
+
+int CPUInfoWithoutAVX2(CPUFeature feature) {
+  return feature == kAVX2 ? 0 : g_cpu_info(feature);
+}
+
+// The comparison is picked from the CPU features when a far-end is created.
+WebRtcBitCountComparison LoadBitCountComparison(WebRtc_CPUInfo cpu_info) {
+  WebRtc_CPUInfo saved = WebRtc_GetCPUInfo;
+  WebRtc_GetCPUInfo = cpu_info;
+  BinaryDelayEstimatorFarend* farend =
+      WebRtc_CreateBinaryDelayEstimatorFarend(kHistorySize);
+  WebRtc_GetCPUInfo = saved;
+  WebRtc_FreeBinaryDelayEstimatorFarend(farend);
+  return WebRtc_BitCountComparison;
+}
+
+TEST(DelayEstimatorKernelTest, BitCountComparisonIsBitExact) {
+  // The POPCNT and AVX2 comparisons must match the generic one for all matrix
+  // sizes, including those with a remainder of delays.
+  g_cpu_info = WebRtc_GetCPUInfo;
+  WebRtcBitCountComparison comparison_c =
+      LoadBitCountComparison(WebRtc_GetCPUInfoNoASM);
+  WebRtcBitCountComparison comparisons[2] = { NULL, NULL };
+  if (g_cpu_info(kPOPCNT)) {
+    comparisons[0] = LoadBitCountComparison(CPUInfoWithoutAVX2);
+  }
+  if (g_cpu_info(kAVX2)) {
+    comparisons[1] = LoadBitCountComparison(g_cpu_info);
+  }
+  // Restore the comparison for this CPU.
+  LoadBitCountComparison(g_cpu_info);
+
+  std::mt19937_64 random;
+  uint64_t binary_matrix[kHistorySize];
+  int32_t bit_counts_c[kHistorySize];
+  int32_t bit_counts[kHistorySize];
+  for (int matrix_size = 1; matrix_size <= kHistorySize; matrix_size += 3) {
+    const uint64_t binary_vector = random();
+    for (int i = 0; i < matrix_size; ++i) {
+      binary_matrix[i] = random();
+    }
+    // Include the extremes.
+    binary_matrix[matrix_size - 1] = ~binary_vector;
+    binary_matrix[0] = binary_vector;
+    comparison_c(binary_vector, binary_matrix, matrix_size, bit_counts_c);
+    EXPECT_EQ(0, bit_counts_c[0]);
+    EXPECT_EQ(matrix_size > 1 ? 64 : 0, bit_counts_c[matrix_size - 1]);
+    for (size_t k = 0; k < sizeof(comparisons) / sizeof(*comparisons); ++k) {
+      if (comparisons[k] == NULL) {
+        continue;
+      }
+      comparisons[k](binary_vector, binary_matrix, matrix_size, bit_counts);
+      for (int i = 0; i < matrix_size; ++i) {
+        ASSERT_EQ(bit_counts_c[i], bit_counts[i]) << "at " << i;
+      }
+    }
+  }
+}
+
+#endif  // defined(WEBRTC_ARCH_X86_FAMILY)
+
 }  // namespace
@@ -22,14 +22,21 @@
 // |kBandFirst| - |kBandLast| must be < 32.
 enum { kBandFirst = 12 };
 enum { kBandLast = 43 };
+// Same for the wide binary spectra, which must fit in 64 bits.
+enum { kWideBandFirst = 1 };
+enum { kWideBandLast = 64 };
 
-static __inline uint32_t SetBit(uint32_t in, int pos) {
-  uint32_t mask = (1 << pos);
-  uint32_t out = (in | mask);
+static __inline uint64_t SetBit(uint64_t in, int pos) {
+  uint64_t mask = ((uint64_t) 1 << pos);
+  uint64_t out = (in | mask);
 
   return out;
 }
 
+static int BandFirst(int num_bands) {
+  return num_bands == kWideBinarySpectrumBands ? kWideBandFirst : kBandFirst;
+}
+
 // Calculates the mean recursively. Same version as WebRtc_MeanEstimatorFix(),
 // but for float.
 //
@@ -55,22 +62,26 @@ static void MeanEstimatorFloat(float new_value,
 //                              calculated.
 //      - threshold_spectrum  : Threshold spectrum with which the input
 //                              spectrum is compared.
+//      - num_bands           : Number of bands of the binary spectrum.
 // Return:
 //      - out                 : Binary spectrum.
 //
-static uint32_t BinarySpectrumFix(const uint16_t* spectrum,
+static uint64_t BinarySpectrumFix(const uint16_t* spectrum,
                                   SpectrumType* threshold_spectrum,
                                   int q_domain,
+                                  int num_bands,
                                   int* threshold_initialized) {
-  int i = kBandFirst;
-  uint32_t out = 0;
+  const int band_first = BandFirst(num_bands);
+  const int band_last = band_first + num_bands - 1;
+  int i = band_first;
+  uint64_t out = 0;
 
   assert(q_domain < 16);
 
   if (!(*threshold_initialized)) {
     // Set the |threshold_spectrum| to half the input |spectrum| as starting
     // value. This speeds up the convergence.
-    for (i = kBandFirst; i <= kBandLast; i++) {
+    for (i = band_first; i <= band_last; i++) {
       if (spectrum[i] > 0) {
         // Convert input spectrum from Q(|q_domain|) to Q15.
         int32_t spectrum_q15 = ((int32_t) spectrum[i]) << (15 - q_domain);
@@ -79,31 +90,34 @@ static uint32_t BinarySpectrumFix(const uint16_t* spectrum,
       }
     }
   }
-  for (i = kBandFirst; i <= kBandLast; i++) {
+  for (i = band_first; i <= band_last; i++) {
     // Convert input spectrum from Q(|q_domain|) to Q15.
     int32_t spectrum_q15 = ((int32_t) spectrum[i]) << (15 - q_domain);
     // Update the |threshold_spectrum|.
     WebRtc_MeanEstimatorFix(spectrum_q15, 6, &(threshold_spectrum[i].int32_));
     // Convert |spectrum| at current frequency bin to a binary value.
     if (spectrum_q15 > threshold_spectrum[i].int32_) {
-      out = SetBit(out, i - kBandFirst);
+      out = SetBit(out, i - band_first);
     }
   }
 
   return out;
 }
 
-static uint32_t BinarySpectrumFloat(const float* spectrum,
+static uint64_t BinarySpectrumFloat(const float* spectrum,
                                     SpectrumType* threshold_spectrum,
+                                    int num_bands,
                                     int* threshold_initialized) {
-  int i = kBandFirst;
-  uint32_t out = 0;
+  const int band_first = BandFirst(num_bands);
+  const int band_last = band_first + num_bands - 1;
+  int i = band_first;
+  uint64_t out = 0;
   const float kScale = 1 / 64.0;
 
   if (!(*threshold_initialized)) {
     // Set the |threshold_spectrum| to half the input |spectrum| as starting
     // value. This speeds up the convergence.
-    for (i = kBandFirst; i <= kBandLast; i++) {
+    for (i = band_first; i <= band_last; i++) {
       if (spectrum[i] > 0.0f) {
         threshold_spectrum[i].float_ = (spectrum[i] / 2);
         *threshold_initialized = 1;
@@ -111,12 +125,12 @@ static uint32_t BinarySpectrumFloat(const float* spectrum,
     }
   }
 
-  for (i = kBandFirst; i <= kBandLast; i++) {
+  for (i = band_first; i <= band_last; i++) {
     // Update the |threshold_spectrum|.
     MeanEstimatorFloat(spectrum[i], kScale, &(threshold_spectrum[i].float_));
     // Convert |spectrum| at current frequency bin to a binary value.
     if (spectrum[i] > threshold_spectrum[i].float_) {
-      out = SetBit(out, i - kBandFirst);
+      out = SetBit(out, i - band_first);
     }
   }
 
@@ -140,13 +154,23 @@ void WebRtc_FreeDelayEstimatorFarend(void* handle) {
 }
 
 void* WebRtc_CreateDelayEstimatorFarend(int spectrum_size, int history_size) {
+  return WebRtc_CreateDelayEstimatorFarendWithBands(spectrum_size, history_size,
+                                                    kBinarySpectrumBands);
+}
+
+void* WebRtc_CreateDelayEstimatorFarendWithBands(int spectrum_size,
+                                                 int history_size,
+                                                 int num_bands) {
   DelayEstimatorFarend* self = NULL;
 
   // Check if the sub band used in the delay estimation is small enough to fit
-  // the binary spectra in a uint32_t.
-  COMPILE_ASSERT(kBandLast - kBandFirst < 32);
+  // the binary spectra in a uint32_t, or a uint64_t for the wide ones.
+  COMPILE_ASSERT(kBandLast - kBandFirst < kBinarySpectrumBands);
+  COMPILE_ASSERT(kWideBandLast - kWideBandFirst < kWideBinarySpectrumBands);
 
-  if (spectrum_size >= kBandLast) {
+  if ((num_bands == kBinarySpectrumBands && spectrum_size >= kBandLast) ||
+      (num_bands == kWideBinarySpectrumBands &&
+       spectrum_size > kWideBandLast)) {
     self = malloc(sizeof(DelayEstimatorFarend));
   }
 
@@ -156,6 +180,9 @@ void* WebRtc_CreateDelayEstimatorFarend(int spectrum_size, int history_size) {
     // Allocate memory for the binary far-end spectrum handling.
     self->binary_farend = WebRtc_CreateBinaryDelayEstimatorFarend(history_size);
     memory_fail |= (self->binary_farend == NULL);
+    if (self->binary_farend != NULL) {
+      self->binary_farend->num_bands = num_bands;
+    }
 
     // Allocate memory for spectrum buffers.
     self->mean_far_spectrum = malloc(spectrum_size * sizeof(SpectrumType));
@@ -202,7 +229,7 @@ int WebRtc_AddFarSpectrumFix(void* handle,
                              int spectrum_size,
                              int far_q) {
   DelayEstimatorFarend* self = (DelayEstimatorFarend*) handle;
-  uint32_t binary_spectrum = 0;
+  uint64_t binary_spectrum = 0;
 
   if (self == NULL) {
     return -1;
@@ -222,7 +249,8 @@ int WebRtc_AddFarSpectrumFix(void* handle,
 
   // Get binary spectrum.
   binary_spectrum = BinarySpectrumFix(far_spectrum, self->mean_far_spectrum,
-                                      far_q, &(self->far_spectrum_initialized));
+                                      far_q, self->binary_farend->num_bands,
+                                      &(self->far_spectrum_initialized));
   WebRtc_AddBinaryFarSpectrum(self->binary_farend, binary_spectrum);
 
   return 0;
@@ -232,7 +260,7 @@ int WebRtc_AddFarSpectrumFloat(void* handle,
                                const float* far_spectrum,
                                int spectrum_size) {
   DelayEstimatorFarend* self = (DelayEstimatorFarend*) handle;
-  uint32_t binary_spectrum = 0;
+  uint64_t binary_spectrum = 0;
 
   if (self == NULL) {
     return -1;
@@ -248,6 +276,7 @@ int WebRtc_AddFarSpectrumFloat(void* handle,
 
   // Get binary spectrum.
   binary_spectrum = BinarySpectrumFloat(far_spectrum, self->mean_far_spectrum,
+                                        self->binary_farend->num_bands,
                                         &(self->far_spectrum_initialized));
   WebRtc_AddBinaryFarSpectrum(self->binary_farend, binary_spectrum);
 
@@ -416,7 +445,7 @@ int WebRtc_DelayEstimatorProcessFix(void* handle,
                                     int spectrum_size,
                                     int near_q) {
   DelayEstimator* self = (DelayEstimator*) handle;
-  uint32_t binary_spectrum = 0;
+  uint64_t binary_spectrum = 0;
 
   if (self == NULL) {
     return -1;
@@ -438,6 +467,7 @@ int WebRtc_DelayEstimatorProcessFix(void* handle,
   binary_spectrum = BinarySpectrumFix(near_spectrum,
                                       self->mean_near_spectrum,
                                       near_q,
+                                      self->binary_handle->farend->num_bands,
                                       &(self->near_spectrum_initialized));
 
   return WebRtc_ProcessBinarySpectrum(self->binary_handle, binary_spectrum);
@@ -447,7 +477,7 @@ int WebRtc_DelayEstimatorProcessFloat(void* handle,
                                       const float* near_spectrum,
                                       int spectrum_size) {
   DelayEstimator* self = (DelayEstimator*) handle;
-  uint32_t binary_spectrum = 0;
+  uint64_t binary_spectrum = 0;
 
   if (self == NULL) {
     return -1;
@@ -463,6 +493,7 @@ int WebRtc_DelayEstimatorProcessFloat(void* handle,
 
   // Get binary spectrum.
   binary_spectrum = BinarySpectrumFloat(near_spectrum, self->mean_near_spectrum,
+                                        self->binary_handle->farend->num_bands,
                                         &(self->near_spectrum_initialized));
 
   return WebRtc_ProcessBinarySpectrum(self->binary_handle, binary_spectrum);
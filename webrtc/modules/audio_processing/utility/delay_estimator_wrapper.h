@@ -38,6 +38,15 @@ void WebRtc_FreeDelayEstimatorFarend(void* handle);
 //                        returned.
 void* WebRtc_CreateDelayEstimatorFarend(int spectrum_size, int history_size);
 
+// Same as WebRtc_CreateDelayEstimatorFarend(), with |num_bands| bands in the
+// binary spectra, kBinarySpectrumBands or kWideBinarySpectrumBands. The wide
+// spectra use bins 1 through 64 instead of 12 through 43, which takes a
+// |spectrum_size| of at least 65. With hardware popcount they cost the same
+// per delay, and their sharper matches allow a longer |history_size|.
+void* WebRtc_CreateDelayEstimatorFarendWithBands(int spectrum_size,
+                                                 int history_size,
+                                                 int num_bands);
+
 // Initializes the far-end part of the delay estimation instance returned by
 // WebRtc_CreateDelayEstimatorFarend(...)
 int WebRtc_InitDelayEstimatorFarend(void* handle);
@@ -13,7 +13,6 @@
 #include <math.h>
 #include <stdio.h>
 
-#include "webrtc/common_audio/fft4g.h"
 #include "webrtc/modules/audio_processing/vad/vad_audio_proc_internal.h"
 #include "webrtc/modules/audio_processing/vad/pitch_internal.h"
 #include "webrtc/modules/audio_processing/vad/pole_zero_filter.h"
@@ -38,7 +37,8 @@ static const int kSilenceRms = 5;
 
 // TODO(turajs): Make a Create or Init for VadAudioProc.
 VadAudioProc::VadAudioProc()
-    : audio_buffer_(),
+    : rdft_(WebRtcRdft_Create(kDftSize)),
+      audio_buffer_(),
       num_buffer_samples_(kNumPastSignalSamples),
       log_old_gain_(-2),
       old_lag_(50),  // Arbitrary but valid as pitch-lag (in samples).
@@ -55,10 +55,6 @@ VadAudioProc::VadAudioProc()
                 "correlation weight incorrect size");
 
   // TODO(turajs): Are we doing too much in the constructor?
-  float data[kDftSize];
-  // Make FFT to initialize.
-  ip_[0] = 0;
-  WebRtc_rdft(kDftSize, 1, data, ip_, w_fft_);
   // TODO(turajs): Need to initialize high-pass filter.
 
   // Initialize iSAC components.
@@ -191,7 +187,7 @@ void VadAudioProc::FindFirstSpectralPeaks(double* f_peak,
       data[n] = static_cast<float>(lpc[i * (kLpcOrder + 1) + n]);
     }
     // Transform to frequency domain.
-    WebRtc_rdft(kDftSize, 1, data, ip_, w_fft_);
+    WebRtcRdft_Forward(rdft_.get(), data);
 
     size_t index_peak = 0;
     float prev_magn_sqr = data[0] * data[0];
@@ -12,6 +12,7 @@
 #define WEBRTC_MODULES_AUDIO_PROCESSING_VAD_VAD_AUDIO_PROC_H_
 
 #include "webrtc/base/scoped_ptr.h"
+#include "webrtc/common_audio/rdft.h"
 #include "webrtc/modules/audio_processing/vad/common.h"
 #include "webrtc/typedefs.h"
 
@@ -64,13 +65,10 @@ class VadAudioProc {
       kNumSubframeSamples;  // Samples in 30 ms @ given sampling rate.
   static const size_t kBufferLength =
       kNumPastSignalSamples + kNumSamplesToProcess;
-  static const size_t kIpLength = kDftSize >> 1;
-  static const size_t kWLength = kDftSize >> 1;
 
   static const size_t kLpcOrder = 16;
 
-  size_t ip_[kIpLength];
-  float w_fft_[kWLength];
+  rtc::scoped_ptr<WebRtcRdft, RdftDeleter> rdft_;
 
   // A buffer of 5 ms (past audio) + 30 ms (one iSAC frame ).
   float audio_buffer_[kBufferLength];
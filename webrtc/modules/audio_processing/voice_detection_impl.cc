@@ -78,6 +78,19 @@ void VoiceDetectionImpl::ProcessCaptureAudio(AudioBuffer* audio) {
   }
 }
 
+void VoiceDetectionImpl::ProcessSilentCaptureAudio(AudioBuffer* audio) {
+  rtc::CritScope cs(crit_);
+  if (!enabled_) {
+    return;
+  }
+  if (using_external_vad_) {
+    using_external_vad_ = false;
+    return;
+  }
+  stream_has_voice_ = false;
+  audio->set_activity(AudioFrame::kVadPassive);
+}
+
 int VoiceDetectionImpl::Enable(bool enable) {
   rtc::CritScope cs(crit_);
   if (enabled_ != enable) {
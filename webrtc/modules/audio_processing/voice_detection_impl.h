@@ -28,6 +28,8 @@ class VoiceDetectionImpl : public VoiceDetection {
   // TODO(peah): Fold into ctor, once public API is removed.
   void Initialize(int sample_rate_hz);
   void ProcessCaptureAudio(AudioBuffer* audio);
+  // Reports no voice for a frame that AudioProcessingImpl skipped as silent.
+  void ProcessSilentCaptureAudio(AudioBuffer* audio);
 
   // VoiceDetection implementation.
   int Enable(bool enable) override;
@@ -219,14 +219,19 @@
                 'audio_coding/neteq/tools/packet_unittest.cc',
                 'audio_conference_mixer/test/audio_conference_mixer_unittest.cc',
                 'audio_device/fine_audio_buffer_unittest.cc',
+                'audio_processing/aec/aec_core_avx2_unittest.cc',
                 'audio_processing/aec/echo_cancellation_unittest.cc',
                 'audio_processing/aec/system_delay_unittest.cc',
+                'audio_processing/aecm/aecm_core_unittest.cc',
+                'audio_processing/aecm/echo_control_mobile_unittest.cc',
+                'audio_processing/audio_buffer_unittest.cc',
                 'audio_processing/agc/agc_manager_direct_unittest.cc',
                 # TODO(ajm): Fix to match new interface.
                 # 'audio_processing/agc/agc_unittest.cc',
                 'audio_processing/agc/histogram_unittest.cc',
                 'audio_processing/agc/mock_agc.h',
                 'audio_processing/beamformer/array_util_unittest.cc',
+                'audio_processing/beamformer/bin_quadratic_forms_unittest.cc',
                 'audio_processing/beamformer/complex_matrix_unittest.cc',
                 'audio_processing/beamformer/covariance_matrix_generator_unittest.cc',
                 'audio_processing/beamformer/matrix_unittest.cc',
@@ -235,7 +240,10 @@
                 'audio_processing/echo_cancellation_impl_unittest.cc',
                 'audio_processing/intelligibility/intelligibility_enhancer_unittest.cc',
                 'audio_processing/intelligibility/intelligibility_utils_unittest.cc',
+                'audio_processing/logging/aec_trace_unittest.cc',
+                'audio_processing/ns/ns_core_unittest.cc',
                 'audio_processing/splitting_filter_unittest.cc',
+                'audio_processing/three_band_filter_bank_unittest.cc',
                 'audio_processing/transient/dyadic_decimator_unittest.cc',
                 'audio_processing/transient/file_utils.cc',
                 'audio_processing/transient/file_utils.h',
@@ -400,6 +408,9 @@
                 }],
                 ['prefer_fixed_point==1', {
                   'defines': [ 'WEBRTC_AUDIOPROC_FIXED_PROFILE' ],
+                  'sources': [
+                    'audio_processing/ns/nsx_core_unittest.cc',
+                  ],
                 }, {
                   'defines': [ 'WEBRTC_AUDIOPROC_FLOAT_PROFILE' ],
                 }],
@@ -412,10 +423,12 @@
                     'audioproc_protobuf_utils',
                     'audioproc_unittest_proto',
                     'neteq_unittest_proto',
+                    '<(DEPTH)/third_party/zlib/zlib.gyp:zlib',
                   ],
                   'sources': [
                     'audio_processing/audio_processing_impl_locking_unittest.cc',
                     'audio_processing/audio_processing_impl_unittest.cc',
+                    'audio_processing/debug_dump_writer_unittest.cc',
                     'audio_processing/test/audio_processing_unittest.cc',
                     'audio_processing/test/debug_dump_test.cc',
                     'audio_processing/test/test_utils.h',
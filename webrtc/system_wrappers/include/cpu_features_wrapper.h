@@ -20,7 +20,11 @@ extern "C" {
 // List of features in x86.
 typedef enum {
   kSSE2,
-  kSSE3
+  kSSE3,
+  kAVX2,  // Also implies the OS saves the ymm registers.
+  kFMA3,
+  kSSE4_1,
+  kPOPCNT
 } CPUFeature;
 
 // List of features in ARM.
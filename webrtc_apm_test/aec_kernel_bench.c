@@ -0,0 +1,241 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "webrtc/modules/audio_processing/aec/aec_core.h"
+#include "webrtc/modules/audio_processing/aec/aec_core_internal.h"
+#include "webrtc/system_wrappers/include/cpu_features_wrapper.h"
+
+
+#define LOGW(fmt, ...) fprintf(stderr, fmt"\n", ##__VA_ARGS__)
+#define LOGI           LOGW
+
+#ifndef ARRAY_SIZE
+#define ARRAY_SIZE(ARRAY) (sizeof((ARRAY)) / sizeof((ARRAY)[0]))
+#endif
+
+/*
+ * Times the aec kernels WebRtcAec_CreateAec picks for each instruction set
+ * this cpu has, with the extended filter (kExtendedNumPartitions). The
+ * generic C kernels come first, every other line shows its speedup over
+ * them. Variants that end up with the same kernels (e.g. no AVX2 here, or
+ * NEON builds where the choice is made at compile time) are skipped.
+ *
+ * aec_kernel_bench [-n calls]
+ */
+
+typedef struct _bench_kernels {
+    const char                    *name;
+    WebRtcAecFilterFar             filter_far;
+    WebRtcAecScaleErrorSignal      scale_error_signal;
+    WebRtcAecFilterAdaptation      filter_adaptation;
+    WebRtcAecOverdriveAndSuppress  overdrive_and_suppress;
+} bench_kernels;
+
+enum {
+    BENCH_FILTER_FAR = 0,
+    BENCH_SCALE_ERROR_SIGNAL,
+    BENCH_FILTER_ADAPTATION,
+    BENCH_OVERDRIVE_AND_SUPPRESS,
+    NR_BENCH_KERNEL
+};
+
+static const char *bench_kernel_names[NR_BENCH_KERNEL] = {
+    "FilterFar", "ScaleErrorSignal", "FilterAdaptation", "OverdriveAndSuppress"
+};
+
+static WebRtc_CPUInfo cpu_info_native;
+
+static int cpu_info_without_avx2(CPUFeature feature)
+{
+    return (feature == kAVX2 || feature == kFMA3) ? 0 : cpu_info_native(feature);
+}
+
+static int cpu_info_generic(CPUFeature feature)
+{
+    return WebRtc_GetCPUInfoNoASM(feature);
+}
+
+static int cpu_info_all(CPUFeature feature)
+{
+    return cpu_info_native(feature);
+}
+
+static const struct {
+    const char     *name;
+    WebRtc_CPUInfo  cpu_info;
+} bench_variants[] = {
+    { "generic", cpu_info_generic },
+    { "sse2",    cpu_info_without_avx2 },
+    { "native",  cpu_info_all },
+};
+
+/* the inputs every variant runs on, restored before each call */
+static float x_fft_buf[2][2 * kExtendedNumPartitions * PART_LEN1_PADDED];
+static float h_fft_buf[2][kExtendedNumPartitions * PART_LEN1_PADDED];
+static float h_fft_work[2][kExtendedNumPartitions * PART_LEN1_PADDED];
+static float y_fft[2][PART_LEN1];
+static float ef[2][PART_LEN1], ef_work[2][PART_LEN1];
+static float x_pow[PART_LEN1];
+static float h_nl[PART_LEN1], h_nl_work[PART_LEN1];
+
+static uint64_t now_ns()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static float frand(float min, float max)
+{
+    return min + (max - min) * ((float)rand() / RAND_MAX);
+}
+
+static void fill(float *data, size_t size, float min, float max)
+{
+    for(size_t i = 0; i < size; ++i){
+        data[i] = frand(min, max);
+    }
+}
+
+/* selects the kernels through the same path as the aec, by faking the cpu features */
+static int load_kernels(WebRtc_CPUInfo cpu_info, const char *name, bench_kernels *k)
+{
+    WebRtc_CPUInfo saved = WebRtc_GetCPUInfo;
+    AecCore *aec;
+
+    WebRtc_GetCPUInfo = cpu_info;
+    aec = WebRtcAec_CreateAec();
+    WebRtc_GetCPUInfo = saved;
+
+    if(!aec){
+        return -1;
+    }
+
+    k->name = name;
+    k->filter_far = WebRtcAec_FilterFar;
+    k->scale_error_signal = WebRtcAec_ScaleErrorSignal;
+    k->filter_adaptation = WebRtcAec_FilterAdaptation;
+    k->overdrive_and_suppress = WebRtcAec_OverdriveAndSuppress;
+
+    WebRtcAec_FreeAec(aec);
+
+    return 0;
+}
+
+static double run_kernel(const bench_kernels *k, int kernel, AecCore *aec, int calls)
+{
+    uint64_t start, elapsed = 0;
+
+    for(int n = 0; n < calls; ++n){
+        int block_pos = n % kExtendedNumPartitions;
+
+        /* the kernels work in place, restart each call from the same data */
+        switch(kernel){
+        case BENCH_SCALE_ERROR_SIGNAL:
+            memcpy(ef_work, ef, sizeof(ef));
+            break;
+        case BENCH_FILTER_ADAPTATION:
+            if(n % kExtendedNumPartitions == 0){
+                memcpy(h_fft_work, h_fft_buf, sizeof(h_fft_buf));
+            }
+            break;
+        case BENCH_OVERDRIVE_AND_SUPPRESS:
+            memcpy(h_nl_work, h_nl, sizeof(h_nl));
+            memcpy(ef_work, ef, sizeof(ef));
+            break;
+        }
+
+        start = now_ns();
+
+        switch(kernel){
+        case BENCH_FILTER_FAR:
+            k->filter_far(kExtendedNumPartitions, block_pos, x_fft_buf, h_fft_buf, y_fft);
+            break;
+        case BENCH_SCALE_ERROR_SIGNAL:
+            k->scale_error_signal(1, 0.5f, 2e-6f, x_pow, ef_work);
+            break;
+        case BENCH_FILTER_ADAPTATION:
+            k->filter_adaptation(kExtendedNumPartitions, block_pos, x_fft_buf, ef, h_fft_work);
+            break;
+        case BENCH_OVERDRIVE_AND_SUPPRESS:
+            k->overdrive_and_suppress(aec, h_nl_work, 0.5f, ef_work);
+            break;
+        }
+
+        elapsed += now_ns() - start;
+    }
+
+    return (double)elapsed / calls;
+}
+
+int main(int argc, const char *argv[])
+{
+    bench_kernels kernels[ARRAY_SIZE(bench_variants)];
+    double        ns[ARRAY_SIZE(bench_variants)][NR_BENCH_KERNEL];
+    int           nr_kernels = 0, calls = 200000;
+    AecCore      *aec;
+
+    for(int i = 1; i + 1 < argc; i += 2){
+        if(!strcmp(argv[i], "-n")){
+            calls = atoi(argv[i + 1]);
+        }
+    }
+
+    if(calls <= 0){
+        LOGW("usage: %s [-n calls]", argv[0]);
+        return -1;
+    }
+
+    cpu_info_native = WebRtc_GetCPUInfo;
+
+    for(int v = 0; v < (int)ARRAY_SIZE(bench_variants); ++v){
+        bench_kernels *k = &kernels[nr_kernels];
+        int dup = 0;
+
+        if(load_kernels(bench_variants[v].cpu_info, bench_variants[v].name, k) < 0){
+            LOGW("%s: failed to create the aec", bench_variants[v].name);
+            return -1;
+        }
+
+        for(int i = 0; i < nr_kernels; ++i){
+            dup |= (kernels[i].filter_far == k->filter_far
+                && kernels[i].overdrive_and_suppress == k->overdrive_and_suppress);
+        }
+
+        if(!dup){
+            nr_kernels++;
+        }
+    }
+
+    /* spectra of the magnitude a real stream produces, see aec_core.c */
+    srand(1);
+    fill(&x_fft_buf[0][0], 4 * kExtendedNumPartitions * PART_LEN1_PADDED, -1e3f, 1e3f);
+    fill(&h_fft_buf[0][0], 2 * kExtendedNumPartitions * PART_LEN1_PADDED, -1.f, 1.f);
+    fill(&ef[0][0], 2 * PART_LEN1, -1e2f, 1e2f);
+    fill(x_pow, PART_LEN1, 1e2f, 1e7f);
+    fill(h_nl, PART_LEN1, 1e-3f, 1.f);
+
+    aec = WebRtcAec_CreateAec();
+    if(!aec){
+        return -1;
+    }
+    aec->overDriveSm = 4.f;
+
+    for(int kernel = 0; kernel < NR_BENCH_KERNEL; ++kernel){
+        for(int i = 0; i < nr_kernels; ++i){
+            ns[i][kernel] = run_kernel(&kernels[i], kernel, aec, calls);
+
+            LOGI("%-20s %-8s %8.1f ns/call  x%.2f", bench_kernel_names[kernel],
+                kernels[i].name, ns[i][kernel], ns[0][kernel] / ns[i][kernel]);
+        }
+    }
+
+    WebRtcAec_FreeAec(aec);
+
+    return 0;
+}
@@ -0,0 +1,169 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include <vector>
+
+#include "webrtc/common_audio/channel_buffer.h"
+#include "webrtc/modules/audio_processing/beamformer/nonlinear_beamformer.h"
+#include "webrtc/system_wrappers/include/cpu_features_wrapper.h"
+
+
+#define LOGW(fmt, ...) fprintf(stderr, fmt"\n", ##__VA_ARGS__)
+#define LOGI           LOGW
+
+#ifndef ARRAY_SIZE
+#define ARRAY_SIZE(ARRAY) (sizeof((ARRAY)) / sizeof((ARRAY)[0]))
+#endif
+
+#define BENCH_CHUNK_MS     (10)
+#define BENCH_MIC_SPACING  (0.05f)
+
+/*
+ * Times NonlinearBeamformer::ProcessChunk per 10 ms chunk for linear arrays
+ * of 2, 4 and 8 mics (or the -m one), with the generic postfilter kernels and
+ * with what BinQuadraticForms picks for this cpu, and shows the speedup of the
+ * latter. The time covers the whole chunk, the lapped fft included.
+ * The input is noise with a tone from broadside switching on and off, so both
+ * the target and the interference paths of the postfilter get exercised.
+ *
+ * beamformer_bench [-n chunks] [-m mics] [-f rate]
+ */
+
+static WebRtc_CPUInfo cpu_info_native;
+
+static int cpu_info_generic(CPUFeature feature)
+{
+    return WebRtc_GetCPUInfoNoASM(feature);
+}
+
+static int cpu_info_all(CPUFeature feature)
+{
+    return cpu_info_native(feature);
+}
+
+static const struct {
+    const char     *name;
+    WebRtc_CPUInfo  cpu_info;
+} bench_variants[] = {
+    { "generic", cpu_info_generic },
+    { "native",  cpu_info_all },
+};
+
+static const int bench_mics[] = { 2, 4, 8 };
+
+static uint64_t now_ns()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static float frand(float min, float max)
+{
+    return min + (max - min) * ((float)rand() / RAND_MAX);
+}
+
+static void fill(webrtc::ChannelBuffer<float> *in, int chunk)
+{
+    /* a tone for half a second every second, in phase on every mic */
+    float amplitude = (chunk / 50) % 2 ? 3000.f : 0.f;
+    size_t length = in->num_frames_per_band();
+
+    for(size_t c = 0; c < in->num_channels(); ++c){
+        for(size_t b = 0; b < in->num_bands(); ++b){
+            float *band = in->channels(b)[c];
+
+            for(size_t i = 0; i < length; ++i){
+                size_t t = chunk * length + i;
+
+                band[i] = frand(-500.f, 500.f)
+                    + (b == 0 ? amplitude * sinf(0.2f * t) : 0.f);
+            }
+        }
+    }
+}
+
+static double run(WebRtc_CPUInfo cpu_info, int chunks, int mics, int rate)
+{
+    WebRtc_CPUInfo      saved = WebRtc_GetCPUInfo;
+    std::vector<webrtc::Point> geometry;
+    size_t              bands = rate > 16000 ? (size_t)rate / 16000 : 1;
+    size_t              frames = (size_t)rate / 100;
+    uint64_t            elapsed = 0;
+
+    for(int m = 0; m < mics; ++m){
+        geometry.push_back(webrtc::Point(
+            BENCH_MIC_SPACING * (m - (mics - 1) / 2.f), 0.f, 0.f));
+    }
+
+    webrtc::NonlinearBeamformer bf(geometry);
+    webrtc::ChannelBuffer<float> in(frames, mics, bands);
+    webrtc::ChannelBuffer<float> out(frames, 1, bands);
+
+    /* the kernels are picked when the beamformer is aimed */
+    WebRtc_GetCPUInfo = cpu_info;
+    bf.Initialize(BENCH_CHUNK_MS, rate / (int)bands);
+    WebRtc_GetCPUInfo = saved;
+
+    srand(1);
+    for(int n = 0; n < chunks; ++n){
+        uint64_t start;
+
+        fill(&in, n);
+
+        start = now_ns();
+        bf.ProcessChunk(in, &out);
+        elapsed += now_ns() - start;
+    }
+
+    return (double)elapsed / chunks;
+}
+
+int main(int argc, const char *argv[])
+{
+    double ns[ARRAY_SIZE(bench_variants)];
+    int    chunks = 5000, mics = 0, rate = 16000;
+
+    for(int i = 1; i + 1 < argc; i += 2){
+        if(!strcmp(argv[i], "-n")){
+            chunks = atoi(argv[i + 1]);
+        }else if(!strcmp(argv[i], "-m")){
+            mics = atoi(argv[i + 1]);
+        }else if(!strcmp(argv[i], "-f")){
+            rate = atoi(argv[i + 1]);
+        }
+    }
+
+    if(chunks <= 0 || mics < 0 || mics == 1
+        || (rate != 16000 && rate != 32000 && rate != 48000)){
+        LOGW("usage: %s [-n chunks] [-m mics (2..)] [-f 16000|32000|48000]",
+            argv[0]);
+        return -1;
+    }
+
+    cpu_info_native = WebRtc_GetCPUInfo;
+
+    for(int a = 0; a < (int)ARRAY_SIZE(bench_mics); ++a){
+        int array_mics = mics ? mics : bench_mics[a];
+
+        for(int v = 0; v < (int)ARRAY_SIZE(bench_variants); ++v){
+            ns[v] = run(bench_variants[v].cpu_info, chunks, array_mics, rate);
+
+            LOGI("%-8s %d Hz %d mics  %10.1f ns/chunk  x%.2f",
+                bench_variants[v].name, rate, array_mics, ns[v],
+                ns[0] / ns[v]);
+        }
+
+        if(mics){
+            break;
+        }
+    }
+
+    return 0;
+}
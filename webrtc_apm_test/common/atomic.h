@@ -1,71 +1,41 @@
 /*
- *  copied from kernel: arch/arm/include/asm/atomic.h
- *
- *  Copyright (C) 1996 Russell King.
- *  Copyright (C) 2002 Deep Blue Solutions Ltd.
- *
- * This program is free software; you can redistribute it and/or modify
- * it under the terms of the GNU General Public License version 2 as
- * published by the Free Software Foundation.
+ *  Portable replacement for the ARMv6-only ldrex/strex helpers that were
+ *  copied from the kernel (arch/arm/include/asm/atomic.h). Built on C11
+ *  <stdatomic.h>, so it works on every ABI the NDK targets and on x86 hosts.
  */
-#ifndef __ASM_ARM_ATOMIC_H
-#define __ASM_ARM_ATOMIC_H
+#ifndef __COMMON_ATOMIC_H
+#define __COMMON_ATOMIC_H
 
-typedef struct { 
-    volatile int counter; 
-}atomic_t;
+#include <stdatomic.h>
 
-/*
- * On ARM, ordinary assignment (str instruction) doesn't clear the local
- * strex/ldrex monitor on some implementations. The reason we can use it for
- * atomic_set() is the clrex or dummy strex done on every exception return.
- */
- 
-#define atomic_read(v)	(*(volatile int *)&(v)->counter)
-#define atomic_set(v,i)	(((v)->counter) = (i))
+typedef struct {
+    atomic_int counter;
+}atomic_t;
 
-//#if __LINUX_ARM_ARCH__ >= 6
+#define ATOMIC_INIT(i)  { (i) }
 
-/*
- * ARMv6 UP and SMP safe atomic ops.  We use load exclusive and
- * store exclusive to ensure that these are atomic.  We may loop
- * to ensure that the update happens.
- */
+#define atomic_read(v)	atomic_load_explicit(&(v)->counter, memory_order_acquire)
+#define atomic_set(v,i)	atomic_store_explicit(&(v)->counter, (i), memory_order_release)
 
 static inline void atomic_add(int i, atomic_t *v)
 {
-	unsigned long tmp;
-	int result;
-
-	__asm__ __volatile__("@ atomic_add\n"
-"1:	ldrex	%0, [%3]\n"
-"	add	%0, %0, %4\n"
-"	strex	%1, %0, [%3]\n"
-"	teq	%1, #0\n"
-"	bne	1b"
-	: "=&r" (result), "=&r" (tmp), "+Qo" (v->counter)
-	: "r" (&v->counter), "Ir" (i)
-	: "cc");
+	atomic_fetch_add_explicit(&v->counter, i, memory_order_relaxed);
 }
 
 static inline void atomic_sub(int i, atomic_t *v)
 {
-	unsigned long tmp;
-	int result;
+	atomic_fetch_sub_explicit(&v->counter, i, memory_order_relaxed);
+}
 
-	__asm__ __volatile__("@ atomic_sub\n"
-"1:	ldrex	%0, [%3]\n"
-"	sub	%0, %0, %4\n"
-"	strex	%1, %0, [%3]\n"
-"	teq	%1, #0\n"
-"	bne	1b"
-	: "=&r" (result), "=&r" (tmp), "+Qo" (v->counter)
-	: "r" (&v->counter), "Ir" (i)
-	: "cc");
+/* the *_return variants order the access like a full reference count drop */
+static inline int atomic_add_return(int i, atomic_t *v)
+{
+	return atomic_fetch_add_explicit(&v->counter, i, memory_order_acq_rel) + i;
 }
 
-//#else /* ARM_ARCH_6 */
-//#error No surppor for pre-ARMv6 CPUs
-//#endif
+static inline int atomic_sub_return(int i, atomic_t *v)
+{
+	return atomic_fetch_sub_explicit(&v->counter, i, memory_order_acq_rel) - i;
+}
 
 #endif
@@ -0,0 +1,247 @@
+#include "audio_drift_tracker.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define AP_DRIFT_BLOCK_FRAMES   (100) /* levels are averaged over 1 s, that evens out the callback bursts */
+#define AP_DRIFT_SETTLE_BLOCKS  (1)   /* startup blocks skipped before the target level is taken */
+#define AP_DRIFT_HISTORY_BLOCKS (32)  /* drift is the level slope over the last 32 s */
+#define AP_DRIFT_MIN_BLOCKS     (4)
+#define AP_DRIFT_CATCHUP_BLOCKS (8)   /* a level offset is worked off over 8 s */
+#define AP_DRIFT_MAX_SKEW       (0.002) /* 2000 ppm, far beyond any real crystal */
+#define AP_DRIFT_DELAY_STEP_MS  (8)   /* do not shake the aec for less than this */
+#define AP_DRIFT_MAX_DELAY_MS   (500)
+
+#ifndef MIN
+#define MIN(x,y) ((x)<(y) ?(x):(y))
+#endif
+#ifndef MAX
+#define MAX(x,y) ((x)>(y) ?(x):(y))
+#endif
+
+struct _ap_drift_tracker {
+    uint32_t  freq;
+    uint32_t  channels;
+    uint32_t  frame_samples;
+    int       delay_ms;     /* configured */
+    int       stream_delay; /* handed to the aec */
+
+    /*
+     * level is farend minus nearend samples waiting in the ring buffers.
+     * Corrected reads keep it flat, so the drift is measured on the level
+     * the farend would have without them (level + extra samples read).
+     */
+    int64_t   extra_read;
+    double    level_sum, virt_sum;
+    int       block_frames;
+    int       nr_blocks;
+    double    virt_levels[AP_DRIFT_HISTORY_BLOCKS];
+    double    target;
+    double    drift; /* farend samples gained per nearend sample */
+    double    step;  /* farend samples consumed per output sample */
+
+    /* linear interpolation like WebRtcAec_ResampleLinear, one sample late */
+    double    phase;
+    size_t    need;
+    int16_t  *last;
+    uint64_t  underruns;
+};
+
+ap_drift_tracker* ap_drift_create()
+{
+    ap_drift_tracker *dt;
+
+    dt = (ap_drift_tracker *)malloc(sizeof(*dt));
+    if(dt){
+        memset(dt, 0, sizeof(*dt));
+    }
+
+    return dt;
+}
+
+void ap_drift_free(ap_drift_tracker *dt)
+{
+    if(!dt){
+        return;
+    }
+
+    free(dt->last);
+    free(dt);
+}
+
+int ap_drift_init(ap_drift_tracker *dt, uint32_t freq, uint32_t channels,
+    uint32_t frame_samples, int delay_ms)
+{
+    int16_t *last;
+
+    if(!dt || !freq || !channels || !frame_samples){
+        return -1;
+    }
+
+    last = (int16_t *)realloc(dt->last, channels * sizeof(int16_t));
+    if(!last){
+        return -1;
+    }
+
+    dt->last = last;
+    dt->freq = freq;
+    dt->channels = channels;
+    dt->frame_samples = frame_samples;
+    dt->delay_ms = delay_ms;
+
+    ap_drift_reset(dt);
+
+    return 0;
+}
+
+void ap_drift_reset(ap_drift_tracker *dt)
+{
+    dt->stream_delay = dt->delay_ms;
+
+    dt->extra_read = 0;
+    dt->level_sum = 0.0;
+    dt->virt_sum = 0.0;
+    dt->block_frames = 0;
+    dt->nr_blocks = 0;
+    dt->target = 0.0;
+    dt->drift = 0.0;
+    dt->step = 1.0;
+
+    dt->phase = 0.0;
+    dt->need = dt->frame_samples;
+    memset(dt->last, 0, dt->channels * sizeof(int16_t));
+}
+
+/* least squares slope of the last n virtual levels, per block */
+static double ap_drift_slope(ap_drift_tracker *dt, int stored, int n)
+{
+    double sx = 0.0, sy = 0.0, sxx = 0.0, sxy = 0.0;
+
+    for(int k = 0; k < n; ++k){
+        double y = dt->virt_levels[(stored - n + k) % AP_DRIFT_HISTORY_BLOCKS];
+
+        sx += k;
+        sy += y;
+        sxx += (double)k * k;
+        sxy += k * y;
+    }
+
+    return (n * sxy - sx * sy) / (n * sxx - sx * sx);
+}
+
+static void ap_drift_end_block(ap_drift_tracker *dt)
+{
+    double level = dt->level_sum / AP_DRIFT_BLOCK_FRAMES;
+    double virt = dt->virt_sum / AP_DRIFT_BLOCK_FRAMES;
+    double block_samples = (double)AP_DRIFT_BLOCK_FRAMES * dt->frame_samples;
+    double skew;
+    int stored, delay;
+
+    dt->level_sum = 0.0;
+    dt->virt_sum = 0.0;
+    dt->block_frames = 0;
+
+    if(dt->nr_blocks++ < AP_DRIFT_SETTLE_BLOCKS){
+        return;
+    }
+
+    stored = dt->nr_blocks - AP_DRIFT_SETTLE_BLOCKS;
+    dt->virt_levels[(stored - 1) % AP_DRIFT_HISTORY_BLOCKS] = virt;
+
+    if(stored == 1){
+        dt->target = level;
+        return;
+    }
+
+    if(stored >= AP_DRIFT_MIN_BLOCKS){
+        dt->drift = ap_drift_slope(dt, stored, MIN(stored, AP_DRIFT_HISTORY_BLOCKS)) / block_samples;
+    }
+
+    skew = dt->drift + (level - dt->target) / (AP_DRIFT_CATCHUP_BLOCKS * block_samples);
+    skew = MAX(-AP_DRIFT_MAX_SKEW, MIN(AP_DRIFT_MAX_SKEW, skew));
+
+    dt->step = 1.0 + skew;
+
+    /* farend queued beyond the target reaches the aec that much later than its echo */
+    delay = dt->delay_ms + (int)lrint((dt->target - level) * 1000 / dt->freq);
+    delay = MAX(0, MIN(AP_DRIFT_MAX_DELAY_MS, delay));
+
+    if(abs(delay - dt->stream_delay) >= AP_DRIFT_DELAY_STEP_MS){
+        dt->stream_delay = delay;
+    }
+}
+
+size_t ap_drift_update(ap_drift_tracker *dt, size_t far_level, size_t near_level)
+{
+    double level = (double)far_level - (double)near_level;
+
+    dt->level_sum += level;
+    dt->virt_sum += level + dt->extra_read;
+
+    if(++dt->block_frames == AP_DRIFT_BLOCK_FRAMES){
+        ap_drift_end_block(dt);
+    }
+
+    /* the sample after the last one this frame interpolates, see ap_drift_stretch */
+    dt->need = (size_t)(dt->phase + dt->frame_samples * dt->step);
+    dt->extra_read += (int64_t)dt->need - dt->frame_samples;
+
+    return dt->need;
+}
+
+void ap_drift_stretch(ap_drift_tracker *dt, const int16_t *in,
+    size_t avail_frames, int16_t *out)
+{
+    size_t channels = dt->channels;
+    size_t need = dt->need;
+
+    /* the farend missing from a short read never comes back, it slips */
+    if(avail_frames < need){
+        dt->extra_read -= need - avail_frames;
+        dt->underruns++;
+    }
+
+    /*
+     * Output sample j sits at phase + j * step on the input, where 0 is the
+     * last sample of the previous frame and k is in[k - 1]. The very last
+     * output may land a hair past in[need - 1] when step < 1, it is taken
+     * as in[need - 1] then.
+     */
+    for(size_t j = 0; j < dt->frame_samples; ++j){
+        double pos = dt->phase + j * dt->step;
+        size_t i = (size_t)pos;
+        float frac = (float)(pos - i);
+
+        if(i >= need){
+            i = need;
+            frac = 0.0f;
+        }
+
+        for(size_t ch = 0; ch < channels; ++ch){
+            float a = i ? in[(i - 1) * channels + ch] : dt->last[ch];
+            float b = (frac > 0.0f) ? in[i * channels + ch] : a;
+
+            out[j * channels + ch] = (int16_t)lrintf(a + frac * (b - a));
+        }
+    }
+
+    memcpy(dt->last, &in[(need - 1) * channels], channels * sizeof(int16_t));
+
+    dt->phase += dt->frame_samples * dt->step - need;
+}
+
+int ap_drift_get_delay(ap_drift_tracker *dt)
+{
+    return dt->stream_delay;
+}
+
+double ap_drift_get_ppm(ap_drift_tracker *dt)
+{
+    return dt->drift * 1e6;
+}
+
+uint64_t ap_drift_get_underruns(ap_drift_tracker *dt)
+{
+    return dt->underruns;
+}
@@ -0,0 +1,51 @@
+#ifndef _AUDIO_DRIFT_TRACKER_H_
+#define _AUDIO_DRIFT_TRACKER_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * Follows the clock drift and delay between the farend and nearend ring
+ * buffers of one audio_proc_ctx. Fed the fill levels once per 10 ms frame,
+ * it tells how many farend samples to consume for the frame (a fraction
+ * more or less than a frame, carried between frames) and stretches them
+ * back to a frame, so the farend level stays where the stream started.
+ * Only called from the processing thread.
+ */
+typedef struct _ap_drift_tracker ap_drift_tracker;
+
+ap_drift_tracker* ap_drift_create();
+
+void ap_drift_free(ap_drift_tracker *dt);
+
+/* frame_samples per channel at freq, delay_ms is the configured aec delay */
+int ap_drift_init(ap_drift_tracker *dt, uint32_t freq, uint32_t channels,
+    uint32_t frame_samples, int delay_ms);
+
+/* forget the measured drift and levels, for a new stream */
+void ap_drift_reset(ap_drift_tracker *dt);
+
+/*
+ * far_level/near_level are the samples per channel waiting in the ring
+ * buffers before the frame is read. Returns the farend samples per channel
+ * to read for this frame, frame_samples +- 1.
+ */
+size_t ap_drift_update(ap_drift_tracker *dt, size_t far_level, size_t near_level);
+
+/*
+ * Stretches the interleaved farend samples read for the frame (as many as
+ * ap_drift_update returned) into frame_samples at out. avail_frames below
+ * that is an underrun, counted here; the caller zero fills the tail.
+ */
+void ap_drift_stretch(ap_drift_tracker *dt, const int16_t *in,
+    size_t avail_frames, int16_t *out);
+
+/* delay (ms) to hand the aec, the configured one corrected by the farend level */
+int ap_drift_get_delay(ap_drift_tracker *dt);
+
+/* farend clock relative to the nearend clock, in ppm */
+double ap_drift_get_ppm(ap_drift_tracker *dt);
+
+uint64_t ap_drift_get_underruns(ap_drift_tracker *dt);
+
+#endif
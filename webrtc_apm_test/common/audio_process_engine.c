@@ -0,0 +1,515 @@
+#include "audio_process_engine.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#include "w_log.h"
+
+#define audio_proc_log_warn LOGW
+#define audio_proc_log_info LOGI
+
+#define AP_ENGINE_MAX_WORKERS    (64)
+#define AP_ENGINE_JOBS_PER_SLOT  (4)
+
+
+typedef struct _ap_engine_session {
+    audio_proc_ctx *ap_ctx;
+    bool            in_use;
+    int             worker;
+
+    uint32_t        channels;
+    uint32_t        nearend_freq;
+    uint32_t        farend_freq;
+    uint32_t        aec_delay;
+
+    uint32_t        nr_pending; // jobs submitted and not processed yet, under pending_lock
+} ap_engine_session;
+
+typedef struct _ap_engine_job {
+    ap_engine_session  *session;
+    audio_proc_ctx     *ap_ctx;
+    uint8_t            *out;
+    size_t              out_size;
+    ap_engine_done_pft  done;
+    void               *args;
+} ap_engine_job;
+
+typedef struct _ap_engine_worker {
+    audio_proc_engine *engine;
+    pthread_t          thread;
+    pthread_mutex_t    lock;
+    pthread_cond_t     cond;
+    bool               started;
+
+    ap_engine_job     *jobs;
+    uint32_t           nr_jobs, max_jobs;
+    uint32_t           head, tail;
+} ap_engine_worker;
+
+struct _audio_proc_engine {
+    int                inited;
+    bool               quit;
+
+    pthread_mutex_t    pool_lock;
+    ap_engine_session *sessions;
+    uint32_t           max_sessions;
+    uint32_t           nr_sessions;
+
+    ap_engine_worker  *workers;
+    uint32_t           nr_workers;
+
+    pthread_mutex_t    pending_lock;
+    pthread_cond_t     pending_cond;
+    uint32_t           nr_pending;
+};
+
+
+static void ap_engine_add_pending(audio_proc_engine* engine, ap_engine_session *session)
+{
+    pthread_mutex_lock(&engine->pending_lock);
+    session->nr_pending++;
+    engine->nr_pending++;
+    pthread_mutex_unlock(&engine->pending_lock);
+}
+
+/* wakes ap_engine_wait and ap_engine_close_session once their count drains */
+static void ap_engine_del_pending(audio_proc_engine* engine, ap_engine_session *session)
+{
+    pthread_mutex_lock(&engine->pending_lock);
+    --engine->nr_pending;
+    if(--session->nr_pending == 0 || engine->nr_pending == 0){
+        pthread_cond_broadcast(&engine->pending_cond);
+    }
+    pthread_mutex_unlock(&engine->pending_lock);
+}
+
+static void ap_engine_run_job(audio_proc_engine* engine, ap_engine_job *job)
+{
+    int processed;
+
+    processed = ap_ctx_try_process(job->ap_ctx, job->out, job->out_size);
+
+    if(job->done){
+        job->done(job->ap_ctx, job->out, processed, job->args);
+    }
+
+    ap_engine_del_pending(engine, job->session);
+}
+
+static void* ap_engine_worker_loop(void *args)
+{
+    ap_engine_worker  *worker = (ap_engine_worker *)args;
+    audio_proc_engine *engine = worker->engine;
+    ap_engine_job      job;
+
+    for(;;){
+        pthread_mutex_lock(&worker->lock);
+
+        while(!worker->nr_jobs && !engine->quit){
+            pthread_cond_wait(&worker->cond, &worker->lock);
+        }
+
+        if(!worker->nr_jobs){
+            pthread_mutex_unlock(&worker->lock);
+            break;
+        }
+
+        job = worker->jobs[worker->head];
+        worker->head = (worker->head + 1) % worker->max_jobs;
+        worker->nr_jobs--;
+
+        pthread_mutex_unlock(&worker->lock);
+
+        ap_engine_run_job(engine, &job);
+    }
+
+    return NULL;
+}
+
+audio_proc_engine* ap_engine_create()
+{
+    audio_proc_engine* engine;
+
+    engine = (audio_proc_engine*)malloc(sizeof(audio_proc_engine));
+    if(engine){
+        memset(engine, 0, sizeof(*engine));
+    }
+
+    return engine;
+}
+
+void ap_engine_free(audio_proc_engine* engine)
+{
+    free(engine);
+}
+
+int ap_engine_init(audio_proc_engine* engine, uint32_t max_sessions, uint32_t nr_workers)
+{
+    uint32_t max_jobs;
+
+    if(!engine || !max_sessions){
+        return -1;
+    }
+
+    if(engine->inited){
+        audio_proc_log_warn("audio process engine is inited, sessions %d, workers %d",
+            engine->max_sessions, engine->nr_workers);
+        return engine->inited;
+    }
+
+    if(nr_workers > AP_ENGINE_MAX_WORKERS){
+        nr_workers = AP_ENGINE_MAX_WORKERS;
+    }
+
+    engine->sessions = (ap_engine_session*)calloc(max_sessions, sizeof(ap_engine_session));
+    if(!engine->sessions){
+        audio_proc_log_warn("Failed to alloc %d engine sessions", max_sessions);
+        return -1;
+    }
+
+    engine->max_sessions = max_sessions;
+    engine->nr_sessions = 0;
+    engine->nr_pending = 0;
+    engine->quit = false;
+
+    pthread_mutex_init(&engine->pool_lock, NULL);
+    pthread_mutex_init(&engine->pending_lock, NULL);
+    pthread_cond_init(&engine->pending_cond, NULL);
+
+    if(nr_workers){
+        engine->workers = (ap_engine_worker*)calloc(nr_workers, sizeof(ap_engine_worker));
+        if(!engine->workers){
+            audio_proc_log_warn("Failed to alloc %d engine workers", nr_workers);
+            nr_workers = 0;
+        }
+    }
+
+    /* every session bound to a worker may have a few frames in flight */
+    max_jobs = ((max_sessions + nr_workers - 1) / (nr_workers ? nr_workers : 1)) * AP_ENGINE_JOBS_PER_SLOT;
+
+    for(uint32_t i = 0; i < nr_workers; ++i){
+        ap_engine_worker *worker = &engine->workers[i];
+
+        worker->engine = engine;
+        worker->max_jobs = max_jobs;
+        worker->jobs = (ap_engine_job*)calloc(max_jobs, sizeof(ap_engine_job));
+
+        pthread_mutex_init(&worker->lock, NULL);
+        pthread_cond_init(&worker->cond, NULL);
+
+        if(!worker->jobs || pthread_create(&worker->thread, NULL, ap_engine_worker_loop, worker)){
+            audio_proc_log_warn("Failed to start engine worker %d", i);
+
+            pthread_mutex_destroy(&worker->lock);
+            pthread_cond_destroy(&worker->cond);
+            free(worker->jobs);
+            worker->jobs = NULL;
+            break;
+        }
+
+        worker->started = true;
+        engine->nr_workers++;
+    }
+
+    for(uint32_t i = 0; i < max_sessions; ++i){
+        engine->sessions[i].worker = engine->nr_workers ? (i % engine->nr_workers) : -1;
+    }
+
+    audio_proc_log_info("audio process engine, sessions %d, workers %d",
+        engine->max_sessions, engine->nr_workers);
+
+    engine->inited = 1;
+
+    return 0;
+}
+
+void ap_engine_fini(audio_proc_engine* engine)
+{
+    if(!engine || !engine->inited){
+        return;
+    }
+
+    ap_engine_wait(engine);
+
+    for(uint32_t i = 0; i < engine->nr_workers; ++i){
+        ap_engine_worker *worker = &engine->workers[i];
+
+        pthread_mutex_lock(&worker->lock);
+        engine->quit = true;
+        pthread_cond_signal(&worker->cond);
+        pthread_mutex_unlock(&worker->lock);
+    }
+
+    for(uint32_t i = 0; i < engine->nr_workers; ++i){
+        ap_engine_worker *worker = &engine->workers[i];
+
+        if(worker->started){
+            pthread_join(worker->thread, NULL);
+        }
+
+        pthread_mutex_destroy(&worker->lock);
+        pthread_cond_destroy(&worker->cond);
+        free(worker->jobs);
+    }
+
+    for(uint32_t i = 0; i < engine->max_sessions; ++i){
+        ap_engine_session *session = &engine->sessions[i];
+
+        if(session->ap_ctx){
+            /* drop the reference taken by the pool, this finis the context */
+            ap_ctx_unref(session->ap_ctx);
+            ap_ctx_free(session->ap_ctx);
+        }
+    }
+
+    pthread_mutex_destroy(&engine->pool_lock);
+    pthread_mutex_destroy(&engine->pending_lock);
+    pthread_cond_destroy(&engine->pending_cond);
+
+    free(engine->workers);
+    free(engine->sessions);
+
+    memset(engine, 0, sizeof(*engine));
+
+    audio_proc_log_info("audio process engine was freed");
+}
+
+static ap_engine_session* ap_engine_find_session(audio_proc_engine* engine, audio_proc_ctx* ap_ctx)
+{
+    for(uint32_t i = 0; i < engine->max_sessions; ++i){
+        if(engine->sessions[i].in_use && engine->sessions[i].ap_ctx == ap_ctx){
+            return &engine->sessions[i];
+        }
+    }
+
+    return NULL;
+}
+
+static ap_engine_session* ap_engine_pick_slot(audio_proc_engine* engine, uint32_t channels,
+    uint32_t nearend_freq, uint32_t farend_freq, uint32_t aec_delay)
+{
+    ap_engine_session *empty = NULL, *stale = NULL;
+
+    for(uint32_t i = 0; i < engine->max_sessions; ++i){
+        ap_engine_session *session = &engine->sessions[i];
+
+        if(session->in_use){
+            continue;
+        }
+
+        if(!session->ap_ctx){
+            if(!empty){
+                empty = session;
+            }
+            continue;
+        }
+
+        if(session->channels == channels && session->nearend_freq == nearend_freq
+            && session->farend_freq == farend_freq && session->aec_delay == aec_delay){
+            return session;
+        }
+
+        if(!stale){
+            stale = session;
+        }
+    }
+
+    return empty ? empty : stale;
+}
+
+audio_proc_ctx* ap_engine_open_session(audio_proc_engine* engine, uint32_t channels,
+    uint32_t nearend_freq, uint32_t farend_freq, uint32_t aec_delay)
+{
+    int rc;
+    ap_engine_session *session;
+
+    if(!engine || !engine->inited){
+        return NULL;
+    }
+
+    pthread_mutex_lock(&engine->pool_lock);
+
+    session = ap_engine_pick_slot(engine, channels, nearend_freq, farend_freq, aec_delay);
+    if(!session){
+        pthread_mutex_unlock(&engine->pool_lock);
+
+        audio_proc_log_warn("No free audio process session, %d in use", engine->nr_sessions);
+        return NULL;
+    }
+
+    session->in_use = true;
+    engine->nr_sessions++;
+
+    pthread_mutex_unlock(&engine->pool_lock);
+
+    if(session->ap_ctx && (session->channels != channels || session->nearend_freq != nearend_freq
+        || session->farend_freq != farend_freq || session->aec_delay != aec_delay)){
+        /* format changed, rebuild this pooled context from scratch */
+        ap_ctx_unref(session->ap_ctx);
+    }
+
+    if(!session->ap_ctx){
+        session->ap_ctx = ap_ctx_create();
+    }
+
+    if(!session->ap_ctx){
+        rc = -1;
+    }else if(session->channels == channels && session->nearend_freq == nearend_freq
+        && session->farend_freq == farend_freq && session->aec_delay == aec_delay
+        && ap_ctx_get_per_proc_bytes(session->ap_ctx) > 0){
+        rc = ap_ctx_recycle(session->ap_ctx);
+    }else{
+        rc = ap_ctx_init(session->ap_ctx, channels, nearend_freq, farend_freq, aec_delay);
+        if(rc >= 0){
+            /* the pool holds one reference for the lifetime of the engine */
+            ap_ctx_ref(session->ap_ctx);
+        }
+    }
+
+    if(rc < 0){
+        pthread_mutex_lock(&engine->pool_lock);
+        session->in_use = false;
+        engine->nr_sessions--;
+        pthread_mutex_unlock(&engine->pool_lock);
+
+        audio_proc_log_warn("Failed to open audio process session, channels %d, nearend freq %d, farend freq %d",
+            channels, nearend_freq, farend_freq);
+        return NULL;
+    }
+
+    session->channels = channels;
+    session->nearend_freq = nearend_freq;
+    session->farend_freq = farend_freq;
+    session->aec_delay = aec_delay;
+
+    /* ap_ctx_init / ap_ctx_recycle already applied this format and reset
+     * the aec/ns/agc once, the set_*_info calls would reset them again */
+    ap_ctx_set_nearend_is_ready(session->ap_ctx, 1);
+    ap_ctx_set_farend_is_ready(session->ap_ctx, 1);
+
+    return session->ap_ctx;
+}
+
+int ap_engine_close_session(audio_proc_engine* engine, audio_proc_ctx* ap_ctx)
+{
+    ap_engine_session *session;
+
+    if(!engine || !engine->inited || !ap_ctx){
+        return -1;
+    }
+
+    pthread_mutex_lock(&engine->pool_lock);
+    session = ap_engine_find_session(engine, ap_ctx);
+    pthread_mutex_unlock(&engine->pool_lock);
+
+    if(!session){
+        return -1;
+    }
+
+    /* the worker may still hold frames of this session, the other
+     * sessions keep streaming meanwhile */
+    pthread_mutex_lock(&engine->pending_lock);
+    while(session->nr_pending){
+        pthread_cond_wait(&engine->pending_cond, &engine->pending_lock);
+    }
+    pthread_mutex_unlock(&engine->pending_lock);
+
+    ap_ctx_set_nearend_is_ready(ap_ctx, 0);
+    ap_ctx_set_farend_is_ready(ap_ctx, 0);
+
+    pthread_mutex_lock(&engine->pool_lock);
+    session->in_use = false;
+    engine->nr_sessions--;
+    pthread_mutex_unlock(&engine->pool_lock);
+
+    return 0;
+}
+
+int ap_engine_get_nr_sessions(audio_proc_engine* engine)
+{
+    int nr_sessions;
+
+    if(!engine || !engine->inited){
+        return 0;
+    }
+
+    pthread_mutex_lock(&engine->pool_lock);
+    nr_sessions = engine->nr_sessions;
+    pthread_mutex_unlock(&engine->pool_lock);
+
+    return nr_sessions;
+}
+
+int ap_engine_submit(audio_proc_engine* engine, audio_proc_ctx* ap_ctx,
+    uint8_t *out, size_t out_size, ap_engine_done_pft done, void *args)
+{
+    ap_engine_session *session;
+    ap_engine_worker  *worker;
+    ap_engine_job      job;
+
+    if(!engine || !engine->inited || !ap_ctx){
+        return -1;
+    }
+
+    pthread_mutex_lock(&engine->pool_lock);
+    session = ap_engine_find_session(engine, ap_ctx);
+    pthread_mutex_unlock(&engine->pool_lock);
+
+    if(!session){
+        return -1;
+    }
+
+    job.session = session;
+    job.ap_ctx = ap_ctx;
+    job.out = out;
+    job.out_size = out_size;
+    job.done = done;
+    job.args = args;
+
+    ap_engine_add_pending(engine, session);
+
+    if(session->worker < 0){
+        ap_engine_run_job(engine, &job);
+        return 0;
+    }
+
+    worker = &engine->workers[session->worker];
+
+    pthread_mutex_lock(&worker->lock);
+
+    if(worker->nr_jobs >= worker->max_jobs){
+        pthread_mutex_unlock(&worker->lock);
+
+        ap_engine_del_pending(engine, session);
+
+        audio_proc_log_warn("audio process worker %d is full, %d jobs", session->worker, worker->nr_jobs);
+        return -1;
+    }
+
+    worker->jobs[worker->tail] = job;
+    worker->tail = (worker->tail + 1) % worker->max_jobs;
+    worker->nr_jobs++;
+
+    pthread_cond_signal(&worker->cond);
+    pthread_mutex_unlock(&worker->lock);
+
+    return 0;
+}
+
+int ap_engine_wait(audio_proc_engine* engine)
+{
+    if(!engine || !engine->inited){
+        return -1;
+    }
+
+    pthread_mutex_lock(&engine->pending_lock);
+    while(engine->nr_pending){
+        pthread_cond_wait(&engine->pending_cond, &engine->pending_lock);
+    }
+    pthread_mutex_unlock(&engine->pending_lock);
+
+    return 0;
+}
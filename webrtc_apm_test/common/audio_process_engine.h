@@ -0,0 +1,52 @@
+#ifndef _AUDIO_PROCESS_ENGINE_H_
+#define _AUDIO_PROCESS_ENGINE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "audio_process_util.h"
+
+/*
+ * Session manager for running many independent audio_proc_ctx at once.
+ *
+ * Every session owns its own aec/ns/agc handles, resamplers, ring buffers
+ * and splitting filters. Closed sessions stay in the pool and are recycled
+ * by the next open with the same format, so call setup does not pay the
+ * (large) ring buffer and engine allocation again.
+ *
+ * Processing can be handed to a pool of worker threads. A session is always
+ * bound to the same worker, so its frames are processed in submit order and
+ * its state stays in one core's cache.
+ */
+
+typedef struct _audio_proc_engine audio_proc_engine;
+
+/* called on the worker thread once a submitted job was processed */
+typedef void (*ap_engine_done_pft)(audio_proc_ctx* ap_ctx,
+    uint8_t *out, int processed, void *args);
+
+audio_proc_engine* ap_engine_create();
+
+void ap_engine_free(audio_proc_engine* engine);
+
+/* nr_workers == 0 processes every submitted job inline on the caller */
+int ap_engine_init(audio_proc_engine* engine, uint32_t max_sessions, uint32_t nr_workers);
+
+void ap_engine_fini(audio_proc_engine* engine);
+
+audio_proc_ctx* ap_engine_open_session(audio_proc_engine* engine, uint32_t channels,
+    uint32_t nearend_freq, uint32_t farend_freq, uint32_t aec_delay);
+
+/* waits for the jobs of this session still queued, not for the others */
+int ap_engine_close_session(audio_proc_engine* engine, audio_proc_ctx* ap_ctx);
+
+int ap_engine_get_nr_sessions(audio_proc_engine* engine);
+
+/* queue one ap_ctx_try_process() of the session on its worker */
+int ap_engine_submit(audio_proc_engine* engine, audio_proc_ctx* ap_ctx,
+    uint8_t *out, size_t out_size, ap_engine_done_pft done, void *args);
+
+/* block until every submitted job was processed */
+int ap_engine_wait(audio_proc_engine* engine);
+
+#endif
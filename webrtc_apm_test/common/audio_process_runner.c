@@ -0,0 +1,449 @@
+#include "audio_process_runner.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "audio_process_util.h"
+#include "audio_process_engine.h"
+
+#include "w_log.h"
+
+#define audio_proc_log_warn LOGW
+#define audio_proc_log_info LOGI
+
+#define AP_RUNNER_MAX_THREADS    (64)
+#define AP_RUNNER_IO_BUF_SIZE    (1024 * 1024)
+#define AP_RUNNER_MAX_PATH       (4096)
+
+
+typedef struct _ap_runner_map {
+    const uint8_t *data;
+    size_t         size;
+} ap_runner_map;
+
+typedef struct _ap_runner {
+    const ap_runner_config *config;
+    audio_proc_engine      *engine;
+
+    ap_runner_job          *jobs;
+    int                     nr_jobs;
+
+    pthread_mutex_t         lock;
+    int                     next_job;
+} ap_runner;
+
+
+static double now_secs()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int ap_runner_map_file(const char *path, ap_runner_map *map)
+{
+    int fd;
+    struct stat st;
+    void *data;
+
+    memset(map, 0, sizeof(*map));
+
+    fd = open(path, O_RDONLY);
+    if(fd < 0){
+        audio_proc_log_warn("Failed to open file %s", path);
+        return -1;
+    }
+
+    if(fstat(fd, &st) < 0){
+        close(fd);
+        return -1;
+    }
+
+    if(st.st_size == 0){
+        /* nothing to map, an empty farend just means no echo */
+        close(fd);
+        return 0;
+    }
+
+    data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if(data == MAP_FAILED){
+        audio_proc_log_warn("Failed to mmap file %s", path);
+        return -1;
+    }
+
+    /* read once front to back, let the kernel read ahead aggressively */
+    madvise(data, st.st_size, MADV_SEQUENTIAL);
+
+    map->data = (const uint8_t *)data;
+    map->size = st.st_size;
+
+    return 0;
+}
+
+static void ap_runner_unmap_file(ap_runner_map *map)
+{
+    if(map->data){
+        munmap((void *)map->data, map->size);
+    }
+
+    memset(map, 0, sizeof(*map));
+}
+
+/* FNV-1a over the output, so a repeated run is compared without keeping it */
+static uint64_t ap_runner_hash(uint64_t hash, const void *data, size_t size)
+{
+    const uint8_t *p = (const uint8_t *)data;
+
+    for(size_t i = 0; i < size; ++i){
+        hash = (hash ^ p[i]) * 0x100000001b3ULL;
+    }
+
+    return hash;
+}
+
+/* processes one job into job->out_path, or only into *hash if write_out is not set */
+static int ap_runner_process_job(ap_runner *runner, ap_runner_job *job,
+    bool write_out, uint64_t *hash)
+{
+    const ap_runner_config *config = runner->config;
+    ap_runner_map   farend, nearend;
+    audio_proc_ctx *ap_ctx = NULL;
+    FILE           *out_fp = NULL;
+    int16_t        *out = NULL, *farend_pad = NULL;
+    size_t          frame_bytes, batch_bytes, out_samples, offset;
+    int             rc = -1;
+
+    frame_bytes = (config->frequency / 100) * config->channels * sizeof(int16_t);
+    batch_bytes = frame_bytes * config->batch_frames;
+
+    /* the output resampler may hand back a block it held from the previous batch */
+    out_samples = (batch_bytes + frame_bytes) / sizeof(int16_t);
+
+    if(ap_runner_map_file(job->farend_path, &farend) < 0){
+        return -1;
+    }
+
+    if(ap_runner_map_file(job->nearend_path, &nearend) < 0){
+        ap_runner_unmap_file(&farend);
+        return -1;
+    }
+
+    job->audio_secs = (double)nearend.size / (frame_bytes * 100);
+
+    out = (int16_t *)malloc(out_samples * sizeof(int16_t));
+    farend_pad = (int16_t *)malloc(batch_bytes);
+    if(!out || !farend_pad){
+        audio_proc_log_warn("Failed to alloc buffers for %s", job->nearend_path);
+        goto out;
+    }
+
+    if(write_out){
+        out_fp = fopen(job->out_path, "wb");
+        if(!out_fp){
+            audio_proc_log_warn("Failed to open file %s", job->out_path);
+            goto out;
+        }
+
+        setvbuf(out_fp, NULL, _IOFBF, AP_RUNNER_IO_BUF_SIZE);
+    }
+
+    *hash = 0xcbf29ce484222325ULL;
+
+    ap_ctx = ap_engine_open_session(runner->engine, config->channels,
+        config->frequency, config->frequency, config->aec_delay);
+    if(!ap_ctx){
+        goto out;
+    }
+
+    /* pooled contexts come back recycled to the ap_ctx_init defaults,
+     * only the options of this job need setting */
+    if(config->resampler){
+        ap_ctx_set_resampler_backend(ap_ctx, config->resampler);
+    }
+
+    if(config->shared_farend){
+        ap_ctx_set_shared_farend(ap_ctx, config->shared_farend);
+    }
+
+    rc = 0;
+
+    for(offset = 0; offset + frame_bytes <= nearend.size; ){
+        const int16_t *farend_frames;
+        size_t chunk;
+        int processed;
+
+        chunk = nearend.size - offset;
+        chunk = (chunk < batch_bytes) ? chunk : batch_bytes;
+        chunk -= chunk % frame_bytes;
+
+        if(offset + chunk <= farend.size){
+            farend_frames = (const int16_t *)(farend.data + offset);
+        }else{
+            /* the farend ran out, pad its tail with silence */
+            size_t left = (farend.size > offset) ? (farend.size - offset) : 0;
+
+            if(left){
+                memcpy(farend_pad, farend.data + offset, left);
+            }
+
+            memset((uint8_t *)farend_pad + left, 0, chunk - left);
+            farend_frames = farend_pad;
+        }
+
+        processed = ap_ctx_process_batch(ap_ctx, farend_frames,
+            (const int16_t *)(nearend.data + offset), chunk / frame_bytes, out, out_samples);
+        if(processed < 0){
+            audio_proc_log_warn("Failed to process %s at %zu", job->nearend_path, offset);
+            rc = processed;
+            break;
+        }
+
+        *hash = ap_runner_hash(*hash, out, processed * sizeof(int16_t));
+
+        if(out_fp && fwrite(out, sizeof(int16_t), processed, out_fp) != (size_t)processed){
+            audio_proc_log_warn("Failed to write file %s", job->out_path);
+            rc = -1;
+            break;
+        }
+
+        offset += chunk;
+    }
+
+    ap_engine_close_session(runner->engine, ap_ctx);
+
+out:
+    if(out_fp && fclose(out_fp) != 0){
+        rc = -1;
+    }
+
+    free(out);
+    free(farend_pad);
+
+    ap_runner_unmap_file(&farend);
+    ap_runner_unmap_file(&nearend);
+
+    return rc;
+}
+
+static void* ap_runner_loop(void *args)
+{
+    ap_runner *runner = (ap_runner *)args;
+    ap_runner_job *job;
+    uint64_t hash, repeat_hash;
+    double start;
+
+    for(;;){
+        pthread_mutex_lock(&runner->lock);
+        job = (runner->next_job < runner->nr_jobs) ? &runner->jobs[runner->next_job++] : NULL;
+        pthread_mutex_unlock(&runner->lock);
+
+        if(!job){
+            break;
+        }
+
+        start = now_secs();
+        job->rc = ap_runner_process_job(runner, job, true, &hash);
+        job->proc_secs = now_secs() - start;
+
+        if(runner->config->verify && job->rc >= 0){
+            /* the context of the first run is back in the pool and recycled
+             * for this one, which must not make any difference */
+            if(ap_runner_process_job(runner, job, false, &repeat_hash) < 0 || repeat_hash != hash){
+                audio_proc_log_warn("%s: a repeated run gives a different output (%016llx, %016llx)",
+                    job->nearend_path, (unsigned long long)hash, (unsigned long long)repeat_hash);
+                job->rc = -1;
+            }
+        }
+
+        audio_proc_log_info("%s: %s, %.2f s audio in %.3f s, rtf %.4f",
+            job->nearend_path, job->rc < 0 ? "failed" : "done", job->audio_secs, job->proc_secs,
+            job->audio_secs > 0 ? job->proc_secs / job->audio_secs : 0.0);
+    }
+
+    return NULL;
+}
+
+static char* ap_runner_strdup(const char *str)
+{
+    size_t size = strlen(str) + 1;
+    char *dup;
+
+    dup = (char *)malloc(size);
+    if(dup){
+        memcpy(dup, str, size);
+    }
+
+    return dup;
+}
+
+int ap_runner_load_manifest(const char *path, ap_runner_job **jobs)
+{
+    FILE *fp;
+    char line[AP_RUNNER_MAX_PATH * 3 + 16];
+    char farend[AP_RUNNER_MAX_PATH], nearend[AP_RUNNER_MAX_PATH], out[AP_RUNNER_MAX_PATH];
+    ap_runner_job *list = NULL, *tmp;
+    int nr_jobs = 0, max_jobs = 0, lineno = 0;
+
+    *jobs = NULL;
+
+    fp = fopen(path, "r");
+    if(!fp){
+        audio_proc_log_warn("Failed to open manifest %s", path);
+        return -1;
+    }
+
+    while(fgets(line, sizeof(line), fp)){
+        char *comment;
+
+        lineno++;
+
+        comment = strchr(line, '#');
+        if(comment){
+            *comment = '\0';
+        }
+
+        if(sscanf(line, "%4095s %4095s %4095s", farend, nearend, out) != 3){
+            if(strspn(line, " \t\r\n") != strlen(line)){
+                audio_proc_log_warn("%s:%d: expected <farend> <nearend> <out>", path, lineno);
+            }
+            continue;
+        }
+
+        if(nr_jobs == max_jobs){
+            max_jobs = max_jobs ? max_jobs * 2 : 64;
+
+            tmp = (ap_runner_job *)realloc(list, max_jobs * sizeof(*list));
+            if(!tmp){
+                audio_proc_log_warn("%s:%d: Failed to alloc %d jobs", path, lineno, max_jobs);
+                goto fail;
+            }
+
+            list = tmp;
+        }
+
+        memset(&list[nr_jobs], 0, sizeof(list[nr_jobs]));
+        list[nr_jobs].farend_path = ap_runner_strdup(farend);
+        list[nr_jobs].nearend_path = ap_runner_strdup(nearend);
+        list[nr_jobs].out_path = ap_runner_strdup(out);
+        nr_jobs++;
+
+        if(!list[nr_jobs - 1].farend_path || !list[nr_jobs - 1].nearend_path || !list[nr_jobs - 1].out_path){
+            audio_proc_log_warn("%s:%d: Failed to alloc the job paths", path, lineno);
+            goto fail;
+        }
+    }
+
+    fclose(fp);
+
+    *jobs = list;
+
+    return nr_jobs;
+
+fail:
+    fclose(fp);
+
+    ap_runner_free_jobs(list, nr_jobs);
+
+    return -1;
+}
+
+void ap_runner_free_jobs(ap_runner_job *jobs, int nr_jobs)
+{
+    for(int i = 0; i < nr_jobs && jobs; ++i){
+        free(jobs[i].farend_path);
+        free(jobs[i].nearend_path);
+        free(jobs[i].out_path);
+    }
+
+    free(jobs);
+}
+
+int ap_runner_run(const ap_runner_config *config, ap_runner_job *jobs, int nr_jobs)
+{
+    ap_runner  runner;
+    pthread_t  threads[AP_RUNNER_MAX_THREADS];
+    uint32_t   nr_threads, nr_started = 0;
+    double     start, wall_secs, audio_secs = 0.0, proc_secs = 0.0;
+    int        failed = 0;
+
+    if(!config || !config->channels || !config->frequency || !config->batch_frames){
+        return -1;
+    }
+
+    nr_threads = config->nr_threads ? config->nr_threads : 1;
+    nr_threads = (nr_threads < AP_RUNNER_MAX_THREADS) ? nr_threads : AP_RUNNER_MAX_THREADS;
+    nr_threads = (nr_threads < (uint32_t)nr_jobs) ? nr_threads : (uint32_t)nr_jobs;
+
+    memset(&runner, 0, sizeof(runner));
+
+    runner.config = config;
+    runner.jobs = jobs;
+    runner.nr_jobs = nr_jobs;
+
+    /* one pooled context per thread, processing is done by the runner threads */
+    runner.engine = ap_engine_create();
+    if(!runner.engine || ap_engine_init(runner.engine, nr_threads ? nr_threads : 1, 0) < 0){
+        audio_proc_log_warn("Failed to init audio process engine for %d threads", nr_threads);
+        ap_engine_free(runner.engine);
+        return -1;
+    }
+
+    pthread_mutex_init(&runner.lock, NULL);
+
+    start = now_secs();
+
+    for(uint32_t i = 0; i < nr_threads; ++i){
+        if(pthread_create(&threads[i], NULL, ap_runner_loop, &runner) != 0){
+            audio_proc_log_warn("Failed to start runner thread %d", i);
+            break;
+        }
+
+        nr_started++;
+    }
+
+    if(!nr_started){
+        /* no threads at all, run the jobs on the caller */
+        ap_runner_loop(&runner);
+    }
+
+    for(uint32_t i = 0; i < nr_started; ++i){
+        pthread_join(threads[i], NULL);
+    }
+
+    wall_secs = now_secs() - start;
+
+    pthread_mutex_destroy(&runner.lock);
+
+    ap_engine_fini(runner.engine);
+    ap_engine_free(runner.engine);
+
+    for(int i = 0; i < nr_jobs; ++i){
+        if(jobs[i].rc < 0){
+            failed++;
+            continue;
+        }
+
+        audio_secs += jobs[i].audio_secs;
+        proc_secs += jobs[i].proc_secs;
+    }
+
+    audio_proc_log_info("%d files (%d failed) on %d threads: %.2f s audio in %.3f s, "
+        "rtf %.4f wall, %.4f per thread",
+        nr_jobs, failed, nr_started, audio_secs, wall_secs,
+        audio_secs > 0 ? wall_secs / audio_secs : 0.0,
+        audio_secs > 0 ? proc_secs / audio_secs : 0.0);
+
+    return failed;
+}
@@ -0,0 +1,50 @@
+#ifndef _AUDIO_PROCESS_RUNNER_H_
+#define _AUDIO_PROCESS_RUNNER_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * Offline file to file runner: processes many far/near recordings with a
+ * pool of threads, one audio_proc_ctx per job. Contexts come from an
+ * audio_proc_engine, so jobs of the same format reuse the previous job's
+ * context instead of allocating a new one.
+ *
+ * Inputs are mmap'd and fed to ap_ctx_process_batch() in place, the output
+ * goes through a large stdio buffer.
+ *
+ * The manifest has one job per line, '#' starts a comment:
+ *   <farend.pcm> <nearend.pcm> <out.pcm>
+ */
+
+typedef struct _ap_runner_job {
+    char    *farend_path;
+    char    *nearend_path;
+    char    *out_path;
+
+    int      rc;
+    double   audio_secs; // nearend duration
+    double   proc_secs;  // wall clock spent on this job
+} ap_runner_job;
+
+typedef struct _ap_runner_config {
+    uint32_t channels;
+    uint32_t frequency;
+    uint32_t aec_delay;
+    int      resampler;    // AP_CTX_RESAMPLER_*
+    uint32_t batch_frames; // 10 ms frames per ap_ctx_process_batch call
+    int      shared_farend; // see ap_ctx_set_shared_farend
+    int      verify;       // run every job twice and fail it if the outputs differ
+    uint32_t nr_threads;
+} ap_runner_config;
+
+/* returns the number of jobs, or < 0 on error */
+int ap_runner_load_manifest(const char *path, ap_runner_job **jobs);
+
+void ap_runner_free_jobs(ap_runner_job *jobs, int nr_jobs);
+
+/* runs every job, logs the real time factor per file and in aggregate,
+ * returns the number of failed jobs */
+int ap_runner_run(const ap_runner_config *config, ap_runner_job *jobs, int nr_jobs);
+
+#endif
@@ -2,7 +2,6 @@
 
 #include <stdio.h>
 #include <stdbool.h>
-#include <assert.h>
 
 #include <atomic.h>
 
@@ -11,14 +10,18 @@
 #include <webrtc/modules/audio_processing/agc/legacy/gain_control.h>
 
 #include "resample.h"
+#include "audio_resampler.h"
 #include "audio_splitting_filter_buffer.h"
 
 #include "ring_buffer.h"
+#include "audio_drift_tracker.h"
 
 
 
 
-#if 1
+/* the dump FILE handles are process-wide statics, so only enable this when
+ * a single context is running (see audio_process_engine.h) */
+#ifdef AP_CTX_STREAM_DEBUG
 #define AUDIO_STAREM_DEBUG_EXT(file_name, fp_name, buf, size)                   \
     do{                                                                         \
         static FILE *fp_name = NULL;                                            \
@@ -69,7 +72,6 @@ typedef float sample;
 #endif
 
 #define MAX_NUM_BANDS      (8)
-#define MAX_NUM_CHANNELS   (2)
 #define WEBRTC_PROC_LEN    (160)
 
 #ifndef ARRAY_SIZE
@@ -87,6 +89,13 @@ typedef float sample;
 #endif
 
 
+/* largest push/pull handled in one piece, larger ones are split */
+#define AP_CTX_DEFAULT_PERIOD_MS (40)
+#define AP_CTX_ARENA_ALIGN       (64)
+
+/* every buffer copy/clear done by the wrapper itself goes through this */
+#define ap_ctx_count_copy(ctx, bytes) ((ctx)->copied_bytes += (bytes))
+
 #define check_try_retrun(ctx, ret) do{              \
     if(!ctx || !ctx->inited){                       \
         return (ret);                               \
@@ -107,10 +116,10 @@ struct _audio_proc_ctx {
     int            bytes_per_sample;
     int            bytes_per_proc;
 
-    void          *aec[MAX_NUM_CHANNELS];
+    void         **aec;
 
-    NsHandle      *ns[MAX_NUM_CHANNELS]; // NsxHandle
-    void          *agc[MAX_NUM_CHANNELS];
+    NsHandle     **ns; // NsxHandle
+    void         **agc;
 
     bool           ns_enable;
     bool           agc_enable;
@@ -125,26 +134,69 @@ struct _audio_proc_ctx {
 
     int            num_frames;
 
+    int             resampler_backend;
     struct rs_data *resampler[NR_AP_CTX_AUDIO_MODE]; // one for playback, one for record, one for output
+    audio_resampler *block_resampler[NR_AP_CTX_AUDIO_MODE]; // same, for the sinc/polyphase backends
 
     int            aec_delay; // in ms
+    int            stream_delay; // aec_delay, or as re-estimated by the drift tracker
     uint32_t       nearend_freq, farend_freq, proc_freq;
-    uint32_t       nearend_channels, farend_channels; // webrtc only support one mono when process aec
+    uint32_t       init_nearend_freq, init_farend_freq; // as given to ap_ctx_init, restored by ap_ctx_recycle
+    uint32_t       max_freq; // fastest rate the push/out buffers are sized for
+    uint32_t       nearend_channels; // always channels
+    uint32_t       farend_channels;  // channels, or 1 for a mono farend every channel cancels
     ring_buffer_t *farend_rbuf; // farend ring buffer
     ring_buffer_t *nearend_rbuf; // nearend ring buffer
     uint8_t       *end_buf_for_rbuf;
 
     int            num_bands;
 
-    audio_splitting_filter_buffer* farend_sfb[MAX_NUM_CHANNELS];
-    audio_splitting_filter_buffer* nearend_sfb[MAX_NUM_CHANNELS];
-    audio_splitting_filter_buffer* out_sfb[MAX_NUM_CHANNELS];
-
-    int16_t        farend_chs[MAX_NUM_CHANNELS][480];
-    int16_t        nearend_chs[MAX_NUM_CHANNELS][480];
-    int16_t        out_chs[MAX_NUM_CHANNELS][480];
-
-    volatile int   ref;
+    audio_splitting_filter_buffer** farend_sfb;
+    audio_splitting_filter_buffer** nearend_sfb;
+    audio_splitting_filter_buffer** out_sfb;
+
+    /*
+     * Every per channel / per frame buffer is carved out of one 64 byte
+     * aligned arena, sized at init from channels, rates and max_period_ms.
+     * Nothing below is allocated or put on the stack per call.
+     */
+    uint8_t       *arena;
+    size_t         arena_size;
+    uint32_t       max_period_ms;
+
+    int16_t      **farend_chs; // one 10 ms frame per channel at proc rate
+    int16_t      **nearend_chs;
+    int16_t      **out_chs;
+    void          *band_buf;   // num_bands * samples_per_proc samples (float or int16)
+
+    int           *mic_levels; // per channel agc mic level through a shared farend batch
+
+    int16_t       *farend_frame; // interleaved frame when it wraps the ring buffer
+    int16_t       *nearend_frame;
+    int16_t       *drift_frame;  // farend read for one frame under drift correction, +1 sample
+
+    bool              drift_tracking;
+    bool              drift_active; // tracking with the aec running, the tracker restarts otherwise
+    ap_drift_tracker *drift;
+
+    bool           zero_copy;
+    bool           share_farend;  // requested by ap_ctx_set_shared_farend
+    bool           shared_farend; // in effect: every channel cancels the echo of farend channel 0
+    uint8_t       *out_proc_buf; // processed frames waiting for the output resampler
+    size_t         out_proc_size;
+    uint8_t       *out_resample_buf; // out_proc_buf resampled to nearend rate
+    size_t         out_resample_size;
+
+    uint8_t       *farend_push_buf; // resampler output of one push chunk, owned by the playback thread
+    uint8_t       *nearend_push_buf; // same, owned by the record thread
+    size_t         push_buf_size;
+    uint64_t       nr_proc_frames;
+    uint64_t       copied_bytes; // bytes moved outside of the processing modules
+
+    int16_t       *batch_buf; // proc rate scratch for ap_ctx_process_batch, grown on demand
+    size_t         batch_buf_samples;
+
+    atomic_t       ref;
 
     WebRtcAgcConfig agc_conf;
     AecConfig       aec_conf;
@@ -178,24 +230,22 @@ int ap_ctx_ref(audio_proc_ctx* ap_ctx)
 {
     check_try_retrun(ap_ctx, 0);
 
-    atomic_add(1, &ap_ctx->ref);
-
-    return ap_ctx->ref;
+    return atomic_add_return(1, &ap_ctx->ref);
 }
 
 int ap_ctx_unref(audio_proc_ctx* ap_ctx)
 {
-    check_try_retrun(ap_ctx, -1);
+    int ref;
 
-    atomic_sub(1, &ap_ctx->ref);
+    check_try_retrun(ap_ctx, -1);
 
-    // !!! TODO !!! should be atomic also(atomic get/read) or with mutex
-    if(!ap_ctx->ref){
+    ref = atomic_sub_return(1, &ap_ctx->ref);
+    if(!ref){
         ap_ctx_fini(ap_ctx);
         
         return 0;
     }else{
-        return ap_ctx->ref;
+        return ref;
     }
 }
 
@@ -216,6 +266,207 @@ int ap_ctx_set_aec_config(audio_proc_ctx* ap_ctx)
     return 0;
 }
 
+/*
+ * Opens the resampler of one direction for the current rates. Each
+ * direction carries the channels of its own data: the farend as pushed,
+ * the nearend as recorded and the output as processed.
+ */
+static void ap_ctx_open_resampler(audio_proc_ctx* ap_ctx, int mode)
+{
+    uint32_t in_freq, out_freq, channels;
+    int rc = -1;
+
+    if(mode == AP_CTX_PLAYBACK_MODE){
+        in_freq = ap_ctx->farend_freq;
+        out_freq = ap_ctx->proc_freq;
+        channels = ap_ctx->farend_channels;
+    }else if(mode == AP_CTX_RECORD_MODE){
+        in_freq = ap_ctx->nearend_freq;
+        out_freq = ap_ctx->proc_freq;
+        channels = ap_ctx->nearend_channels;
+    }else{
+        in_freq = ap_ctx->proc_freq;
+        out_freq = ap_ctx->nearend_freq;
+        channels = ap_ctx->channels;
+    }
+
+    if(ap_ctx->resampler_backend != AP_CTX_RESAMPLER_LINEAR){
+        ap_ctx->block_resampler[mode] = audio_resampler_create();
+        if(ap_ctx->block_resampler[mode]){
+            rc = audio_resampler_init(ap_ctx->block_resampler[mode],
+                (ap_ctx->resampler_backend == AP_CTX_RESAMPLER_SINC) ? AUDIO_RESAMPLER_SINC : AUDIO_RESAMPLER_AUTO,
+                in_freq, out_freq, channels);
+        }
+
+        if(rc < 0){
+            audio_proc_log_warn("Failed to init resampler %d (%d -> %d), falling back to linear",
+                mode, in_freq, out_freq);
+
+            audio_resampler_free(ap_ctx->block_resampler[mode]);
+            ap_ctx->block_resampler[mode] = NULL;
+        }
+    }
+
+    if(rc < 0){
+        ap_ctx->resampler[mode] = resample_init(in_freq, out_freq, 8192);
+    }
+}
+
+static void ap_ctx_close_resampler(audio_proc_ctx* ap_ctx, int mode)
+{
+    resample_close(ap_ctx->resampler[mode]);
+    ap_ctx->resampler[mode] = NULL;
+
+    audio_resampler_free(ap_ctx->block_resampler[mode]);
+    ap_ctx->block_resampler[mode] = NULL;
+}
+
+static void ap_ctx_open_resamplers(audio_proc_ctx* ap_ctx)
+{
+    for(int i = 0; i < NR_AP_CTX_AUDIO_MODE; ++i){
+        ap_ctx_open_resampler(ap_ctx, i);
+    }
+}
+
+static void ap_ctx_close_resamplers(audio_proc_ctx* ap_ctx)
+{
+    for(int i = 0; i < NR_AP_CTX_AUDIO_MODE; ++i){
+        ap_ctx_close_resampler(ap_ctx, i);
+    }
+}
+
+int ap_ctx_set_resampler_backend(audio_proc_ctx* ap_ctx, int backend)
+{
+    if(!ap_ctx || backend < 0 || backend >= NR_AP_CTX_RESAMPLER){
+        return -1;
+    }
+
+    ap_ctx->resampler_backend = backend;
+
+    if(ap_ctx->inited){
+        ap_ctx_close_resamplers(ap_ctx);
+        ap_ctx_open_resamplers(ap_ctx);
+    }
+
+    return backend;
+}
+
+int ap_ctx_set_max_period(audio_proc_ctx* ap_ctx, uint32_t period_ms)
+{
+    if(!ap_ctx || ap_ctx->inited || period_ms < 10){
+        return -1;
+    }
+
+    ap_ctx->max_period_ms = period_ms;
+
+    return period_ms;
+}
+
+/* hands out the next aligned piece of the arena, only counts when base is NULL */
+static void* ap_ctx_arena_carve(uint8_t *base, size_t *offset, size_t size)
+{
+    void *ptr;
+
+    *offset = (*offset + AP_CTX_ARENA_ALIGN - 1) & ~(size_t)(AP_CTX_ARENA_ALIGN - 1);
+
+    ptr = base ? (base + *offset) : NULL;
+    *offset += size;
+
+    return ptr;
+}
+
+/* int16 samples of period_ms at freq for all channels */
+#define ap_ctx_period_samples(freq, period_ms, channels) \
+    ((size_t)(freq) * (period_ms) / 1000 * (channels))
+
+/*
+ * Lays the per channel pointers and frame/scratch buffers out in the arena
+ * at base and returns the bytes needed; with base == NULL it only measures.
+ */
+static size_t ap_ctx_layout_arena(audio_proc_ctx* ap_ctx, uint8_t *base)
+{
+    size_t   offset = 0;
+    size_t   channels = ap_ctx->channels;
+    size_t   frame_samples = (size_t)ap_ctx->num_frames * channels;
+    uint32_t period_ms = ap_ctx->max_period_ms;
+
+    ap_ctx->aec = (void **)ap_ctx_arena_carve(base, &offset, channels * sizeof(void *));
+    ap_ctx->ns = (NsHandle **)ap_ctx_arena_carve(base, &offset, channels * sizeof(NsHandle *));
+    ap_ctx->agc = (void **)ap_ctx_arena_carve(base, &offset, channels * sizeof(void *));
+
+    ap_ctx->farend_sfb = (audio_splitting_filter_buffer **)ap_ctx_arena_carve(base, &offset,
+        channels * sizeof(audio_splitting_filter_buffer *));
+    ap_ctx->nearend_sfb = (audio_splitting_filter_buffer **)ap_ctx_arena_carve(base, &offset,
+        channels * sizeof(audio_splitting_filter_buffer *));
+    ap_ctx->out_sfb = (audio_splitting_filter_buffer **)ap_ctx_arena_carve(base, &offset,
+        channels * sizeof(audio_splitting_filter_buffer *));
+
+    ap_ctx->farend_chs = (int16_t **)ap_ctx_arena_carve(base, &offset, channels * sizeof(int16_t *));
+    ap_ctx->nearend_chs = (int16_t **)ap_ctx_arena_carve(base, &offset, channels * sizeof(int16_t *));
+    ap_ctx->out_chs = (int16_t **)ap_ctx_arena_carve(base, &offset, channels * sizeof(int16_t *));
+
+    for(size_t i = 0; i < channels; ++i){
+        int16_t *farend_ch = (int16_t *)ap_ctx_arena_carve(base, &offset, ap_ctx->num_frames * sizeof(int16_t));
+        int16_t *nearend_ch = (int16_t *)ap_ctx_arena_carve(base, &offset, ap_ctx->num_frames * sizeof(int16_t));
+        int16_t *out_ch = (int16_t *)ap_ctx_arena_carve(base, &offset, ap_ctx->num_frames * sizeof(int16_t));
+
+        if(base){
+            ap_ctx->farend_chs[i] = farend_ch;
+            ap_ctx->nearend_chs[i] = nearend_ch;
+            ap_ctx->out_chs[i] = out_ch;
+        }
+    }
+
+    ap_ctx->mic_levels = (int *)ap_ctx_arena_carve(base, &offset, channels * sizeof(int));
+
+    /* wide enough for the float bands too */
+    ap_ctx->band_buf = ap_ctx_arena_carve(base, &offset,
+        (size_t)ap_ctx->num_bands * ap_ctx->samples_per_proc * sizeof(float));
+
+    ap_ctx->farend_frame = (int16_t *)ap_ctx_arena_carve(base, &offset, frame_samples * sizeof(int16_t));
+    ap_ctx->nearend_frame = (int16_t *)ap_ctx_arena_carve(base, &offset, frame_samples * sizeof(int16_t));
+    ap_ctx->drift_frame = (int16_t *)ap_ctx_arena_carve(base, &offset, (frame_samples + channels) * sizeof(int16_t));
+
+    /* ap_ctx_set_*_info may switch the input rates later, up to the fastest one */
+    ap_ctx->max_freq = MAX(ap_ctx->proc_freq, MAX(ap_ctx->farend_freq, ap_ctx->nearend_freq));
+
+    /* the block resamplers may emit one 10 ms block more than the period */
+    ap_ctx->out_proc_size = ap_ctx_period_samples(ap_ctx->proc_freq, period_ms, channels) * sizeof(int16_t);
+    ap_ctx->out_proc_buf = (uint8_t *)ap_ctx_arena_carve(base, &offset, ap_ctx->out_proc_size);
+
+    ap_ctx->out_resample_size = ap_ctx_period_samples(ap_ctx->max_freq, period_ms + 10, channels) * sizeof(int16_t);
+    ap_ctx->out_resample_buf = (uint8_t *)ap_ctx_arena_carve(base, &offset, ap_ctx->out_resample_size);
+
+    ap_ctx->push_buf_size = ap_ctx_period_samples(ap_ctx->max_freq, period_ms + 10, channels) * sizeof(int16_t);
+    ap_ctx->farend_push_buf = (uint8_t *)ap_ctx_arena_carve(base, &offset, ap_ctx->push_buf_size);
+    ap_ctx->nearend_push_buf = (uint8_t *)ap_ctx_arena_carve(base, &offset, ap_ctx->push_buf_size);
+
+    return offset;
+}
+
+static int ap_ctx_alloc_arena(audio_proc_ctx* ap_ctx)
+{
+    void *arena;
+
+    if(!ap_ctx->max_period_ms){
+        ap_ctx->max_period_ms = AP_CTX_DEFAULT_PERIOD_MS;
+    }
+
+    ap_ctx->arena_size = ap_ctx_layout_arena(ap_ctx, NULL);
+
+    if(posix_memalign(&arena, AP_CTX_ARENA_ALIGN, ap_ctx->arena_size)){
+        ap_ctx->arena_size = 0;
+        return -1;
+    }
+
+    memset(arena, 0, ap_ctx->arena_size);
+
+    ap_ctx->arena = (uint8_t *)arena;
+    ap_ctx_layout_arena(ap_ctx, ap_ctx->arena);
+
+    return 0;
+}
+
 int ap_ctx_init(audio_proc_ctx* ap_ctx, uint32_t channels,
     uint32_t nearend_freq, uint32_t farend_freq, uint32_t aec_delay)
 {
@@ -231,6 +482,7 @@ int ap_ctx_init(audio_proc_ctx* ap_ctx, uint32_t channels,
     ap_ctx->samples_per_proc = (nearend_freq > 8000) ? 160 : 80;
     ap_ctx->bytes_per_proc = ap_ctx->samples_per_proc * ap_ctx->bytes_per_sample;
     ap_ctx->aec_delay = aec_delay; // ~100 ms
+    ap_ctx->stream_delay = aec_delay;
 
     static int perm_freqs[] = {8000, 16000, 32000, 48000};
     bool vaild = false;
@@ -250,6 +502,8 @@ int ap_ctx_init(audio_proc_ctx* ap_ctx, uint32_t channels,
     
     ap_ctx->nearend_freq = nearend_freq;
     ap_ctx->farend_freq = farend_freq;
+    ap_ctx->init_nearend_freq = nearend_freq;
+    ap_ctx->init_farend_freq = farend_freq;
 
     ap_ctx->channels = channels;
 
@@ -282,6 +536,18 @@ int ap_ctx_init(audio_proc_ctx* ap_ctx, uint32_t channels,
 
     ap_ctx->num_bands = (ap_ctx->proc_freq <= 8000) ? 1 : (ap_ctx->proc_freq / 16000);
 
+    if(ap_ctx_alloc_arena(ap_ctx) < 0){
+        audio_proc_log_warn("Failed to alloc %zu bytes of frame buffers", ap_ctx->arena_size);
+        return -1;
+    }
+
+    ap_ctx->drift = ap_drift_create();
+    if(!ap_ctx->drift || ap_drift_init(ap_ctx->drift, ap_ctx->proc_freq, ap_ctx->farend_channels,
+            ap_ctx->num_frames, aec_delay) < 0){
+        audio_proc_log_warn("Failed to create drift tracker");
+        return -1;
+    }
+
     
 #ifdef WEBRTC_MOBILE
     ap_ctx->aec_conf.echoMode = 2;
@@ -308,17 +574,37 @@ int ap_ctx_init(audio_proc_ctx* ap_ctx, uint32_t channels,
     
     ap_ctx->ns_policy = 3;
 
-    ap_ctx->resampler[AP_CTX_PLAYBACK_MODE] = resample_init(ap_ctx->farend_freq, ap_ctx->proc_freq, 8192);
-    ap_ctx->resampler[AP_CTX_RECORD_MODE] = resample_init(ap_ctx->nearend_freq, ap_ctx->proc_freq, 8192);
-    ap_ctx->resampler[AP_CTX_OUT_MODE] = resample_init(ap_ctx->proc_freq, ap_ctx->nearend_freq, 8192);
-
-    ap_ctx_reset(ap_ctx);
+    ap_ctx_open_resamplers(ap_ctx);
 
+    /* ap_ctx_reset only runs on an inited context */
     ap_ctx->inited = 1;
 
+    ap_ctx_reset(ap_ctx);
+
     return 0;
 }
 
+/* the splitting filters are created by the first process call, see ap_ctx_ensure_sfbs */
+static void ap_ctx_free_sfbs(audio_proc_ctx* ap_ctx)
+{
+    for(int i = 0; i < ap_ctx->channels; ++i){
+        if(ap_ctx->farend_sfb[i]){
+            audio_splitting_filter_buffer_free(ap_ctx->farend_sfb[i]);
+            ap_ctx->farend_sfb[i] = NULL;
+        }
+
+        if(ap_ctx->nearend_sfb[i]){
+            audio_splitting_filter_buffer_free(ap_ctx->nearend_sfb[i]);
+            ap_ctx->nearend_sfb[i] = NULL;
+        }
+
+        if(ap_ctx->out_sfb[i]){
+            audio_splitting_filter_buffer_free(ap_ctx->out_sfb[i]);
+            ap_ctx->out_sfb[i] = NULL;
+        }
+    }
+}
+
 void ap_ctx_fini(audio_proc_ctx* ap_ctx)
 {
     // check_try_retrun(ap_ctx, void);
@@ -343,20 +629,72 @@ void ap_ctx_fini(audio_proc_ctx* ap_ctx)
         }
     }
 
-    resample_close(ap_ctx->resampler[AP_CTX_PLAYBACK_MODE]);
-    resample_close(ap_ctx->resampler[AP_CTX_RECORD_MODE]);
-    resample_close(ap_ctx->resampler[AP_CTX_OUT_MODE]);
+    ap_ctx_free_sfbs(ap_ctx);
+
+    ap_ctx_close_resamplers(ap_ctx);
 
     ring_buffer_destroy(ap_ctx->farend_rbuf);
     ring_buffer_destroy(ap_ctx->nearend_rbuf);
 
+    ap_drift_free(ap_ctx->drift);
+
     free(ap_ctx->end_buf_for_rbuf);
+    free(ap_ctx->arena);
+    free(ap_ctx->batch_buf);
 
     memset(ap_ctx, 0, sizeof(*ap_ctx));
 
     audio_proc_log_info("audio proc context was freed");
 }
 
+int ap_ctx_recycle(audio_proc_ctx* ap_ctx)
+{
+    check_try_retrun(ap_ctx, -1);
+
+    /* keep the ring buffers, arena and aec/ns/agc handles, drop every bit
+     * of stream state and every option of the previous session, so the next
+     * one processes exactly as on a context fresh from ap_ctx_init with the
+     * same format. Only max_period_ms stays: it sized the arena, and only
+     * changes how a push is chunked, never the output */
+    ring_buffer_flush(ap_ctx->farend_rbuf);
+    ring_buffer_flush(ap_ctx->nearend_rbuf);
+
+    ap_ctx->nearend_freq = ap_ctx->init_nearend_freq;
+    ap_ctx->farend_freq = ap_ctx->init_farend_freq;
+    ap_ctx->nearend_channels = ap_ctx->channels;
+    ap_ctx->farend_channels = ap_ctx->channels;
+
+    ap_ctx->resampler_backend = AP_CTX_RESAMPLER_AUTO;
+    ap_ctx->zero_copy = false;
+    ap_ctx->share_farend = false;
+    ap_ctx->drift_tracking = false;
+
+    ap_ctx_close_resamplers(ap_ctx);
+    ap_ctx_open_resamplers(ap_ctx);
+
+    /* the splitting filters carry their qmf/three band filter state over
+     * frames and have no reset, they are made again by the next process */
+    ap_ctx_free_sfbs(ap_ctx);
+
+    ap_ctx->playback_ready = false;
+    ap_ctx->record_ready = false;
+
+    ap_ctx->agc_mic_level = 128;
+
+    /* the farend may have been switched to mono, back to the layout of ap_ctx_init */
+    if(ap_drift_init(ap_ctx->drift, ap_ctx->proc_freq, ap_ctx->farend_channels,
+            ap_ctx->num_frames, ap_ctx->aec_delay) < 0){
+        audio_proc_log_warn("Failed to init drift tracker for %d farend channels", ap_ctx->farend_channels);
+        return -1;
+    }
+    ap_ctx->drift_active = false;
+    ap_ctx->stream_delay = ap_ctx->aec_delay;
+
+    ap_ctx->nr_proc_frames = 0;
+    ap_ctx->copied_bytes = 0;
+
+    return ap_ctx_reset(ap_ctx);
+}
 
 static const char *apt_ctx_state[] = {"not ready", "ready"};
 
@@ -419,6 +757,131 @@ int ap_ctx_set_agc_is_enable(audio_proc_ctx* ap_ctx, int enable)
     return enable;
 }
 
+int ap_ctx_set_zero_copy(audio_proc_ctx* ap_ctx, int enable)
+{
+    check_try_retrun(ap_ctx, 0);
+
+    ap_ctx->zero_copy = !!enable;
+
+    return enable;
+}
+
+/*
+ * Decides whether the requested farend sharing is in effect: every channel
+ * then cancels the bands of farend channel 0, the right reference only when
+ * the farend is mono; a multi channel farend keeps one per channel. With
+ * the aecm it also points the echo cancellers of channels 1..n at channel 0
+ * for the farend spectrum, or back at their own. Only the aecm can share
+ * that: the float aec moves its farend read position per instance from its
+ * own delay estimate, so its farend spectrum is not the same across channels.
+ */
+static void ap_ctx_link_farend(audio_proc_ctx* ap_ctx)
+{
+    ap_ctx->shared_farend = ap_ctx->share_farend && ap_ctx->farend_channels == 1;
+
+    if (ap_ctx->share_farend && !ap_ctx->shared_farend) {
+        audio_proc_log_warn("Not sharing the farend, it has %d channels", ap_ctx->farend_channels);
+    }
+
+#ifdef WEBRTC_MOBILE
+    bool share = ap_ctx->shared_farend && ap_ctx->aec_enable && ap_ctx->aec[0];
+
+    for (int i = 1; i < ap_ctx->channels; ++i) {
+        if (!ap_ctx->aec[i]) {
+            continue;
+        }
+
+        if (WebRtcAecm_ShareFarend(ap_ctx->aec[i], share ? ap_ctx->aec[0] : NULL) != 0) {
+            audio_proc_log_warn("Failed to %s the farend of aec %d", share ? "share" : "unshare", i);
+        }
+    }
+#endif
+}
+
+int ap_ctx_set_shared_farend(audio_proc_ctx* ap_ctx, int enable)
+{
+    check_try_retrun(ap_ctx, -1);
+
+    ap_ctx->share_farend = !!enable;
+
+    ap_ctx_link_farend(ap_ctx);
+
+    audio_proc_log_info("shared farend %d for %d channels", ap_ctx->shared_farend, ap_ctx->channels);
+
+    return 0;
+}
+
+int ap_ctx_set_drift_tracking(audio_proc_ctx* ap_ctx, int enable)
+{
+    check_try_retrun(ap_ctx, -1);
+
+    ap_ctx->drift_tracking = !!enable;
+
+    audio_proc_log_info("drift tracking %d, aec delay %d", ap_ctx->drift_tracking, ap_ctx->aec_delay);
+
+    return 0;
+}
+
+int ap_ctx_get_drift_stats(audio_proc_ctx* ap_ctx, double *ppm, int *delay_ms, uint64_t *underruns)
+{
+    check_try_retrun(ap_ctx, -1);
+
+    if(ppm){
+        *ppm = ap_drift_get_ppm(ap_ctx->drift);
+    }
+
+    if(delay_ms){
+        *delay_ms = ap_ctx->stream_delay;
+    }
+
+    if(underruns){
+        *underruns = ap_drift_get_underruns(ap_ctx->drift);
+    }
+
+    return 0;
+}
+
+int ap_ctx_get_copy_stats(audio_proc_ctx* ap_ctx, uint64_t *frames, uint64_t *copied_bytes)
+{
+    check_try_retrun(ap_ctx, -1);
+
+    if(frames){
+        *frames = ap_ctx->nr_proc_frames;
+    }
+
+    if(copied_bytes){
+        *copied_bytes = ap_ctx->copied_bytes;
+    }
+
+    return 0;
+}
+
+int ap_ctx_get_conversion_stats(audio_proc_ctx* ap_ctx, uint64_t *frames, uint64_t *converted_samples)
+{
+    audio_splitting_filter_buffer **sfbs[] = {ap_ctx->farend_sfb, ap_ctx->nearend_sfb, ap_ctx->out_sfb};
+    uint64_t converted = 0;
+
+    check_try_retrun(ap_ctx, -1);
+
+    for (int i = 0; i < ARRAY_SIZE(sfbs); ++i) {
+        for (int ch = 0; ch < ap_ctx->channels; ++ch) {
+            if (sfbs[i][ch]) {
+                converted += audio_splitting_filter_buffer_get_conversions(sfbs[i][ch]);
+            }
+        }
+    }
+
+    if(frames){
+        *frames = ap_ctx->nr_proc_frames;
+    }
+
+    if(converted_samples){
+        *converted_samples = converted;
+    }
+
+    return 0;
+}
+
 int ap_ctx_reset(audio_proc_ctx* ap_ctx)
 {
     int rc;
@@ -440,7 +903,10 @@ int ap_ctx_reset(audio_proc_ctx* ap_ctx)
         }
 
         if(ap_ctx->aec[i] && ap_ctx->aec_enable){
-            
+            /* before the init, which skips the startup phase for a delay
+             * agnostic aec; a recycled instance already has it enabled */
+            WebRtcAec_enable_delay_agnostic(WebRtcAec_aec_core(ap_ctx->aec[i]), 1);
+
             rc = WebRtcAec_Init(ap_ctx->aec[i], ap_ctx->proc_freq, ap_ctx->proc_freq);
             if (rc != 0) {
                 WebRtcAec_Free(ap_ctx->aec[i]);
@@ -450,8 +916,6 @@ int ap_ctx_reset(audio_proc_ctx* ap_ctx)
                 
                 audio_proc_log_warn("Failed to init aec %d engin for %d", i, rc);
             }else{
-                WebRtcAec_enable_delay_agnostic(WebRtcAec_aec_core(ap_ctx->aec[i]), 1);
-
                 rc = WebRtcAec_set_config(ap_ctx->aec[i], ap_ctx->aec_conf);
                 if (rc != 0) {
                     ap_ctx->aec_enable = false;
@@ -511,6 +975,8 @@ int ap_ctx_reset(audio_proc_ctx* ap_ctx)
         }
     }
 
+    ap_ctx_link_farend(ap_ctx);
+
     audio_proc_log_info("audio proc: aec enable %d, agc enable %d, ns enable %d", 
         ap_ctx->aec_enable, ap_ctx->agc_enable, ap_ctx->ns_enable);
     
@@ -555,10 +1021,31 @@ int ap_ctx_set_aec_farend_info(audio_proc_ctx* ap_ctx,
 {
     check_try_retrun(ap_ctx, -1);
 
+    /* one farend channel per nearend channel, or a mono one for all of them */
+    if (!farend_freq || farend_freq > ap_ctx->max_freq
+        || (farend_channels != ap_ctx->channels && farend_channels != 1)) {
+        audio_proc_log_warn("Unsupported farend format, freq %d, channels %d", farend_freq, farend_channels);
+        return -1;
+    }
+
+    if (farend_channels != ap_ctx->farend_channels) {
+        /* the queued frames and the drift tracker have the old layout */
+        ring_buffer_flush(ap_ctx->farend_rbuf);
+
+        if (ap_drift_init(ap_ctx->drift, ap_ctx->proc_freq, farend_channels,
+                ap_ctx->num_frames, ap_ctx->aec_delay) < 0) {
+            audio_proc_log_warn("Failed to init drift tracker for %d farend channels", farend_channels);
+            return -1;
+        }
+    }
+
     // ap_ctx->proc_freq = farend_freq;
     ap_ctx->farend_freq = farend_freq;
     ap_ctx->farend_channels = farend_channels;
 
+    ap_ctx_close_resampler(ap_ctx, AP_CTX_PLAYBACK_MODE);
+    ap_ctx_open_resampler(ap_ctx, AP_CTX_PLAYBACK_MODE);
+
     return ap_ctx_reset(ap_ctx);
 }
 
@@ -567,51 +1054,186 @@ int ap_ctx_set_nearend_info(audio_proc_ctx* ap_ctx,
 {
     check_try_retrun(ap_ctx, -1);
 
+    /* one aec/ns/agc per nearend channel, allocated by ap_ctx_init */
+    if (!nearend_freq || nearend_freq > ap_ctx->max_freq || nearend_channels != ap_ctx->channels) {
+        audio_proc_log_warn("Unsupported nearend format, freq %d, channels %d", nearend_freq, nearend_channels);
+        return -1;
+    }
+
     ap_ctx->nearend_freq = nearend_freq;
     ap_ctx->nearend_channels = nearend_channels;
 
+    /* the output goes back to the nearend rate */
+    ap_ctx_close_resampler(ap_ctx, AP_CTX_RECORD_MODE);
+    ap_ctx_open_resampler(ap_ctx, AP_CTX_RECORD_MODE);
+
+    ap_ctx_close_resampler(ap_ctx, AP_CTX_OUT_MODE);
+    ap_ctx_open_resampler(ap_ctx, AP_CTX_OUT_MODE);
+
     return ap_ctx_reset(ap_ctx);
 }
     
-static int split_stereo_to_mono(const int16_t *stereo, size_t stereo_len, 
-    int16_t *left, int16_t *right, size_t mono_size)
+static int split_to_channels(const int16_t *interleaved, size_t interleaved_len, 
+    int16_t **chs, int channels, size_t mono_size)
 {
     int proc_len;
-    int16_t *left_ch, *right_ch;
 
-    proc_len = MIN(stereo_len, (mono_size * 2));
+    proc_len = MIN(interleaved_len / channels, mono_size);
 
-    proc_len &= -2;
+    for (int i = 0; i < proc_len; ++i) {
+        for (int ch = 0; ch < channels; ++ch) {
+            chs[ch][i] = *interleaved++;
+        }
+    }
 
-    left_ch = left;
-    right_ch = right;
+    return proc_len;
+}
+
+static int merge_channels(int16_t **chs, int channels, size_t mono_len, 
+    int16_t* interleaved, size_t interleaved_size)
+{
+    int proc_len, idx;
+
+    proc_len = MIN(mono_len, (interleaved_size / channels));
+    idx = 0;
 
     for (int i = 0; i < proc_len; ++i) {
-        if (i % 2 == 0) {
-            *left_ch++ = stereo[i];
-        }
-        else {
-            *right_ch++ = stereo[i];
+        for (int ch = 0; ch < channels; ++ch) {
+            interleaved[idx++] = chs[ch][i];
         }
     }
 
-    return (proc_len / 2);
+    return idx;
 }
 
-static int merge_mono_to_stereo(const int16_t* left, const int16_t* right, size_t mono_len, 
-    int16_t* stereo, size_t stereo_size)
+/* the farend channel channel ch cancels, a mono farend is fanned out to all */
+#define ap_ctx_farend_ch(ctx, ch) (((ctx)->farend_channels == 1) ? 0 : (ch))
+
+/* the splitting filter holding the farend bands channel ch cancels */
+#define ap_ctx_farend_sfb(ctx, ch) ((ctx)->farend_sfb[(ctx)->shared_farend ? 0 : (ch)])
+
+static void ap_ctx_ensure_sfbs(audio_proc_ctx* ap_ctx)
 {
-    int proc_len, stereo_idx;
+    int proc_channels = 1; // seems like must be one channel (eg. mono)
 
-    proc_len = MIN(mono_len, (stereo_size / 2));
-    stereo_idx = 0;
+    for (int i = 0; i < ap_ctx->channels; ++i) {
+        /* with a shared farend only channel 0 is split into bands */
+        if (!ap_ctx->farend_sfb[i] && (!ap_ctx->shared_farend || i == 0)) {
+            ap_ctx->farend_sfb[i] = audio_splitting_filter_buffer_create();
+            audio_splitting_filter_buffer_init(ap_ctx->farend_sfb[i], proc_channels, ap_ctx->num_bands, ap_ctx->num_frames);
+        }
 
-    for (int i = 0; i < proc_len; ++i) {
-        stereo[stereo_idx++] = left[i];
-        stereo[stereo_idx++] = right[i];
+        if (!ap_ctx->nearend_sfb[i]) {
+            ap_ctx->nearend_sfb[i] = audio_splitting_filter_buffer_create();
+            audio_splitting_filter_buffer_init(ap_ctx->nearend_sfb[i], proc_channels, ap_ctx->num_bands, ap_ctx->num_frames);
+        }
+
+        if (!ap_ctx->out_sfb[i]) {
+            ap_ctx->out_sfb[i] = audio_splitting_filter_buffer_create();
+            audio_splitting_filter_buffer_init(ap_ctx->out_sfb[i], proc_channels, ap_ctx->num_bands, ap_ctx->num_frames);
+        }
+    }
+}
+
+/*
+ * Runs agc/ns/aec for one channel of one interleaved frame, in place on the
+ * nearend bands, and interleaves the result into out. farend (farend_channels
+ * wide) is only read when need_do_aec is set.
+ */
+static void ap_ctx_process_channel(audio_proc_ctx* ap_ctx, int ch,
+    const int16_t *farend, const int16_t *nearend, int16_t *out,
+    bool need_do_aec, int *mic_level)
+{
+    int rc;
+    int to_proc_samples = ap_ctx->num_frames;
+    audio_splitting_filter_buffer *farend_sfb = ap_ctx_farend_sfb(ap_ctx, ch);
+
+    /* a shared farend is split once per frame, by channel 0 */
+    if (need_do_aec && (!ap_ctx->shared_farend || ch == 0)) {
+        rc = audio_splitting_filter_buffer_fill_interleaved(farend_sfb, farend,
+            to_proc_samples, ap_ctx_farend_ch(ap_ctx, ch), ap_ctx->farend_channels);
+        ap_ctx_count_copy(ap_ctx, rc);
+    }
+
+    rc = audio_splitting_filter_buffer_fill_interleaved(ap_ctx->nearend_sfb[ch], nearend,
+        to_proc_samples, ch, ap_ctx->channels);
+    ap_ctx_count_copy(ap_ctx, rc);
+
+    if (ap_ctx->agc_enable) {
+        const int16_t* const* nearend_ibands_c = audio_splitting_filter_buffer_get_ibands_const(ap_ctx->nearend_sfb[ch], 0);
+        int16_t* const* nearend_ibands = audio_splitting_filter_buffer_get_ibands(ap_ctx->nearend_sfb[ch], 0);
+        uint8_t saturation;
+
+        rc = WebRtcAgc_AddMic(ap_ctx->agc[ch], (int16_t**)nearend_ibands, ap_ctx->num_bands, ap_ctx->samples_per_proc);
+        if (rc != 0) {
+            audio_proc_log_warn("Failed to add mic for agc");
+        }
+
+        /* the agc can run in place on the split bands */
+        rc = WebRtcAgc_Process(ap_ctx->agc[ch], nearend_ibands_c, ap_ctx->num_bands, ap_ctx->samples_per_proc,
+            nearend_ibands, *mic_level, mic_level, 0, &saturation);
+        if (rc != 0) {
+            audio_proc_log_warn("Failed to process agc");
+        }
+    }
+
+#ifdef WEBRTC_MOBILE
+    const int16_t* const* nearend_ibands_c = audio_splitting_filter_buffer_get_ibands_const(ap_ctx->nearend_sfb[ch], 0);
+    int16_t* const* nearend_ibands = audio_splitting_filter_buffer_get_ibands(ap_ctx->nearend_sfb[ch], 0);
+
+    if (ap_ctx->ns_enable) {
+        WebRtcNsx_Process((NsxHandle*)ap_ctx->ns[ch], nearend_ibands_c, ap_ctx->num_bands, nearend_ibands);
+    }
+
+    if (need_do_aec) {
+        rc = WebRtcAecm_BufferFarend(ap_ctx->aec[ch], audio_splitting_filter_buffer_get_ibands_const(farend_sfb, 0)[0],
+            ap_ctx->samples_per_proc);
+        if (rc != 0) {
+            audio_proc_log_warn("WebRtcAecm_BufferFarend failed.");
+        }
+
+        /* the ns already ran in place, so the clean signal is the band itself */
+        rc = WebRtcAecm_Process(ap_ctx->aec[ch], nearend_ibands_c[0],
+            (ap_ctx->ns_enable ? nearend_ibands_c[0] : NULL),
+            nearend_ibands[0], ap_ctx->samples_per_proc,
+            ap_ctx->stream_delay);
+        if (rc != 0) {
+            audio_proc_log_warn("WebRtcAecm_Process failed.");
+        }
+    }
+#else
+    if (ap_ctx->ns_enable) {
+        const float* const* nearend_fbands_c = audio_splitting_filter_buffer_get_fbands_const(ap_ctx->nearend_sfb[ch], 0);
+        float* const* nearend_fbands = audio_splitting_filter_buffer_get_fbands(ap_ctx->nearend_sfb[ch], 0);
+
+        WebRtcNs_Analyze(ap_ctx->ns[ch], nearend_fbands_c[0]);
+
+        WebRtcNs_Process((NsHandle*)ap_ctx->ns[ch], nearend_fbands_c, ap_ctx->num_bands, nearend_fbands);
     }
 
-    return stereo_idx;
+    if (need_do_aec) {
+        rc = WebRtcAec_BufferFarend(ap_ctx->aec[ch],
+            audio_splitting_filter_buffer_get_fbands_const(farend_sfb, 0)[0],
+            ap_ctx->samples_per_proc);
+        if (rc != 0) {
+            audio_proc_log_warn("WebRtcAec_BufferFarend failed.");
+        }
+
+        /* the aec writes back into the nearend bands */
+        rc = WebRtcAec_Process(ap_ctx->aec[ch],
+            audio_splitting_filter_buffer_get_fbands_const(ap_ctx->nearend_sfb[ch], 0),
+            ap_ctx->num_bands,
+            audio_splitting_filter_buffer_get_fbands(ap_ctx->nearend_sfb[ch], 0),
+            (size_t)ap_ctx->samples_per_proc, ap_ctx->stream_delay, 0);
+        if (rc != 0) {
+            audio_proc_log_warn("WebRtcAec_Process failed.");
+        }
+    }
+#endif
+
+    rc = audio_splitting_filter_buffer_get_interleaved(ap_ctx->nearend_sfb[ch], out,
+        to_proc_samples, ch, ap_ctx->channels);
+    ap_ctx_count_copy(ap_ctx, rc);
 }
 
 int ap_ctx_do_process(audio_proc_ctx* ap_ctx, const int16_t const *farend, 
@@ -619,10 +1241,10 @@ int ap_ctx_do_process(audio_proc_ctx* ap_ctx, const int16_t const *farend,
     int16_t dest[], size_t len)
 {
     int      rc, avail_bytes, proced_samples, nproc;
-    int      to_proc_samples, to_proc_bytes, to_proc_bytes_mono, proc_channels;
+    int      to_proc_samples, to_proc_bytes, to_proc_bytes_mono, far_proc_bytes;
     int16_t *out;
     const int16_t *farend_sample, *nearend_sample;
-    int is_stereo, need_do_aec;
+    int is_multichannel, need_do_aec;
     
     proced_samples = 0;
     out = dest;
@@ -635,9 +1257,9 @@ int ap_ctx_do_process(audio_proc_ctx* ap_ctx, const int16_t const *farend,
     to_proc_samples = ap_ctx->num_frames;
     to_proc_bytes_mono = to_proc_samples * sizeof(int16_t);
     to_proc_bytes = to_proc_bytes_mono * ap_ctx->channels;
-    proc_channels = 1; // seems like must be one channel (eg. mono)
+    far_proc_bytes = to_proc_bytes_mono * ap_ctx->farend_channels;
 
-    is_stereo = (ap_ctx->channels > 1);
+    is_multichannel = (ap_ctx->channels > 1);
     need_do_aec = (farend != NULL) && ap_ctx_should_do_aec(ap_ctx);
 
     if (avail_bytes < to_proc_bytes) {
@@ -648,187 +1270,209 @@ int ap_ctx_do_process(audio_proc_ctx* ap_ctx, const int16_t const *farend,
         return -1;
     }
 
-    assert(to_proc_bytes_mono <= sizeof(ap_ctx->farend_chs[0]));
-
     audio_proc_log_info("total samples %d, frame num %d, channels %d, bands %d, bandsize %d,"
         "to proc samples %d bytes %d %d, avail bytes %d, need do aec %d",
         nr_samples, ap_ctx->num_frames, ap_ctx->channels, ap_ctx->num_bands, ap_ctx->samples_per_proc, 
         to_proc_samples, to_proc_bytes_mono, to_proc_bytes, avail_bytes, need_do_aec);
 
+    ap_ctx_ensure_sfbs(ap_ctx);
+
     while ((avail_bytes >= to_proc_bytes) && (len > 0)) {
 
         nproc = 0;
 
-        if (is_stereo) {
-            if (need_do_aec && farend_sample) {
-                split_stereo_to_mono(farend_sample, nr_samples, ap_ctx->farend_chs[0], ap_ctx->farend_chs[1], to_proc_samples);
+        if (ap_ctx->zero_copy) {
+            /* the bands are interleaved straight into dest, a partial frame does not fit */
+            if (len < to_proc_samples * ap_ctx->channels) {
+                break;
             }
-            
-            split_stereo_to_mono(nearend_sample, nr_samples, ap_ctx->nearend_chs[0], ap_ctx->nearend_chs[1], to_proc_samples);
+
+            for (int i = 0; i < ap_ctx->channels; ++i) {
+                ap_ctx_process_channel(ap_ctx, i, farend_sample, nearend_sample, out,
+                    need_do_aec, &ap_ctx->agc_mic_level);
+            }
+
+            ap_ctx->nr_proc_frames++;
+
+            nproc = to_proc_samples * ap_ctx->channels;
         }
         else {
             if (need_do_aec && farend_sample) {
-                memcpy(ap_ctx->farend_chs[0], farend_sample, to_proc_bytes_mono);
-            }
-            
-            memcpy(ap_ctx->nearend_chs[0], nearend_sample, to_proc_bytes_mono);
-        }
-
-        for (int i = 0; i < ap_ctx->channels; ++i) {
+                if (ap_ctx->farend_channels > 1) {
+                    split_to_channels(farend_sample, nr_samples / ap_ctx->channels * ap_ctx->farend_channels,
+                        ap_ctx->farend_chs, ap_ctx->farend_channels, to_proc_samples);
+                } else {
+                    memcpy(ap_ctx->farend_chs[0], farend_sample, to_proc_bytes_mono);
+                }
 
-            if (!ap_ctx->farend_sfb[i]) {
-                ap_ctx->farend_sfb[i] = audio_splitting_filter_buffer_create();
-                audio_splitting_filter_buffer_init(ap_ctx->farend_sfb[i], proc_channels, ap_ctx->num_bands, ap_ctx->num_frames);
+                ap_ctx_count_copy(ap_ctx, far_proc_bytes);
             }
 
-            if (!ap_ctx->nearend_sfb[i]) {
-                ap_ctx->nearend_sfb[i] = audio_splitting_filter_buffer_create();
-                audio_splitting_filter_buffer_init(ap_ctx->nearend_sfb[i], proc_channels, ap_ctx->num_bands, ap_ctx->num_frames);
+            if (is_multichannel) {
+                split_to_channels(nearend_sample, nr_samples, ap_ctx->nearend_chs, ap_ctx->channels, to_proc_samples);
+                ap_ctx_count_copy(ap_ctx, to_proc_bytes);
             }
-
-            if (!ap_ctx->out_sfb[i]) {
-                ap_ctx->out_sfb[i] = audio_splitting_filter_buffer_create();
-                audio_splitting_filter_buffer_init(ap_ctx->out_sfb[i], proc_channels, ap_ctx->num_bands, ap_ctx->num_frames);
+            else {
+                memcpy(ap_ctx->nearend_chs[0], nearend_sample, to_proc_bytes_mono);
+                ap_ctx_count_copy(ap_ctx, to_proc_bytes_mono);
             }
 
-            audio_splitting_filter_buffer_fill_data(ap_ctx->farend_sfb[i], (uint8_t*)ap_ctx->farend_chs[i], to_proc_bytes_mono);
-            audio_splitting_filter_buffer_fill_data(ap_ctx->nearend_sfb[i], (uint8_t*)ap_ctx->nearend_chs[i], to_proc_bytes_mono);
+            for (int i = 0; i < ap_ctx->channels; ++i) {
+                audio_splitting_filter_buffer *farend_sfb = ap_ctx_farend_sfb(ap_ctx, i);
+
+                if (!ap_ctx->shared_farend || i == 0) {
+                    audio_splitting_filter_buffer_fill_data(farend_sfb,
+                        (uint8_t*)ap_ctx->farend_chs[ap_ctx_farend_ch(ap_ctx, i)], to_proc_bytes_mono);
+                    ap_ctx_count_copy(ap_ctx, to_proc_bytes_mono);
+                }
+
+                audio_splitting_filter_buffer_fill_data(ap_ctx->nearend_sfb[i], (uint8_t*)ap_ctx->nearend_chs[i], to_proc_bytes_mono);
+                ap_ctx_count_copy(ap_ctx, to_proc_bytes_mono);
 
 #if 0
-            AUDIO_STAREM_DEBUG_EXT("./when_aec_farend.pcm", when_aec_farend_fp,
-                ap_ctx->farend_chs[i], to_proc_bytes_mono);
+                AUDIO_STAREM_DEBUG_EXT("./when_aec_farend.pcm", when_aec_farend_fp,
+                    ap_ctx->farend_chs[i], to_proc_bytes_mono);
 
-            AUDIO_STAREM_DEBUG_EXT("./when_aec_nearend.pcm", when_aec_nearend_fp,
-                ap_ctx->nearend_chs[i], to_proc_bytes_mono);
+                AUDIO_STAREM_DEBUG_EXT("./when_aec_nearend.pcm", when_aec_nearend_fp,
+                    ap_ctx->nearend_chs[i], to_proc_bytes_mono);
 #endif
 
-            if (ap_ctx->agc_enable) {
+                if (ap_ctx->agc_enable) {
+                    const int16_t* const* nearend_ibands_c = audio_splitting_filter_buffer_get_ibands_const(ap_ctx->nearend_sfb[i], 0);
+                    int16_t* const* nearend_ibands = audio_splitting_filter_buffer_get_ibands(ap_ctx->nearend_sfb[i], 0);
+                    int16_t* agcOut[MAX_NUM_BANDS];
+
+                    for (int j = 0; j < ap_ctx->num_bands; j++) {
+                        agcOut[j] = (int16_t*)ap_ctx->band_buf + j * ap_ctx->samples_per_proc;
+                    }
+
+                    uint8_t saturation;
+                    rc = WebRtcAgc_AddMic(ap_ctx->agc[i], (int16_t**)nearend_ibands, ap_ctx->num_bands, ap_ctx->samples_per_proc);
+                    if (rc != 0) {
+                        audio_proc_log_warn("Failed to add mic for agc");
+                    }
+
+                    rc = WebRtcAgc_Process(ap_ctx->agc[i], nearend_ibands_c, ap_ctx->num_bands, ap_ctx->samples_per_proc,
+                        agcOut, ap_ctx->agc_mic_level, &ap_ctx->agc_mic_level, 0, &saturation);
+                    if (rc != 0) {
+                        audio_proc_log_warn("Failed to process agc");
+                    }
+
+                    for (int j = 0; j < ap_ctx->num_bands; j++) {
+                        memcpy((void*)nearend_ibands[j], agcOut[j], ap_ctx->samples_per_proc * sizeof(int16_t));
+                        ap_ctx_count_copy(ap_ctx, ap_ctx->samples_per_proc * sizeof(int16_t));
+                    }
+                }
+
+#ifdef WEBRTC_MOBILE
                 const int16_t* const* nearend_ibands_c = audio_splitting_filter_buffer_get_ibands_const(ap_ctx->nearend_sfb[i], 0);
                 int16_t* const* nearend_ibands = audio_splitting_filter_buffer_get_ibands(ap_ctx->nearend_sfb[i], 0);
-                int16_t _agcOut[3][320];
-                int16_t* agcOut[3];
 
+                int16_t* nsxOut[MAX_NUM_BANDS];
                 for (int j = 0; j < ap_ctx->num_bands; j++) {
-                    agcOut[j] = _agcOut[j];
-                }
-
-                uint8_t saturation;
-                rc = WebRtcAgc_AddMic(ap_ctx->agc[i], (int16_t**)nearend_ibands, ap_ctx->num_bands, ap_ctx->samples_per_proc);
-                if (rc != 0) {
-                    audio_proc_log_warn("Failed to add mic for agc");
+                    nsxOut[j] = (int16_t*)ap_ctx->band_buf + j * ap_ctx->samples_per_proc;
                 }
+                
+                if(ap_ctx->ns_enable){
+                    WebRtcNsx_Process((NsxHandle*)ap_ctx->ns[i], nearend_ibands_c, ap_ctx->num_bands, nsxOut);
 
-                rc = WebRtcAgc_Process(ap_ctx->agc[i], nearend_ibands_c, ap_ctx->num_bands, ap_ctx->samples_per_proc,
-                    agcOut, ap_ctx->agc_mic_level, &ap_ctx->agc_mic_level, 0, &saturation);
-                if (rc != 0) {
-                    audio_proc_log_warn("Failed to process agc");
+                    for (int j = 0; j < ap_ctx->num_bands; j++) {
+                        memcpy((void*)nearend_ibands[j], nsxOut[j], ap_ctx->samples_per_proc * sizeof(int16_t));
+                        ap_ctx_count_copy(ap_ctx, ap_ctx->samples_per_proc * sizeof(int16_t));
+                    }
                 }
 
-                for (int j = 0; j < ap_ctx->num_bands; j++) {
-                    memcpy((void*)nearend_ibands[j], _agcOut[j], ap_ctx->samples_per_proc * sizeof(int16_t));
+                if (need_do_aec) {
+                    rc = WebRtcAecm_BufferFarend(ap_ctx->aec[i], audio_splitting_filter_buffer_get_ibands_const(farend_sfb, 0)[0], 
+                        ap_ctx->samples_per_proc);
+                    if(rc != 0){
+                        audio_proc_log_warn("WebRtcAecm_BufferFarend failed.");
+                    }
+
+                    rc = WebRtcAecm_Process(ap_ctx->aec[i], nearend_ibands_c[0],
+                        (ap_ctx->ns_enable ? nsxOut[0] : NULL),
+                        audio_splitting_filter_buffer_get_ibands(ap_ctx->out_sfb[i], 0)[0], ap_ctx->samples_per_proc,
+                        ap_ctx->stream_delay);
+                    if(rc != 0){
+                        audio_proc_log_warn("WebRtcAecm_Process failed.");
+                    }
+
+                    for (int j = 0; j < ap_ctx->num_bands; j++) {
+                        memcpy((void*)nearend_ibands[j], audio_splitting_filter_buffer_get_ibands(ap_ctx->out_sfb[i], 0)[j], 
+                            ap_ctx->samples_per_proc * sizeof(int16_t));
+                        ap_ctx_count_copy(ap_ctx, ap_ctx->samples_per_proc * sizeof(int16_t));
+                    }
                 }
-            }
 
-#ifdef WEBRTC_MOBILE
-            const int16_t* const* nearend_ibands_c = audio_splitting_filter_buffer_get_ibands_const(ap_ctx->nearend_sfb[i], 0);
-            int16_t* const* nearend_ibands = audio_splitting_filter_buffer_get_ibands(ap_ctx->nearend_sfb[i], 0);
+                audio_splitting_filter_buffer_get_data(ap_ctx->nearend_sfb[i], (uint8_t*)ap_ctx->out_chs[i], to_proc_bytes_mono);
+                ap_ctx_count_copy(ap_ctx, to_proc_bytes_mono);
+#else
+                if (ap_ctx->ns_enable) {
+                    const float* const* nearend_fbands_c = audio_splitting_filter_buffer_get_fbands_const(ap_ctx->nearend_sfb[i], 0);
+                    float* const* nearend_fbands = audio_splitting_filter_buffer_get_fbands(ap_ctx->nearend_sfb[i], 0);
 
-            int16_t _nsxOut[3][320];
-            int16_t* nsxOut[3];
-            for (int j = 0; j < ap_ctx->num_bands; j++) {
-                nsxOut[j] = _nsxOut[j];
-            }
-                
-            if(ap_ctx->ns_enable){
-                WebRtcNsx_Process((NsxHandle*)ap_ctx->ns[i], nearend_ibands_c, ap_ctx->num_bands,
-                    nsxOut);
+                    // WebRtcNsx_Process((NsxHandle*)ns, (const short* const*)nsIn, 3, nsOut);
+                    float* nsOut[MAX_NUM_BANDS];
+                    for (int j = 0; j < ap_ctx->num_bands; j++) {
+                        nsOut[j] = (float*)ap_ctx->band_buf + j * ap_ctx->samples_per_proc;
+                    }
 
-                for (int j = 0; j < ap_ctx->num_bands; j++) {
-                    memcpy((void*)nearend_ibands[j], nsxOut[j], ap_ctx->samples_per_proc * sizeof(int16_t));
-                }
-            }
+                    WebRtcNs_Analyze(ap_ctx->ns[i], nearend_fbands_c[0]);
 
-            if (need_do_aec) {
-                rc = WebRtcAecm_BufferFarend(ap_ctx->aec[i], audio_splitting_filter_buffer_get_ibands_const(ap_ctx->farend_sfb[i], 0)[0], 
-                    ap_ctx->samples_per_proc);
-                if(rc != 0){
-                    audio_proc_log_warn("WebRtcAecm_BufferFarend failed.");
-                }
+                    WebRtcNs_Process((NsHandle*)ap_ctx->ns[i], nearend_fbands_c, ap_ctx->num_bands, nsOut);
 
-                rc = WebRtcAecm_Process(ap_ctx->aec[i], nearend_ibands_c[0],
-                    (ap_ctx->ns_enable ? nsxOut[0] : NULL),
-                    audio_splitting_filter_buffer_get_ibands(ap_ctx->out_sfb[i], 0)[0], ap_ctx->samples_per_proc,
-                    ap_ctx->aec_delay);
-                if(rc != 0){
-                    audio_proc_log_warn("WebRtcAecm_Process failed.");
+                    for (int j = 0; j < ap_ctx->num_bands; j++) {
+                        memcpy((void*)nearend_fbands[j], nsOut[j], ap_ctx->samples_per_proc * sizeof(float));
+                        ap_ctx_count_copy(ap_ctx, ap_ctx->samples_per_proc * sizeof(float));
+                    }
                 }
 
-                for (int j = 0; j < ap_ctx->num_bands; j++) {
-                    memcpy((void*)nearend_ibands[j], audio_splitting_filter_buffer_get_ibands(ap_ctx->out_sfb[i], 0)[j], 
-                        ap_ctx->samples_per_proc * sizeof(int16_t));
-                }
-            }
-
-            audio_splitting_filter_buffer_get_data(ap_ctx->nearend_sfb[i], (uint8_t*)ap_ctx->out_chs[i], to_proc_bytes_mono);
-#else
-            if (ap_ctx->ns_enable) {
-                const float* const* nearend_fbands_c = audio_splitting_filter_buffer_get_fbands_const(ap_ctx->nearend_sfb[i], 0);
-                float* const* nearend_fbands = audio_splitting_filter_buffer_get_fbands(ap_ctx->nearend_sfb[i], 0);
-
-                // WebRtcNsx_Process((NsxHandle*)ns, (const short* const*)nsIn, 3, nsOut);
-                float _nsOut[3][320];
-                float* nsOut[3];
-                for (int j = 0; j < ap_ctx->num_bands; j++) {
-                    nsOut[j] = _nsOut[j];
+                if (need_do_aec) {
+                    rc = WebRtcAec_BufferFarend(ap_ctx->aec[i],
+                        audio_splitting_filter_buffer_get_fbands_const(farend_sfb, 0)[0],
+                        ap_ctx->samples_per_proc);
+                    if (rc != 0) {
+                        audio_proc_log_warn("WebRtcAec_BufferFarend failed.");
+                    }
+
+                    rc = WebRtcAec_Process(ap_ctx->aec[i],
+                        audio_splitting_filter_buffer_get_fbands_const(ap_ctx->nearend_sfb[i], 0),
+                        ap_ctx->num_bands,
+                        audio_splitting_filter_buffer_get_fbands(ap_ctx->out_sfb[i], 0),
+                        (size_t)ap_ctx->samples_per_proc, ap_ctx->stream_delay, 0);
+                    if (rc != 0) {
+                        audio_proc_log_warn("WebRtcAec_Process failed.");
+                    }
+
+                    audio_splitting_filter_buffer_get_data(ap_ctx->out_sfb[i], (uint8_t*)ap_ctx->out_chs[i], to_proc_bytes_mono);
+                    ap_ctx_count_copy(ap_ctx, to_proc_bytes_mono);
+
+                    /*audio_proc_log_info("do aec... to proc bytes %d, aec delay %d, samples per proc %d", 
+                        to_proc_bytes_mono, ap_ctx->aec_delay, ap_ctx->samples_per_proc);*/
                 }
-
-                WebRtcNs_Analyze(ap_ctx->ns[i], nearend_fbands_c[0]);
-
-                WebRtcNs_Process((NsHandle*)ap_ctx->ns[i], nearend_fbands_c, ap_ctx->num_bands, nsOut);
-
-                for (int j = 0; j < ap_ctx->num_bands; j++) {
-                    memcpy((void*)nearend_fbands[j], _nsOut[j], ap_ctx->samples_per_proc * sizeof(float));
+                else {
+                    audio_splitting_filter_buffer_get_data(ap_ctx->nearend_sfb[i], (uint8_t*)ap_ctx->out_chs[i], to_proc_bytes_mono);
+                    ap_ctx_count_copy(ap_ctx, to_proc_bytes_mono);
                 }
+#endif
             }
 
-            if (need_do_aec) {
-                rc = WebRtcAec_BufferFarend(ap_ctx->aec[i],
-                    audio_splitting_filter_buffer_get_fbands_const(ap_ctx->farend_sfb[i], 0)[0],
-                    ap_ctx->samples_per_proc);
-                if (rc != 0) {
-                    audio_proc_log_warn("WebRtcAec_BufferFarend failed.");
-                }
+            ap_ctx->nr_proc_frames++;
 
-                rc = WebRtcAec_Process(ap_ctx->aec[i],
-                    audio_splitting_filter_buffer_get_fbands_const(ap_ctx->nearend_sfb[i], 0),
-                    ap_ctx->num_bands,
-                    audio_splitting_filter_buffer_get_fbands(ap_ctx->out_sfb[i], 0),
-                    (size_t)ap_ctx->samples_per_proc, ap_ctx->aec_delay, 0);
-                if (rc != 0) {
-                    audio_proc_log_warn("WebRtcAec_Process failed.");
+            if (is_multichannel) {
+                nproc = merge_channels(ap_ctx->out_chs, ap_ctx->channels, to_proc_samples, out, len);
+                if (nproc <= 0) {
+                    audio_proc_log_warn("Failed to merge %d channels for %d", ap_ctx->channels, nproc);
+                    break;
                 }
 
-                audio_splitting_filter_buffer_get_data(ap_ctx->out_sfb[i], (uint8_t*)ap_ctx->out_chs[i], to_proc_bytes_mono);
-
-                /*audio_proc_log_info("do aec... to proc bytes %d, aec delay %d, samples per proc %d", 
-                    to_proc_bytes_mono, ap_ctx->aec_delay, ap_ctx->samples_per_proc);*/
+                ap_ctx_count_copy(ap_ctx, nproc * sizeof(int16_t));
             }
             else {
-                audio_splitting_filter_buffer_get_data(ap_ctx->nearend_sfb[i], (uint8_t*)ap_ctx->out_chs[i], to_proc_bytes_mono);
+                memcpy(out, ap_ctx->out_chs[0], MIN(to_proc_bytes_mono, len));
+                ap_ctx_count_copy(ap_ctx, MIN(to_proc_bytes_mono, len));
+                nproc = to_proc_samples;
             }
-#endif
-        }
-
-        if (is_stereo) {
-            nproc = merge_mono_to_stereo(ap_ctx->out_chs[0], ap_ctx->out_chs[1], to_proc_samples, out, len);
-            if (nproc <= 0) {
-                audio_proc_log_warn("Failed to merge mono to stereo for %d", nproc);
-                break;
-            }
-        }
-        else {
-            memcpy(out, ap_ctx->out_chs[0], MIN(to_proc_bytes_mono, len));
-            nproc = to_proc_samples;
         }
 
         len            -= nproc;
@@ -836,7 +1480,7 @@ int ap_ctx_do_process(audio_proc_ctx* ap_ctx, const int16_t const *farend,
         proced_samples += nproc;
 
         nr_samples     -= to_proc_samples * ap_ctx->channels;
-        farend_sample  += to_proc_samples * ap_ctx->channels;
+        farend_sample  += to_proc_samples * ap_ctx->farend_channels;
         nearend_sample += to_proc_samples * ap_ctx->channels;
 
         avail_bytes    -= to_proc_bytes;
@@ -856,7 +1500,7 @@ int ap_ctx_get_per_proc_bytes(audio_proc_ctx* ap_ctx)
     return (ap_ctx->num_frames * ap_ctx->channels * sizeof(int16_t));
 }
 
-static int do_resample(struct rs_data *resampler, 
+static int do_resample(audio_proc_ctx* ap_ctx, int mode,
     const uint8_t* data, size_t size, uint8_t* out, size_t out_size)
 {
     int rc;
@@ -869,7 +1513,15 @@ static int do_resample(struct rs_data *resampler,
     in_samples = (short*)data;
     out_samples = (short*)out;
 
-    rc = resample(resampler,
+    if(ap_ctx->block_resampler[mode]){
+        /* buffers up to 10 ms internally, so 0 is not an error here */
+        rc = audio_resampler_process(ap_ctx->block_resampler[mode],
+                in_samples, in_left, out_samples, out_left);
+
+        return (rc < 0) ? rc : (int)(rc * sizeof(short));
+    }
+
+    rc = resample(ap_ctx->resampler[mode],
             in_samples, in_left, out_samples, out_left, size == 0);
     if (rc <= 0) {
        // audio_proc_log_warn("Failed to do resample for %d, when left %d %d", 
@@ -880,12 +1532,60 @@ static int do_resample(struct rs_data *resampler,
     return (rc * sizeof(short));
 }
 
+/*
+ * Reads the farend of one frame through the drift tracker: a sample more or
+ * less than a frame when the clocks drift apart, stretched back to a frame
+ * in farend_frame. Also picks up the stream delay the tracker re-estimated.
+ */
+static const int16_t* ap_ctx_read_farend_drift(audio_proc_ctx* ap_ctx)
+{
+    size_t frame_bytes = ap_ctx->farend_channels * sizeof(int16_t);
+    size_t need, to_read;
+    const int16_t *in;
+    uint8_t *region;
+    int rc, peeked;
+
+    need = ap_drift_update(ap_ctx->drift,
+        ring_buffer_avail(ap_ctx->farend_rbuf) / frame_bytes,
+        ring_buffer_avail(ap_ctx->nearend_rbuf) / (ap_ctx->channels * sizeof(int16_t)));
+    to_read = need * frame_bytes;
+
+    peeked = ring_buffer_peek_read(ap_ctx->farend_rbuf, &region, to_read);
+    if (peeked == to_read) {
+        in = (const int16_t*)region;
+        rc = peeked;
+    } else {
+        peeked = 0;
+        in = ap_ctx->drift_frame;
+
+        memset(ap_ctx->drift_frame, 0, to_read);
+
+        rc = ring_buffer_read(ap_ctx->farend_rbuf, (uint8_t*)ap_ctx->drift_frame, to_read);
+        ap_ctx_count_copy(ap_ctx, to_read + rc);
+        if (rc != to_read) {
+            audio_proc_log_info("farend buf size %d, to read %zu", rc, to_read);
+        }
+    }
+
+    ap_drift_stretch(ap_ctx->drift, in, rc / frame_bytes, ap_ctx->farend_frame);
+    ap_ctx_count_copy(ap_ctx, ap_ctx->num_frames * frame_bytes);
+
+    if (peeked) {
+        ring_buffer_commit_read(ap_ctx->farend_rbuf, peeked);
+    }
+
+    ap_ctx->stream_delay = ap_drift_get_delay(ap_ctx->drift);
+
+    return ap_ctx->farend_frame;
+}
+
 int ap_ctx_try_process(audio_proc_ctx* ap_ctx, 
     uint8_t *out, size_t out_size)
 {
     int rc;
     int near_avail, far_avail, avail;
-    int to_read, copied;
+    int to_read, far_to_read, copied;
+    bool stage_for_resample;
 
     int16_t *out_buf;
 
@@ -901,45 +1601,103 @@ int ap_ctx_try_process(audio_proc_ctx* ap_ctx,
 
     out_buf = out;
 
-#if 1
-    int16_t farend_buf[960];
-    int16_t nearend_buf[960];
-#else
-    int16_t farend_buf[640];
-    int16_t nearend_buf[640];
-    int16_t out_buf[640];
-#endif
+    /* in zero copy mode frames are processed into the staging buffer and
+     * resampled straight into out, instead of resampling out into a
+     * temporary and copying it back */
+    stage_for_resample = ap_ctx->zero_copy && (ap_ctx->proc_freq != ap_ctx->nearend_freq);
+    if (stage_for_resample) {
+        out_buf = (int16_t*)ap_ctx->out_proc_buf;
+    }
+
+    /* at most one period per call when the output is resampled, so it fits the arena */
+    if (ap_ctx->proc_freq != ap_ctx->nearend_freq) {
+        out_size = MIN(out_size, ap_ctx->out_proc_size);
+    }
 
-    to_read = MIN(sizeof(nearend_buf), ap_ctx->num_frames * ap_ctx->channels * sizeof(int16_t));
+    int16_t *farend_buf = ap_ctx->farend_frame;
+    int16_t *nearend_buf = ap_ctx->nearend_frame;
+
+    to_read = ap_ctx->num_frames * ap_ctx->channels * sizeof(int16_t);
+    far_to_read = ap_ctx->num_frames * ap_ctx->farend_channels * sizeof(int16_t);
+
+    /* the levels only mean something while both sides run, start over when they resume */
+    bool track_drift = ap_ctx->drift_tracking && ap_ctx_should_do_aec(ap_ctx);
+    if (track_drift && !ap_ctx->drift_active) {
+        ap_drift_reset(ap_ctx->drift);
+    }
+
+    if (!track_drift) {
+        ap_ctx->stream_delay = ap_ctx->aec_delay;
+    }
+
+    ap_ctx->drift_active = track_drift;
 
     /* audio_proc_log_info("avail %d, to read %d, out size %d, size of farend %d, thread id %d", 
         avail, to_read, out_size, sizeof(farend_buf), pthread_self()); */
 
     while((avail >= to_read) && (out_size > 0)) {
-        memset(farend_buf, 0, to_read);
-        memset(nearend_buf, 0, to_read);
-    
-        rc = ring_buffer_read(ap_ctx->farend_rbuf, (uint8_t*)farend_buf, to_read);
-        if (rc != to_read) {
-            audio_proc_log_info("farend buf size %d, to read %d", rc, to_read);        
-            // break;
+        const int16_t *farend, *nearend;
+        uint8_t *region;
+        int far_peeked, near_peeked;
+
+        /* use the frame in place when it does not wrap around the ring buffer */
+        far_peeked = track_drift ? 0 : ring_buffer_peek_read(ap_ctx->farend_rbuf, &region, far_to_read);
+        if (track_drift) {
+            farend = ap_ctx_read_farend_drift(ap_ctx);
+            rc = far_to_read;
+        } else if (far_peeked == far_to_read) {
+            farend = (const int16_t*)region;
+            rc = far_peeked;
+        } else {
+            far_peeked = 0;
+            farend = farend_buf;
+
+            memset(farend_buf, 0, far_to_read);
+
+            rc = ring_buffer_read(ap_ctx->farend_rbuf, (uint8_t*)farend_buf, far_to_read);
+            ap_ctx_count_copy(ap_ctx, far_to_read + rc);
+            if (rc != far_to_read) {
+                audio_proc_log_info("farend buf size %d, to read %d", rc, far_to_read);
+                // break;
+            }
         }
 
         AUDIO_STAREM_DEBUG_EXT("/sdcard/read_from_farend.pcm", from_playback_fp,
-            farend_buf, rc);
-
-        rc = ring_buffer_read(ap_ctx->nearend_rbuf, (uint8_t*)nearend_buf, to_read);
-        if (rc != to_read) {
-            audio_proc_log_info("nearend buf size %d, to read %d", rc, to_read);
-            // break;
+            farend, rc);
+
+        near_peeked = ring_buffer_peek_read(ap_ctx->nearend_rbuf, &region, to_read);
+        if (near_peeked == to_read) {
+            nearend = (const int16_t*)region;
+            rc = near_peeked;
+        } else {
+            near_peeked = 0;
+            nearend = nearend_buf;
+
+            memset(nearend_buf, 0, to_read);
+
+            rc = ring_buffer_read(ap_ctx->nearend_rbuf, (uint8_t*)nearend_buf, to_read);
+            ap_ctx_count_copy(ap_ctx, to_read + rc);
+            if (rc != to_read) {
+                audio_proc_log_info("nearend buf size %d, to read %d", rc, to_read);
+                // break;
+            }
         }
 
         AUDIO_STAREM_DEBUG_EXT("/sdcard/read_from_nearend.pcm", from_record_fp,
-            nearend_buf, rc);
+            nearend, rc);
 
 #if 1
-        rc = ap_ctx_do_process(ap_ctx, farend_buf, nearend_buf, to_read / sizeof(int16_t), 
+        rc = ap_ctx_do_process(ap_ctx, farend, nearend, to_read / sizeof(int16_t), 
                 out_buf, out_size / sizeof(int16_t));
+
+        if (far_peeked) {
+            ring_buffer_commit_read(ap_ctx->farend_rbuf, far_peeked);
+        }
+
+        if (near_peeked) {
+            ring_buffer_commit_read(ap_ctx->nearend_rbuf, near_peeked);
+        }
+
         if (rc <= 0) {
             audio_proc_log_warn("Failed to process pcm");
             break;
@@ -956,18 +1714,30 @@ int ap_ctx_try_process(audio_proc_ctx* ap_ctx,
         out_size -= rc * sizeof(out_buf[0]);
     }
 
-    if(ap_ctx->proc_freq != ap_ctx->nearend_freq){
-        uint8_t samples_buf[1920 * 4];
+    if(stage_for_resample){
+        /* same bound as the copying path: out holds the frames at nearend rate */
+        rc = do_resample(ap_ctx, AP_CTX_OUT_MODE,
+                ap_ctx->out_proc_buf, copied, out, ap_ctx->out_resample_size);
+        if (rc <= 0) {
+           ap_ctx_unref(ap_ctx);
+           return rc;
+        }
+
+        copied = rc;
+    }else if(ap_ctx->proc_freq != ap_ctx->nearend_freq){
+        uint8_t *samples_buf = ap_ctx->out_resample_buf;
         const uint8_t *samples = out;
     
-        rc = do_resample(ap_ctx->resampler[AP_CTX_OUT_MODE],
-                samples, copied, samples_buf, sizeof(samples_buf));
+        rc = do_resample(ap_ctx, AP_CTX_OUT_MODE,
+                samples, copied, samples_buf, ap_ctx->out_resample_size);
         if (rc <= 0) {
            // audio_proc_log_warn("Failed to do resample for %d", rc);
+           ap_ctx_unref(ap_ctx);
            return rc;
         }
 
         memcpy(out, samples_buf, rc);
+        ap_ctx_count_copy(ap_ctx, rc);
 
         copied = rc;
     }
@@ -977,55 +1747,236 @@ int ap_ctx_try_process(audio_proc_ctx* ap_ctx,
     return copied;
 }
 
-int ap_ctx_push_farend(audio_proc_ctx* ap_ctx, const uint8_t* data, size_t size)
+static int16_t* ap_ctx_get_batch_buf(audio_proc_ctx* ap_ctx, size_t samples)
+{
+    int16_t *buf;
+
+    if (ap_ctx->batch_buf_samples >= samples) {
+        return ap_ctx->batch_buf;
+    }
+
+    buf = (int16_t*)realloc(ap_ctx->batch_buf, samples * sizeof(int16_t));
+    if (!buf) {
+        audio_proc_log_warn("Failed to alloc %zu samples for batch process", samples);
+        return NULL;
+    }
+
+    ap_ctx->batch_buf = buf;
+    ap_ctx->batch_buf_samples = samples;
+
+    return buf;
+}
+
+/* brings one end of a batch to proc_freq, returns the samples available at proc rate */
+static int ap_ctx_batch_to_proc_freq(audio_proc_ctx* ap_ctx, int mode, uint32_t freq,
+    const int16_t *data, size_t samples, int16_t *scratch, size_t scratch_samples,
+    const int16_t **proc_data)
 {
     int rc;
-    const uint8_t *samples;
-    uint8_t samples_buf[1920 * 4];
-    
+
+    if (freq == ap_ctx->proc_freq) {
+        *proc_data = data;
+        return samples;
+    }
+
+    rc = do_resample(ap_ctx, mode, (const uint8_t*)data, samples * sizeof(int16_t),
+            (uint8_t*)scratch, scratch_samples * sizeof(int16_t));
+    if (rc < 0) {
+        audio_proc_log_warn("Failed to do resample for %d", rc);
+        return rc;
+    }
+
+    *proc_data = scratch;
+    return rc / sizeof(int16_t);
+}
+
+int ap_ctx_process_batch(audio_proc_ctx* ap_ctx, const int16_t *farend,
+    const int16_t *nearend, size_t nr_frames, int16_t *out, size_t len)
+{
+    int            rc, far_samples, near_samples;
+    int            mic_level;
+    size_t         frame_samples, far_frame_samples, batch_samples, nr_proc;
+    const int16_t *far_proc, *near_proc;
+    int16_t       *scratch, *out_proc;
+    bool           need_do_aec, out_in_place;
+
     check_try_retrun(ap_ctx, -1);
 
-    if(!ap_ctx_should_do_aec(ap_ctx)){
+    if (!nearend || !nr_frames) {
         return 0;
     }
 
-    assert(sizeof(samples_buf) >= size);
+    ap_ctx_ref(ap_ctx);
 
-    samples = data;
-    rc = size;
+    frame_samples = ap_ctx->num_frames * ap_ctx->channels;
+    far_frame_samples = ap_ctx->num_frames * ap_ctx->farend_channels;
+    batch_samples = nr_frames * frame_samples;
 
-    ap_ctx_ref(ap_ctx);
+    /* far | near | out, all at proc rate; the resamplers may hand back one block more than asked */
+    scratch = ap_ctx_get_batch_buf(ap_ctx, (batch_samples + frame_samples) * 3);
+    if (!scratch) {
+        ap_ctx_unref(ap_ctx);
+        return -1;
+    }
 
-    if(ap_ctx->farend_freq != ap_ctx->proc_freq){
-        // do resample
-        
-        rc = do_resample(ap_ctx->resampler[AP_CTX_PLAYBACK_MODE],
-                data, size, samples_buf, sizeof(samples_buf));
-        if (rc <= 0) {
-           ap_ctx_unref(ap_ctx);
-           
-           audio_proc_log_warn("Failed to do resample for %d", rc);
-           return rc;
+    need_do_aec = (farend != NULL) && ap_ctx_should_do_aec(ap_ctx);
+
+    near_samples = ap_ctx_batch_to_proc_freq(ap_ctx, AP_CTX_RECORD_MODE, ap_ctx->nearend_freq,
+            nearend, nr_frames * (ap_ctx->nearend_freq / 100) * ap_ctx->channels,
+            scratch + batch_samples + frame_samples, batch_samples + frame_samples, &near_proc);
+    if (near_samples < 0) {
+        ap_ctx_unref(ap_ctx);
+        return near_samples;
+    }
+
+    if (need_do_aec) {
+        far_samples = ap_ctx_batch_to_proc_freq(ap_ctx, AP_CTX_PLAYBACK_MODE, ap_ctx->farend_freq,
+                farend, nr_frames * (ap_ctx->farend_freq / 100) * ap_ctx->farend_channels,
+                scratch, batch_samples + frame_samples, &far_proc);
+        if (far_samples < 0) {
+            ap_ctx_unref(ap_ctx);
+            return far_samples;
         }
 
-        samples = samples_buf;
+        /* the farend resampler may still hold back a block, it is silence for the aec */
+        size_t far_need = near_samples / frame_samples * far_frame_samples;
 
-        /* audio_proc_log_info("playback should do resample from %d to %d, size %d to %d", 
-            ap_ctx->farend_freq, ap_ctx->proc_freq, size, rc); */
+        if ((size_t)far_samples < far_need) {
+            if (far_proc != scratch) {
+                memcpy(scratch, far_proc, far_samples * sizeof(int16_t));
+                ap_ctx_count_copy(ap_ctx, far_samples * sizeof(int16_t));
+                far_proc = scratch;
+            }
+
+            memset(scratch + far_samples, 0, (far_need - far_samples) * sizeof(int16_t));
+            ap_ctx_count_copy(ap_ctx, (far_need - far_samples) * sizeof(int16_t));
+        }
+    } else {
+        far_proc = NULL;
     }
 
-    rc = ring_buffer_write(ap_ctx->farend_rbuf, samples, rc);
+    nr_proc = near_samples / frame_samples;
+
+    out_in_place = (ap_ctx->nearend_freq == ap_ctx->proc_freq) && (len >= nr_proc * frame_samples);
+    out_proc = out_in_place ? out : scratch + (batch_samples + frame_samples) * 2;
+
+    ap_ctx_ensure_sfbs(ap_ctx);
+
+    mic_level = ap_ctx->agc_mic_level;
+
+    if (ap_ctx->shared_farend) {
+        /* the channels of a shared farend reuse the analysis channel 0 made
+         * of the same frame, so go frame by frame like the streaming path;
+         * the mic levels are still carried per channel, as below */
+        for (int i = 0; i < ap_ctx->channels; ++i) {
+            ap_ctx->mic_levels[i] = ap_ctx->agc_mic_level;
+        }
+
+        for (size_t f = 0; f < nr_proc; ++f) {
+            for (int i = 0; i < ap_ctx->channels; ++i) {
+                ap_ctx_process_channel(ap_ctx, i,
+                    need_do_aec ? far_proc + f * far_frame_samples : NULL,
+                    near_proc + f * frame_samples,
+                    out_proc + f * frame_samples,
+                    need_do_aec, &ap_ctx->mic_levels[i]);
+            }
+        }
+
+        mic_level = ap_ctx->mic_levels[ap_ctx->channels - 1];
+    } else {
+        /* run all frames of a channel back to back, so its aec/ns/agc state and
+         * splitting filter stay in cache; each channel owns its instances, only
+         * the agc mic level is shared and it is carried per channel here */
+        for (int i = 0; i < ap_ctx->channels; ++i) {
+            int channel_mic_level = ap_ctx->agc_mic_level;
+
+            for (size_t f = 0; f < nr_proc; ++f) {
+                ap_ctx_process_channel(ap_ctx, i,
+                    need_do_aec ? far_proc + f * far_frame_samples : NULL,
+                    near_proc + f * frame_samples,
+                    out_proc + f * frame_samples,
+                    need_do_aec, &channel_mic_level);
+            }
+
+            mic_level = channel_mic_level;
+        }
+    }
+
+    ap_ctx->agc_mic_level = mic_level;
+    ap_ctx->nr_proc_frames += nr_proc;
+
+    rc = nr_proc * frame_samples;
+
+    if (!out_in_place) {
+        if (ap_ctx->nearend_freq == ap_ctx->proc_freq) {
+            rc = MIN(rc, len);
+            memcpy(out, out_proc, rc * sizeof(int16_t));
+            ap_ctx_count_copy(ap_ctx, rc * sizeof(int16_t));
+        } else {
+            rc = do_resample(ap_ctx, AP_CTX_OUT_MODE,
+                    (const uint8_t*)out_proc, rc * sizeof(int16_t), (uint8_t*)out, len * sizeof(int16_t));
+            rc = (rc < 0) ? rc : (int)(rc / sizeof(int16_t));
+        }
+    }
 
     ap_ctx_unref(ap_ctx);
 
-    return size; /* rc */
+    return rc;
 }
 
-int ap_ctx_push_nearend(audio_proc_ctx* ap_ctx, const uint8_t* data, size_t size)
+/*
+ * Resamples one end into its ring buffer. The input is cut into pieces of
+ * at most max_period_ms, so any push size works with the arena sized
+ * push_buf; the output goes straight into the ring buffer when the
+ * writable region is contiguous.
+ */
+static int ap_ctx_push(audio_proc_ctx* ap_ctx, int mode, ring_buffer_t *rbuf,
+    uint32_t freq, uint32_t channels, uint8_t *push_buf, const uint8_t* data, size_t size)
+{
+    int rc;
+    size_t offset, chunk, chunk_max, frame_bytes;
+
+    if(freq == ap_ctx->proc_freq){
+        ring_buffer_write(rbuf, data, size);
+        return size;
+    }
+
+    frame_bytes = MAX(channels, 1) * sizeof(int16_t);
+
+    chunk_max = ap_ctx_period_samples(freq, ap_ctx->max_period_ms, MAX(channels, 1)) * sizeof(int16_t);
+    chunk_max -= chunk_max % frame_bytes;
+
+    for(offset = 0; offset < size; offset += chunk){
+        uint8_t *region;
+
+        chunk = MIN(size - offset, chunk_max);
+
+        if(ring_buffer_peek_write(rbuf, &region, ap_ctx->push_buf_size) == ap_ctx->push_buf_size){
+            rc = do_resample(ap_ctx, mode,
+                data + offset, chunk, region, ap_ctx->push_buf_size);
+            if (rc > 0) {
+                ring_buffer_commit_write(rbuf, rc);
+            }
+        }else{
+            rc = do_resample(ap_ctx, mode,
+                data + offset, chunk, push_buf, ap_ctx->push_buf_size);
+            if (rc > 0) {
+                ring_buffer_write(rbuf, push_buf, rc);
+            }
+        }
+
+        if (rc < 0) {
+            audio_proc_log_warn("Failed to do resample for %d", rc);
+            return rc;
+        }
+    }
+
+    return size;
+}
+
+int ap_ctx_push_farend(audio_proc_ctx* ap_ctx, const uint8_t* data, size_t size)
 {
     int rc;
-    const uint8_t *samples;
-    uint8_t samples_buf[1920 * 4];
     
     check_try_retrun(ap_ctx, -1);
 
@@ -1033,34 +1984,32 @@ int ap_ctx_push_nearend(audio_proc_ctx* ap_ctx, const uint8_t* data, size_t size
         return 0;
     }
 
-    assert(sizeof(samples_buf) >= size);
+    ap_ctx_ref(ap_ctx);
 
-    samples = data;
-    rc = size;
+    rc = ap_ctx_push(ap_ctx, AP_CTX_PLAYBACK_MODE, ap_ctx->farend_rbuf,
+        ap_ctx->farend_freq, ap_ctx->farend_channels, ap_ctx->farend_push_buf, data, size);
 
-    ap_ctx_ref(ap_ctx);
+    ap_ctx_unref(ap_ctx);
 
-    if(ap_ctx->nearend_freq != ap_ctx->proc_freq){
-        // do resample
-        
-        rc = do_resample(ap_ctx->resampler[AP_CTX_RECORD_MODE], 
-            data, size, samples_buf, sizeof(samples_buf));
-        if (rc <= 0) {
-           ap_ctx_unref(ap_ctx);
-           
-           audio_proc_log_warn("Failed to do resample for %d", rc);
-           return rc;
-        }
+    return rc;
+}
 
-        samples = samples_buf;
+int ap_ctx_push_nearend(audio_proc_ctx* ap_ctx, const uint8_t* data, size_t size)
+{
+    int rc;
+    
+    check_try_retrun(ap_ctx, -1);
 
-        /* audio_proc_log_info("record should do resample from %d to %d, size %d to %d", 
-            ap_ctx->nearend_freq, ap_ctx->proc_freq, size, rc); */
+    if(!ap_ctx_should_do_aec(ap_ctx)){
+        return 0;
     }
 
-    rc = ring_buffer_write(ap_ctx->nearend_rbuf, samples, rc);
+    ap_ctx_ref(ap_ctx);
+
+    rc = ap_ctx_push(ap_ctx, AP_CTX_RECORD_MODE, ap_ctx->nearend_rbuf,
+        ap_ctx->nearend_freq, ap_ctx->nearend_channels, ap_ctx->nearend_push_buf, data, size);
 
     ap_ctx_unref(ap_ctx);
 
-    return size; /* rc */
+    return rc;
 }
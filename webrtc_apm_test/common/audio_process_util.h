@@ -16,6 +16,23 @@ int ap_ctx_ref(audio_proc_ctx* ap_ctx);
 
 int ap_ctx_unref(audio_proc_ctx* ap_ctx);
 
+enum {
+AP_CTX_RESAMPLER_AUTO = 0, // polyphase fast path for 48k <-> 16k/32k, PushSincResampler otherwise
+AP_CTX_RESAMPLER_SINC,     // PushSincResampler (SSE/NEON) for every rate pair
+AP_CTX_RESAMPLER_LINEAR,   // legacy ccrma linear interpolation (resample.c)
+NR_AP_CTX_RESAMPLER
+};
+
+/* may be called before ap_ctx_init, otherwise the resamplers are rebuilt */
+int ap_ctx_set_resampler_backend(audio_proc_ctx* ap_ctx, int backend);
+
+/*
+ * Longest callback period (ms, default 40) handled in one piece, sizes the
+ * frame arena allocated by ap_ctx_init. Larger pushes still work, they are
+ * just resampled in several pieces. Must be called before ap_ctx_init.
+ */
+int ap_ctx_set_max_period(audio_proc_ctx* ap_ctx, uint32_t period_ms);
+
 int ap_ctx_init(audio_proc_ctx* ap_ctx, uint32_t channels,
     uint32_t nearend_freq, uint32_t farend_freq, uint32_t aec_delay);
 
@@ -31,12 +48,60 @@ int ap_ctx_set_agc_is_enable(audio_proc_ctx* ap_ctx, int enable);
 
 int ap_ctx_should_do_aec(audio_proc_ctx* ap_ctx);
 
+/* process frames in place: ring buffer views feed the splitting filters and
+ * the processed bands are interleaved straight into the caller's buffer */
+int ap_ctx_set_zero_copy(audio_proc_ctx* ap_ctx, int enable);
+
+/*
+ * For a mono farend (one loudspeaker, many mics, see
+ * ap_ctx_set_aec_farend_info): the farend is split into bands once per frame
+ * instead of once per channel, and with WEBRTC_MOBILE the aecm of channel 0
+ * also computes the farend spectrum and delay history for all the others.
+ * The output is the same as without it. Off by default, and ignored while
+ * the farend has more than one channel, each then cancelling its own.
+ */
+int ap_ctx_set_shared_farend(audio_proc_ctx* ap_ctx, int enable);
+
+/*
+ * Follow the clock drift between the farend and nearend (see
+ * audio_drift_tracker.h): the farend is read a fraction of a sample faster or
+ * slower to keep its ring buffer level, and the delay handed to the aec moves
+ * with what is left of the level change. Off by default.
+ */
+int ap_ctx_set_drift_tracking(audio_proc_ctx* ap_ctx, int enable);
+
+/* measured farend clock offset (ppm), current aec delay (ms) and farend underruns */
+int ap_ctx_get_drift_stats(audio_proc_ctx* ap_ctx, double *ppm, int *delay_ms, uint64_t *underruns);
+
+/* frames processed and bytes copied/cleared by the wrapper outside of the
+ * processing modules, copied_bytes / frames is the per frame copy cost */
+int ap_ctx_get_copy_stats(audio_proc_ctx* ap_ctx, uint64_t *frames, uint64_t *copied_bytes);
+
+/* samples converted between int16 and float by the splitting filter buffers,
+ * converted_samples / frames / channels / samples per frame is the number of
+ * int16 <-> float passes each frame goes through */
+int ap_ctx_get_conversion_stats(audio_proc_ctx* ap_ctx, uint64_t *frames, uint64_t *converted_samples);
+
 int ap_ctx_set_aec_config(audio_proc_ctx* ap_ctx);
 
 int ap_ctx_reset(audio_proc_ctx* ap_ctx);
 
+/* reuse an inited context for a new stream with the same format, the
+ * stream is processed bit exact with a context fresh from ap_ctx_init:
+ * the end formats, resampler backend, zero copy, shared farend and drift
+ * tracking go back to their ap_ctx_init defaults, only the max period of
+ * ap_ctx_set_max_period stays */
+int ap_ctx_recycle(audio_proc_ctx* ap_ctx);
+
 int ap_ctx_cleanup(audio_proc_ctx* ap_ctx);
 
+/*
+ * Switch the format one end is pushed in: its resampler is reopened for the
+ * new rate and the aec/ns/agc are reset. The channels must be the ones given
+ * to ap_ctx_init, or 1 for the farend: a mono farend (one loudspeaker) is
+ * cancelled on every nearend channel. The rate must be at most the fastest
+ * one given to ap_ctx_init, which sized the frame arena; returns -1 otherwise.
+ */
 int ap_ctx_set_aec_farend_info(audio_proc_ctx* ap_ctx,
     uint32_t farend_freq, uint32_t farend_channels);
 
@@ -47,10 +112,23 @@ int ap_ctx_push_farend(audio_proc_ctx* ap_ctx, const uint8_t* data, size_t size)
 
 int ap_ctx_push_nearend(audio_proc_ctx* ap_ctx, const uint8_t* data, size_t size);
 
+/* nr_samples counts the nearend, the farend holds as many frames of farend channels */
 int ap_ctx_do_process(audio_proc_ctx* ap_ctx, const int16_t const *farend, 
     const int16_t const *nearend, size_t nr_samples, 
     int16_t dest[], size_t len);
 
+/*
+ * Offline path: process nr_frames 10 ms frames in one call, bypassing the
+ * ring buffers. farend/nearend are interleaved at farend_freq/nearend_freq
+ * with their own channels (farend may be NULL to skip the aec), out
+ * receives up to len samples at nearend_freq. Returns the samples written
+ * to out, or < 0 on error.
+ * Shares the resamplers and aec/ns/agc state with the push/try_process
+ * path, so do not mix both on one stream.
+ */
+int ap_ctx_process_batch(audio_proc_ctx* ap_ctx, const int16_t *farend,
+    const int16_t *nearend, size_t nr_frames, int16_t *out, size_t len);
+
 // typedef int (*ap_ctx_process_pft)(const uint8_t* src, uint8_t* dest, size_t size, void *args);
 
 int ap_ctx_try_process(audio_proc_ctx* ap_ctx, 
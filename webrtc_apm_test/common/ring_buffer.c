@@ -2,6 +2,7 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <stdatomic.h>
 
 #ifndef unref_param
 #define unref_param(...) ((void)(__VA_ARGS__))
@@ -14,12 +15,29 @@
 #define max(a, b) (((a) > (b)) ? (a) : (b))
 #endif
 
-
+#define RING_BUFFER_CACHE_LINE (64)
+
+/*
+ * rpos/wpos are free running counters, masked only when touching data, so
+ * the whole buffer is usable and (wpos - rpos) is the fill level even after
+ * the counters wrap.
+ *
+ * The writer owns wpos and the reader owns rpos; each lives on its own cache
+ * line next to a private copy of the other side's counter, so the hot path
+ * only touches the peer's line when the cached value says the buffer looks
+ * full (writer) or empty (reader).
+ */
 struct ring_buffer_ {
     uint8_t           *data;
     uint32_t           size, size_mask; /* size must be pow of two */
-    volatile uint32_t  rpos;
-    volatile uint32_t  wpos;
+
+    _Alignas(RING_BUFFER_CACHE_LINE)
+    atomic_uint        wpos;
+    uint32_t           rpos_cache; /* writer's view of rpos */
+
+    _Alignas(RING_BUFFER_CACHE_LINE)
+    atomic_uint        rpos;
+    uint32_t           wpos_cache; /* reader's view of wpos */
 };
 
 static uint32_t roundup_pow_of_two(uint32_t x)
@@ -39,14 +57,15 @@ static uint32_t roundup_pow_of_two(uint32_t x)
 
 ring_buffer_t* ring_buffer_create()
 {
-    ring_buffer_t *rbuf;
-    
-    rbuf = (ring_buffer_t*)malloc(sizeof(ring_buffer_t));
-    if(rbuf){
-        memset(rbuf, 0, sizeof(*rbuf));
+    void *rbuf;
+
+    if(posix_memalign(&rbuf, RING_BUFFER_CACHE_LINE, sizeof(ring_buffer_t))){
+        return NULL;
     }
-    
-    return rbuf;
+
+    memset(rbuf, 0, sizeof(ring_buffer_t));
+
+    return (ring_buffer_t*)rbuf;
 }
 
 void ring_buffer_destroy(ring_buffer_t *rbuf)
@@ -61,40 +80,41 @@ int ring_buffer_init(ring_buffer_t *rbuf, uint8_t *data, size_t len)
         return -1;
     }
 
-    rbuf->rpos = rbuf->wpos = 0;
     rbuf->data = data;
     rbuf->size = len;
     rbuf->size_mask = rbuf->size - 1;
 
+    rbuf->rpos_cache = rbuf->wpos_cache = 0;
+    atomic_store_explicit(&rbuf->rpos, 0, memory_order_relaxed);
+    atomic_store_explicit(&rbuf->wpos, 0, memory_order_release);
+
     return 0;
 }
 
 uint32_t ring_buffer_free(ring_buffer_t *rbuf)
 {
-    int32_t free;
+    uint32_t rpos, wpos;
 
-    free = rbuf->rpos - rbuf->wpos;
-    if (free <= 0)
-        free += rbuf->size;
+    rpos = atomic_load_explicit(&rbuf->rpos, memory_order_acquire);
+    wpos = atomic_load_explicit(&rbuf->wpos, memory_order_acquire);
 
-    return (uint32_t)(free - 1);
+    return rbuf->size - (wpos - rpos);
 }
 
 
 uint32_t ring_buffer_avail(ring_buffer_t *rbuf)
 {
-    int32_t avail;
+    uint32_t rpos, wpos;
 
-    avail = rbuf->wpos - rbuf->rpos;
-    if (avail < 0)
-        avail += rbuf->size;
+    wpos = atomic_load_explicit(&rbuf->wpos, memory_order_acquire);
+    rpos = atomic_load_explicit(&rbuf->rpos, memory_order_acquire);
 
-    return (uint32_t)avail;
+    return wpos - rpos;
 }
 
 int ring_buffer_empty(ring_buffer_t *rbuf)
 {
-    return (rbuf->rpos == rbuf->wpos);
+    return ring_buffer_avail(rbuf) == 0;
 }
 
 int ring_buffer_full(ring_buffer_t *rbuf)
@@ -104,7 +124,41 @@ int ring_buffer_full(ring_buffer_t *rbuf)
 
 void ring_buffer_flush(ring_buffer_t *rbuf)
 {
-    rbuf->rpos = rbuf->wpos;
+    uint32_t wpos;
+
+    /* reader side only */
+    wpos = atomic_load_explicit(&rbuf->wpos, memory_order_acquire);
+    rbuf->wpos_cache = wpos;
+
+    atomic_store_explicit(&rbuf->rpos, wpos, memory_order_release);
+}
+
+/* writer side: bytes that can be written without waiting for the reader */
+static uint32_t writer_free(ring_buffer_t *rbuf, uint32_t wpos, uint32_t want)
+{
+    uint32_t room;
+
+    room = rbuf->size - (wpos - rbuf->rpos_cache);
+    if (room < want) {
+        rbuf->rpos_cache = atomic_load_explicit(&rbuf->rpos, memory_order_acquire);
+        room = rbuf->size - (wpos - rbuf->rpos_cache);
+    }
+
+    return room;
+}
+
+/* reader side: bytes that can be read without waiting for the writer */
+static uint32_t reader_avail(ring_buffer_t *rbuf, uint32_t rpos, uint32_t want)
+{
+    uint32_t avail;
+
+    avail = rbuf->wpos_cache - rpos;
+    if (avail < want) {
+        rbuf->wpos_cache = atomic_load_explicit(&rbuf->wpos, memory_order_acquire);
+        avail = rbuf->wpos_cache - rpos;
+    }
+
+    return avail;
 }
 
 int ring_buffer_write(ring_buffer_t *rbuf, const uint8_t* buf, size_t leng)
@@ -112,10 +166,10 @@ int ring_buffer_write(ring_buffer_t *rbuf, const uint8_t* buf, size_t leng)
     size_t to_transfer, chunk;
     uint32_t wpos, start, copied = 0;
 
-    to_transfer = ring_buffer_free(rbuf);
-    to_transfer = min(to_transfer, leng);
+    wpos = atomic_load_explicit(&rbuf->wpos, memory_order_relaxed);
 
-    wpos = rbuf->wpos;
+    to_transfer = writer_free(rbuf, wpos, leng);
+    to_transfer = min(to_transfer, leng);
 
     while (to_transfer) {
         start = wpos & rbuf->size_mask;
@@ -128,18 +182,13 @@ int ring_buffer_write(ring_buffer_t *rbuf, const uint8_t* buf, size_t leng)
         wpos        += chunk;
     }
 
-    rbuf->wpos = wpos & rbuf->size_mask;
-
-    if(wpos != rbuf->wpos){
-        #include "w_log.h"
-
-        // LOGW("!!! circle buffer write wrapped !!!");
-    }
+    /* publish the data before the new write position */
+    atomic_store_explicit(&rbuf->wpos, wpos, memory_order_release);
 
     return copied;
 }
 
-int ring_buffer_consume(ring_buffer_t *rbuf, uint8_t *dest_buf, ssize_t leng, 
+int ring_buffer_consume(ring_buffer_t *rbuf, uint8_t *dest_buf, ssize_t leng,
     process_data_pft callback, void *args)
 {
     size_t to_transfer, chunk;
@@ -147,10 +196,10 @@ int ring_buffer_consume(ring_buffer_t *rbuf, uint8_t *dest_buf, ssize_t leng,
     int32_t written = 0;
     uint8_t *dest = dest_buf;
 
-    to_transfer = ring_buffer_avail(rbuf);
-    to_transfer = min(to_transfer, leng);
+    rpos = atomic_load_explicit(&rbuf->rpos, memory_order_relaxed);
 
-    rpos = rbuf->rpos;
+    to_transfer = reader_avail(rbuf, rpos, leng);
+    to_transfer = min(to_transfer, leng);
 
     if(!callback){
         return to_transfer;
@@ -171,7 +220,8 @@ int ring_buffer_consume(ring_buffer_t *rbuf, uint8_t *dest_buf, ssize_t leng,
         dest        += written;
     }
 
-    rbuf->rpos = rpos & rbuf->size_mask;
+    /* hand the space back only after the data was consumed */
+    atomic_store_explicit(&rbuf->rpos, rpos, memory_order_release);
 
     return copied;
 }
@@ -181,7 +231,7 @@ static ssize_t copy_data_proc(uint8_t *src, uint8_t *dest, ssize_t size, void *a
     unref_param(args);
 
     memcpy(dest, src, size);
-    
+
     return size;
 }
 
@@ -190,4 +240,52 @@ int ring_buffer_read(ring_buffer_t *rbuf, uint8_t* buf, size_t leng)
     return ring_buffer_consume(rbuf, buf, leng, copy_data_proc, NULL);
 }
 
+int ring_buffer_peek_write(ring_buffer_t *rbuf, uint8_t **region, size_t leng)
+{
+    uint32_t wpos, start, chunk;
+
+    wpos = atomic_load_explicit(&rbuf->wpos, memory_order_relaxed);
+    start = wpos & rbuf->size_mask;
+
+    chunk = writer_free(rbuf, wpos, leng);
+    chunk = min(chunk, rbuf->size - start);
+    chunk = min(chunk, leng);
+
+    *region = rbuf->data + start;
 
+    return chunk;
+}
+
+void ring_buffer_commit_write(ring_buffer_t *rbuf, size_t leng)
+{
+    uint32_t wpos;
+
+    wpos = atomic_load_explicit(&rbuf->wpos, memory_order_relaxed);
+
+    atomic_store_explicit(&rbuf->wpos, wpos + leng, memory_order_release);
+}
+
+int ring_buffer_peek_read(ring_buffer_t *rbuf, uint8_t **region, size_t leng)
+{
+    uint32_t rpos, start, chunk;
+
+    rpos = atomic_load_explicit(&rbuf->rpos, memory_order_relaxed);
+    start = rpos & rbuf->size_mask;
+
+    chunk = reader_avail(rbuf, rpos, leng);
+    chunk = min(chunk, rbuf->size - start);
+    chunk = min(chunk, leng);
+
+    *region = rbuf->data + start;
+
+    return chunk;
+}
+
+void ring_buffer_commit_read(ring_buffer_t *rbuf, size_t leng)
+{
+    uint32_t rpos;
+
+    rpos = atomic_load_explicit(&rbuf->rpos, memory_order_relaxed);
+
+    atomic_store_explicit(&rbuf->rpos, rpos + leng, memory_order_release);
+}
@@ -3,7 +3,7 @@
 
 #include <stdint.h>
 
-/* only for one writer thread and one reader thread */
+/* only for one writer thread and one reader thread, lock free (C11 atomics) */
 
 typedef struct ring_buffer_ ring_buffer_t;
 
@@ -28,4 +28,15 @@ int ring_buffer_read(ring_buffer_t *rbuf, uint8_t* buf, size_t leng);
 int ring_buffer_consume(ring_buffer_t *rbuf, uint8_t *dest_buf, ssize_t leng, 
     process_data_pft callback, void *args);
 
+/*
+ * zero-copy access: peek returns the size of the contiguous region (at most
+ * leng) at the write/read position, commit publishes/releases leng bytes of it.
+ * peek_write/commit_write belong to the writer, peek_read/commit_read to the reader.
+ */
+int ring_buffer_peek_write(ring_buffer_t *rbuf, uint8_t **region, size_t leng);
+void ring_buffer_commit_write(ring_buffer_t *rbuf, size_t leng);
+
+int ring_buffer_peek_read(ring_buffer_t *rbuf, uint8_t **region, size_t leng);
+void ring_buffer_commit_read(ring_buffer_t *rbuf, size_t leng);
+
 #endif
@@ -0,0 +1,137 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "webrtc/common_audio/fft4g.h"
+#include "webrtc/common_audio/rdft.h"
+#include "webrtc/modules/audio_processing/aec/aec_core.h"
+#include "webrtc/modules/audio_processing/aec/aec_rdft.h"
+
+
+#define LOGW(fmt, ...) fprintf(stderr, fmt"\n", ##__VA_ARGS__)
+#define LOGI           LOGW
+
+#define BENCH_MAX_LENGTH (1024)
+
+/*
+ * Times a forward plus an inverse real fft with each backend, for the
+ * lengths the apm uses: Ooura's WebRtc_rdft, WebRtcRdft as created on this
+ * cpu (radix-4 on SSE2/NEON from 32 points on, Ooura otherwise) and, at 128
+ * points, the aec's own aec_rdft. Every line shows its speedup over Ooura.
+ *
+ * fft_bench [-n calls]
+ */
+
+typedef struct _bench_ooura {
+    size_t  length;
+    size_t  ip[2 + 64];
+    float   w[BENCH_MAX_LENGTH / 2];
+} bench_ooura;
+
+static float data[BENCH_MAX_LENGTH];
+
+static uint64_t now_ns()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static void fill(float *buf, size_t size)
+{
+    for(size_t i = 0; i < size; ++i){
+        buf[i] = -32768.0f + 65535.0f * ((float)rand() / RAND_MAX);
+    }
+}
+
+static void run_ooura(void *arg, float *buf)
+{
+    bench_ooura *o = (bench_ooura *)arg;
+
+    WebRtc_rdft(o->length, 1, buf, o->ip, o->w);
+    WebRtc_rdft(o->length, -1, buf, o->ip, o->w);
+}
+
+static void run_rdft(void *arg, float *buf)
+{
+    WebRtcRdft_Forward((struct WebRtcRdft *)arg, buf);
+    WebRtcRdft_Inverse((struct WebRtcRdft *)arg, buf);
+}
+
+static void run_aec_rdft(void *arg, float *buf)
+{
+    (void)arg;
+
+    aec_rdft_forward_128(buf);
+    aec_rdft_inverse_128(buf);
+}
+
+static double run(void (*fn)(void *, float *), void *arg, size_t length, int calls)
+{
+    uint64_t start;
+    float    scale = 2.0f / length;
+
+    fill(data, length);
+
+    start = now_ns();
+    for(int n = 0; n < calls; ++n){
+        fn(arg, data);
+        /* keeps the data in range, the transforms scale it by length / 2 */
+        data[n % length] *= scale;
+    }
+
+    return (double)(now_ns() - start) / calls;
+}
+
+int main(int argc, const char *argv[])
+{
+    int calls = 200000;
+
+    for(int i = 1; i + 1 < argc; i += 2){
+        if(!strcmp(argv[i], "-n")){
+            calls = atoi(argv[i + 1]);
+        }
+    }
+
+    if(calls <= 0){
+        LOGW("usage: %s [-n calls]", argv[0]);
+        return -1;
+    }
+
+    srand(1);
+    aec_rdft_init();
+
+    for(size_t length = 64; length <= BENCH_MAX_LENGTH; length *= 2){
+        bench_ooura        ooura;
+        struct WebRtcRdft *rdft;
+        double             ns_ooura, ns;
+
+        memset(&ooura, 0, sizeof(ooura));
+        ooura.length = length;
+
+        rdft = WebRtcRdft_Create(length);
+        if(!rdft){
+            LOGW("failed to create a %zu point rdft", length);
+            return -1;
+        }
+
+        ns_ooura = run(run_ooura, &ooura, length, calls);
+        LOGI("%4zu  %-10s %8.1f ns/call", length, "ooura", ns_ooura);
+
+        ns = run(run_rdft, rdft, length, calls);
+        LOGI("%4zu  %-10s %8.1f ns/call  x%.2f", length, "WebRtcRdft", ns, ns_ooura / ns);
+
+        if(length == PART_LEN2){
+            ns = run(run_aec_rdft, NULL, length, calls);
+            LOGI("%4zu  %-10s %8.1f ns/call  x%.2f", length, "aec_rdft", ns, ns_ooura / ns);
+        }
+
+        WebRtcRdft_Free(rdft);
+    }
+
+    return 0;
+}
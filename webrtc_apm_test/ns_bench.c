@@ -0,0 +1,176 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "webrtc/modules/audio_processing/ns/noise_suppression.h"
+#include "webrtc/system_wrappers/include/cpu_features_wrapper.h"
+
+
+#define LOGW(fmt, ...) fprintf(stderr, fmt"\n", ##__VA_ARGS__)
+#define LOGI           LOGW
+
+#ifndef ARRAY_SIZE
+#define ARRAY_SIZE(ARRAY) (sizeof((ARRAY)) / sizeof((ARRAY)[0]))
+#endif
+
+#define BENCH_MAX_CHANNELS (8)
+#define BENCH_MAX_BANDS    (3)
+#define BENCH_BAND_LENGTH  (160)
+
+/*
+ * Times the float noise suppressor (WebRtcNs_Analyze + WebRtcNs_Process) per
+ * 10 ms frame of every channel, with the generic C kernels (and Ooura's fft)
+ * and with what WebRtcNs_InitCore picks for this cpu, and shows the speedup
+ * of the latter.
+ * Every channel runs its own instance, as the apm does for multi-mic input;
+ * the input is noise with a tone switching on and off, so both the noise and
+ * the speech paths of the estimator get exercised.
+ *
+ * ns_bench [-n frames] [-c channels] [-f rate]
+ */
+
+static WebRtc_CPUInfo cpu_info_native;
+
+static int cpu_info_generic(CPUFeature feature)
+{
+    return WebRtc_GetCPUInfoNoASM(feature);
+}
+
+static int cpu_info_all(CPUFeature feature)
+{
+    return cpu_info_native(feature);
+}
+
+static const struct {
+    const char     *name;
+    WebRtc_CPUInfo  cpu_info;
+} bench_variants[] = {
+    { "generic", cpu_info_generic },
+    { "native",  cpu_info_all },
+};
+
+static float in[BENCH_MAX_CHANNELS][BENCH_MAX_BANDS][BENCH_BAND_LENGTH];
+static float out[BENCH_MAX_CHANNELS][BENCH_MAX_BANDS][BENCH_BAND_LENGTH];
+
+static uint64_t now_ns()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static float frand(float min, float max)
+{
+    return min + (max - min) * ((float)rand() / RAND_MAX);
+}
+
+static void fill(int frame, int channels, size_t bands, size_t length)
+{
+    /* a tone for half a second every second, over noise */
+    float amplitude = (frame / 50) % 2 ? 3000.f : 0.f;
+
+    for(int c = 0; c < channels; ++c){
+        for(size_t b = 0; b < bands; ++b){
+            for(size_t i = 0; i < length; ++i){
+                size_t t = frame * length + i;
+
+                in[c][b][i] = frand(-500.f, 500.f)
+                    + (b == 0 ? amplitude * sinf(0.1f * (c + 1) * t) : 0.f);
+            }
+        }
+    }
+}
+
+static double run(WebRtc_CPUInfo cpu_info, int frames, int channels, int rate)
+{
+    WebRtc_CPUInfo  saved = WebRtc_GetCPUInfo;
+    NsHandle       *ns[BENCH_MAX_CHANNELS];
+    size_t          bands = rate > 16000 ? (size_t)rate / 16000 : 1;
+    size_t          length = rate == 8000 ? 80 : BENCH_BAND_LENGTH;
+    uint64_t        elapsed = 0;
+    int             ret = 0;
+
+    /* the kernels are global, picked when an instance is initialized */
+    WebRtc_GetCPUInfo = cpu_info;
+    for(int c = 0; c < channels; ++c){
+        ns[c] = WebRtcNs_Create();
+        if(!ns[c] || WebRtcNs_Init(ns[c], rate) != 0 || WebRtcNs_set_policy(ns[c], 2) != 0){
+            ret = -1;
+        }
+    }
+    WebRtc_GetCPUInfo = saved;
+
+    srand(1);
+    for(int n = 0; ret == 0 && n < frames; ++n){
+        uint64_t start;
+
+        fill(n, channels, bands, length);
+
+        start = now_ns();
+        for(int c = 0; c < channels; ++c){
+            const float *in_bands[BENCH_MAX_BANDS];
+            float       *out_bands[BENCH_MAX_BANDS];
+
+            for(size_t b = 0; b < bands; ++b){
+                in_bands[b] = in[c][b];
+                out_bands[b] = out[c][b];
+            }
+
+            WebRtcNs_Analyze(ns[c], in_bands[0]);
+            WebRtcNs_Process(ns[c], in_bands, bands, out_bands);
+        }
+        elapsed += now_ns() - start;
+    }
+
+    for(int c = 0; c < channels; ++c){
+        if(ns[c]){
+            WebRtcNs_Free(ns[c]);
+        }
+    }
+
+    return ret < 0 ? -1.0 : (double)elapsed / frames;
+}
+
+int main(int argc, const char *argv[])
+{
+    double ns[ARRAY_SIZE(bench_variants)];
+    int    frames = 20000, channels = 2, rate = 16000;
+
+    for(int i = 1; i + 1 < argc; i += 2){
+        if(!strcmp(argv[i], "-n")){
+            frames = atoi(argv[i + 1]);
+        }else if(!strcmp(argv[i], "-c")){
+            channels = atoi(argv[i + 1]);
+        }else if(!strcmp(argv[i], "-f")){
+            rate = atoi(argv[i + 1]);
+        }
+    }
+
+    if(frames <= 0 || channels <= 0 || channels > BENCH_MAX_CHANNELS
+        || (rate != 8000 && rate != 16000 && rate != 32000 && rate != 48000)){
+        LOGW("usage: %s [-n frames] [-c channels (1..%d)] [-f 8000|16000|32000|48000]",
+            argv[0], BENCH_MAX_CHANNELS);
+        return -1;
+    }
+
+    cpu_info_native = WebRtc_GetCPUInfo;
+
+    for(int v = 0; v < (int)ARRAY_SIZE(bench_variants); ++v){
+        ns[v] = run(bench_variants[v].cpu_info, frames, channels, rate);
+        if(ns[v] < 0){
+            LOGW("%s: failed to create the ns", bench_variants[v].name);
+            return -1;
+        }
+
+        LOGI("%-8s %d Hz x%d  %9.1f ns/frame  %8.1f ns/frame/channel  x%.2f",
+            bench_variants[v].name, rate, channels, ns[v], ns[v] / channels,
+            ns[0] / ns[v]);
+    }
+
+    return 0;
+}
@@ -0,0 +1,251 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "common/resample.h"
+#include "audio_resampler.h"
+
+
+#define LOGW(fmt, ...) fprintf(stderr, fmt"\n", ##__VA_ARGS__)
+#define LOGI           LOGW
+
+#ifndef ARRAY_SIZE
+#define ARRAY_SIZE(ARRAY) (sizeof((ARRAY)) / sizeof((ARRAY)[0]))
+#endif
+
+/*
+ * Compares the resampler backends available to audio_proc_ctx:
+ *   - CPU per 10 ms mono frame
+ *   - passband gain of a 1 kHz tone
+ *   - aliasing (downsampling) or imaging (upsampling) of a tone just outside
+ *     the band that survives the conversion, relative to the input tone
+ *
+ * resample_bench [-s seconds]
+ */
+
+#define BENCH_AMPLITUDE (16384.0)
+#define BENCH_MAX_FRAME (480)
+
+typedef enum {
+    BENCH_LINEAR = 0,
+    BENCH_SINC,
+    BENCH_POLYPHASE,
+    NR_BENCH_BACKEND
+} bench_backend;
+
+static const char *bench_backend_names[NR_BENCH_BACKEND] = {"linear", "sinc", "polyphase"};
+
+static const struct {
+    int in_rate;
+    int out_rate;
+} rate_pairs[] = {
+    { 48000, 16000 },
+    { 16000, 48000 },
+    { 48000, 32000 },
+    { 32000, 48000 },
+    { 44100, 16000 },
+    { 16000, 44100 },
+};
+
+typedef struct _bench_resampler {
+    bench_backend    backend;
+    struct rs_data  *linear;
+    audio_resampler *block;
+} bench_resampler;
+
+static uint64_t now_ns()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static int bench_resampler_open(bench_resampler *rs, bench_backend backend, int in_rate, int out_rate)
+{
+    memset(rs, 0, sizeof(*rs));
+
+    rs->backend = backend;
+
+    if(backend == BENCH_LINEAR){
+        rs->linear = resample_init(in_rate, out_rate, 8192);
+        return rs->linear ? 0 : -1;
+    }
+
+    rs->block = audio_resampler_create();
+    if(!rs->block){
+        return -1;
+    }
+
+    return audio_resampler_init(rs->block,
+        (backend == BENCH_SINC) ? AUDIO_RESAMPLER_SINC : AUDIO_RESAMPLER_POLYPHASE,
+        in_rate, out_rate, 1) < 0 ? -1 : 0;
+}
+
+static void bench_resampler_close(bench_resampler *rs)
+{
+    resample_close(rs->linear);
+    audio_resampler_free(rs->block);
+}
+
+static int bench_resampler_process(bench_resampler *rs, int16_t *in, int in_len,
+    int16_t *out, int out_len)
+{
+    if(rs->linear){
+        return resample(rs->linear, in, in_len, out, out_len, 0);
+    }
+
+    return audio_resampler_process(rs->block, in, in_len, out, out_len);
+}
+
+/* amplitude of the frequency component freq in x, via the goertzel recurrence */
+static double goertzel_amplitude(const int16_t *x, int len, double freq, int rate)
+{
+    double coeff, s0, s1 = 0.0, s2 = 0.0, power;
+
+    coeff = 2.0 * cos(2.0 * M_PI * freq / rate);
+
+    for(int i = 0; i < len; ++i){
+        /* hann window to keep the leakage of the other tone out */
+        double w = 0.5 - 0.5 * cos(2.0 * M_PI * i / (len - 1));
+
+        s0 = x[i] * w + coeff * s1 - s2;
+        s2 = s1;
+        s1 = s0;
+    }
+
+    power = s1 * s1 + s2 * s2 - coeff * s1 * s2;
+
+    /* the hann window has a coherent gain of 0.5 */
+    return 2.0 * sqrt(power > 0.0 ? power : 0.0) / (len * 0.5);
+}
+
+static double to_db(double ratio)
+{
+    return 20.0 * log10(ratio > 1e-9 ? ratio : 1e-9);
+}
+
+/* resamples a tone of freq Hz, returns the output and its length */
+static int16_t* run_tone(bench_backend backend, int in_rate, int out_rate, double freq,
+    int seconds, int *out_len, double *ns_per_frame)
+{
+    bench_resampler rs;
+    int16_t   in[BENCH_MAX_FRAME];
+    int16_t  *out;
+    int       in_frame, nr_frames, capacity, produced = 0;
+    uint64_t  elapsed = 0, start;
+
+    if(bench_resampler_open(&rs, backend, in_rate, out_rate) < 0){
+        bench_resampler_close(&rs);
+        return NULL;
+    }
+
+    in_frame = in_rate / 100;
+    nr_frames = seconds * 100;
+    capacity = (int)((double)nr_frames * out_rate / 100) + BENCH_MAX_FRAME * 2;
+
+    out = (int16_t *)calloc(capacity, sizeof(int16_t));
+
+    for(int f = 0; f < nr_frames && out; ++f){
+        int rc;
+
+        for(int i = 0; i < in_frame; ++i){
+            int n = f * in_frame + i;
+            in[i] = (int16_t)(BENCH_AMPLITUDE * sin(2.0 * M_PI * freq * n / in_rate));
+        }
+
+        start = now_ns();
+        rc = bench_resampler_process(&rs, in, in_frame, out + produced, capacity - produced);
+        elapsed += now_ns() - start;
+
+        if(rc > 0){
+            produced += rc;
+        }
+    }
+
+    bench_resampler_close(&rs);
+
+    *out_len = produced;
+    *ns_per_frame = (double)elapsed / nr_frames;
+
+    return out;
+}
+
+static void bench_pair(bench_backend backend, int in_rate, int out_rate, int seconds)
+{
+    int16_t *out;
+    int      out_len, skip;
+    double   ns_pass, ns_stop, pass_db, stop_db, stop_freq, probe_freq;
+    bool     down = out_rate < in_rate;
+
+    if(backend == BENCH_POLYPHASE && !audio_resampler_has_fast_path(in_rate, out_rate)){
+        return;
+    }
+
+    /* the tone that must not come through, and where its alias/image lands */
+    if(down){
+        stop_freq = out_rate / 2 * 1.25;
+        probe_freq = out_rate - stop_freq;
+    }else{
+        stop_freq = in_rate / 2 * 0.625;
+        probe_freq = in_rate - stop_freq;
+    }
+
+    out = run_tone(backend, in_rate, out_rate, 1000.0, seconds, &out_len, &ns_pass);
+    if(!out){
+        LOGW("%-9s %5d -> %5d: not supported", bench_backend_names[backend], in_rate, out_rate);
+        return;
+    }
+
+    /* skip the first 100 ms, it carries the filter and block delay */
+    skip = out_rate / 10;
+    pass_db = to_db(goertzel_amplitude(out + skip, out_len - skip, 1000.0, out_rate) / BENCH_AMPLITUDE);
+    free(out);
+
+    out = run_tone(backend, in_rate, out_rate, stop_freq, seconds, &out_len, &ns_stop);
+    if(!out){
+        return;
+    }
+
+    if(down){
+        stop_db = to_db(goertzel_amplitude(out + skip, out_len - skip, probe_freq, out_rate) / BENCH_AMPLITUDE);
+    }else{
+        /* imaging: the image of the in band tone relative to the tone itself */
+        stop_db = to_db(goertzel_amplitude(out + skip, out_len - skip, probe_freq, out_rate)
+            / goertzel_amplitude(out + skip, out_len - skip, stop_freq, out_rate));
+    }
+    free(out);
+
+    LOGI("%-9s %5d -> %5d: %8.0f ns/frame, 1 kHz gain %6.2f dB, %s at %5.0f Hz %7.1f dB",
+        bench_backend_names[backend], in_rate, out_rate, (ns_pass + ns_stop) / 2,
+        pass_db, down ? "alias" : "image", probe_freq, stop_db);
+}
+
+int main(int argc, const char *argv[])
+{
+    int seconds = 10;
+
+    for(int i = 1; i + 1 < argc; i += 2){
+        if(!strcmp(argv[i], "-s")){
+            seconds = atoi(argv[i + 1]);
+        }
+    }
+
+    if(seconds <= 0){
+        LOGW("usage: %s [-s seconds]", argv[0]);
+        return -1;
+    }
+
+    for(int i = 0; i < (int)ARRAY_SIZE(rate_pairs); ++i){
+        for(int backend = 0; backend < NR_BENCH_BACKEND; ++backend){
+            bench_pair((bench_backend)backend, rate_pairs[i].in_rate, rate_pairs[i].out_rate, seconds);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,227 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "common/ring_buffer.h"
+
+
+#define LOGW(fmt, ...) fprintf(stderr, fmt"\n", ##__VA_ARGS__)
+#define LOGI           LOGW
+
+/*
+ * Contention benchmark for the SPSC ring buffer: one producer and one
+ * consumer thread hammer the same ring buffer with chunks of a fixed size.
+ * The byte stream carries a running counter, so the consumer also verifies
+ * that nothing was lost, duplicated or reordered.
+ *
+ * ring_buffer_bench -s 640 -r 65536 -t 1024
+ *   -s  bytes per push/pop (default 640, one stereo 16 kHz frame)
+ *   -r  ring buffer size in bytes, power of two (default 64 KiB)
+ *   -t  MiB to transfer (default 1024)
+ */
+
+typedef enum {
+    BENCH_MODE_COPY = 0,
+    BENCH_MODE_ZERO_COPY,
+    NR_BENCH_MODE
+} bench_mode;
+
+static const char *bench_mode_names[NR_BENCH_MODE] = {"copy", "peek/commit"};
+
+typedef struct _bench_ctx {
+    ring_buffer_t *rbuf;
+    bench_mode     mode;
+    size_t         chunk;
+    uint64_t       total;
+
+    uint64_t       producer_stalls;
+    uint64_t       consumer_stalls;
+    uint64_t       errors;
+} bench_ctx;
+
+static uint64_t now_ns()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static void fill_pattern(uint8_t *buf, size_t size, uint64_t offset)
+{
+    for(size_t i = 0; i < size; ++i){
+        buf[i] = (uint8_t)(offset + i);
+    }
+}
+
+static size_t check_pattern(const uint8_t *buf, size_t size, uint64_t offset)
+{
+    size_t errors = 0;
+
+    for(size_t i = 0; i < size; ++i){
+        errors += (buf[i] != (uint8_t)(offset + i));
+    }
+
+    return errors;
+}
+
+static void* producer_loop(void *args)
+{
+    bench_ctx *ctx = (bench_ctx *)args;
+    uint8_t   *chunk, *region;
+    uint64_t   written = 0;
+    int        rc;
+
+    chunk = (uint8_t *)malloc(ctx->chunk);
+
+    while(written < ctx->total){
+        size_t to_write = ctx->chunk;
+
+        if(to_write > ctx->total - written){
+            to_write = ctx->total - written;
+        }
+
+        if(ctx->mode == BENCH_MODE_ZERO_COPY){
+            rc = ring_buffer_peek_write(ctx->rbuf, &region, to_write);
+            if(rc > 0){
+                fill_pattern(region, rc, written);
+                ring_buffer_commit_write(ctx->rbuf, rc);
+            }
+        }else{
+            fill_pattern(chunk, to_write, written);
+
+            /* a short write just regenerates the tail from the new offset next round */
+            rc = ring_buffer_write(ctx->rbuf, chunk, to_write);
+        }
+
+        if(rc <= 0){
+            ctx->producer_stalls++;
+            sched_yield();
+            continue;
+        }
+
+        written += rc;
+    }
+
+    free(chunk);
+
+    return NULL;
+}
+
+static void* consumer_loop(void *args)
+{
+    bench_ctx *ctx = (bench_ctx *)args;
+    uint8_t   *chunk, *region;
+    uint64_t   read = 0;
+    int        rc;
+
+    chunk = (uint8_t *)malloc(ctx->chunk);
+
+    while(read < ctx->total){
+        if(ctx->mode == BENCH_MODE_ZERO_COPY){
+            rc = ring_buffer_peek_read(ctx->rbuf, &region, ctx->chunk);
+            if(rc > 0){
+                ctx->errors += check_pattern(region, rc, read);
+                ring_buffer_commit_read(ctx->rbuf, rc);
+            }
+        }else{
+            rc = ring_buffer_read(ctx->rbuf, chunk, ctx->chunk);
+            if(rc > 0){
+                ctx->errors += check_pattern(chunk, rc, read);
+            }
+        }
+
+        if(rc <= 0){
+            ctx->consumer_stalls++;
+            sched_yield();
+            continue;
+        }
+
+        read += rc;
+    }
+
+    free(chunk);
+
+    return NULL;
+}
+
+static int run_bench(bench_mode mode, size_t chunk, size_t rbuf_size, uint64_t total)
+{
+    bench_ctx  ctx;
+    pthread_t  producer, consumer;
+    uint8_t   *data;
+    uint64_t   start, elapsed;
+
+    memset(&ctx, 0, sizeof(ctx));
+
+    data = (uint8_t *)malloc(rbuf_size);
+    ctx.rbuf = ring_buffer_create();
+
+    if(!data || !ctx.rbuf || ring_buffer_init(ctx.rbuf, data, rbuf_size) < 0){
+        LOGW("Failed to create ring buffer of %zu bytes (must be pow of two)", rbuf_size);
+        ring_buffer_destroy(ctx.rbuf);
+        free(data);
+        return -1;
+    }
+
+    ctx.mode = mode;
+    ctx.chunk = chunk;
+    ctx.total = total;
+
+    start = now_ns();
+
+    pthread_create(&consumer, NULL, consumer_loop, &ctx);
+    pthread_create(&producer, NULL, producer_loop, &ctx);
+
+    pthread_join(producer, NULL);
+    pthread_join(consumer, NULL);
+
+    elapsed = now_ns() - start;
+
+    LOGI("%-12s chunk %6zu, ring %8zu: %8.1f MiB/s, %6.1f ns/chunk, stalls w %llu r %llu, errors %llu",
+        bench_mode_names[mode], chunk, rbuf_size,
+        (total / (1024.0 * 1024.0)) / (elapsed / 1e9),
+        (double)elapsed / ((total + chunk - 1) / chunk),
+        (unsigned long long)ctx.producer_stalls, (unsigned long long)ctx.consumer_stalls,
+        (unsigned long long)ctx.errors);
+
+    ring_buffer_destroy(ctx.rbuf);
+    free(data);
+
+    return ctx.errors ? -1 : 0;
+}
+
+int main(int argc, const char *argv[])
+{
+    size_t   chunk = 640;
+    size_t   rbuf_size = 64 * 1024;
+    uint64_t total_mb = 1024;
+    int      rc = 0;
+
+    for(int i = 1; i + 1 < argc; i += 2){
+        if(!strcmp(argv[i], "-s")){
+            chunk = strtoul(argv[i + 1], NULL, 10);
+        }else if(!strcmp(argv[i], "-r")){
+            rbuf_size = strtoul(argv[i + 1], NULL, 10);
+        }else if(!strcmp(argv[i], "-t")){
+            total_mb = strtoull(argv[i + 1], NULL, 10);
+        }
+    }
+
+    if(!chunk || !total_mb){
+        LOGW("usage: %s [-s chunk bytes] [-r ring bytes] [-t MiB]", argv[0]);
+        return -1;
+    }
+
+    for(int mode = 0; mode < NR_BENCH_MODE; ++mode){
+        rc |= run_bench((bench_mode)mode, chunk, rbuf_size, total_mb * 1024 * 1024);
+    }
+
+    return rc;
+}
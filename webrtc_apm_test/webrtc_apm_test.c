@@ -7,6 +7,7 @@
 
 #include "common/ring_buffer.h"
 #include "common/audio_process_util.h"
+#include "common/audio_process_runner.h"
 
 
 #define LOGW(fmt, ...) fprintf(stderr, fmt"\n", ##__VA_ARGS__)
@@ -37,8 +38,17 @@
 
 typedef struct _global{
     int         channels;
+    int         farend_channels;
     int         frequency;
     int         aec_delay;
+    int         zero_copy;
+    int         resampler;
+    int         batch;
+    int         threads;
+    int         shared_farend;
+    int         drift;
+    int         verify;
+    const char *manifest_path;
     const char *farend_path;
     const char *nearend_path;
     const char *out_path;
@@ -46,8 +56,17 @@ typedef struct _global{
 
 static global session = {
     .channels     = 2,
+    .farend_channels = 0,
     .frequency    = 48000,
     .aec_delay    = 100,
+    .zero_copy    = 0,
+    .resampler    = 0,
+    .batch        = 0,
+    .threads      = 1,
+    .shared_farend = 0,
+    .drift        = 0,
+    .verify       = 0,
+    .manifest_path = NULL,
     .farend_path  = "/sdcard/farend_for_playback.pcm",
     .nearend_path = "/sdcard/nearend_for_record.pcm",
     .out_path     = "/sdcard/after_apm.pcm"
@@ -55,6 +74,23 @@ static global session = {
 
 static audio_proc_ctx *ap_ctx;
 
+/* FNV-1a of everything processed, to compare passes without keeping them */
+static uint64_t out_hash;
+static bool     out_discard; // hash only, the output file is written once
+
+static void out_write(const void *buf, size_t size)
+{
+    const uint8_t *p = (const uint8_t *)buf;
+
+    for(size_t i = 0; i < size; ++i){
+        out_hash = (out_hash ^ p[i]) * 0x100000001b3ULL;
+    }
+
+    if(!out_discard){
+        AUDIO_STAREM_DEBUG(session.out_path, out_fp, buf, size);
+    }
+}
+
 
 
 typedef struct _cmd_t cmd_t;
@@ -123,6 +159,13 @@ cmd_t cmds[] = {
         .desc     = "pcm channels",
         .def_pval = (void*)(2),
         .pval     = &session.channels
+    }, {
+        .name     = "farend_channels",
+        .opt      = "-fc",
+        .parse    = parse_integer,
+        .desc     = "farend pcm channels, 1 for a mono farend cancelled on every channel, 0 as -c",
+        .def_pval = (void*)(0),
+        .pval     = &session.farend_channels
     }, {
         .name     = "frequency",
         .opt      = "-f",
@@ -137,6 +180,62 @@ cmd_t cmds[] = {
         .desc     = "pcm frequency",
         .def_pval = (void*)(100),
         .pval     = &session.aec_delay
+    }, {
+        .name     = "zero_copy",
+        .opt      = "-z",
+        .parse    = parse_integer,
+        .desc     = "process frames in place (1) or through copies (0)",
+        .def_pval = (void*)(0),
+        .pval     = &session.zero_copy
+    }, {
+        .name     = "resampler",
+        .opt      = "-r",
+        .parse    = parse_integer,
+        .desc     = "resampler backend, 0 auto, 1 sinc, 2 linear",
+        .def_pval = (void*)(0),
+        .pval     = &session.resampler
+    }, {
+        .name     = "batch",
+        .opt      = "-b",
+        .parse    = parse_integer,
+        .desc     = "10 ms frames per ap_ctx_process_batch call, 0 streams through the ring buffers",
+        .def_pval = (void*)(0),
+        .pval     = &session.batch
+    }, {
+        .name     = "threads",
+        .opt      = "-j",
+        .parse    = parse_integer,
+        .desc     = "runner threads for -m",
+        .def_pval = (void*)(1),
+        .pval     = &session.threads
+    }, {
+        .name     = "shared_farend",
+        .opt      = "-s",
+        .parse    = parse_integer,
+        .desc     = "analyze a mono farend (-fc 1) once for all channels",
+        .def_pval = (void*)(0),
+        .pval     = &session.shared_farend
+    }, {
+        .name     = "drift",
+        .opt      = "-t",
+        .parse    = parse_integer,
+        .desc     = "track the farend/nearend clock drift and re-estimate the aec delay",
+        .def_pval = (void*)(0),
+        .pval     = &session.drift
+    }, {
+        .name     = "verify",
+        .opt      = "-v",
+        .parse    = parse_integer,
+        .desc     = "process the input again on the recycled context (each -m job twice) and compare",
+        .def_pval = (void*)(0),
+        .pval     = &session.verify
+    }, {
+        .name     = "manifest",
+        .opt      = "-m",
+        .parse    = parse_string,
+        .desc     = "manifest of '<farend> <nearend> <out>' lines, processed offline on -j threads",
+        .def_pval = NULL,
+        .pval     = &session.manifest_path
     }, {
         .name     = "farend_file",
         .opt      = "-far",
@@ -165,6 +264,227 @@ cmd_t cmds[] = {
     }
 };
 
+static int process_stream(FILE *farend_fp, FILE *nearend_fp)
+{
+    int     rc;
+    int     processed;
+    uint8_t buffer[1920 * 2] = { 0 };
+
+    do {
+        /* the same frames of the farend, in its own channels */
+        rc = fread(buffer, 1, sizeof(buffer) / session.channels * session.farend_channels, farend_fp);
+        if (!rc) {
+            break;
+        }
+
+        ap_ctx_push_farend(ap_ctx, buffer, rc);
+
+        rc = fread(buffer, 1, sizeof(buffer), nearend_fp);
+        if (!rc) {
+            break;
+        }
+
+        ap_ctx_push_nearend(ap_ctx, buffer, rc);
+    } while (rc > 0);
+
+
+    do{
+        processed = ap_ctx_try_process(ap_ctx, buffer, ap_ctx_get_per_proc_bytes(ap_ctx));
+
+        if(processed > 0){
+            // LOGI("ap_ctx_do_aec processed %d", processed);
+
+            out_write(buffer, processed);
+        }else{
+            LOGW("ap_ctx_do_aec Faile to processed %d", processed);
+            break;
+        }
+    }while(processed > 0);
+
+    return 0;
+}
+
+static int process_batch(FILE *farend_fp, FILE *nearend_fp)
+{
+    size_t   frame_bytes, far_frame_bytes, batch_bytes, far_read, near_read;
+    int16_t *farend, *nearend, *out;
+    int      processed, rc = 0;
+
+    frame_bytes = (session.frequency / 100) * session.channels * sizeof(int16_t);
+    far_frame_bytes = (session.frequency / 100) * session.farend_channels * sizeof(int16_t);
+    batch_bytes = frame_bytes * session.batch;
+
+    farend = (int16_t *)malloc(batch_bytes);
+    nearend = (int16_t *)malloc(batch_bytes);
+    out = (int16_t *)malloc(batch_bytes);
+
+    if(!farend || !nearend || !out){
+        LOGW("Failed to alloc %zu bytes for batch of %d frames", batch_bytes, session.batch);
+        rc = -1;
+        goto out;
+    }
+
+    for(;;){
+        far_read = fread(farend, 1, far_frame_bytes * session.batch, farend_fp);
+        near_read = fread(nearend, 1, batch_bytes, nearend_fp);
+
+        /* whole frames only, a short farend is padded with silence */
+        near_read -= near_read % frame_bytes;
+        if(!near_read){
+            break;
+        }
+
+        if(far_read < near_read / frame_bytes * far_frame_bytes){
+            memset((uint8_t *)farend + far_read, 0, near_read / frame_bytes * far_frame_bytes - far_read);
+        }
+
+        processed = ap_ctx_process_batch(ap_ctx, farend, nearend, near_read / frame_bytes,
+            out, batch_bytes / sizeof(int16_t));
+        if(processed < 0){
+            LOGW("ap_ctx_process_batch Faile to processed %d", processed);
+            rc = processed;
+            break;
+        }
+
+        out_write(out, processed * sizeof(int16_t));
+    }
+
+out:
+    free(farend);
+    free(nearend);
+    free(out);
+
+    return rc;
+}
+
+static int run_manifest()
+{
+    ap_runner_job   *jobs;
+    ap_runner_config config;
+    int              nr_jobs, failed;
+
+    nr_jobs = ap_runner_load_manifest(session.manifest_path, &jobs);
+    if(nr_jobs < 0){
+        return -1;
+    }
+
+    config.channels = session.channels;
+    config.frequency = session.frequency;
+    config.aec_delay = session.aec_delay;
+    config.resampler = session.resampler;
+    config.batch_frames = (session.batch > 0) ? session.batch : 100;
+    config.nr_threads = (session.threads > 0) ? session.threads : 1;
+    config.shared_farend = session.shared_farend;
+    config.verify = session.verify;
+
+    failed = ap_runner_run(&config, jobs, nr_jobs);
+
+    ap_runner_free_jobs(jobs, nr_jobs);
+
+    return failed ? -1 : 0;
+}
+
+/*
+ * Formats the inited or recycled context for a pass over the input. Both come
+ * with the ap_ctx_init defaults, only what differs from them is set, so an
+ * option a recycle fails to put back shows in the -v check.
+ */
+static void open_pass(int shared_farend)
+{
+    if(session.resampler){
+        ap_ctx_set_resampler_backend(ap_ctx, session.resampler);
+    }
+
+    if(session.farend_channels != session.channels){
+        ap_ctx_set_aec_farend_info(ap_ctx, session.frequency, session.farend_channels);
+    }
+
+    ap_ctx_set_nearend_is_ready(ap_ctx, 1);
+    ap_ctx_set_farend_is_ready(ap_ctx, 1);
+
+    if(session.zero_copy){
+        ap_ctx_set_zero_copy(ap_ctx, session.zero_copy);
+    }
+
+    if(shared_farend){
+        ap_ctx_set_shared_farend(ap_ctx, shared_farend);
+    }
+
+    if(session.drift){
+        ap_ctx_set_drift_tracking(ap_ctx, session.drift);
+    }
+}
+
+/*
+ * Runs the input through the recycled context with every option turned the
+ * other way and both ends in another format, to leave behind what the next
+ * recycle has to put back. Its output is dropped.
+ */
+static void process_dirty(FILE *farend_fp, FILE *nearend_fp)
+{
+    uint8_t  buffer[1920 * 2];
+    uint32_t freq = (session.frequency > 8000) ? 8000 : session.frequency;
+    int      farend_channels = (session.farend_channels == 1) ? session.channels : 1;
+    int      rc;
+
+    ap_ctx_recycle(ap_ctx);
+
+    ap_ctx_set_resampler_backend(ap_ctx, (session.resampler + 1) % NR_AP_CTX_RESAMPLER);
+    ap_ctx_set_nearend_info(ap_ctx, freq, session.channels);
+    ap_ctx_set_nearend_is_ready(ap_ctx, 1);
+    ap_ctx_set_aec_farend_info(ap_ctx, freq, farend_channels);
+    ap_ctx_set_farend_is_ready(ap_ctx, 1);
+    ap_ctx_set_zero_copy(ap_ctx, !session.zero_copy);
+    ap_ctx_set_shared_farend(ap_ctx, !session.shared_farend);
+    ap_ctx_set_drift_tracking(ap_ctx, !session.drift);
+
+    rewind(farend_fp);
+    rewind(nearend_fp);
+
+    /* processed as it is pushed, the input is taken for a slower rate and
+     * would not fit the ring buffers whole */
+    for(;;){
+        rc = fread(buffer, 1, sizeof(buffer) / session.channels * farend_channels, farend_fp);
+        if(!rc){
+            break;
+        }
+
+        ap_ctx_push_farend(ap_ctx, buffer, rc);
+
+        rc = fread(buffer, 1, sizeof(buffer), nearend_fp);
+        if(!rc){
+            break;
+        }
+
+        ap_ctx_push_nearend(ap_ctx, buffer, rc);
+
+        while(ap_ctx_try_process(ap_ctx, buffer, sizeof(buffer)) > 0){
+            ;
+        }
+    }
+}
+
+/* processes the input again on the recycled context, returns the hash of its output */
+static uint64_t process_again(FILE *farend_fp, FILE *nearend_fp, int shared_farend)
+{
+    ap_ctx_recycle(ap_ctx);
+    open_pass(shared_farend);
+
+    rewind(farend_fp);
+    rewind(nearend_fp);
+
+    out_hash = 0xcbf29ce484222325ULL;
+    out_discard = true;
+
+    if(session.batch > 0){
+        process_batch(farend_fp, nearend_fp);
+    }else{
+        process_stream(farend_fp, nearend_fp);
+    }
+
+    return out_hash;
+}
+
 /*
 * /system/lib/webrtc_apm_test -far /sdcard/read_from_playback.pcm -near /sdcard/read_from_record.pcm
 * busybox ls -lh /sdcard/
@@ -173,8 +493,7 @@ int main(int argc, const char *argv[])
 {
     FILE   *farend_fp, *nearend_fp;
     int     rc;
-    int     processed;
-    uint8_t buffer[1920 * 2] = { 0 };
+    bool    mismatch = false;
 
     for(int i = 1; i < argc; ++i){
         bool is_last = (i + 1 >= argc);
@@ -190,8 +509,17 @@ int main(int argc, const char *argv[])
         }
     }
 
-    LOGW("channels %d, frequency %d, aec delay %d",
-        session.channels, session.frequency, session.aec_delay);
+    if(!session.farend_channels){
+        session.farend_channels = session.channels;
+    }
+
+    LOGW("channels %d, farend channels %d, frequency %d, aec delay %d",
+        session.channels, session.farend_channels, session.frequency, session.aec_delay);
+
+    if(session.manifest_path){
+        rc = run_manifest();
+        goto out;
+    }
     
     ap_ctx = ap_ctx_get_default();
 
@@ -208,49 +536,78 @@ int main(int argc, const char *argv[])
         LOGW("Failed to init audio process context");
     }else{
         ap_ctx_ref(ap_ctx);
-        ap_ctx_set_nearend_info(ap_ctx, session.frequency, session.channels);
-        ap_ctx_set_nearend_is_ready(ap_ctx, 1);
+        open_pass(session.shared_farend);
+    }
+
 
-        ap_ctx_set_aec_farend_info(ap_ctx, session.frequency, session.channels);
-        ap_ctx_set_farend_is_ready(ap_ctx, 1);
+    out_hash = 0xcbf29ce484222325ULL;
+
+    if(session.batch > 0){
+        process_batch(farend_fp, nearend_fp);
+    }else{
+        process_stream(farend_fp, nearend_fp);
     }
 
+    if(session.verify){
+        uint64_t first_hash = out_hash, hash;
 
-    do {
-        rc = fread(buffer, 1, sizeof(buffer), farend_fp);
-        if (!rc) {
-            break;
-        }
+        /* a recycled context must not remember anything of the sessions before */
+        process_dirty(farend_fp, nearend_fp);
+        hash = process_again(farend_fp, nearend_fp, session.shared_farend);
 
-        ap_ctx_push_farend(ap_ctx, buffer, rc);
+        LOGI("recycled context output %s the fresh one (%016llx, %016llx)",
+            (hash != first_hash) ? "differs from" : "matches",
+            (unsigned long long)first_hash, (unsigned long long)hash);
 
-        rc = fread(buffer, 1, sizeof(buffer), nearend_fp);
-        if (!rc) {
-            break;
+        mismatch = (hash != first_hash);
+
+        /* a mono farend split once for all channels must cancel as one split per channel */
+        if(session.farend_channels == 1 && session.channels > 1){
+            hash = process_again(farend_fp, nearend_fp, !session.shared_farend);
+
+            LOGI("%s farend output %s the %s one (%016llx, %016llx)",
+                session.shared_farend ? "unshared" : "shared",
+                (hash != first_hash) ? "differs from" : "matches",
+                session.shared_farend ? "shared" : "unshared",
+                (unsigned long long)hash, (unsigned long long)first_hash);
+
+            mismatch = mismatch || (hash != first_hash);
         }
+    }
 
-        ap_ctx_push_nearend(ap_ctx, buffer, rc);
-    } while (rc > 0);
+    {
+        uint64_t frames = 0, copied_bytes = 0, converted = 0;
 
+        ap_ctx_get_copy_stats(ap_ctx, &frames, &copied_bytes);
 
-    do{
-        processed = ap_ctx_try_process(ap_ctx, buffer, ap_ctx_get_per_proc_bytes(ap_ctx));
+        LOGI("zero copy %d: %llu frames, %llu bytes copied, %.1f bytes/frame",
+            session.zero_copy, (unsigned long long)frames, (unsigned long long)copied_bytes,
+            frames ? (double)copied_bytes / frames : 0.0);
 
-        if(processed > 0){
-            // LOGI("ap_ctx_do_aec processed %d", processed);
+        ap_ctx_get_conversion_stats(ap_ctx, &frames, &converted);
 
-            AUDIO_STAREM_DEBUG(session.out_path, from_playback_fp,
-                buffer, processed);
-        }else{
-            LOGW("ap_ctx_do_aec Faile to processed %d", processed);
-            break;
+        LOGI("int16/float conversions: %llu samples, %.1f samples/frame",
+            (unsigned long long)converted, frames ? (double)converted / frames : 0.0);
+
+        if(session.drift){
+            uint64_t underruns = 0;
+            double ppm = 0.0;
+            int delay = 0;
+
+            ap_ctx_get_drift_stats(ap_ctx, &ppm, &delay, &underruns);
+
+            LOGI("drift %.1f ppm, aec delay %d ms, %llu farend underruns",
+                ppm, delay, (unsigned long long)underruns);
         }
-    }while(processed > 0);
+    }
 
     ap_ctx_set_nearend_is_ready(ap_ctx, 0);
     ap_ctx_set_farend_is_ready(ap_ctx, 0);
     ap_ctx_unref(ap_ctx);
 
+    rc = mismatch ? -1 : 0;
+
+out:
     for(cmd_t *cmd = cmds; cmd && cmd->name; ++cmd){
         if(cmd->is_alloc && cmd->pval){
             char **ptr = (char **)cmd->pval;
@@ -259,6 +616,6 @@ int main(int argc, const char *argv[])
         }
     }
 
-    return 0;
+    return rc;
 }
 
@@ -16,6 +16,9 @@ LOCAL_SRC_FILES := \
     common/ring_buffer.c \
     common/resample.c \
 	common/audio_process_util.c \
+	common/audio_drift_tracker.c \
+	common/audio_process_engine.c \
+	common/audio_process_runner.c \
 	w_log.c	\
     webrtc_apm_test.c
 
@@ -45,7 +48,7 @@ SPICEFLAGS := \
 LOCAL_CPPFLAGS := $(SPICEFLAGS) -std=c11 -O2 -Wall
 
 LOCAL_CFLAGS := $(SPICEFLAGS) \
-                -std=gnu99 -O2 -Wall -Wno-sign-compare \
+                -std=gnu11 -O2 -Wall -Wno-sign-compare \
                 -Wno-deprecated-declarations -Wl,--no-undefined \
                 -fPIC -lpthread -mfpu=neon -mfloat-abi=softfp -DNOLOGF -DRK3188
 
@@ -58,3 +61,128 @@ LOCAL_ARM_MODE := arm
 # include $(BUILD_SHARED_LIBRARY)
 include $(BUILD_EXECUTABLE)
 
+
+include $(CLEAR_VARS)
+
+# contention benchmark for the SPSC ring buffer, also builds on x86 hosts
+LOCAL_MODULE := ring_buffer_bench
+
+LOCAL_SRC_FILES := \
+    common/ring_buffer.c \
+    ring_buffer_bench.c
+
+LOCAL_C_INCLUDES += $(LOCAL_PATH) \
+                    $(LOCAL_PATH)/common
+
+LOCAL_CFLAGS := -std=gnu11 -O2 -Wall -Wno-sign-compare -lpthread
+
+LOCAL_ARM_MODE := arm
+
+include $(BUILD_EXECUTABLE)
+
+
+include $(CLEAR_VARS)
+
+# CPU per frame and aliasing of the resampler backends
+LOCAL_MODULE := resample_bench
+
+LOCAL_SRC_FILES := \
+    common/resample.c \
+    resample_bench.c
+
+LOCAL_C_INCLUDES += $(LOCAL_PATH) \
+                    $(LOCAL_PATH)/common \
+                    $(LOCAL_PATH)/../extra/webrtc-android-apm-master/webrtc_wrapper \
+                    $(LOCAL_PATH)/../extra/webrtc-android-apm-master
+
+LOCAL_CFLAGS := -std=gnu11 -O2 -Wall -Wno-sign-compare
+
+LOCAL_LDLIBS += -lstdc++ -lm
+
+LOCAL_SHARED_LIBRARIES := webrtc_audio_preprocessing webrtc_wrapper
+LOCAL_ARM_MODE := arm
+
+include $(BUILD_EXECUTABLE)
+
+
+include $(CLEAR_VARS)
+
+# ns per call of the aec kernels, generic C vs each SIMD variant the cpu has
+LOCAL_MODULE := aec_kernel_bench
+
+LOCAL_SRC_FILES := \
+    aec_kernel_bench.c
+
+LOCAL_C_INCLUDES += $(LOCAL_PATH) \
+                    $(LOCAL_PATH)/../extra/webrtc-android-apm-master
+
+LOCAL_CFLAGS := -std=gnu11 -O2 -Wall -Wno-sign-compare
+
+LOCAL_LDLIBS += -lstdc++ -lm
+
+LOCAL_SHARED_LIBRARIES := webrtc_audio_preprocessing webrtc_wrapper
+LOCAL_ARM_MODE := arm
+
+include $(BUILD_EXECUTABLE)
+
+include $(CLEAR_VARS)
+
+# ns per forward + inverse real fft, Ooura vs WebRtcRdft (and aec_rdft at 128)
+LOCAL_MODULE := fft_bench
+
+LOCAL_SRC_FILES := \
+    fft_bench.c
+
+LOCAL_C_INCLUDES += $(LOCAL_PATH) \
+                    $(LOCAL_PATH)/../extra/webrtc-android-apm-master
+
+LOCAL_CFLAGS := -std=gnu11 -O2 -Wall -Wno-sign-compare
+
+LOCAL_LDLIBS += -lstdc++ -lm
+
+LOCAL_SHARED_LIBRARIES := webrtc_audio_preprocessing webrtc_wrapper
+LOCAL_ARM_MODE := arm
+
+include $(BUILD_EXECUTABLE)
+
+include $(CLEAR_VARS)
+
+# ns per 10 ms frame of the float noise suppressor, generic C vs native kernels
+LOCAL_MODULE := ns_bench
+
+LOCAL_SRC_FILES := \
+    ns_bench.c
+
+LOCAL_C_INCLUDES += $(LOCAL_PATH) \
+                    $(LOCAL_PATH)/../extra/webrtc-android-apm-master
+
+LOCAL_CFLAGS := -std=gnu11 -O2 -Wall -Wno-sign-compare
+
+LOCAL_LDLIBS += -lstdc++ -lm
+
+LOCAL_SHARED_LIBRARIES := webrtc_audio_preprocessing webrtc_wrapper
+LOCAL_ARM_MODE := arm
+
+include $(BUILD_EXECUTABLE)
+
+include $(CLEAR_VARS)
+
+# ns per 10 ms chunk of the beamformer over 2, 4 and 8 mic arrays, generic C vs
+# native postfilter kernels
+LOCAL_MODULE := beamformer_bench
+
+LOCAL_CPP_EXTENSION := .cc
+LOCAL_SRC_FILES := \
+    beamformer_bench.cc
+
+LOCAL_C_INCLUDES += $(LOCAL_PATH) \
+                    $(LOCAL_PATH)/../extra/webrtc-android-apm-master
+
+LOCAL_CPPFLAGS := -std=c++11 -O2 -Wall -Wno-sign-compare
+
+LOCAL_LDLIBS += -lstdc++ -lm
+
+LOCAL_SHARED_LIBRARIES := webrtc_audio_preprocessing webrtc_wrapper
+LOCAL_ARM_MODE := arm
+
+include $(BUILD_EXECUTABLE)
@@ -18,7 +18,8 @@ LOCAL_MODULE := libwebrtc_wrapper_static
 LOCAL_MODULE_TAGS := optional
 LOCAL_CPP_EXTENSION := .cc
 LOCAL_SRC_FILES := \
-	audio_splitting_filter_buffer.cc
+	audio_splitting_filter_buffer.cc \
+	audio_resampler.cc
 
 # LOCAL_LDLIBS += -llog -ldl -lstdc++
 #LOCAL_LDLIBS += -lwebrtc_audio_preprocessing # -lwebrtc_common -lwebrtc_apm
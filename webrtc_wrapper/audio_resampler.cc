@@ -0,0 +1,229 @@
+#include "audio_resampler.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "webrtc/common_audio/resampler/include/resampler.h"
+#include "webrtc/common_audio/resampler/push_sinc_resampler.h"
+
+/* integer ratio pairs served by webrtc::Resampler's polyphase filters */
+static const struct {
+	int in_rate;
+	int out_rate;
+} kPolyphaseFastPaths[] = {
+	{ 48000, 16000 },
+	{ 16000, 48000 },
+	{ 48000, 32000 },
+	{ 32000, 48000 },
+};
+
+struct _audio_resampler {
+	audio_resampler_backend backend;
+
+	size_t num_channels;
+	size_t in_frames;  // per channel, 10 ms at the input rate
+	size_t out_frames; // per channel, 10 ms at the output rate
+
+	webrtc::PushSincResampler** sinc;
+	webrtc::Resampler** polyphase;
+
+	int16_t* pending; // interleaved input waiting for a full block
+	size_t num_pending;
+
+	int16_t* ch_in;
+	int16_t* ch_out;
+};
+
+int audio_resampler_has_fast_path(int in_rate, int out_rate)
+{
+	for (size_t i = 0; i < sizeof(kPolyphaseFastPaths) / sizeof(kPolyphaseFastPaths[0]); ++i) {
+		if (kPolyphaseFastPaths[i].in_rate == in_rate && kPolyphaseFastPaths[i].out_rate == out_rate) {
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+static void audio_resampler_release(audio_resampler* rs)
+{
+	for (size_t i = 0; i < rs->num_channels; ++i) {
+		if (rs->sinc) {
+			delete rs->sinc[i];
+		}
+
+		if (rs->polyphase) {
+			delete rs->polyphase[i];
+		}
+	}
+
+	delete[] rs->sinc;
+	delete[] rs->polyphase;
+	delete[] rs->pending;
+	delete[] rs->ch_in;
+	delete[] rs->ch_out;
+
+	memset(rs, 0, sizeof(*rs));
+}
+
+audio_resampler* audio_resampler_create()
+{
+	audio_resampler* rs;
+
+	rs = (audio_resampler*)malloc(sizeof(*rs));
+	if (rs) {
+		memset(rs, 0, sizeof(*rs));
+	}
+
+	return rs;
+}
+
+void audio_resampler_free(audio_resampler* rs)
+{
+	if (!rs) {
+		return;
+	}
+
+	audio_resampler_release(rs);
+
+	free(rs);
+}
+
+int audio_resampler_init(audio_resampler* rs, audio_resampler_backend backend,
+	int in_rate, int out_rate, size_t num_channels)
+{
+	audio_resampler_release(rs);
+
+	if (in_rate <= 0 || out_rate <= 0 || !num_channels) {
+		return -1;
+	}
+
+	if (backend == AUDIO_RESAMPLER_AUTO) {
+		backend = audio_resampler_has_fast_path(in_rate, out_rate) ?
+			AUDIO_RESAMPLER_POLYPHASE : AUDIO_RESAMPLER_SINC;
+	}
+	else if (backend == AUDIO_RESAMPLER_POLYPHASE && !audio_resampler_has_fast_path(in_rate, out_rate)) {
+		return -1;
+	}
+
+	rs->backend = backend;
+	rs->num_channels = num_channels;
+	rs->in_frames = in_rate / 100;
+	rs->out_frames = out_rate / 100;
+
+	rs->pending = new int16_t[rs->in_frames * num_channels];
+	rs->ch_in = new int16_t[rs->in_frames];
+	rs->ch_out = new int16_t[rs->out_frames];
+
+	if (backend == AUDIO_RESAMPLER_SINC) {
+		rs->sinc = new webrtc::PushSincResampler*[num_channels];
+		for (size_t i = 0; i < num_channels; ++i) {
+			rs->sinc[i] = new webrtc::PushSincResampler(rs->in_frames, rs->out_frames);
+		}
+	}
+	else {
+		rs->polyphase = new webrtc::Resampler*[num_channels];
+		for (size_t i = 0; i < num_channels; ++i) {
+			rs->polyphase[i] = new webrtc::Resampler(in_rate, out_rate, 1);
+		}
+	}
+
+	return backend;
+}
+
+static int audio_resampler_process_channel(audio_resampler* rs, size_t channel,
+	const int16_t* in, int16_t* out)
+{
+	size_t out_len = 0;
+
+	if (rs->sinc) {
+		out_len = rs->sinc[channel]->Resample(in, rs->in_frames, out, rs->out_frames);
+	}
+	else if (rs->polyphase[channel]->Push(in, rs->in_frames, out, rs->out_frames, out_len) < 0) {
+		return -1;
+	}
+
+	return (out_len == rs->out_frames) ? 0 : -1;
+}
+
+/* resamples one interleaved 10 ms block */
+static int audio_resampler_process_block(audio_resampler* rs, const int16_t* in, int16_t* out)
+{
+	size_t num_channels = rs->num_channels;
+
+	if (num_channels == 1) {
+		return audio_resampler_process_channel(rs, 0, in, out);
+	}
+
+	for (size_t ch = 0; ch < num_channels; ++ch) {
+		for (size_t i = 0; i < rs->in_frames; ++i) {
+			rs->ch_in[i] = in[i * num_channels + ch];
+		}
+
+		if (audio_resampler_process_channel(rs, ch, rs->ch_in, rs->ch_out) < 0) {
+			return -1;
+		}
+
+		for (size_t i = 0; i < rs->out_frames; ++i) {
+			out[i * num_channels + ch] = rs->ch_out[i];
+		}
+	}
+
+	return 0;
+}
+
+int audio_resampler_process(audio_resampler* rs, const int16_t* in, size_t in_samples,
+	int16_t* out, size_t out_capacity)
+{
+	size_t block_in, block_out, written;
+
+	if (!rs->pending) {
+		return -1;
+	}
+
+	block_in = rs->in_frames * rs->num_channels;
+	block_out = rs->out_frames * rs->num_channels;
+	written = 0;
+
+	/* refuse the whole call rather than drop the input out can not take */
+	if ((rs->num_pending + in_samples) / block_in * block_out > out_capacity) {
+		return -1;
+	}
+
+	while (in_samples > 0) {
+		if (!rs->num_pending && in_samples >= block_in) {
+			/* whole block available in the input, no need to stage it */
+			if (audio_resampler_process_block(rs, in, out + written) < 0) {
+				return -1;
+			}
+
+			in += block_in;
+			in_samples -= block_in;
+			written += block_out;
+			continue;
+		}
+
+		size_t chunk = block_in - rs->num_pending;
+		if (chunk > in_samples) {
+			chunk = in_samples;
+		}
+
+		memcpy(rs->pending + rs->num_pending, in, chunk * sizeof(int16_t));
+
+		rs->num_pending += chunk;
+		in += chunk;
+		in_samples -= chunk;
+
+		if (rs->num_pending == block_in) {
+			rs->num_pending = 0;
+
+			if (audio_resampler_process_block(rs, rs->pending, out + written) < 0) {
+				return -1;
+			}
+
+			written += block_out;
+		}
+	}
+
+	return written;
+}
@@ -0,0 +1,60 @@
+#ifndef AUDIO_RESAMPLER_H_
+#define AUDIO_RESAMPLER_H_
+
+#include "audio_splitting_filter_buffer.h" /* EXPORT */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Push based int16 resampler over the webrtc common_audio resamplers.
+ *
+ * Input of any size is accepted, it is cut into 10 ms blocks internally, so
+ * the output lags the input by up to one block. Interleaved frames with any
+ * number of channels are resampled channel by channel.
+ */
+
+typedef enum {
+	/* polyphase fast path from the table if the rate pair has one, sinc otherwise */
+	AUDIO_RESAMPLER_AUTO = 0,
+	/* PushSincResampler, SSE/NEON convolution */
+	AUDIO_RESAMPLER_SINC,
+	/* fixed point integer ratio polyphase filters (48k <-> 16k/32k only) */
+	AUDIO_RESAMPLER_POLYPHASE,
+	NR_AUDIO_RESAMPLER_BACKEND
+} audio_resampler_backend;
+
+typedef struct _audio_resampler audio_resampler;
+
+EXPORT
+audio_resampler* audio_resampler_create();
+
+EXPORT
+void audio_resampler_free(audio_resampler* rs);
+
+/* returns the backend in use, or -1 if the rate pair is not supported by it */
+EXPORT
+int audio_resampler_init(audio_resampler* rs, audio_resampler_backend backend,
+	int in_rate, int out_rate, size_t num_channels);
+
+EXPORT
+int audio_resampler_has_fast_path(int in_rate, int out_rate);
+
+/*
+ * returns the number of output samples (all channels) written to out, or -1
+ * if a resampler fails or the 10 ms blocks completed by in do not all fit
+ * into out_capacity, in which case nothing of in is consumed
+ */
+EXPORT
+int audio_resampler_process(audio_resampler* rs, const int16_t* in, size_t in_samples,
+	int16_t* out, size_t out_capacity);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // !AUDIO_RESAMPLER_H_
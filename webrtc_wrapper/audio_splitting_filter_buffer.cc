@@ -10,12 +10,53 @@ struct _audio_splitting_filter_buffer {
 	int num_bands;
 	int channels;
 
+	size_t conversions; // samples converted by the fill/get functions themselves
+
 	webrtc::SplittingFilter* sp;
 
 	webrtc::IFChannelBuffer* data;
 	webrtc::IFChannelBuffer* bands;
 };
 
+/*
+ * The three band filter bank runs on floats, the two band qmf and a single
+ * band on int16. The fill/get functions read and write the full band signal
+ * in the representation the splitting filter uses, converting while they
+ * (de)interleave, so IFChannelBuffer never has to refresh it in another pass.
+ */
+static bool data_is_float(const audio_splitting_filter_buffer* sp)
+{
+	return sp->num_bands == 3;
+}
+
+template <typename S, typename D>
+static void deinterleave_channel(const S* src, size_t num_frames,
+	size_t channel, size_t num_channels, D* dest)
+{
+	for (size_t i = 0; i < num_frames; ++i) {
+		dest[i] = src[i * num_channels + channel];
+	}
+}
+
+template <typename S, typename D>
+static void interleave_channel(const S* src, size_t num_frames,
+	size_t channel, size_t num_channels, D* dest)
+{
+	for (size_t i = 0; i < num_frames; ++i) {
+		dest[i * num_channels + channel] = src[i];
+	}
+}
+
+/* float samples are in the int16 range, like IFChannelBuffer::fbuf() */
+template <>
+void interleave_channel<float, int16_t>(const float* src, size_t num_frames,
+	size_t channel, size_t num_channels, int16_t* dest)
+{
+	for (size_t i = 0; i < num_frames; ++i) {
+		dest[i * num_channels + channel] = webrtc::FloatS16ToS16(src[i]);
+	}
+}
+
 audio_splitting_filter_buffer* audio_splitting_filter_buffer_create()
 {
 	audio_splitting_filter_buffer* fp;
@@ -35,6 +76,7 @@ void audio_splitting_filter_buffer_free(audio_splitting_filter_buffer* sp)
 	}
 
 	delete sp->data;
+	delete sp->sp;
 
 	free(sp);
 }
@@ -76,21 +118,106 @@ int audio_splitting_filter_buffer_init(audio_splitting_filter_buffer* sp,
 int audio_splitting_filter_buffer_fill_data(audio_splitting_filter_buffer* sp,
 	const uint8_t* data, size_t size)
 {
-	memcpy(sp->data->ibuf()->bands(0)[0], data, size);
-
-	audio_splitting_filter_buffer_analysis(sp);
+	audio_splitting_filter_buffer_fill_interleaved(sp, (const int16_t*)data,
+		size / sizeof(int16_t), 0, 1);
 
 	return size;
 }
 
 int audio_splitting_filter_buffer_get_data(audio_splitting_filter_buffer* sp,
 	uint8_t* data, size_t size)
+{
+	audio_splitting_filter_buffer_get_interleaved(sp, (int16_t*)data,
+		size / sizeof(int16_t), 0, 1);
+
+	return size;
+}
+
+int audio_splitting_filter_buffer_fill_interleaved(audio_splitting_filter_buffer* sp,
+	const int16_t* data, size_t num_frames, size_t channel, size_t num_channels)
+{
+	if (data_is_float(sp)) {
+		deinterleave_channel(data, num_frames, channel, num_channels,
+			sp->data->fbuf()->channels()[0]);
+		sp->conversions += num_frames;
+	}
+	else {
+		deinterleave_channel(data, num_frames, channel, num_channels,
+			sp->data->ibuf()->channels()[0]);
+	}
+
+	audio_splitting_filter_buffer_analysis(sp);
+
+	return num_frames * sizeof(int16_t);
+}
+
+int audio_splitting_filter_buffer_get_interleaved(audio_splitting_filter_buffer* sp,
+	int16_t* data, size_t num_frames, size_t channel, size_t num_channels)
 {
 	audio_splitting_filter_buffer_synthesis(sp);
 
-	memcpy(data, sp->data->ibuf_const()->bands(0)[0], size);
+	if (data_is_float(sp)) {
+		interleave_channel(sp->data->fbuf_const()->channels()[0], num_frames,
+			channel, num_channels, data);
+		sp->conversions += num_frames;
+	}
+	else {
+		interleave_channel(sp->data->ibuf_const()->channels()[0], num_frames,
+			channel, num_channels, data);
+	}
 
-	return size;
+	return num_frames * sizeof(int16_t);
+}
+
+int audio_splitting_filter_buffer_fill_interleaved_float(audio_splitting_filter_buffer* sp,
+	const float* data, size_t num_frames, size_t channel, size_t num_channels)
+{
+	if (data_is_float(sp)) {
+		deinterleave_channel(data, num_frames, channel, num_channels,
+			sp->data->fbuf()->channels()[0]);
+	}
+	else {
+		int16_t* dest = sp->data->ibuf()->channels()[0];
+
+		for (size_t i = 0; i < num_frames; ++i) {
+			dest[i] = webrtc::FloatS16ToS16(data[i * num_channels + channel]);
+		}
+
+		sp->conversions += num_frames;
+	}
+
+	audio_splitting_filter_buffer_analysis(sp);
+
+	return num_frames * sizeof(float);
+}
+
+int audio_splitting_filter_buffer_get_interleaved_float(audio_splitting_filter_buffer* sp,
+	float* data, size_t num_frames, size_t channel, size_t num_channels)
+{
+	audio_splitting_filter_buffer_synthesis(sp);
+
+	if (data_is_float(sp)) {
+		interleave_channel(sp->data->fbuf_const()->channels()[0], num_frames,
+			channel, num_channels, data);
+	}
+	else {
+		interleave_channel(sp->data->ibuf_const()->channels()[0], num_frames,
+			channel, num_channels, data);
+		sp->conversions += num_frames;
+	}
+
+	return num_frames * sizeof(float);
+}
+
+size_t audio_splitting_filter_buffer_get_conversions(audio_splitting_filter_buffer* sp)
+{
+	size_t conversions = sp->conversions + sp->data->num_conversions();
+
+	if (sp->bands != sp->data) {
+		conversions += sp->bands->num_conversions();
+	}
+
+	return conversions;
 }
 
 const float* const* audio_splitting_filter_buffer_get_fbands_const(audio_splitting_filter_buffer* sp, 
@@ -42,6 +42,41 @@ EXPORT
 int audio_splitting_filter_buffer_get_data(audio_splitting_filter_buffer* sp,
 	uint8_t* data, size_t size);
 
+/*
+ * Same as fill_data/get_data, but (de)interleave one channel of a
+ * num_channels frame directly, without an intermediate mono buffer.
+ */
+EXPORT 
+int audio_splitting_filter_buffer_fill_interleaved(audio_splitting_filter_buffer* sp,
+	const int16_t* data, size_t num_frames, size_t channel, size_t num_channels);
+
+EXPORT
+int audio_splitting_filter_buffer_get_interleaved(audio_splitting_filter_buffer* sp,
+	int16_t* data, size_t num_frames, size_t channel, size_t num_channels);
+
+/*
+ * Float variants, the samples are in the int16 range (-32768..32767) like
+ * the fbands. The full band signal is kept in the representation the
+ * splitting filter runs on (float for 3 bands, int16 otherwise), so a float
+ * frame into a 3 band filter is never converted at all.
+ */
+EXPORT
+int audio_splitting_filter_buffer_fill_interleaved_float(audio_splitting_filter_buffer* sp,
+	const float* data, size_t num_frames, size_t channel, size_t num_channels);
+
+EXPORT
+int audio_splitting_filter_buffer_get_interleaved_float(audio_splitting_filter_buffer* sp,
+	float* data, size_t num_frames, size_t channel, size_t num_channels);
+
+/*
+ * Samples converted between int16 and float so far, by fill/get and by
+ * mixing the fbands and ibands accessors. Each mixed access converts a
+ * whole frame, so this divided by the frames processed shows how often
+ * a frame changes representation.
+ */
+EXPORT
+size_t audio_splitting_filter_buffer_get_conversions(audio_splitting_filter_buffer* sp);
+
 EXPORT
 const float* const* audio_splitting_filter_buffer_get_fbands_const(audio_splitting_filter_buffer* sp,
 	int channel);